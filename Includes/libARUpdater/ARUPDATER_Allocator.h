@@ -0,0 +1,70 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Allocator.h
+ * @brief libARUpdater allocator header file.
+ * @details The transient memory of the downloader, uploader and manager operations
+ * (paths, urls, digests) is taken from per operation arenas. The arenas get their
+ * blocks from this allocator, so an embedded build can serve them from a fixed pool.
+ **/
+
+#ifndef _ARUPDATER_ALLOCATOR_H_
+#define _ARUPDATER_ALLOCATOR_H_
+
+#include <stddef.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+/**
+ * @brief Allocate a block
+ * @param ctx The pointer of the user custom context
+ * @param size The size of the block in bytes
+ * @return the block, NULL if the allocation failed
+ */
+typedef void *(*ARUPDATER_Allocator_Alloc_t) (void *ctx, size_t size);
+
+/**
+ * @brief Free a block given by the alloc callback
+ * @param ctx The pointer of the user custom context
+ * @param ptr The block
+ */
+typedef void (*ARUPDATER_Allocator_Free_t) (void *ctx, void *ptr);
+
+/**
+ * @brief Set the allocator of the arena blocks
+ * @warning Must be called while no downloader, uploader or manager operation is running
+ * @param[in] allocCallback : alloc callback, NULL with freeCallback NULL to restore malloc
+ * @param[in] freeCallback : free callback
+ * @param[in] ctx : custom context given to the callbacks
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Allocator_Set(ARUPDATER_Allocator_Alloc_t allocCallback, ARUPDATER_Allocator_Free_t freeCallback, void *ctx);
+
+#endif /* _ARUPDATER_ALLOCATOR_H_ */
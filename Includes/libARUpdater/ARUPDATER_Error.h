@@ -73,6 +73,7 @@ typedef enum
     ARUPDATER_ERROR_UPLOADER_ARUTILS_ERROR,             /**< error on a ARUtils operation in uploader*/
     ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR,      /**< error on a ARDataTransfer operation in uploader*/
     ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR,               /**< error on a ARSAL operation in uploader*/
+    ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE,        /**< The device already runs the plf, nothing was uploaded */
     
 } eARUPDATER_ERROR;
 
@@ -0,0 +1,159 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Fleet.h
+ * @brief libARUpdater Fleet header file.
+ * @details A fleet uploads the same plf to several devices at once. The plf
+ * digest is computed a single time and shared by the uploads of all targets.
+ * Targets of other products, like the drone attached to a skycontroller, get
+ * the plf of their product and are uploaded at the same time.
+ **/
+
+#ifndef _ARUPDATER_FLEET_H_
+#define _ARUPDATER_FLEET_H_
+
+#include <libARUpdater/ARUPDATER_Error.h>
+#include <libARUpdater/ARUPDATER_Uploader.h>
+#include <libARUtils/ARUtils.h>
+#include <libARDiscovery/ARDISCOVERY_Discovery.h>
+#include <libARSAL/ARSAL_MD5_Manager.h>
+
+struct mux_ctx;
+
+typedef struct ARUPDATER_Fleet_t ARUPDATER_Fleet_t;
+
+/**
+ * @brief Progress callback of the upload to one target
+ * @param arg The pointer of the user custom argument
+ * @param targetIndex The index of the target, as returned by ARUPDATER_Fleet_AddTarget()
+ * @param percent The percent size of the plf file already uploaded to the target
+ */
+typedef void (*ARUPDATER_Fleet_TargetProgressCallback_t) (void *arg, int targetIndex, float percent);
+
+/**
+ * @brief Completion callback of the upload to one target
+ * @param arg The pointer of the user custom argument
+ * @param targetIndex The index of the target, as returned by ARUPDATER_Fleet_AddTarget()
+ * @param error The error status of the upload to the target
+ */
+typedef void (*ARUPDATER_Fleet_TargetCompletionCallback_t) (void *arg, int targetIndex, eARUPDATER_ERROR error);
+
+/**
+ * @brief Create an object to upload a plf file to several devices
+ * @warning This function allocates memory
+ * @post ARUPDATER_Fleet_Delete should be called
+ * @param[in] rootFolder : root folder
+ * @param[in] md5Manager : md5 manager
+ * @param[in] product : product of all the targets
+ * @param[in] maxParallelUploads : maximum number of uploads running at the same time, 0 for no limit
+ * @param[in] progressCallback : callback which tells the progress of the upload to each target
+ * @param[in|out] progressArg : arg given to the progressCallback
+ * @param[in] completionCallback : callback which tells when the upload to a target is completed
+ * @param[in|out] completionArg : arg given to the completionCallback
+ * @param[out] error : pointer on the error output. Can be null
+ * @return Pointer on the new fleet, NULL if an error occurred
+ * @see ARUPDATER_Fleet_Delete()
+ */
+ARUPDATER_Fleet_t *ARUPDATER_Fleet_New(const char *const rootFolder, ARSAL_MD5_Manager_t *md5Manager, eARDISCOVERY_PRODUCT product, int maxParallelUploads, ARUPDATER_Fleet_TargetProgressCallback_t progressCallback, void *progressArg, ARUPDATER_Fleet_TargetCompletionCallback_t completionCallback, void *completionArg, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Delete a fleet
+ * @warning This function frees memory
+ * @param fleet : address of the pointer on the fleet
+ * @see ARUPDATER_Fleet_New()
+ */
+void ARUPDATER_Fleet_Delete(ARUPDATER_Fleet_t **fleet);
+
+/**
+ * @brief Add a device to update
+ * @param fleet : pointer on the fleet
+ * @param[in] mux : optional mux context of the device
+ * @param[in] ftpManager : ftp manager connected to the device
+ * @param[in] isAndroidApp : 1 if running on android
+ * @param[out] error : pointer on the error output. Can be null
+ * @return the index of the target, -1 if an error occurred
+ */
+int ARUPDATER_Fleet_AddTarget(ARUPDATER_Fleet_t *fleet, struct mux_ctx *mux, ARUTILS_Manager_t *ftpManager, int isAndroidApp, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Add a device of another product than the fleet one
+ * @details Used to update a skycontroller and its drone together: both targets are given the
+ * skycontroller mux, and the drone one is told its mux channel with
+ * ARUPDATER_Uploader_SetMuxChannel() on its manager. Their transfers then run at the same time
+ * on separate update channels, each one reporting its own progress.
+ * @param fleet : pointer on the fleet
+ * @param[in] mux : optional mux context of the device, or of the skycontroller it is attached to
+ * @param[in] ftpManager : ftp manager connected to the device
+ * @param[in] isAndroidApp : 1 if running on android
+ * @param[in] product : product of the device, its plf is in the product folder of the fleet root folder
+ * @param[out] error : pointer on the error output. Can be null
+ * @return the index of the target, -1 if an error occurred
+ * @see ARUPDATER_Fleet_GetTargetManager()
+ */
+int ARUPDATER_Fleet_AddProductTarget(ARUPDATER_Fleet_t *fleet, struct mux_ctx *mux, ARUTILS_Manager_t *ftpManager, int isAndroidApp, eARDISCOVERY_PRODUCT product, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Get the manager of a target, to configure its uploader before the upload
+ * @param fleet : pointer on the fleet
+ * @param[in] targetIndex : index of the target
+ * @return the manager of the target, NULL if the index is invalid
+ * @see ARUPDATER_Uploader_SetFtpServer()
+ */
+ARUPDATER_Manager_t *ARUPDATER_Fleet_GetTargetManager(ARUPDATER_Fleet_t *fleet, int targetIndex);
+
+/**
+ * @brief Get the result of the upload to a target
+ * @param fleet : pointer on the fleet
+ * @param[in] targetIndex : index of the target
+ * @return the error status of the upload to the target
+ */
+eARUPDATER_ERROR ARUPDATER_Fleet_GetTargetError(ARUPDATER_Fleet_t *fleet, int targetIndex);
+
+/**
+ * @brief Upload the plf to all the targets
+ * @warning This function must be called in its own thread.
+ * @details Returns once all the uploads are completed.
+ * @param fleetArg : thread data of type ARUPDATER_Fleet_t*
+ * @return ARUPDATER_OK if all uploads went well, ARUPDATER_ERROR_UPLOADER if one of them failed;
+ * a target already up to date counts as a success, and gets ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE
+ * from ARUPDATER_Fleet_GetTargetError()
+ * @see ARUPDATER_Fleet_GetTargetError()
+ */
+void* ARUPDATER_Fleet_ThreadRun(void *fleetArg);
+
+/**
+ * @brief Cancel the uploads
+ * @details Used to kill the thread calling ARUPDATER_Fleet_ThreadRun().
+ * @param fleet : pointer on the fleet
+ */
+eARUPDATER_ERROR ARUPDATER_Fleet_CancelThread(ARUPDATER_Fleet_t *fleet);
+
+#endif
@@ -41,6 +41,8 @@
 #include <libARUpdater/ARUPDATER_Manager.h>
 #include <libARDiscovery/ARDISCOVERY_Discovery.h>
 #include <libARSAL/ARSAL_MD5_Manager.h>
+#include <stddef.h>
+#include <stdint.h>
 
 struct mux_ctx;
 
@@ -48,12 +50,65 @@ typedef struct ARUPDATER_Uploader_t ARUPDATER_Uploader_t;
 
 /**
  * @brief Progress callback of the upload
+ * @details Called on every transport within the limits of ARUPDATER_Uploader_SetProgressLimit(),
+ * the details of the progress are given by ARUPDATER_Uploader_GetProgress().
  * @param arg The pointer of the user custom argument
  * @param percent The percent size of the plf file already uploaded
  * @see ARUPDATER_Manager_CheckLocaleVersionThreadRun ()
  */
 typedef void (*ARUPDATER_Uploader_PlfUploadProgressCallback_t) (void* arg, float percent);
 
+/**
+ * @brief Progress of the running or last upload
+ */
+typedef struct
+{
+    uint64_t bytesDone;                 /**< bytes of the plf on the device, a resumed part included */
+    uint64_t bytesTotal;                /**< size of the plf */
+    float percent;                      /**< bytesDone in percent of bytesTotal */
+    double rate;                        /**< smoothed upload rate in bytes/s, 0 until known */
+    double etaSec;                      /**< estimated seconds left, -1 until known */
+} ARUPDATER_Uploader_Progress_t;
+
+/**
+ * @brief Write without response of a packet to the device, see ARUPDATER_Uploader_SetBleLink()
+ * @details Called from the upload thread. The packet must be written whole as one GATT write
+ * without response, or not at all.
+ * @param arg The pointer of the user custom argument
+ * @param packet The packet, at most the ATT MTU minus 3 bytes
+ * @param len Its length
+ * @return 0 if the packet is queued, -EAGAIN if the link queue is full and the packet must be
+ * written again later, another negative errno if the link is lost
+ */
+typedef int (*ARUPDATER_Uploader_BleWriteCallback_t) (void* arg, const uint8_t *packet, size_t len);
+
+/**
+ * @brief Number of chunk sizes counted in ARUPDATER_Uploader_MuxStats_t, from 16 KiB to 1 MiB
+ */
+#define ARUPDATER_UPLOADER_MUX_STATS_SIZES 7
+
+/**
+ * @brief Chunks of the running or last mux update
+ */
+typedef struct
+{
+    uint32_t chunkSize;                 /**< size of the next chunks in bytes */
+    uint32_t chunkSizeMin;              /**< smallest chunk size of this update */
+    uint32_t chunkSizeMax;              /**< largest chunk size of this update, bounded by the remote buffer */
+    uint32_t rttLastMs;                 /**< time between the last chunk sent and its ack */
+    uint32_t rttSmoothedMs;             /**< smoothed time between a chunk sent and its ack */
+    uint32_t rttMinMs;
+    uint32_t rttMaxMs;
+    uint32_t chunksSent;                /**< chunks sent, retransmissions included */
+    uint32_t retransmissions;           /**< chunks sent again after an ack timeout */
+    uint32_t chunksBySize[ARUPDATER_UPLOADER_MUX_STATS_SIZES]; /**< chunks sent by size : up to 16 KiB, 32 KiB ... 1 MiB */
+    uint32_t nacks;                     /**< chunks sent again after the remote found them corrupted */
+    uint32_t chunksCompressed;          /**< chunks sent compressed */
+    uint64_t bytesSent;                 /**< image bytes sent, retransmissions included */
+    uint64_t bytesOnLink;               /**< chunk data sent for them, bytesSent / bytesOnLink is the compression ratio */
+    uint32_t effectiveRate;             /**< image bytes acknowledged per second */
+} ARUPDATER_Uploader_MuxStats_t;
+
 /**
  * @brief Completion callback of the Plf upload
  * @param arg The pointer of the user custom argument
@@ -89,6 +144,198 @@ eARUPDATER_ERROR ARUPDATER_Uploader_New(ARUPDATER_Manager_t* manager, const char
  */
 eARUPDATER_ERROR ARUPDATER_Uploader_Delete(ARUPDATER_Manager_t *manager);
 
+/**
+ * @brief Give the uploader a direct access to the ftp server of the device
+ * @details Optional. ARUtils does not expose ranged reads nor REST offsets, so without it
+ * a partial upload can only be resumed as a whole. With it, the chunks of the partial
+ * upload are read back and checked against the chunk manifest, and the upload restarts
+ * from the last verified chunk.
+ * @param manager : pointer on the manager
+ * @param[in] server : address of the ftp server, NULL to disable the direct access
+ * @param[in] port : port of the ftp server
+ * @param[in] username : user name, can be NULL
+ * @param[in] password : password, can be NULL
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetFtpServer(ARUPDATER_Manager_t *manager, const char *server, int port, const char *username, const char *password);
+
+/**
+ * @brief Upload the plf on several ftp data connections
+ * @details Optional, needs the direct access of ARUPDATER_Uploader_SetFtpServer(). Each
+ * connection writes one range of the plf using REST offsets, which fills the link better
+ * than a single stream when there is latency. Falls back to a single stream if the server
+ * refuses REST. An interrupted segmented upload is restarted rather than resumed.
+ * @param manager : pointer on the manager
+ * @param[in] segmentCount : number of data connections, from 1 (default, no segmentation) to 8
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetFtpSegmentCount(ARUPDATER_Manager_t *manager, int segmentCount);
+
+/**
+ * @brief Set the firmware the device reports, to skip the upload when it is already the plf one
+ * @details Optional. Before uploading, the version is compared with the one of the local plf,
+ * and the md5 with the plf one when given. When they match nothing is sent and the completion
+ * callback receives ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE.
+ * @param manager : pointer on the manager
+ * @param[in] version : version reported by the device (pattern : X.Y.Z), NULL to always upload
+ * @param[in] md5Txt : md5 of the device firmware as an hexadecimal string, NULL if unknown
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetDeviceVersion(ARUPDATER_Manager_t *manager, const char *version, const char *md5Txt);
+
+/**
+ * @brief Update a device through the mux of the skycontroller it is attached to
+ * @details Optional. By default, only skycontrollers are updated over mux, on the mux update
+ * channel. With a channel id, the plf of the uploader's product (typically the drone paired
+ * with the skycontroller) is sent over mux on that channel, which the skycontroller relays to
+ * the device. Uploaders of the skycontroller and of its drone can then share the same mux and
+ * run at the same time, see ARUPDATER_Fleet_AddProductTarget().
+ * @param manager : pointer on the manager
+ * @param[in] channelId : mux channel of the device, 0 for the skycontroller update channel (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChannel(ARUPDATER_Manager_t *manager, uint32_t channelId);
+
+/**
+ * @brief Keep several chunks in flight during a mux update
+ * @details Optional. The remote is asked for the window before the update request; a remote
+ * that doesn't answer gets the stop-and-wait transfer. Chunks not acknowledged in time are sent
+ * again.
+ * @param manager : pointer on the manager
+ * @param[in] chunks : most chunks in flight, from 1 (stop-and-wait, default) to 16
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxWindow(ARUPDATER_Manager_t *manager, int chunks);
+
+/**
+ * @brief Adapt the size of the mux update chunks to the ack round trip time
+ * @details Optional. Only used when the remote answers the capabilities request with the
+ * size of its buffer: chunks then grow while they are acknowledged quickly and shrink when the
+ * acks are slow or lost, from 16 KiB to the remote buffer (1 MiB at most). Otherwise chunks are
+ * 128 KiB.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to adapt the chunk size, 0 to send 128 KiB chunks (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChunkAdaptive(ARUPDATER_Manager_t *manager, int enabled);
+
+/**
+ * @brief Resume an interrupted mux update from its last acknowledged chunk
+ * @details Optional. When the remote advertises it in its capabilities, the last acknowledged
+ * chunk of a failed update is kept next to the plf. The next update of the same plf (same md5,
+ * version and size) offers it to the remote, which answers with the chunk to restart from.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to resume updates, 0 to always restart from the first chunk (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxResume(ARUPDATER_Manager_t *manager, int enabled);
+
+/**
+ * @brief Send a crc32c with each mux update chunk
+ * @details Optional. When the remote advertises it in its capabilities, it checks each chunk on
+ * receipt and nacks the corrupted ones, which are sent again at once instead of the whole
+ * image being refused by the final status.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to send chunk crcs, 0 to rely on the md5 of the whole image (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChunkCrc(ARUPDATER_Manager_t *manager, int enabled);
+
+/**
+ * @brief Compress the mux update chunks
+ * @details Optional. When the remote advertises it in its capabilities, each chunk is
+ * compressed with raw deflate (fastest level) before being sent; chunks that don't shrink by
+ * at least 1/16 are sent as they are, and compression is skipped for the few chunks after
+ * them. The ratio and the effective throughput are in ARUPDATER_Uploader_MuxStats_t.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to compress chunks, 0 to send them as they are (default)
+ * @return ARUPDATER_OK if operation went well, ARUPDATER_ERROR_SYSTEM if the library is built
+ * without zlib, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxCompression(ARUPDATER_Manager_t *manager, int enabled);
+
+/**
+ * @brief Get the chunk sizes and ack round trip times of the running or last mux update
+ * @param manager : pointer on the manager
+ * @param[out] stats : the statistics
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_GetMuxStats(ARUPDATER_Manager_t *manager, ARUPDATER_Uploader_MuxStats_t *stats);
+
+/**
+ * @brief Resume an interrupted Delos (BLE) upload from the bytes the device already received
+ * @details Optional. A journal of the plf digest and of the bytes confirmed is kept next to the
+ * plf while it is uploaded. The next upload of the same plf (same md5 and size) asks the device
+ * the size it received and goes on from there; it restarts from the beginning if the device
+ * doesn't answer or has more than the plf.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to resume uploads, 0 to always restart from the beginning (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetDelosResume(ARUPDATER_Manager_t *manager, int enabled);
+
+/**
+ * @brief Upload the plf over a BLE link of the application, for minidrones
+ * @details Optional. Instead of the Delos ftp, the plf is given to writeCallback in packets as
+ * large as the ATT MTU allows, written without response; up to window packets are in flight
+ * while the device acknowledges them by notifications, which must be given to
+ * ARUPDATER_Uploader_BleReceive(). Lost packets are sent again, and an interrupted upload goes
+ * on from the bytes the device kept.
+ * @param manager : pointer on the manager
+ * @param[in] mtu : ATT MTU negotiated with the device, at least 23
+ * @param[in] window : most packets in flight, from 1 to 255
+ * @param[in] writeCallback : write without response to the device, NULL to use the Delos ftp (default)
+ * @param[in] writeArg : arg given to the writeCallback
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetBleLink(ARUPDATER_Manager_t *manager, int mtu, int window, ARUPDATER_Uploader_BleWriteCallback_t writeCallback, void *writeArg);
+
+/**
+ * @brief Give the uploader a notification of the device, see ARUPDATER_Uploader_SetBleLink()
+ * @details Can be called from any thread, notifications outside an upload are ignored.
+ * @param manager : pointer on the manager
+ * @param[in] data : the notification
+ * @param[in] len : its length
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_BleReceive(ARUPDATER_Manager_t *manager, const uint8_t *data, size_t len);
+
+/**
+ * @brief Limit the rate of the progress callback
+ * @details Optional. A progress is reported once both limits are passed since the last one;
+ * the first progress of an upload and its completion are always reported. By default, at
+ * most every 100 ms and every 0.1%. Both at 0 report every progress of the transport.
+ * @param manager : pointer on the manager
+ * @param[in] intervalMs : shortest time between two progress callbacks in milliseconds
+ * @param[in] stepPercent : smallest change of percent between two progress callbacks
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetProgressLimit(ARUPDATER_Manager_t *manager, int intervalMs, float stepPercent);
+
+/**
+ * @brief Get the bytes done, the rate and the time left of the running or last upload
+ * @details Can be called from the progress callback.
+ * @param manager : pointer on the manager
+ * @param[out] progress : the progress
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_GetProgress(ARUPDATER_Manager_t *manager, ARUPDATER_Uploader_Progress_t *progress);
+
+/**
+ * @brief Choose the transport of the upload by measuring it
+ * @details Optional, only used when both the mux and the ftp of the device are usable, and
+ * needs the direct access of ARUPDATER_Uploader_SetFtpServer(). The ftp is measured with a
+ * short timed upload, the mux on the first chunks of the update. The upload switches to the
+ * other transport when the running one gets much slower than the other and restarting on the
+ * other one still ends sooner. A switch to the ftp restarts the transfer from its first byte,
+ * since the mux leaves nothing that the ftp resume can check; a switch back to the mux only
+ * goes on from the mux journal (see ARUPDATER_Uploader_SetMuxResume()), and restarts otherwise.
+ * @param manager : pointer on the manager
+ * @param[in] enabled : 1 to measure the transports, 0 to use the fixed rules (default)
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetTransportSelection(ARUPDATER_Manager_t *manager, int enabled);
+
 /**
  * @brief Upload a plf
  * @warning This function must be called in its own thread.
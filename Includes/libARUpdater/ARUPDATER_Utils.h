@@ -39,6 +39,7 @@
 #ifndef _ARUPDATER_UTILS_H_
 #define _ARUPDATER_UTILS_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef enum
@@ -106,4 +107,66 @@ int ARUPDATER_Utils_PlfVersionCompare(const ARUPDATER_PlfVersion *v1, const ARUP
  */
 eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFileFromPlf(const char *plfFileName, const char *outFolder, const char *unixFileName);
 
+/**
+ * @brief Result of a file extracted by ARUPDATER_Utils_ExtractUnixFilesFromPlf()
+ * @param arg : user argument
+ * @param unixFileName : name of the file, or the name or pattern that is in none of the files
+ * @param error : ARUPDATER_OK if the file was extracted, the description of the error otherwise
+ */
+typedef void (*ARUPDATER_Utils_ExtractCallback_t) (void *arg, const char *unixFileName, eARUPDATER_ERROR error);
+
+/**
+ * @brief Extract several U_UNIXFILE regular files from a PLF file, in one pass over it
+ *
+ * Each of @unixFileNames is the last path component of a file, as for ARUPDATER_Utils_ExtractUnixFileFromPlf(),
+ * or a shell wildcard pattern matched against it ("*.txt"). The files are written in outFolder with that name,
+ * in the order of their sections.
+ *
+ * @param[in] plfFileName : PLF file path
+ * @param[in] outFolder : Directory path in which the files will be extracted
+ * @param[in] unixFileNames : names or patterns of the files to extract
+ * @param[in] count : number of names or patterns
+ * @param[in] extractCallback : called once per matching file, and once per name or pattern that matches nothing; can be NULL
+ * @param[in] extractArg : arg given to the extractCallback
+ * @return ARUPDATER_OK if every name or pattern matched and all the matching files were extracted, the first error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFilesFromPlf(const char *plfFileName, const char *outFolder, const char * const *unixFileNames, int count,
+							 ARUPDATER_Utils_ExtractCallback_t extractCallback, void *extractArg);
+
+typedef struct ARUPDATER_PlfFileView ARUPDATER_PlfFileView;
+
+/**
+ * @brief Open a U_UNIXFILE regular file of a PLF file in memory, without writing it to disk
+ *
+ * A file stored as is in the PLF is read-only memory of the mapped PLF: it is not copied.
+ * A compressed file is decoded into memory allocated by the library.
+ * The data stays valid until ARUPDATER_Utils_CloseUnixFileFromPlf().
+ *
+ * @param[in] plfFileName : PLF file path
+ * @param[in] unixFileName : last path component of the file, as for ARUPDATER_Utils_ExtractUnixFileFromPlf()
+ * @param[out] view : the opened file, to close with ARUPDATER_Utils_CloseUnixFileFromPlf()
+ * @param[out] data : the content of the file
+ * @param[out] size : size of the content
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Utils_OpenUnixFileFromPlf(const char *plfFileName, const char *unixFileName, ARUPDATER_PlfFileView **view, const void **data, size_t *size);
+
+/**
+ * @brief Close a file opened by ARUPDATER_Utils_OpenUnixFileFromPlf()
+ * @param view : address of the pointer on the opened file, set to NULL
+ */
+void ARUPDATER_Utils_CloseUnixFileFromPlf(ARUPDATER_PlfFileView **view);
+
+/**
+ * @brief Read a U_UNIXFILE regular file of a PLF file into a buffer, without writing it to disk
+ * @param[in] plfFileName : PLF file path
+ * @param[in] unixFileName : last path component of the file, as for ARUPDATER_Utils_ExtractUnixFileFromPlf()
+ * @param[out] buffer : the buffer, can be NULL with a bufferSize of 0 to get the size of the file
+ * @param[in] bufferSize : size of the buffer
+ * @param[out] size : size of the file, also set when the buffer is too small
+ * @return ARUPDATER_OK if operation went well, ARUPDATER_ERROR_MANAGER_BUFFER_TOO_SMALL if the file is larger than
+ * the buffer, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Utils_ReadUnixFileFromPlf(const char *plfFileName, const char *unixFileName, void *buffer, size_t bufferSize, size_t *size);
+
 #endif /* _ARUPDATER_UTILS_H_ */
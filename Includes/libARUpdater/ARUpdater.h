@@ -39,9 +39,11 @@
 #define _ARUPDATER_H_
 
 #include <libARUpdater/ARUPDATER_Error.h>
+#include <libARUpdater/ARUPDATER_Allocator.h>
 #include <libARUpdater/ARUPDATER_Manager.h>
 #include <libARUpdater/ARUPDATER_Downloader.h>
 #include <libARUpdater/ARUPDATER_Uploader.h>
+#include <libARUpdater/ARUPDATER_Fleet.h>
 #include <libARUpdater/ARUPDATER_Utils.h>
 
 #endif /* _ARUPDATER_H_ */
@@ -0,0 +1,222 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Arena.c
+ * @brief libARUpdater per operation arena
+ **/
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "ARUPDATER_Arena.h"
+
+struct ARUPDATER_Arena_Block_t
+{
+    ARUPDATER_Arena_Block_t *next;
+    size_t size;
+};
+
+/* the strictest alignment of the basic types */
+typedef union
+{
+    long double d;
+    long long l;
+    void *p;
+    void (*f)(void);
+} ARUPDATER_Arena_Align_t;
+
+typedef struct
+{
+    char c;
+    ARUPDATER_Arena_Align_t align;
+} ARUPDATER_Arena_AlignOf_t;
+
+#define ARUPDATER_ARENA_ALIGNMENT   offsetof(ARUPDATER_Arena_AlignOf_t, align)
+#define ARUPDATER_ARENA_ALIGN(size) (((size) + ARUPDATER_ARENA_ALIGNMENT - 1) & ~(ARUPDATER_ARENA_ALIGNMENT - 1))
+#define ARUPDATER_ARENA_HEADER_SIZE ARUPDATER_ARENA_ALIGN(sizeof(ARUPDATER_Arena_Block_t))
+
+static void *ARUPDATER_Arena_DefaultAlloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void ARUPDATER_Arena_DefaultFree(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+static ARUPDATER_Allocator_Alloc_t allocCallback = ARUPDATER_Arena_DefaultAlloc;
+static ARUPDATER_Allocator_Free_t freeCallback = ARUPDATER_Arena_DefaultFree;
+static void *allocatorCtx = NULL;
+
+eARUPDATER_ERROR ARUPDATER_Allocator_Set(ARUPDATER_Allocator_Alloc_t alloc, ARUPDATER_Allocator_Free_t release, void *ctx)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((alloc == NULL) && (release == NULL))
+    {
+        allocCallback = ARUPDATER_Arena_DefaultAlloc;
+        freeCallback = ARUPDATER_Arena_DefaultFree;
+        allocatorCtx = NULL;
+    }
+    else if ((alloc == NULL) || (release == NULL))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else
+    {
+        allocCallback = alloc;
+        freeCallback = release;
+        allocatorCtx = ctx;
+    }
+
+    return error;
+}
+
+void ARUPDATER_Arena_Init(ARUPDATER_Arena_t *arena)
+{
+    char *start = (char *)ARUPDATER_ARENA_ALIGN((uintptr_t)arena->inlineBuffer);
+
+    arena->blocks = NULL;
+    arena->current = start;
+    arena->available = ARUPDATER_ARENA_INLINE_SIZE - (start - arena->inlineBuffer);
+}
+
+void *ARUPDATER_Arena_Alloc(ARUPDATER_Arena_t *arena, size_t size)
+{
+    ARUPDATER_Arena_Block_t *block = NULL;
+    size_t blockSize = ARUPDATER_ARENA_BLOCK_SIZE;
+    void *ptr = NULL;
+
+    size = ARUPDATER_ARENA_ALIGN(size);
+
+    if (size > arena->available)
+    {
+        if (size + ARUPDATER_ARENA_HEADER_SIZE > blockSize)
+        {
+            blockSize = size + ARUPDATER_ARENA_HEADER_SIZE;
+        }
+        block = allocCallback(allocatorCtx, blockSize);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+        block->size = blockSize;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->current = (char *)block + ARUPDATER_ARENA_HEADER_SIZE;
+        arena->available = blockSize - ARUPDATER_ARENA_HEADER_SIZE;
+    }
+
+    ptr = arena->current;
+    arena->current += size;
+    arena->available -= size;
+
+    return ptr;
+}
+
+char *ARUPDATER_Arena_Concat(ARUPDATER_Arena_t *arena, ...)
+{
+    va_list args;
+    const char *part;
+    size_t length = 0;
+    char *str = NULL;
+    char *end;
+
+    va_start(args, arena);
+    while ((part = va_arg(args, const char *)) != NULL)
+    {
+        length += strlen(part);
+    }
+    va_end(args);
+
+    str = ARUPDATER_Arena_Alloc(arena, length + 1);
+    if (str != NULL)
+    {
+        end = str;
+        va_start(args, arena);
+        while ((part = va_arg(args, const char *)) != NULL)
+        {
+            length = strlen(part);
+            memcpy(end, part, length);
+            end += length;
+        }
+        va_end(args);
+        *end = '\0';
+    }
+
+    return str;
+}
+
+char *ARUPDATER_Arena_Printf(ARUPDATER_Arena_t *arena, const char *format, ...)
+{
+    va_list args;
+    int length;
+    char *str = NULL;
+
+    va_start(args, format);
+    length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    if (length >= 0)
+    {
+        str = ARUPDATER_Arena_Alloc(arena, length + 1);
+    }
+    if (str != NULL)
+    {
+        va_start(args, format);
+        vsnprintf(str, length + 1, format, args);
+        va_end(args);
+    }
+
+    return str;
+}
+
+void ARUPDATER_Arena_Release(ARUPDATER_Arena_t *arena)
+{
+    ARUPDATER_Arena_Block_t *block = arena->blocks;
+    ARUPDATER_Arena_Block_t *next = NULL;
+
+    while (block != NULL)
+    {
+        next = block->next;
+        freeCallback(allocatorCtx, block);
+        block = next;
+    }
+
+    ARUPDATER_Arena_Init(arena);
+}
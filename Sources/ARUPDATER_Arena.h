@@ -0,0 +1,95 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Arena.h
+ * @brief libARUpdater per operation arena header file.
+ * @details Everything allocated from an arena is freed at once by
+ * ARUPDATER_Arena_Release(). The first bytes come from the arena itself, so the
+ * paths of a run usually need no allocation at all; the next blocks come from the
+ * allocator set by ARUPDATER_Allocator_Set().
+ **/
+
+#ifndef _ARUPDATER_ARENA_PRIVATE_H_
+#define _ARUPDATER_ARENA_PRIVATE_H_
+
+#include <stddef.h>
+#include <libARUpdater/ARUPDATER_Allocator.h>
+
+#define ARUPDATER_ARENA_INLINE_SIZE     2048
+#define ARUPDATER_ARENA_BLOCK_SIZE      4096
+
+typedef struct ARUPDATER_Arena_Block_t ARUPDATER_Arena_Block_t;
+
+typedef struct
+{
+    ARUPDATER_Arena_Block_t *blocks;    /* allocated blocks, last one first */
+    char *current;                      /* free space of the current block */
+    size_t available;
+    char inlineBuffer[ARUPDATER_ARENA_INLINE_SIZE];
+} ARUPDATER_Arena_t;
+
+/**
+ * @brief Initialize an empty arena
+ * @param arena : the arena
+ */
+void ARUPDATER_Arena_Init(ARUPDATER_Arena_t *arena);
+
+/**
+ * @brief Allocate memory from the arena
+ * @param arena : the arena
+ * @param[in] size : size in bytes
+ * @return the memory, aligned for any type, NULL if the allocation failed
+ */
+void *ARUPDATER_Arena_Alloc(ARUPDATER_Arena_t *arena, size_t size);
+
+/**
+ * @brief Concatenate strings into the arena
+ * @param arena : the arena
+ * @param ... : the strings, terminated by NULL
+ * @return the string, NULL if the allocation failed
+ */
+char *ARUPDATER_Arena_Concat(ARUPDATER_Arena_t *arena, ...);
+
+/**
+ * @brief Format a string into the arena
+ * @param arena : the arena
+ * @param[in] format : printf format
+ * @return the string, NULL if the allocation failed
+ */
+char *ARUPDATER_Arena_Printf(ARUPDATER_Arena_t *arena, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+/**
+ * @brief Free everything allocated from the arena, which can then be used again
+ * @param arena : the arena
+ */
+void ARUPDATER_Arena_Release(ARUPDATER_Arena_t *arena);
+
+#endif /* _ARUPDATER_ARENA_PRIVATE_H_ */
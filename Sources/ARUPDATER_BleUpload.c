@@ -0,0 +1,552 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_BleUpload.c
+ * @brief libARUpdater BLE upload c file.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include <libARSAL/ARSAL_Print.h>
+#include <libARSAL/ARSAL_Mutex.h>
+#include <libARSAL/ARSAL_MD5_Manager.h>
+
+#include "ARUPDATER_BleUpload.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+#define ARUPDATER_BLE_UPLOAD_TAG                "ARUPDATER_BleUpload"
+/* no ack for this long: the packets in flight are sent again */
+#define ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS     1000
+#define ARUPDATER_BLE_UPLOAD_MAX_RETRIES        5
+/* wait before writing again when the link queue is full, about a connection interval */
+#define ARUPDATER_BLE_UPLOAD_BUSY_WAIT_MS       5
+
+struct ARUPDATER_BleUpload_t
+{
+    int mtu;
+    int window;
+    size_t payloadSize;             /* data bytes of a DATA packet */
+    uint8_t *packet;
+
+    ARUPDATER_Uploader_BleWriteCallback_t writeCallback;
+    void *writeArg;
+    ARUPDATER_BleUpload_ProgressCallback_t progressCallback;
+    void *progressArg;
+
+    /* answers of the device, written by ARUPDATER_BleUpload_Receive */
+    ARSAL_Mutex_t lock;
+    int hasAck;
+    uint64_t ackOffset;
+    int hasNack;
+    uint64_t nackOffset;
+    int hasStatus;
+    int status;
+    int hasAnswer;                  /* an ack or a nack not seen by the upload yet */
+    int isCanceled;
+    int fds[2];                     /* wakeup of the upload on an answer or a cancel */
+};
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+static void ARUPDATER_BleUpload_Put32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t ARUPDATER_BleUpload_Get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int64_t ARUPDATER_BleUpload_NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void ARUPDATER_BleUpload_Wake(ARUPDATER_BleUpload_t *ble)
+{
+    uint8_t one = 1;
+
+    // a full pipe already wakes the upload
+    if (write(ble->fds[1], &one, 1) < 0)
+    {
+    }
+}
+
+/* wait for an answer of the device or a cancel, at most timeoutMs */
+static void ARUPDATER_BleUpload_Wait(ARUPDATER_BleUpload_t *ble, int timeoutMs)
+{
+    struct pollfd pfd;
+    uint8_t buffer[64];
+
+    pfd.fd = ble->fds[0];
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if ((poll(&pfd, 1, timeoutMs) > 0) && (pfd.revents & POLLIN))
+    {
+        while (read(ble->fds[0], buffer, sizeof(buffer)) > 0)
+        {
+        }
+    }
+}
+
+/* the flags written under the lock by the cancel and the notifications */
+static int ARUPDATER_BleUpload_IsCanceled(ARUPDATER_BleUpload_t *ble)
+{
+    int isCanceled = 0;
+
+    ARSAL_Mutex_Lock(&ble->lock);
+    isCanceled = ble->isCanceled;
+    ARSAL_Mutex_Unlock(&ble->lock);
+
+    return isCanceled;
+}
+
+static int ARUPDATER_BleUpload_HasAnswer(ARUPDATER_BleUpload_t *ble)
+{
+    int hasAnswer = 0;
+
+    ARSAL_Mutex_Lock(&ble->lock);
+    hasAnswer = ble->hasAnswer;
+    ARSAL_Mutex_Unlock(&ble->lock);
+
+    return hasAnswer;
+}
+
+/* write a packet, waiting while the link queue is full; returns 0 or a negative errno */
+static int ARUPDATER_BleUpload_Write(ARUPDATER_BleUpload_t *ble, const uint8_t *packet, size_t len)
+{
+    int64_t deadline = ARUPDATER_BleUpload_NowMs() + ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS;
+    int ret = 0;
+
+    do
+    {
+        if (ARUPDATER_BleUpload_IsCanceled(ble))
+        {
+            return -ECANCELED;
+        }
+
+        ret = ble->writeCallback(ble->writeArg, packet, len);
+        if (ret == -EAGAIN)
+        {
+            if (ARUPDATER_BleUpload_NowMs() > deadline)
+            {
+                return -ETIMEDOUT;
+            }
+            ARUPDATER_BleUpload_Wait(ble, ARUPDATER_BLE_UPLOAD_BUSY_WAIT_MS);
+        }
+    } while (ret == -EAGAIN);
+
+    return ret;
+}
+
+ARUPDATER_BleUpload_t *ARUPDATER_BleUpload_New(int mtu, int window, ARUPDATER_Uploader_BleWriteCallback_t writeCallback, void *writeArg, ARUPDATER_BleUpload_ProgressCallback_t progressCallback, void *progressArg, eARUPDATER_ERROR *error)
+{
+    ARUPDATER_BleUpload_t *ble = NULL;
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+
+    if ((writeCallback == NULL) || (mtu < ARUPDATER_BLE_UPLOAD_MTU_MIN) || (mtu > ARUPDATER_BLE_UPLOAD_MTU_MAX) ||
+        (window < 1) || (window > ARUPDATER_BLE_UPLOAD_WINDOW_MAX))
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        ble = calloc(1, sizeof(ARUPDATER_BleUpload_t));
+        if (ble == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        ble->fds[0] = -1;
+        ble->fds[1] = -1;
+        ble->packet = malloc(mtu - ARUPDATER_BLE_UPLOAD_ATT_HEADER);
+        if (ble->packet == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        if ((pipe(ble->fds) != 0) ||
+            (fcntl(ble->fds[0], F_SETFL, O_NONBLOCK) != 0) || (fcntl(ble->fds[1], F_SETFL, O_NONBLOCK) != 0) ||
+            (ARSAL_Mutex_Init(&ble->lock) != 0))
+        {
+            err = ARUPDATER_ERROR_SYSTEM;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        ble->mtu = mtu;
+        ble->window = window;
+        ble->payloadSize = mtu - ARUPDATER_BLE_UPLOAD_ATT_HEADER - ARUPDATER_BLE_UPLOAD_DATA_HEADER;
+        ble->writeCallback = writeCallback;
+        ble->writeArg = writeArg;
+        ble->progressCallback = progressCallback;
+        ble->progressArg = progressArg;
+    }
+    else if (ble != NULL)
+    {
+        if (ble->fds[0] >= 0)
+        {
+            close(ble->fds[0]);
+            close(ble->fds[1]);
+        }
+        free(ble->packet);
+        free(ble);
+        ble = NULL;
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return ble;
+}
+
+void ARUPDATER_BleUpload_Delete(ARUPDATER_BleUpload_t **ble)
+{
+    if ((ble != NULL) && (*ble != NULL))
+    {
+        ARSAL_Mutex_Destroy(&(*ble)->lock);
+        close((*ble)->fds[0]);
+        close((*ble)->fds[1]);
+        free((*ble)->packet);
+        free(*ble);
+        *ble = NULL;
+    }
+}
+
+void ARUPDATER_BleUpload_Cancel(ARUPDATER_BleUpload_t *ble)
+{
+    if (ble != NULL)
+    {
+        ARSAL_Mutex_Lock(&ble->lock);
+        ble->isCanceled = 1;
+        ARSAL_Mutex_Unlock(&ble->lock);
+        ARUPDATER_BleUpload_Wake(ble);
+    }
+}
+
+void ARUPDATER_BleUpload_Receive(ARUPDATER_BleUpload_t *ble, const uint8_t *data, size_t len)
+{
+    if ((ble == NULL) || (data == NULL) || (len < 1))
+    {
+        return;
+    }
+
+    ARSAL_Mutex_Lock(&ble->lock);
+    switch (data[0])
+    {
+    case ARUPDATER_BLE_UPLOAD_TYPE_ACK:
+        if (len >= ARUPDATER_BLE_UPLOAD_ACK_SIZE)
+        {
+            ble->hasAck = 1;
+            ble->hasAnswer = 1;
+            ble->ackOffset = ARUPDATER_BleUpload_Get32(&data[1]);
+        }
+        break;
+    case ARUPDATER_BLE_UPLOAD_TYPE_NACK:
+        if (len >= ARUPDATER_BLE_UPLOAD_ACK_SIZE)
+        {
+            ble->hasNack = 1;
+            ble->hasAnswer = 1;
+            ble->nackOffset = ARUPDATER_BleUpload_Get32(&data[1]);
+        }
+        break;
+    case ARUPDATER_BLE_UPLOAD_TYPE_STATUS:
+        if (len >= ARUPDATER_BLE_UPLOAD_STATUS_SIZE)
+        {
+            ble->hasStatus = 1;
+            ble->status = data[1];
+        }
+        break;
+    default:
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_BLE_UPLOAD_TAG, "unknown notification 0x%02x", data[0]);
+        break;
+    }
+    ARSAL_Mutex_Unlock(&ble->lock);
+
+    ARUPDATER_BleUpload_Wake(ble);
+}
+
+/* send START until the device answers the offset to start from */
+static eARUPDATER_ERROR ARUPDATER_BleUpload_Start(ARUPDATER_BleUpload_t *ble, uint64_t fileSize, const uint8_t *md5, uint64_t *offset)
+{
+    int retries = 0;
+    int hasAck = 0;
+    int64_t deadline = 0;
+
+    ble->packet[0] = ARUPDATER_BLE_UPLOAD_TYPE_START;
+    ble->packet[1] = (uint8_t)ble->window;
+    ARUPDATER_BleUpload_Put32(&ble->packet[2], (uint32_t)fileSize);
+    memcpy(&ble->packet[6], md5, ARUPDATER_BLE_UPLOAD_START_SIZE - 6);
+
+    for (retries = 0; (retries < ARUPDATER_BLE_UPLOAD_MAX_RETRIES) && !hasAck && !ARUPDATER_BleUpload_IsCanceled(ble); retries++)
+    {
+        if (ARUPDATER_BleUpload_Write(ble, ble->packet, ARUPDATER_BLE_UPLOAD_START_SIZE) != 0)
+        {
+            return ARUPDATER_ERROR_UPLOADER;
+        }
+
+        deadline = ARUPDATER_BleUpload_NowMs() + ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS;
+        while (!hasAck && !ARUPDATER_BleUpload_IsCanceled(ble) && (ARUPDATER_BleUpload_NowMs() < deadline))
+        {
+            ARUPDATER_BleUpload_Wait(ble, (int)(deadline - ARUPDATER_BleUpload_NowMs()));
+            ARSAL_Mutex_Lock(&ble->lock);
+            hasAck = ble->hasAck;
+            *offset = ble->ackOffset;
+            ARSAL_Mutex_Unlock(&ble->lock);
+        }
+    }
+
+    if (!hasAck || (*offset > fileSize))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_BLE_UPLOAD_TAG, "no valid answer to start");
+        return ARUPDATER_ERROR_UPLOADER;
+    }
+
+    return ARUPDATER_OK;
+}
+
+/* send the packets of the window until the device acknowledged the whole file */
+static eARUPDATER_ERROR ARUPDATER_BleUpload_SendData(ARUPDATER_BleUpload_t *ble, ARUPDATER_FileMap_t *map, uint64_t fileSize, uint64_t offset)
+{
+    uint64_t acked = offset;
+    uint64_t next = offset;
+    uint64_t inFlight = (uint64_t)ble->window * ble->payloadSize;
+    int64_t lastAck = ARUPDATER_BleUpload_NowMs();
+    int64_t now = 0;
+    int retries = 0;
+    const void *data = NULL;
+    size_t got = 0;
+    int ret = 0;
+
+    while ((acked < fileSize) && !ARUPDATER_BleUpload_IsCanceled(ble))
+    {
+        ARSAL_Mutex_Lock(&ble->lock);
+        ble->hasAnswer = 0;
+        if (ble->hasNack)
+        {
+            // a packet was lost: go back to the first byte missing
+            ble->hasNack = 0;
+            if ((ble->nackOffset >= acked) && (ble->nackOffset < next))
+            {
+                next = ble->nackOffset;
+            }
+        }
+        if (ble->hasAck && (ble->ackOffset > acked) && (ble->ackOffset <= fileSize))
+        {
+            acked = ble->ackOffset;
+        }
+        ARSAL_Mutex_Unlock(&ble->lock);
+
+        now = ARUPDATER_BleUpload_NowMs();
+        if (acked > offset)
+        {
+            offset = acked;
+            lastAck = now;
+            retries = 0;
+            if (next < acked)
+            {
+                next = acked;
+            }
+            if (ble->progressCallback != NULL)
+            {
+                ble->progressCallback(ble->progressArg, acked, fileSize);
+            }
+        }
+        else if (now - lastAck > ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS)
+        {
+            if (++retries > ARUPDATER_BLE_UPLOAD_MAX_RETRIES)
+            {
+                ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_BLE_UPLOAD_TAG, "no ack after %llu bytes", (unsigned long long)acked);
+                return ARUPDATER_ERROR_UPLOADER;
+            }
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_BLE_UPLOAD_TAG, "ack timeout, sending again from %llu", (unsigned long long)acked);
+            next = acked;
+            lastAck = now;
+        }
+
+        // fill the window, the packets are written without waiting for the device
+        ble->packet[0] = ARUPDATER_BLE_UPLOAD_TYPE_DATA;
+        while ((next < fileSize) && (next - acked < inFlight))
+        {
+            data = ARUPDATER_FileMap_Get(map, (off_t)next, ble->payloadSize, &got);
+            if (data == NULL)
+            {
+                ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_BLE_UPLOAD_TAG, "can't read the file at %llu", (unsigned long long)next);
+                return ARUPDATER_ERROR_UPLOADER;
+            }
+            ARUPDATER_BleUpload_Put32(&ble->packet[1], (uint32_t)next);
+            memcpy(&ble->packet[ARUPDATER_BLE_UPLOAD_DATA_HEADER], data, got);
+
+            ret = ARUPDATER_BleUpload_Write(ble, ble->packet, ARUPDATER_BLE_UPLOAD_DATA_HEADER + got);
+            if (ret != 0)
+            {
+                if (ret != -ECANCELED)
+                {
+                    ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_BLE_UPLOAD_TAG, "write failed: %s", strerror(-ret));
+                }
+                return ARUPDATER_ERROR_UPLOADER;
+            }
+            next += got;
+
+            // go on with the acks and nacks received meanwhile
+            if (ARUPDATER_BleUpload_HasAnswer(ble))
+            {
+                break;
+            }
+        }
+
+        if (!ARUPDATER_BleUpload_HasAnswer(ble) && (acked < fileSize))
+        {
+            ARUPDATER_BleUpload_Wait(ble, ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS);
+        }
+    }
+
+    return ARUPDATER_BleUpload_IsCanceled(ble) ? ARUPDATER_ERROR_UPLOADER : ARUPDATER_OK;
+}
+
+/* send END until the device answers whether the file is whole */
+static eARUPDATER_ERROR ARUPDATER_BleUpload_End(ARUPDATER_BleUpload_t *ble, const uint8_t *md5)
+{
+    int retries = 0;
+    int hasStatus = 0;
+    int status = 0;
+    int64_t deadline = 0;
+
+    ble->packet[0] = ARUPDATER_BLE_UPLOAD_TYPE_END;
+    memcpy(&ble->packet[1], md5, ARSAL_MD5_LENGTH);
+
+    for (retries = 0; (retries < ARUPDATER_BLE_UPLOAD_MAX_RETRIES) && !hasStatus && !ARUPDATER_BleUpload_IsCanceled(ble); retries++)
+    {
+        if (ARUPDATER_BleUpload_Write(ble, ble->packet, ARUPDATER_BLE_UPLOAD_END_SIZE) != 0)
+        {
+            return ARUPDATER_ERROR_UPLOADER;
+        }
+
+        deadline = ARUPDATER_BleUpload_NowMs() + ARUPDATER_BLE_UPLOAD_ACK_TIMEOUT_MS;
+        while (!hasStatus && !ARUPDATER_BleUpload_IsCanceled(ble) && (ARUPDATER_BleUpload_NowMs() < deadline))
+        {
+            ARUPDATER_BleUpload_Wait(ble, (int)(deadline - ARUPDATER_BleUpload_NowMs()));
+            ARSAL_Mutex_Lock(&ble->lock);
+            hasStatus = ble->hasStatus;
+            status = ble->status;
+            ARSAL_Mutex_Unlock(&ble->lock);
+        }
+    }
+
+    if (!hasStatus || (status != ARUPDATER_BLE_UPLOAD_STATUS_OK))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_BLE_UPLOAD_TAG, hasStatus ? "device refused the file: %d" : "no answer to end", status);
+        return ARUPDATER_ERROR_UPLOADER;
+    }
+
+    return ARUPDATER_OK;
+}
+
+eARUPDATER_ERROR ARUPDATER_BleUpload_Upload(ARUPDATER_BleUpload_t *ble, ARUPDATER_FileMap_t *map, const uint8_t *md5)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    uint64_t fileSize = 0;
+    uint64_t offset = 0;
+
+    if ((ble == NULL) || (map == NULL) || (md5 == NULL))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    fileSize = map->size;
+    if (fileSize > UINT32_MAX)
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    ARSAL_Mutex_Lock(&ble->lock);
+    ble->hasAck = 0;
+    ble->hasNack = 0;
+    ble->hasStatus = 0;
+    ble->hasAnswer = 0;
+    ARSAL_Mutex_Unlock(&ble->lock);
+
+    error = ARUPDATER_BleUpload_Start(ble, fileSize, md5, &offset);
+
+    if (error == ARUPDATER_OK)
+    {
+        if (offset > 0)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_BLE_UPLOAD_TAG, "device has %llu of %llu bytes, resuming",
+                        (unsigned long long)offset, (unsigned long long)fileSize);
+        }
+        if (ble->progressCallback != NULL)
+        {
+            ble->progressCallback(ble->progressArg, offset, fileSize);
+        }
+        error = ARUPDATER_BleUpload_SendData(ble, map, fileSize, offset);
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        error = ARUPDATER_BleUpload_End(ble, md5);
+    }
+
+    return error;
+}
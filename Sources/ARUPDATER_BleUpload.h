@@ -0,0 +1,134 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_BleUpload.h
+ * @brief libARUpdater BLE upload header file.
+ * @details The plf is sent as GATT writes without response given to the application, each
+ * filled up to the ATT MTU, and several are in flight: the device acknowledges the bytes it
+ * received in order in notifications, once every half window. A gap makes the device ask for
+ * the bytes again from its offset (go-back-N), a lost ack is recovered on timeout.
+ *
+ * Packets, little endian, host -> device:
+ *   START  type, window (packets), size u32, first 8 bytes of the plf md5
+ *   DATA   type, offset u32, data up to the end of the packet
+ *   END    type, plf md5
+ * device -> host:
+ *   ACK    type, offset u32 : bytes received in order; the answer to START is the offset of a
+ *          previous upload of the same plf to resume from, 0 otherwise
+ *   NACK   type, offset u32 : DATA out of order, send again from offset
+ *   STATUS type, status u8  : answer to END, ARUPDATER_BLE_UPLOAD_STATUS_OK if the plf is whole
+ **/
+
+#ifndef _ARUPDATER_BLE_UPLOAD_PRIVATE_H_
+#define _ARUPDATER_BLE_UPLOAD_PRIVATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+#include <libARUpdater/ARUPDATER_Uploader.h>
+#include "ARUPDATER_FileMap.h"
+
+/* ATT header of a write or a notification, the packets are the rest of the MTU */
+#define ARUPDATER_BLE_UPLOAD_ATT_HEADER     3
+#define ARUPDATER_BLE_UPLOAD_MTU_MIN        23
+#define ARUPDATER_BLE_UPLOAD_MTU_MAX        517
+#define ARUPDATER_BLE_UPLOAD_WINDOW_MAX     255
+
+#define ARUPDATER_BLE_UPLOAD_TYPE_START     0x01
+#define ARUPDATER_BLE_UPLOAD_TYPE_DATA      0x02
+#define ARUPDATER_BLE_UPLOAD_TYPE_END       0x03
+#define ARUPDATER_BLE_UPLOAD_TYPE_ACK       0x81
+#define ARUPDATER_BLE_UPLOAD_TYPE_NACK      0x82
+#define ARUPDATER_BLE_UPLOAD_TYPE_STATUS    0x83
+
+#define ARUPDATER_BLE_UPLOAD_START_SIZE     14
+#define ARUPDATER_BLE_UPLOAD_DATA_HEADER    5
+#define ARUPDATER_BLE_UPLOAD_END_SIZE       17
+#define ARUPDATER_BLE_UPLOAD_ACK_SIZE       5
+#define ARUPDATER_BLE_UPLOAD_STATUS_SIZE    2
+
+#define ARUPDATER_BLE_UPLOAD_STATUS_OK      0
+#define ARUPDATER_BLE_UPLOAD_STATUS_MD5     1   /* the plf received doesn't match the md5 */
+
+typedef struct ARUPDATER_BleUpload_t ARUPDATER_BleUpload_t;
+
+/**
+ * @brief Progress callback of a BLE upload
+ * @param arg : user argument
+ * @param done : number of bytes of the file acknowledged by the device
+ * @param total : size of the file
+ */
+typedef void (*ARUPDATER_BleUpload_ProgressCallback_t) (void *arg, uint64_t done, uint64_t total);
+
+/**
+ * @brief Create a BLE uploader
+ * @warning This function allocates memory
+ * @param[in] mtu : ATT MTU negotiated with the device, from ARUPDATER_BLE_UPLOAD_MTU_MIN
+ * @param[in] window : most packets in flight, from 1 to ARUPDATER_BLE_UPLOAD_WINDOW_MAX
+ * @param[in] writeCallback : write without response of a packet
+ * @param[in] writeArg : arg given to the writeCallback
+ * @param[in] progressCallback : progress callback, can be NULL
+ * @param[in] progressArg : arg given to the progressCallback
+ * @param[out] error : the error, can be NULL
+ * @return the BLE uploader, NULL if an error occurred
+ */
+ARUPDATER_BleUpload_t *ARUPDATER_BleUpload_New(int mtu, int window, ARUPDATER_Uploader_BleWriteCallback_t writeCallback, void *writeArg, ARUPDATER_BleUpload_ProgressCallback_t progressCallback, void *progressArg, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Delete a BLE uploader
+ * @param ble : address of the pointer on the BLE uploader
+ */
+void ARUPDATER_BleUpload_Delete(ARUPDATER_BleUpload_t **ble);
+
+/**
+ * @brief Upload a mapped file, from the offset the device answers to START
+ * @param ble : pointer on the BLE uploader
+ * @param map : the file, its chunks are read with ARUPDATER_FileMap_Get()
+ * @param[in] md5 : md5 of the file, ARSAL_MD5_LENGTH bytes
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_BleUpload_Upload(ARUPDATER_BleUpload_t *ble, ARUPDATER_FileMap_t *map, const uint8_t *md5);
+
+/**
+ * @brief Give a notification of the device, can be called from any thread
+ * @param ble : pointer on the BLE uploader
+ * @param[in] data : the notification
+ * @param[in] len : its length
+ */
+void ARUPDATER_BleUpload_Receive(ARUPDATER_BleUpload_t *ble, const uint8_t *data, size_t len);
+
+/**
+ * @brief Cancel a running upload, can be called from any thread
+ * @param ble : pointer on the BLE uploader
+ */
+void ARUPDATER_BleUpload_Cancel(ARUPDATER_BleUpload_t *ble);
+
+#endif /* _ARUPDATER_BLE_UPLOAD_PRIVATE_H_ */
@@ -46,6 +46,7 @@
 #include "ARUPDATER_Manager.h"
 #include "ARUPDATER_Downloader.h"
 #include "ARUPDATER_Utils.h"
+#include "ARUPDATER_Arena.h"
 #include <json-c/json.h>
 
 /* ***************************************
@@ -424,6 +425,9 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
     int ret;
     char *plfFolder = NULL;
     int productIndex = 0;
+    ARUPDATER_Arena_t arena;
+
+    ARUPDATER_Arena_Init(&arena);
 
     if (manager == NULL)
     {
@@ -438,13 +442,11 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
 
     manager->downloader->updateHasBeenChecked = 1;
 
-    plfFolder = malloc(strlen(manager->downloader->rootFolder) + strlen(ARUPDATER_MANAGER_PLF_FOLDER) + 1);
+    plfFolder = ARUPDATER_Arena_Concat(&arena, manager->downloader->rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, NULL);
     if (plfFolder == NULL) {
         error = ARUPDATER_ERROR_ALLOC;
         goto end;
     }
-    strcpy(plfFolder, manager->downloader->rootFolder);
-    strcat(plfFolder, ARUPDATER_MANAGER_PLF_FOLDER);
 
     platform = ARUPDATER_Downloader_GetPlatformName(manager->downloader->appPlatform);
     if (platform == NULL) {
@@ -458,31 +460,24 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
         eARDISCOVERY_PRODUCT product = manager->downloader->productList[productIndex];
         uint16_t productId = ARDISCOVERY_getProductID(product);
 
-        device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-        snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
+        device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
         char *fileName = NULL;
 
         // read the header of the plf file
-        deviceFolder = malloc(strlen(plfFolder) + strlen(device) + strlen(ARUPDATER_MANAGER_FOLDER_SEPARATOR) + 1);
+        deviceFolder = (device != NULL) ? ARUPDATER_Arena_Concat(&arena, plfFolder, device, ARUPDATER_MANAGER_FOLDER_SEPARATOR, NULL) : NULL;
         if (!deviceFolder) {
             error = ARUPDATER_ERROR_ALLOC;
         } else {
-            strcpy(deviceFolder, plfFolder);
-            strcat(deviceFolder, device);
-            strcat(deviceFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
             error = ARUPDATER_Utils_GetPlfInFolder(deviceFolder, &fileName);
         }
 
         if (error == ARUPDATER_OK)
         {
             // file path = deviceFolder + plfFilename + \0
-            existingPlfFilePath = malloc(strlen(deviceFolder) + strlen(fileName) + 1);
+            existingPlfFilePath = ARUPDATER_Arena_Concat(&arena, deviceFolder, fileName, NULL);
             if (!existingPlfFilePath) {
                 error = ARUPDATER_ERROR_ALLOC;
             } else {
-                strcpy(existingPlfFilePath, deviceFolder);
-                strcat(existingPlfFilePath, fileName);
-
                 error = ARUPDATER_Utils_ReadPlfVersion(existingPlfFilePath, &v);
             }
         }
@@ -559,34 +554,25 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
         if (error == ARUPDATER_OK)
         {
             char buffer[ARUPDATER_DOWNLOADER_VERSION_BUFFER_MAX_LENGHT];
-            // create the url params
-            char *params = malloc(ARUPDATER_DOWNLOADER_PARAM_MAX_LENGTH);
-            strcpy(params, ARUPDATER_DOWNLOADER_PRODUCT_PARAM);
-            strcat(params, device);
-
-            strcat(params, ARUPDATER_DOWNLOADER_SERIAL_PARAM);
-            strcat(params, ARUPDATER_DOWNLOADER_SERIAL_DEFAULT_VALUE);
-
-            strcat(params, ARUPDATER_DOWNLOADER_VERSION_PARAM);
+            // create the url
             ARUPDATER_Utils_PlfVersionToString(&v, buffer, sizeof(buffer));
-            strcat(params, buffer);
-
-            strcat(params, ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM);
-            strcat(params, platform);
-
-            strcat(params, ARUPDATER_DOWNLOADER_APP_VERSION_PARAM);
-            strcat(params, manager->downloader->appVersion);
-
-            char *endUrl = malloc(strlen(ARUPDATER_DOWNLOADER_BEGIN_URL) + strlen(device) + strlen(ARUPDATER_DOWNLOADER_PHP_URL) + strlen(params) + 1);
-            strcpy(endUrl, ARUPDATER_DOWNLOADER_BEGIN_URL);
-            strcat(endUrl, device);
-            strcat(endUrl, ARUPDATER_DOWNLOADER_PHP_URL);
-            strcat(endUrl, params);
-
-            utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
-            if (utilsError != ARUTILS_OK)
+            char *endUrl = ARUPDATER_Arena_Concat(&arena, ARUPDATER_DOWNLOADER_BEGIN_URL, device, ARUPDATER_DOWNLOADER_PHP_URL,
+                                                  ARUPDATER_DOWNLOADER_PRODUCT_PARAM, device,
+                                                  ARUPDATER_DOWNLOADER_SERIAL_PARAM, ARUPDATER_DOWNLOADER_SERIAL_DEFAULT_VALUE,
+                                                  ARUPDATER_DOWNLOADER_VERSION_PARAM, buffer,
+                                                  ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM, platform,
+                                                  ARUPDATER_DOWNLOADER_APP_VERSION_PARAM, manager->downloader->appVersion, NULL);
+            if (endUrl == NULL)
             {
-                error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                error = ARUPDATER_ERROR_ALLOC;
+            }
+            else
+            {
+                utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
+                if (utilsError != ARUTILS_OK)
+                {
+                    error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                }
             }
 
             ARSAL_Mutex_Lock(&manager->downloader->requestLock);
@@ -597,11 +583,6 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
                 ARSAL_Sem_Destroy(&requestSem);
             }
             ARSAL_Mutex_Unlock(&manager->downloader->requestLock);
-
-            free(endUrl);
-            endUrl = NULL;
-            free(params);
-            params = NULL;
         }
 
         // check if plf file need to be updated
@@ -642,21 +623,9 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
             }
         }
 
-        if (deviceFolder != NULL)
-        {
-            free(deviceFolder);
-            deviceFolder = NULL;
-        }
-        if (existingPlfFilePath != NULL)
-        {
-            free(existingPlfFilePath);
-            existingPlfFilePath = NULL;
-        }
-        if (device != NULL)
-        {
-            free(device);
-            device = NULL;
-        }
+        deviceFolder = NULL;
+        existingPlfFilePath = NULL;
+        device = NULL;
         if (dataPtr != NULL)
         {
             free(dataPtr);
@@ -667,7 +636,7 @@ int ARUPDATER_Downloader_CheckUpdatesSync(ARUPDATER_Manager_t *manager, eARUPDAT
     }
 
 end:
-    free(plfFolder);
+    ARUPDATER_Arena_Release(&arena);
     plfFolder = NULL;
 
     if (err != NULL)
@@ -990,6 +959,7 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
     json_object *jsonObj = NULL;
     array_list *blacklistedRemoteList = NULL;
     char *device = NULL;
+    ARUPDATER_Arena_t arena;
 
     if (manager == NULL)
     {
@@ -1000,6 +970,8 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
         return ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
     }
 
+    ARUPDATER_Arena_Init(&arena);
+
     if (alsoCheckRemote != 0)
     {
         if (error == ARUPDATER_OK)
@@ -1038,25 +1010,22 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
         // request the php
         if (error == ARUPDATER_OK)
         {
-            // create the url params
-            char *params = malloc(ARUPDATER_DOWNLOADER_PARAM_MAX_LENGTH);
-
-            strcpy(params, ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM_BEGIN);
-            strcat(params, platform);
-
-            strcat(params, ARUPDATER_DOWNLOADER_APP_VERSION_PARAM);
-            strcat(params, manager->downloader->appVersion);
-
-            char *endUrl = malloc(strlen(ARUPDATER_DOWNLOADER_BEGIN_URL) + strlen(ARUPDATER_DOWNLOADER_PHP_BLACKLIST_FIRM_URL) + strlen(params) + 1);
-            strcpy(endUrl, ARUPDATER_DOWNLOADER_BEGIN_URL);
-            strcat(endUrl, ARUPDATER_DOWNLOADER_PHP_BLACKLIST_FIRM_URL);
-            strcat(endUrl, params);
-
-            utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestBlacklistConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
-            if (utilsError != ARUTILS_OK)
+            // create the url
+            char *endUrl = ARUPDATER_Arena_Concat(&arena, ARUPDATER_DOWNLOADER_BEGIN_URL, ARUPDATER_DOWNLOADER_PHP_BLACKLIST_FIRM_URL,
+                                                  ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM_BEGIN, platform,
+                                                  ARUPDATER_DOWNLOADER_APP_VERSION_PARAM, manager->downloader->appVersion, NULL);
+            if (endUrl == NULL)
             {
-                ARSAL_PRINT (ARSAL_PRINT_ERROR, ARUPDATER_DOWNLOADER_TAG, "Error : %d", utilsError);
-                error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                error = ARUPDATER_ERROR_ALLOC;
+            }
+            else
+            {
+                utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestBlacklistConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
+                if (utilsError != ARUTILS_OK)
+                {
+                    ARSAL_PRINT (ARSAL_PRINT_ERROR, ARUPDATER_DOWNLOADER_TAG, "Error : %d", utilsError);
+                    error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                }
             }
             ARSAL_Mutex_Lock(&manager->downloader->requestBlacklistLock);
             if (manager->downloader->requestBlacklistConnection != NULL)
@@ -1066,10 +1035,6 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
                 ARSAL_Sem_Destroy(&requestSem);
             }
             ARSAL_Mutex_Unlock(&manager->downloader->requestBlacklistLock);
-            free(endUrl);
-            endUrl = NULL;
-            free(params);
-            params = NULL;
         }
 
         // use blacklist info from server
@@ -1112,10 +1077,9 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
                 json_object *productJsonObj = NULL;
                 uint16_t productId = ARDISCOVERY_getProductID(manager->downloader->blacklistedVersions[i]->product);
 
-                device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-                snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
+                device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
 
-                if (json_object_is_type(jsonObj, json_type_object))
+                if ((device != NULL) && json_object_is_type(jsonObj, json_type_object))
                 {
                     productJsonObj = json_object_object_get (jsonObj, device);
                 }
@@ -1163,11 +1127,7 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
                     }
                 }
 
-                if (device != NULL)
-                {
-                    free(device);
-                    device = NULL;
-                }
+                device = NULL;
             }
         }
     }
@@ -1176,6 +1136,7 @@ eARUPDATER_ERROR ARUPDATER_Downloader_GetBlacklistedFirmwareVersionsSync(ARUPDAT
     {
         json_object_put(jsonObj);
     }
+    ARUPDATER_Arena_Release(&arena);
 
     if (manager && manager->downloader && blacklistedFirmwares)
         *blacklistedFirmwares = manager->downloader->blacklistedVersions;
@@ -1210,6 +1171,9 @@ int ARUPDATER_Downloader_GetUpdatesInfoSync(ARUPDATER_Manager_t *manager, eARUPD
     char *data;
     ARSAL_Sem_t requestSem;
     char *platform = NULL;
+    ARUPDATER_Arena_t arena;
+
+    ARUPDATER_Arena_Init(&arena);
 
     if (error == ARUPDATER_OK)
     {
@@ -1230,8 +1194,11 @@ int ARUPDATER_Downloader_GetUpdatesInfoSync(ARUPDATER_Manager_t *manager, eARUPD
         // for each product, check if update is needed
         uint16_t productId = ARDISCOVERY_getProductID(product);
 
-        device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-        snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
+        device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
+        if (device == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
 
         // init the request semaphore
         ARSAL_Mutex_Lock(&manager->downloader->requestLock);
@@ -1259,42 +1226,27 @@ int ARUPDATER_Downloader_GetUpdatesInfoSync(ARUPDATER_Manager_t *manager, eARUPD
         // request the php
         if (error == ARUPDATER_OK)
         {
-            char buffer[ARUPDATER_DOWNLOADER_VERSION_BUFFER_MAX_LENGHT];
-            // create the url params
-            char *params = malloc(ARUPDATER_DOWNLOADER_PARAM_MAX_LENGTH);
-            strcpy(params, ARUPDATER_DOWNLOADER_PRODUCT_PARAM);
-            strcat(params, device);
-
-            strcat(params, ARUPDATER_DOWNLOADER_SERIAL_PARAM);
-            strcat(params, ARUPDATER_DOWNLOADER_SERIAL_DEFAULT_VALUE);
-
-            strcat(params, ARUPDATER_DOWNLOADER_VERSION_PARAM);
-            sprintf(buffer,"%i",version);
-            strncat(params, buffer, strlen(buffer));
-            strcat(params, ARUPDATER_DOWNLOADER_VERSION_SEPARATOR);
-            sprintf(buffer,"%i",edit);
-            strncat(params, buffer, strlen(buffer));
-            strcat(params, ARUPDATER_DOWNLOADER_VERSION_SEPARATOR);
-            sprintf(buffer,"%i",ext);
-            strncat(params, buffer, strlen(buffer));
-
-            strcat(params, ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM);
-            strcat(params, platform);
-
-            strcat(params, ARUPDATER_DOWNLOADER_APP_VERSION_PARAM);
-            strcat(params, manager->downloader->appVersion);
-
-            char *endUrl = malloc(strlen(ARUPDATER_DOWNLOADER_BEGIN_URL) + strlen(device) + strlen(ARUPDATER_DOWNLOADER_PHP_URL) + strlen(params) + 1);
-            strcpy(endUrl, ARUPDATER_DOWNLOADER_BEGIN_URL);
-            strcat(endUrl, device);
-            strcat(endUrl, ARUPDATER_DOWNLOADER_PHP_URL);
-            strcat(endUrl, params);
-            ARSAL_PRINT (ARSAL_PRINT_DEBUG, ARUPDATER_DOWNLOADER_TAG, "%s", endUrl);
-            utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
-            if (utilsError != ARUTILS_OK)
+            // create the url
+            char *endUrl = ARUPDATER_Arena_Printf(&arena, "%s%s%s%s%s%s%s%s%i%s%i%s%i%s%s%s%s",
+                                                  ARUPDATER_DOWNLOADER_BEGIN_URL, device, ARUPDATER_DOWNLOADER_PHP_URL,
+                                                  ARUPDATER_DOWNLOADER_PRODUCT_PARAM, device,
+                                                  ARUPDATER_DOWNLOADER_SERIAL_PARAM, ARUPDATER_DOWNLOADER_SERIAL_DEFAULT_VALUE,
+                                                  ARUPDATER_DOWNLOADER_VERSION_PARAM, version, ARUPDATER_DOWNLOADER_VERSION_SEPARATOR, edit, ARUPDATER_DOWNLOADER_VERSION_SEPARATOR, ext,
+                                                  ARUPDATER_DOWNLOADER_APP_PLATFORM_PARAM, platform,
+                                                  ARUPDATER_DOWNLOADER_APP_VERSION_PARAM, manager->downloader->appVersion);
+            if (endUrl == NULL)
             {
-                ARSAL_PRINT (ARSAL_PRINT_DEBUG, ARUPDATER_DOWNLOADER_TAG, "%d", utilsError);
-                error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                error = ARUPDATER_ERROR_ALLOC;
+            }
+            else
+            {
+                ARSAL_PRINT (ARSAL_PRINT_DEBUG, ARUPDATER_DOWNLOADER_TAG, "%s", endUrl);
+                utilsError = ARUTILS_Http_Get_WithBuffer(manager->downloader->requestConnection, endUrl, (uint8_t**)&dataPtr, &dataSize, NULL, NULL);
+                if (utilsError != ARUTILS_OK)
+                {
+                    ARSAL_PRINT (ARSAL_PRINT_DEBUG, ARUPDATER_DOWNLOADER_TAG, "%d", utilsError);
+                    error = ARUPDATER_ERROR_DOWNLOADER_ARUTILS_ERROR;
+                }
             }
 
             ARSAL_Mutex_Lock(&manager->downloader->requestLock);
@@ -1305,10 +1257,6 @@ int ARUPDATER_Downloader_GetUpdatesInfoSync(ARUPDATER_Manager_t *manager, eARUPD
                 ARSAL_Sem_Destroy(&requestSem);
             }
             ARSAL_Mutex_Unlock(&manager->downloader->requestLock);
-            free(endUrl);
-            endUrl = NULL;
-            free(params);
-            params = NULL;
         }
 
         // check if plf file need to be updated
@@ -1347,15 +1295,13 @@ int ARUPDATER_Downloader_GetUpdatesInfoSync(ARUPDATER_Manager_t *manager, eARUPD
                 error = ARUPDATER_ERROR_DOWNLOADER_PHP_ERROR;
             }
         }
-        if (device != NULL)
-        {
-            free(device);
-            device = NULL;
-        }
+        device = NULL;
 
         productIndex++;
     }
 
+    ARUPDATER_Arena_Release(&arena);
+
     if (err != NULL)
     {
         *err = error;
@@ -0,0 +1,213 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_EventRing.c
+ * @brief libARUpdater single producer, single consumer event ring
+ **/
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include "ARUPDATER_EventRing.h"
+
+#define ARUPDATER_EVENTRING_MASK (ARUPDATER_EVENTRING_SIZE - 1)
+
+static void ARUPDATER_EventRing_Signal(ARUPDATER_EventRing_t *ring)
+{
+    uint64_t one = 1;
+    ssize_t ret;
+
+    /* a full pipe or eventfd is already readable */
+    do
+    {
+        ret = write(ring->fds[1], &one, sizeof(one));
+    } while ((ret < 0) && (errno == EINTR));
+}
+
+int ARUPDATER_EventRing_Init(ARUPDATER_EventRing_t *ring)
+{
+    if (ring == NULL)
+    {
+        return -EINVAL;
+    }
+
+    memset(ring, 0, sizeof(*ring));
+
+#if defined(__linux__)
+    ring->fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ring->fds[0] < 0)
+    {
+        ring->fds[1] = -1;
+        return -errno;
+    }
+    ring->fds[1] = ring->fds[0];
+#else
+    if (pipe(ring->fds) < 0)
+    {
+        ring->fds[0] = ring->fds[1] = -1;
+        return -errno;
+    }
+    fcntl(ring->fds[0], F_SETFL, fcntl(ring->fds[0], F_GETFL, 0) | O_NONBLOCK);
+    fcntl(ring->fds[1], F_SETFL, fcntl(ring->fds[1], F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    return 0;
+}
+
+void ARUPDATER_EventRing_Destroy(ARUPDATER_EventRing_t *ring)
+{
+    if (ring != NULL)
+    {
+        if (ring->fds[0] >= 0)
+        {
+            close(ring->fds[0]);
+        }
+        if ((ring->fds[1] >= 0) && (ring->fds[1] != ring->fds[0]))
+        {
+            close(ring->fds[1]);
+        }
+        ring->fds[0] = ring->fds[1] = -1;
+    }
+}
+
+void ARUPDATER_EventRing_Reset(ARUPDATER_EventRing_t *ring)
+{
+    ARUPDATER_Event_t events[ARUPDATER_EVENTRING_SIZE];
+
+    /* clear the wakeup */
+    ARUPDATER_EventRing_Pop(ring, events, ARUPDATER_EVENTRING_SIZE);
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->overflowStatus = 0;
+}
+
+int ARUPDATER_EventRing_Push(ARUPDATER_EventRing_t *ring, const ARUPDATER_Event_t *event)
+{
+    unsigned int head = ring->head;
+    unsigned int tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    ARUPDATER_Event_t *slot;
+
+    if (head - tail >= ARUPDATER_EVENTRING_SIZE)
+    {
+        if (event->type == ARUPDATER_EVENT_PROGRESS)
+        {
+            ring->dropped++;
+            return -ENOBUFS;
+        }
+
+        /* the first status is the one that counts */
+        if (__atomic_load_n(&ring->overflowStatus, __ATOMIC_RELAXED) == 0)
+        {
+            ring->overflowEvent = *event;
+            clock_gettime(CLOCK_MONOTONIC, &ring->overflowEvent.timestamp);
+            __atomic_store_n(&ring->overflowStatus, 1, __ATOMIC_RELEASE);
+        }
+        ARUPDATER_EventRing_Signal(ring);
+        return 0;
+    }
+
+    slot = &ring->events[head & ARUPDATER_EVENTRING_MASK];
+    *slot = *event;
+    clock_gettime(CLOCK_MONOTONIC, &slot->timestamp);
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_SEQ_CST);
+
+    /* the consumer may sleep only once it took every event before this one: tail is read
+     * again after head is published, as the pop reads head again after publishing tail,
+     * so that one of them at least sees the other and signals */
+    if (__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head)
+    {
+        ARUPDATER_EventRing_Signal(ring);
+    }
+
+    return 0;
+}
+
+int ARUPDATER_EventRing_Pop(ARUPDATER_EventRing_t *ring, ARUPDATER_Event_t *events, int max)
+{
+    uint64_t counter;
+    unsigned int head, tail;
+    ssize_t ret;
+    int count = 0;
+
+    /* clear the wakeup before looking at the ring */
+    do
+    {
+        ret = read(ring->fds[0], &counter, sizeof(counter));
+    } while ((ret > 0) || ((ret < 0) && (errno == EINTR)));
+
+    tail = ring->tail;
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    while ((tail != head) && (count < max))
+    {
+        events[count++] = ring->events[tail & ARUPDATER_EVENTRING_MASK];
+        tail++;
+    }
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+
+    /* events left for the next pop, or pushed by a producer that saw the old tail */
+    head = __atomic_load_n(&ring->head, __ATOMIC_SEQ_CST);
+    if (tail != head)
+    {
+        ARUPDATER_EventRing_Signal(ring);
+    }
+    else if (__atomic_load_n(&ring->overflowStatus, __ATOMIC_ACQUIRE) != 0)
+    {
+        /* the status that didn't fit comes after everything before it */
+        if (count < max)
+        {
+            events[count++] = ring->overflowEvent;
+            __atomic_store_n(&ring->overflowStatus, 0, __ATOMIC_RELEASE);
+        }
+        else
+        {
+            ARUPDATER_EventRing_Signal(ring);
+        }
+    }
+
+    return count;
+}
+
+void ARUPDATER_EventRing_Wake(ARUPDATER_EventRing_t *ring)
+{
+    ARUPDATER_EventRing_Signal(ring);
+}
+
+int ARUPDATER_EventRing_GetFd(const ARUPDATER_EventRing_t *ring)
+{
+    return ring->fds[0];
+}
@@ -0,0 +1,127 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_EventRing.h
+ * @brief libARUpdater single producer, single consumer event ring header file.
+ * @details One thread pushes events and another one pops them, without lock. The consumer
+ * sleeps on ARUPDATER_EventRing_GetFd() (an eventfd, or a pipe where there is none) which
+ * is signaled when an event is pushed into an empty ring. Progress events pushed into a
+ * full ring are dropped, the next one supersedes them; a status is never lost.
+ **/
+
+#ifndef _ARUPDATER_EVENTRING_PRIVATE_H_
+#define _ARUPDATER_EVENTRING_PRIVATE_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+/* number of events of a ring, a power of two */
+#define ARUPDATER_EVENTRING_SIZE 64
+
+typedef enum
+{
+    ARUPDATER_EVENT_PROGRESS = 0,       /* bytes acknowledged by the remote */
+    ARUPDATER_EVENT_STATUS,             /* end of the transfer */
+} eARUPDATER_EVENT_TYPE;
+
+typedef struct
+{
+    eARUPDATER_EVENT_TYPE type;
+    eARUPDATER_ERROR status;            /* ARUPDATER_EVENT_STATUS only */
+    uint32_t chunkId;                   /* last chunk acknowledged */
+    uint64_t bytesAcked;
+    struct timespec timestamp;
+} ARUPDATER_Event_t;
+
+typedef struct
+{
+    ARUPDATER_Event_t events[ARUPDATER_EVENTRING_SIZE];
+    unsigned int head;                  /* next event pushed, written by the producer */
+    unsigned int tail;                  /* next event popped, written by the consumer */
+    unsigned int dropped;               /* progress events dropped in a full ring */
+    int overflowStatus;                 /* a status pushed into a full ring is kept here */
+    ARUPDATER_Event_t overflowEvent;
+    int fds[2];                         /* read and write ends of the wakeup, the same eventfd twice when there is one */
+} ARUPDATER_EventRing_t;
+
+/**
+ * @brief Initialize an empty ring
+ * @param ring : the ring
+ * @return 0 if operation went well, a negative errno otherwise
+ */
+int ARUPDATER_EventRing_Init(ARUPDATER_EventRing_t *ring);
+
+/**
+ * @brief Free the resources of a ring
+ * @param ring : the ring
+ */
+void ARUPDATER_EventRing_Destroy(ARUPDATER_EventRing_t *ring);
+
+/**
+ * @brief Empty a ring, only when neither the producer nor the consumer runs
+ * @param ring : the ring
+ */
+void ARUPDATER_EventRing_Reset(ARUPDATER_EventRing_t *ring);
+
+/**
+ * @brief Push an event, from the producer thread
+ * @param ring : the ring
+ * @param[in] event : the event, its timestamp is set by the ring
+ * @return 0 if the event was pushed, -ENOBUFS if a progress event was dropped
+ */
+int ARUPDATER_EventRing_Push(ARUPDATER_EventRing_t *ring, const ARUPDATER_Event_t *event);
+
+/**
+ * @brief Pop the pending events, from the consumer thread
+ * @details Clears the wakeup first, so an event pushed while popping signals it again. The
+ * wakeup is signaled again when more than max events, or the status of a full ring, are pending.
+ * @param ring : the ring
+ * @param[out] events : the events, oldest first
+ * @param[in] max : size of events
+ * @return the number of events popped
+ */
+int ARUPDATER_EventRing_Pop(ARUPDATER_EventRing_t *ring, ARUPDATER_Event_t *events, int max);
+
+/**
+ * @brief Wake the consumer without event, from any thread
+ * @param ring : the ring
+ */
+void ARUPDATER_EventRing_Wake(ARUPDATER_EventRing_t *ring);
+
+/**
+ * @brief Get the file descriptor readable when events are pending
+ * @param ring : the ring
+ * @return the file descriptor
+ */
+int ARUPDATER_EventRing_GetFd(const ARUPDATER_EventRing_t *ring);
+
+#endif /* _ARUPDATER_EVENTRING_PRIVATE_H_ */
@@ -0,0 +1,171 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_FileMap.c
+ * @brief libARUpdater read only view of a file
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <libARSAL/ARSAL_Print.h>
+
+#include "ARUPDATER_FileMap.h"
+
+#define ARUPDATER_FILEMAP_TAG   "ARUPDATER_FileMap"
+
+int ARUPDATER_FileMap_Open(ARUPDATER_FileMap_t *map, int fd, size_t size, size_t chunkSize, int useMmap)
+{
+    int ret = 0;
+
+    if ((map == NULL) || (fd < 0) || (chunkSize == 0))
+    {
+        return -EINVAL;
+    }
+
+    memset(map, 0, sizeof(*map));
+    map->fd = fd;
+    map->size = size;
+    map->bufferSize = chunkSize;
+    map->pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    if ((map->pageSize == 0) || (map->pageSize == (size_t)-1))
+    {
+        map->pageSize = 4096;
+    }
+
+    if ((useMmap != 0) && (size > 0))
+    {
+        void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            /* chunks are sent in order, let the kernel read ahead */
+            madvise(data, size, MADV_SEQUENTIAL);
+            map->data = data;
+        }
+        else
+        {
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_FILEMAP_TAG, "mmap failed (%s), reading the file", strerror(errno));
+        }
+    }
+
+    if (map->data == NULL)
+    {
+        map->buffer = malloc(chunkSize);
+        if (map->buffer == NULL)
+        {
+            ret = -ENOMEM;
+        }
+    }
+
+    return ret;
+}
+
+const void *ARUPDATER_FileMap_Get(ARUPDATER_FileMap_t *map, off_t offset, size_t length, size_t *got)
+{
+    const void *chunk = NULL;
+    size_t available = 0;
+
+    if ((map != NULL) && (offset >= 0) && ((size_t)offset < map->size) && (length <= map->bufferSize))
+    {
+        available = map->size - (size_t)offset;
+        if (available > length)
+        {
+            available = length;
+        }
+
+        if (map->data != NULL)
+        {
+            chunk = map->data + offset;
+        }
+        else
+        {
+            ssize_t readSize = pread(map->fd, map->buffer, available, offset);
+            if (readSize > 0)
+            {
+                available = (size_t)readSize;
+                chunk = map->buffer;
+            }
+            else
+            {
+                ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FILEMAP_TAG, "read error at %lld: %s", (long long)offset, (readSize < 0) ? strerror(errno) : "end of file");
+                available = 0;
+            }
+        }
+    }
+
+    if (got != NULL)
+    {
+        *got = available;
+    }
+
+    return chunk;
+}
+
+void ARUPDATER_FileMap_Prefetch(ARUPDATER_FileMap_t *map, off_t offset, size_t length)
+{
+    size_t start, end;
+
+    if ((map == NULL) || (offset < 0) || ((size_t)offset >= map->size) || (length == 0))
+    {
+        return;
+    }
+
+    /* madvise needs a page aligned address */
+    start = (size_t)offset & ~(map->pageSize - 1);
+    end = ((map->size - (size_t)offset) > length) ? (size_t)offset + length : map->size;
+
+    if (map->data != NULL)
+    {
+        madvise((void *)(map->data + start), end - start, MADV_WILLNEED);
+    }
+    else
+    {
+        posix_fadvise(map->fd, (off_t)start, (off_t)(end - start), POSIX_FADV_WILLNEED);
+    }
+}
+
+void ARUPDATER_FileMap_Close(ARUPDATER_FileMap_t *map)
+{
+    if (map != NULL)
+    {
+        if (map->data != NULL)
+        {
+            munmap((void *)map->data, map->size);
+            map->data = NULL;
+        }
+        free(map->buffer);
+        map->buffer = NULL;
+    }
+}
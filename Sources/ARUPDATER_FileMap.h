@@ -0,0 +1,93 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_FileMap.h
+ * @brief libARUpdater read only view of a file header file.
+ * @details The file is memory mapped when possible, chunks are then pointers into the
+ * mapping and are never copied. When it can't be mapped, chunks are read into a buffer.
+ * The next chunks can be prefetched so that getting them needs no disk access.
+ **/
+
+#ifndef _ARUPDATER_FILEMAP_PRIVATE_H_
+#define _ARUPDATER_FILEMAP_PRIVATE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct
+{
+    int fd;
+    size_t size;
+    const uint8_t *data;            /* the mapping, NULL when the file is read */
+    uint8_t *buffer;                /* chunk buffer of the read fallback */
+    size_t bufferSize;
+    size_t pageSize;
+} ARUPDATER_FileMap_t;
+
+/**
+ * @brief Open a view of a file
+ * @param map : the view
+ * @param[in] fd : the file, it must stay open until ARUPDATER_FileMap_Close()
+ * @param[in] size : size of the file
+ * @param[in] chunkSize : largest chunk asked to ARUPDATER_FileMap_Get()
+ * @param[in] useMmap : 1 to map the file, 0 to always read it
+ * @return 0 if operation went well, a negative errno otherwise
+ */
+int ARUPDATER_FileMap_Open(ARUPDATER_FileMap_t *map, int fd, size_t size, size_t chunkSize, int useMmap);
+
+/**
+ * @brief Get a chunk of the file
+ * @param map : the view
+ * @param[in] offset : offset of the chunk in the file
+ * @param[in] length : length wanted, at most the chunkSize given to ARUPDATER_FileMap_Open()
+ * @param[out] got : length of the chunk, shorter at the end of the file
+ * @return the chunk, valid until the next call, NULL at the end of the file or on a read error
+ */
+const void *ARUPDATER_FileMap_Get(ARUPDATER_FileMap_t *map, off_t offset, size_t length, size_t *got);
+
+/**
+ * @brief Start reading a part of the file in the background
+ * @details The kernel reads it into the page cache and the call returns at once, a later
+ * ARUPDATER_FileMap_Get() of this part then needs no disk access.
+ * @param map : the view
+ * @param[in] offset : offset of the part in the file
+ * @param[in] length : length of the part
+ */
+void ARUPDATER_FileMap_Prefetch(ARUPDATER_FileMap_t *map, off_t offset, size_t length);
+
+/**
+ * @brief Close a view, the file itself is not closed
+ * @param map : the view
+ */
+void ARUPDATER_FileMap_Close(ARUPDATER_FileMap_t *map);
+
+#endif /* _ARUPDATER_FILEMAP_PRIVATE_H_ */
@@ -0,0 +1,527 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Fleet.c
+ * @brief libARUpdater Fleet c file.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libARSAL/ARSAL_Print.h>
+#include <libARSAL/ARSAL_Thread.h>
+
+#include "ARUPDATER_Manager.h"
+#include "ARUPDATER_Uploader.h"
+#include "ARUPDATER_Manifest.h"
+#include "ARUPDATER_Utils.h"
+#include "ARUPDATER_Arena.h"
+#include "ARUPDATER_Fleet.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+#define ARUPDATER_FLEET_TAG                 "ARUPDATER_Fleet"
+#define ARUPDATER_FLEET_SUFFIX_SIZE         16
+
+/* ***************************************
+ *
+ *             implementation :
+ *
+ *****************************************/
+
+static void ARUPDATER_Fleet_TargetProgressCallback(void *arg, float percent)
+{
+    ARUPDATER_FleetTarget_t *target = (ARUPDATER_FleetTarget_t *)arg;
+
+    if (target->fleet->progressCallback != NULL)
+    {
+        target->fleet->progressCallback(target->fleet->progressArg, target->index, percent);
+    }
+}
+
+static void ARUPDATER_Fleet_TargetCompletionCallback(void *arg, eARUPDATER_ERROR error)
+{
+    ARUPDATER_FleetTarget_t *target = (ARUPDATER_FleetTarget_t *)arg;
+
+    target->error = error;
+    if (target->fleet->completionCallback != NULL)
+    {
+        target->fleet->completionCallback(target->fleet->completionArg, target->index, error);
+    }
+}
+
+ARUPDATER_Fleet_t *ARUPDATER_Fleet_New(const char *const rootFolder, ARSAL_MD5_Manager_t *md5Manager, eARDISCOVERY_PRODUCT product, int maxParallelUploads, ARUPDATER_Fleet_TargetProgressCallback_t progressCallback, void *progressArg, ARUPDATER_Fleet_TargetCompletionCallback_t completionCallback, void *completionArg, eARUPDATER_ERROR *error)
+{
+    ARUPDATER_Fleet_t *fleet = NULL;
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    int mutexInitialized = 0;
+
+    if ((rootFolder == NULL) || (md5Manager == NULL) || (maxParallelUploads < 0))
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        fleet = calloc(1, sizeof(ARUPDATER_Fleet_t));
+        if (fleet == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        int stringLen = strlen(rootFolder);
+        fleet->rootFolder = malloc(stringLen + strlen(ARUPDATER_MANAGER_FOLDER_SEPARATOR) + 1);
+        if (fleet->rootFolder == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+        else
+        {
+            strcpy(fleet->rootFolder, rootFolder);
+            if ((stringLen == 0) || (rootFolder[stringLen - 1] != '/'))
+            {
+                strcat(fleet->rootFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
+            }
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        if (ARSAL_Mutex_Init(&fleet->fleetLock) != 0)
+        {
+            err = ARUPDATER_ERROR_SYSTEM;
+        }
+        else
+        {
+            mutexInitialized = 1;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        fleet->product = product;
+        fleet->md5Manager = md5Manager;
+        fleet->maxParallelUploads = maxParallelUploads;
+        fleet->progressCallback = progressCallback;
+        fleet->progressArg = progressArg;
+        fleet->completionCallback = completionCallback;
+        fleet->completionArg = completionArg;
+    }
+
+    if ((err != ARUPDATER_OK) && (fleet != NULL))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FLEET_TAG, "error: %s", ARUPDATER_Error_ToString(err));
+        if (mutexInitialized)
+        {
+            ARSAL_Mutex_Destroy(&fleet->fleetLock);
+        }
+        free(fleet->rootFolder);
+        free(fleet);
+        fleet = NULL;
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return fleet;
+}
+
+void ARUPDATER_Fleet_Delete(ARUPDATER_Fleet_t **fleet)
+{
+    int i = 0;
+
+    if ((fleet != NULL) && (*fleet != NULL))
+    {
+        if ((*fleet)->isRunning != 0)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FLEET_TAG, "fleet deleted while running");
+            return;
+        }
+
+        for (i = 0; i < (*fleet)->targetCount; i++)
+        {
+            ARUPDATER_Manager_Delete(&(*fleet)->targets[i]->manager);
+            free((*fleet)->targets[i]);
+        }
+        free((*fleet)->targets);
+        ARSAL_Mutex_Destroy(&(*fleet)->fleetLock);
+        free((*fleet)->rootFolder);
+        free(*fleet);
+        *fleet = NULL;
+    }
+}
+
+int ARUPDATER_Fleet_AddTarget(ARUPDATER_Fleet_t *fleet, struct mux_ctx *mux, ARUTILS_Manager_t *ftpManager, int isAndroidApp, eARUPDATER_ERROR *error)
+{
+    if (fleet == NULL)
+    {
+        if (error != NULL)
+        {
+            *error = ARUPDATER_ERROR_BAD_PARAMETER;
+        }
+        return -1;
+    }
+
+    return ARUPDATER_Fleet_AddProductTarget(fleet, mux, ftpManager, isAndroidApp, fleet->product, error);
+}
+
+int ARUPDATER_Fleet_AddProductTarget(ARUPDATER_Fleet_t *fleet, struct mux_ctx *mux, ARUTILS_Manager_t *ftpManager, int isAndroidApp, eARDISCOVERY_PRODUCT product, eARUPDATER_ERROR *error)
+{
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    ARUPDATER_FleetTarget_t *target = NULL;
+    ARUPDATER_FleetTarget_t **targets = NULL;
+    char suffix[ARUPDATER_FLEET_SUFFIX_SIZE];
+    int index = -1;
+
+    if ((fleet == NULL) || (ftpManager == NULL))
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (fleet->isRunning != 0)
+    {
+        err = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        target = calloc(1, sizeof(ARUPDATER_FleetTarget_t));
+        targets = realloc(fleet->targets, (fleet->targetCount + 1) * sizeof(ARUPDATER_FleetTarget_t *));
+        if (targets != NULL)
+        {
+            fleet->targets = targets;
+        }
+        if ((target == NULL) || (targets == NULL))
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        target->fleet = fleet;
+        target->index = fleet->targetCount;
+        target->product = product;
+        target->error = ARUPDATER_OK;
+        target->manager = ARUPDATER_Manager_New(&err);
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        err = ARUPDATER_Uploader_New(target->manager, fleet->rootFolder, mux, ftpManager, fleet->md5Manager, isAndroidApp, product, ARUPDATER_Fleet_TargetProgressCallback, target, ARUPDATER_Fleet_TargetCompletionCallback, target);
+    }
+
+    /* uploads of a fleet share the local plf folder */
+    if (err == ARUPDATER_OK)
+    {
+        snprintf(suffix, sizeof(suffix), ".%d", target->index);
+        err = ARUPDATER_Uploader_SetLocalFileSuffix(target->manager, suffix);
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        fleet->targets[fleet->targetCount] = target;
+        index = fleet->targetCount;
+        fleet->targetCount++;
+    }
+    else if (target != NULL)
+    {
+        ARUPDATER_Manager_Delete(&target->manager);
+        free(target);
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return index;
+}
+
+ARUPDATER_Manager_t *ARUPDATER_Fleet_GetTargetManager(ARUPDATER_Fleet_t *fleet, int targetIndex)
+{
+    if ((fleet == NULL) || (targetIndex < 0) || (targetIndex >= fleet->targetCount))
+    {
+        return NULL;
+    }
+
+    return fleet->targets[targetIndex]->manager;
+}
+
+eARUPDATER_ERROR ARUPDATER_Fleet_GetTargetError(ARUPDATER_Fleet_t *fleet, int targetIndex)
+{
+    if ((fleet == NULL) || (targetIndex < 0) || (targetIndex >= fleet->targetCount))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    return fleet->targets[targetIndex]->error;
+}
+
+/* compute the md5 and the manifest of the plf of a product once for all its targets */
+static ARUPDATER_Manifest_t *ARUPDATER_Fleet_ComputeDigest(ARUPDATER_Fleet_t *fleet, eARDISCOVERY_PRODUCT product, uint8_t *md5, eARUPDATER_ERROR *error)
+{
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    ARUPDATER_Manifest_t *manifest = NULL;
+    ARUPDATER_Arena_t arena;
+    char *folder = NULL;
+    char *filePath = NULL;
+    char md5Txt[ARSAL_MD5_LENGTH * 2 + 1];
+    char *fileName = NULL;
+    int i = 0;
+
+    ARUPDATER_Arena_Init(&arena);
+
+    folder = ARUPDATER_Arena_Printf(&arena, "%s%s%04x%s", fleet->rootFolder, ARUPDATER_MANAGER_PLF_FOLDER,
+                                    ARDISCOVERY_getProductID(product), ARUPDATER_MANAGER_FOLDER_SEPARATOR);
+    if (folder == NULL)
+    {
+        err = ARUPDATER_ERROR_ALLOC;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        err = ARUPDATER_Utils_GetPlfInFolder(folder, &fileName);
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        filePath = ARUPDATER_Arena_Concat(&arena, folder, fileName, NULL);
+        if (filePath == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        if (ARSAL_MD5_Manager_Compute(fleet->md5Manager, filePath, md5, ARSAL_MD5_LENGTH) != ARSAL_OK)
+        {
+            err = ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        for (i = 0; i < ARSAL_MD5_LENGTH; i++)
+        {
+            snprintf(&md5Txt[i * 2], 3, "%02x", md5[i]);
+        }
+        manifest = ARUPDATER_Manifest_New(filePath, md5Txt, ARUPDATER_UPLOADER_RESUME_CHUNK_SIZE, &err);
+    }
+
+    free(fileName);
+    ARUPDATER_Arena_Release(&arena);
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return manifest;
+}
+
+static void *ARUPDATER_Fleet_WorkerRun(void *fleetArg)
+{
+    ARUPDATER_Fleet_t *fleet = (ARUPDATER_Fleet_t *)fleetArg;
+    ARUPDATER_FleetTarget_t *target = NULL;
+
+    do
+    {
+        target = NULL;
+        ARSAL_Mutex_Lock(&fleet->fleetLock);
+        if ((fleet->isCanceled == 0) && (fleet->nextTarget < fleet->targetCount))
+        {
+            target = fleet->targets[fleet->nextTarget];
+            fleet->nextTarget++;
+        }
+        ARSAL_Mutex_Unlock(&fleet->fleetLock);
+
+        if (target != NULL)
+        {
+            ARUPDATER_Uploader_ThreadRun(target->manager);
+        }
+    } while (target != NULL);
+
+    return NULL;
+}
+
+void* ARUPDATER_Fleet_ThreadRun(void *fleetArg)
+{
+    ARUPDATER_Fleet_t *fleet = (ARUPDATER_Fleet_t *)fleetArg;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Manifest_t **manifests = NULL;
+    uint8_t (*md5s)[ARSAL_MD5_LENGTH] = NULL;
+    ARSAL_Thread_t *workers = NULL;
+    int workerCount = 0;
+    int startedWorkers = 0;
+    int i = 0;
+    int j = 0;
+
+    if (fleet == NULL)
+    {
+        return (void *)ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    fleet->isRunning = 1;
+    fleet->nextTarget = 0;
+
+    if (fleet->targetCount == 0)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        manifests = calloc(fleet->targetCount, sizeof(ARUPDATER_Manifest_t *));
+        md5s = calloc(fleet->targetCount, sizeof(*md5s));
+        if ((manifests == NULL) || (md5s == NULL))
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    /* one digest per product, kept at the index of its first target */
+    for (i = 0; (error == ARUPDATER_OK) && (i < fleet->targetCount); i++)
+    {
+        for (j = 0; (j < i) && (fleet->targets[j]->product != fleet->targets[i]->product); j++)
+        {
+        }
+        if (j == i)
+        {
+            manifests[i] = ARUPDATER_Fleet_ComputeDigest(fleet, fleet->targets[i]->product, md5s[i], &error);
+        }
+
+        if (error == ARUPDATER_OK)
+        {
+            fleet->targets[i]->error = ARUPDATER_OK;
+            error = ARUPDATER_Uploader_SetPlfDigest(fleet->targets[i]->manager, md5s[j], manifests[j]);
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        workerCount = fleet->targetCount;
+        if ((fleet->maxParallelUploads > 0) && (fleet->maxParallelUploads < workerCount))
+        {
+            workerCount = fleet->maxParallelUploads;
+        }
+
+        workers = calloc(workerCount, sizeof(ARSAL_Thread_t));
+        if (workers == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    for (i = 0; (error == ARUPDATER_OK) && (i < workerCount); i++)
+    {
+        if (ARSAL_Thread_Create(&workers[i], ARUPDATER_Fleet_WorkerRun, fleet) != 0)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FLEET_TAG, "could only start %d upload threads", i);
+            break;
+        }
+        startedWorkers++;
+    }
+
+    if ((error == ARUPDATER_OK) && (startedWorkers == 0))
+    {
+        error = ARUPDATER_ERROR_SYSTEM;
+    }
+
+    for (i = 0; i < startedWorkers; i++)
+    {
+        ARSAL_Thread_Join(workers[i], NULL);
+        ARSAL_Thread_Destroy(&workers[i]);
+    }
+
+    /* report the targets that never started, because of an error or a cancel */
+    for (i = fleet->nextTarget; i < fleet->targetCount; i++)
+    {
+        ARUPDATER_Fleet_TargetCompletionCallback(fleet->targets[i], (error != ARUPDATER_OK) ? error : ARUPDATER_ERROR_UPLOADER);
+    }
+
+    for (i = 0; (error == ARUPDATER_OK) && (i < fleet->targetCount); i++)
+    {
+        /* a target already running the plf needed no upload, it is kept in its own error */
+        if ((fleet->targets[i]->error != ARUPDATER_OK) && (fleet->targets[i]->error != ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE))
+        {
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_FLEET_TAG, "upload to target %d failed: %s", i, ARUPDATER_Error_ToString(fleet->targets[i]->error));
+            error = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    free(workers);
+
+    /* the managers outlive the run: they must not keep the digests freed below */
+    for (i = 0; i < fleet->targetCount; i++)
+    {
+        ARUPDATER_Uploader_SetPlfDigest(fleet->targets[i]->manager, NULL, NULL);
+    }
+
+    for (i = 0; (manifests != NULL) && (i < fleet->targetCount); i++)
+    {
+        ARUPDATER_Manifest_Delete(&manifests[i]);
+    }
+    free(manifests);
+    free(md5s);
+    fleet->isRunning = 0;
+
+    return (void *)error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Fleet_CancelThread(ARUPDATER_Fleet_t *fleet)
+{
+    int i = 0;
+
+    if (fleet == NULL)
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    ARSAL_Mutex_Lock(&fleet->fleetLock);
+    fleet->isCanceled = 1;
+    ARSAL_Mutex_Unlock(&fleet->fleetLock);
+
+    for (i = 0; i < fleet->targetCount; i++)
+    {
+        ARUPDATER_Uploader_CancelThread(fleet->targets[i]->manager);
+    }
+
+    return ARUPDATER_OK;
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Fleet.h
+ * @brief libARUpdater Fleet private header file.
+ **/
+
+#ifndef _ARUPDATER_FLEET_PRIVATE_H_
+#define _ARUPDATER_FLEET_PRIVATE_H_
+
+#include <libARUpdater/ARUPDATER_Fleet.h>
+#include <libARSAL/ARSAL_Mutex.h>
+
+typedef struct
+{
+    ARUPDATER_Fleet_t *fleet;
+    int index;
+    eARDISCOVERY_PRODUCT product;
+    ARUPDATER_Manager_t *manager;
+    eARUPDATER_ERROR error;
+} ARUPDATER_FleetTarget_t;
+
+struct ARUPDATER_Fleet_t
+{
+    char *rootFolder;
+    eARDISCOVERY_PRODUCT product;
+    ARSAL_MD5_Manager_t *md5Manager;
+    int maxParallelUploads;
+
+    ARUPDATER_FleetTarget_t **targets;
+    int targetCount;
+    int nextTarget;
+
+    int isRunning;
+    int isCanceled;
+    ARSAL_Mutex_t fleetLock;
+
+    ARUPDATER_Fleet_TargetProgressCallback_t progressCallback;
+    ARUPDATER_Fleet_TargetCompletionCallback_t completionCallback;
+    void *progressArg;
+    void *completionArg;
+};
+
+#endif
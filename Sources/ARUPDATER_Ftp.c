@@ -0,0 +1,638 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Ftp.c
+ * @brief libARUpdater minimal FTP client c file.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#include <libARSAL/ARSAL_Print.h>
+
+#include "ARUPDATER_Ftp.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+#define ARUPDATER_FTP_TAG                  "ARUPDATER_Ftp"
+#define ARUPDATER_FTP_DEFAULT_USERNAME     "anonymous"
+#define ARUPDATER_FTP_LINE_MAX_SIZE        512
+#define ARUPDATER_FTP_RX_BUFFER_SIZE       1024
+#define ARUPDATER_FTP_DATA_BUFFER_SIZE     (64*1024)
+#define ARUPDATER_FTP_TIMEOUT_SEC          10
+
+struct ARUPDATER_Ftp_Connection_t
+{
+    int controlFd;
+    int dataFd;
+    int isCanceled;
+
+    struct sockaddr_storage peer;
+    socklen_t peerLength;
+
+    char rx[ARUPDATER_FTP_RX_BUFFER_SIZE];
+    size_t rxLength;
+};
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+static void ARUPDATER_Ftp_SetTimeouts(int fd)
+{
+    struct timeval tv;
+
+    tv.tv_sec = ARUPDATER_FTP_TIMEOUT_SEC;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static int ARUPDATER_Ftp_SendAll(int fd, const void *data, size_t length)
+{
+    const uint8_t *p = data;
+    ssize_t ret;
+
+    while (length > 0)
+    {
+        ret = send(fd, p, length, MSG_NOSIGNAL);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        p += ret;
+        length -= ret;
+    }
+
+    return 0;
+}
+
+static int ARUPDATER_Ftp_ReadLine(ARUPDATER_Ftp_Connection_t *connection, char *line, size_t size)
+{
+    char *eol;
+    size_t lineLength;
+    ssize_t ret;
+
+    while ((eol = memchr(connection->rx, '\n', connection->rxLength)) == NULL)
+    {
+        if (connection->rxLength == sizeof(connection->rx))
+        {
+            /* line too long: drop what was already buffered */
+            connection->rxLength = 0;
+        }
+
+        ret = recv(connection->controlFd, connection->rx + connection->rxLength, sizeof(connection->rx) - connection->rxLength, 0);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return -1;
+
+        connection->rxLength += ret;
+    }
+
+    lineLength = eol - connection->rx + 1;
+    if (size > 0)
+    {
+        size_t copyLength = (lineLength < size) ? lineLength : size - 1;
+        memcpy(line, connection->rx, copyLength);
+        line[copyLength] = '\0';
+    }
+
+    memmove(connection->rx, connection->rx + lineLength, connection->rxLength - lineLength);
+    connection->rxLength -= lineLength;
+
+    return 0;
+}
+
+/* read a (possibly multi-line) reply and return its code, -1 on error */
+static int ARUPDATER_Ftp_ReadReply(ARUPDATER_Ftp_Connection_t *connection, char *text, size_t size)
+{
+    char line[ARUPDATER_FTP_LINE_MAX_SIZE];
+    int code = -1;
+
+    if (ARUPDATER_Ftp_ReadLine(connection, line, sizeof(line)) < 0)
+        return -1;
+
+    if (sscanf(line, "%3d", &code) != 1)
+        return -1;
+
+    /* multi-line reply: "xyz-" ... "xyz " */
+    if (line[3] == '-')
+    {
+        char end[5];
+        snprintf(end, sizeof(end), "%03d ", code);
+        do
+        {
+            if (ARUPDATER_Ftp_ReadLine(connection, line, sizeof(line)) < 0)
+                return -1;
+        } while (strncmp(line, end, 4) != 0);
+    }
+
+    if (text != NULL && size > 0)
+    {
+        snprintf(text, size, "%s", line);
+    }
+
+    return code;
+}
+
+static int ARUPDATER_Ftp_Command(ARUPDATER_Ftp_Connection_t *connection, char *text, size_t size, const char *fmt, ...)
+{
+    char command[ARUPDATER_FTP_LINE_MAX_SIZE];
+    va_list args;
+    int length;
+
+    if (connection->isCanceled)
+        return -1;
+
+    va_start(args, fmt);
+    length = vsnprintf(command, sizeof(command) - 2, fmt, args);
+    va_end(args);
+    if ((length < 0) || (length >= (int)sizeof(command) - 2))
+        return -1;
+
+    command[length++] = '\r';
+    command[length++] = '\n';
+
+    if (ARUPDATER_Ftp_SendAll(connection->controlFd, command, length) < 0)
+        return -1;
+
+    return ARUPDATER_Ftp_ReadReply(connection, text, size);
+}
+
+static int ARUPDATER_Ftp_OpenData(ARUPDATER_Ftp_Connection_t *connection)
+{
+    char reply[ARUPDATER_FTP_LINE_MAX_SIZE];
+    struct sockaddr_storage addr;
+    unsigned int h1, h2, h3, h4, p1, p2;
+    char *p;
+    int fd;
+
+    if (ARUPDATER_Ftp_Command(connection, reply, sizeof(reply), "PASV") != 227)
+        return -1;
+
+    p = strchr(reply, '(');
+    if ((p == NULL) || (sscanf(p + 1, "%u,%u,%u,%u,%u,%u", &h1, &h2, &h3, &h4, &p1, &p2) != 6))
+        return -1;
+
+    /* always connect to the control peer: the announced address is not
+     * reliable behind NAT */
+    memcpy(&addr, &connection->peer, connection->peerLength);
+    if (addr.ss_family == AF_INET)
+        ((struct sockaddr_in *)&addr)->sin_port = htons((p1 << 8) | p2);
+    else if (addr.ss_family == AF_INET6)
+        ((struct sockaddr_in6 *)&addr)->sin6_port = htons((p1 << 8) | p2);
+    else
+        return -1;
+
+    fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    ARUPDATER_Ftp_SetTimeouts(fd);
+
+    if (connect(fd, (struct sockaddr *)&addr, connection->peerLength) < 0)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "data connect error: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    connection->dataFd = fd;
+    return fd;
+}
+
+static void ARUPDATER_Ftp_CloseData(ARUPDATER_Ftp_Connection_t *connection)
+{
+    if (connection->dataFd != -1)
+    {
+        close(connection->dataFd);
+        connection->dataFd = -1;
+    }
+}
+
+ARUPDATER_Ftp_Connection_t *ARUPDATER_Ftp_Connection_New(const char *server, int port, const char *username, const char *password, eARUPDATER_ERROR *error)
+{
+    ARUPDATER_Ftp_Connection_t *connection = NULL;
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    struct addrinfo hints, *res = NULL, *ai;
+    char service[16];
+    int code;
+
+    if (server == NULL)
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        connection = calloc(1, sizeof(ARUPDATER_Ftp_Connection_t));
+        if (connection == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+        else
+        {
+            connection->controlFd = -1;
+            connection->dataFd = -1;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        snprintf(service, sizeof(service), "%d", port);
+
+        if (getaddrinfo(server, service, &hints, &res) != 0)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "can't resolve '%s'", server);
+            err = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        for (ai = res; (ai != NULL) && (connection->controlFd == -1); ai = ai->ai_next)
+        {
+            int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0)
+                continue;
+
+            ARUPDATER_Ftp_SetTimeouts(fd);
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                connection->controlFd = fd;
+                memcpy(&connection->peer, ai->ai_addr, ai->ai_addrlen);
+                connection->peerLength = ai->ai_addrlen;
+            }
+            else
+            {
+                close(fd);
+            }
+        }
+
+        if (connection->controlFd == -1)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "can't connect to %s:%d", server, port);
+            err = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (res != NULL)
+    {
+        freeaddrinfo(res);
+    }
+
+    /* greeting then login */
+    if (err == ARUPDATER_OK)
+    {
+        if (ARUPDATER_Ftp_ReadReply(connection, NULL, 0) != 220)
+        {
+            err = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        code = ARUPDATER_Ftp_Command(connection, NULL, 0, "USER %s", ((username != NULL) && (username[0] != '\0')) ? username : ARUPDATER_FTP_DEFAULT_USERNAME);
+        if (code == 331)
+        {
+            code = ARUPDATER_Ftp_Command(connection, NULL, 0, "PASS %s", (password != NULL) ? password : "");
+        }
+        if ((code != 230) && (code != 202))
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "login refused: %d", code);
+            err = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        if (ARUPDATER_Ftp_Command(connection, NULL, 0, "TYPE I") != 200)
+        {
+            err = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (err != ARUPDATER_OK)
+    {
+        ARUPDATER_Ftp_Connection_Delete(&connection);
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return connection;
+}
+
+void ARUPDATER_Ftp_Connection_Delete(ARUPDATER_Ftp_Connection_t **connection)
+{
+    if ((connection != NULL) && (*connection != NULL))
+    {
+        ARUPDATER_Ftp_CloseData(*connection);
+
+        if ((*connection)->controlFd != -1)
+        {
+            if (!(*connection)->isCanceled)
+            {
+                ARUPDATER_Ftp_Command(*connection, NULL, 0, "QUIT");
+            }
+            close((*connection)->controlFd);
+        }
+
+        free(*connection);
+        *connection = NULL;
+    }
+}
+
+void ARUPDATER_Ftp_Connection_Cancel(ARUPDATER_Ftp_Connection_t *connection)
+{
+    int fd;
+
+    if (connection != NULL)
+    {
+        connection->isCanceled = 1;
+
+        /* unblock any pending send/recv, sockets are closed by the owner */
+        fd = connection->dataFd;
+        if (fd != -1)
+            shutdown(fd, SHUT_RDWR);
+        fd = connection->controlFd;
+        if (fd != -1)
+            shutdown(fd, SHUT_RDWR);
+    }
+}
+
+eARUPDATER_ERROR ARUPDATER_Ftp_Size(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, uint64_t *size)
+{
+    char reply[ARUPDATER_FTP_LINE_MAX_SIZE];
+    unsigned long long value;
+    int code;
+
+    if ((connection == NULL) || (remotePath == NULL) || (size == NULL))
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    code = ARUPDATER_Ftp_Command(connection, reply, sizeof(reply), "SIZE %s", remotePath);
+    if (code == 550)
+        return ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+
+    if ((code != 213) || (sscanf(reply + 4, "%llu", &value) != 1))
+        return ARUPDATER_ERROR_UPLOADER;
+
+    *size = value;
+    return ARUPDATER_OK;
+}
+
+eARUPDATER_ERROR ARUPDATER_Ftp_GetRange(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, uint64_t offset, uint8_t *buffer, size_t length, size_t *readLength)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    int transferStarted = 0;
+    size_t done = 0;
+    ssize_t ret;
+    int code;
+
+    if ((connection == NULL) || (remotePath == NULL) || (buffer == NULL) || (readLength == NULL))
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    if (ARUPDATER_Ftp_OpenData(connection) < 0)
+        error = ARUPDATER_ERROR_UPLOADER;
+
+    if ((error == ARUPDATER_OK) && (offset > 0))
+    {
+        if (ARUPDATER_Ftp_Command(connection, NULL, 0, "REST %llu", (unsigned long long)offset) != 350)
+            error = ARUPDATER_ERROR_UPLOADER;
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        code = ARUPDATER_Ftp_Command(connection, NULL, 0, "RETR %s", remotePath);
+        if ((code != 125) && (code != 150))
+            error = ARUPDATER_ERROR_UPLOADER;
+        else
+            transferStarted = 1;
+    }
+
+    while ((error == ARUPDATER_OK) && (done < length))
+    {
+        ret = recv(connection->dataFd, buffer + done, length - done, 0);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret < 0)
+            error = ARUPDATER_ERROR_UPLOADER;
+        else if (ret == 0)
+            break;
+        else
+            done += ret;
+    }
+
+    ARUPDATER_Ftp_CloseData(connection);
+
+    if (transferStarted)
+    {
+        /* closing early makes the server report an aborted transfer:
+         * the reply only matters if the file was shorter than asked */
+        code = ARUPDATER_Ftp_ReadReply(connection, NULL, 0);
+        if ((error == ARUPDATER_OK) && (done < length) && (code != 226) && (code != 250))
+            error = ARUPDATER_ERROR_UPLOADER;
+    }
+
+    if (connection->isCanceled)
+        error = ARUPDATER_ERROR_UPLOADER;
+
+    *readLength = done;
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Ftp_PutRange(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, const char *localPath, uint64_t offset, uint64_t length, ARUPDATER_Ftp_ProgressCallback_t progressCallback, void *progressArg)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    uint8_t *buffer = NULL;
+    struct stat st;
+    int transferStarted = 0;
+    ssize_t ret;
+    int fd = -1;
+    int code;
+
+    if ((connection == NULL) || (remotePath == NULL) || (localPath == NULL))
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    fd = open(localPath, O_RDONLY);
+    if ((fd < 0) || (fstat(fd, &st) < 0) || ((uint64_t)st.st_size < offset))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "can't read '%s'", localPath);
+        error = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        if ((length == 0) || (offset + length > (uint64_t)st.st_size))
+            length = st.st_size - offset;
+
+        if (lseek(fd, offset, SEEK_SET) < 0)
+            error = ARUPDATER_ERROR_SYSTEM;
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        buffer = malloc(ARUPDATER_FTP_DATA_BUFFER_SIZE);
+        if (buffer == NULL)
+            error = ARUPDATER_ERROR_ALLOC;
+    }
+
+    if ((error == ARUPDATER_OK) && (ARUPDATER_Ftp_OpenData(connection) < 0))
+        error = ARUPDATER_ERROR_UPLOADER;
+
+    if ((error == ARUPDATER_OK) && (offset > 0))
+    {
+        if (ARUPDATER_Ftp_Command(connection, NULL, 0, "REST %llu", (unsigned long long)offset) != 350)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_TAG, "server refused REST %llu", (unsigned long long)offset);
+            error = ARUPDATER_ERROR_UPLOADER;
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        code = ARUPDATER_Ftp_Command(connection, NULL, 0, "STOR %s", remotePath);
+        if ((code != 125) && (code != 150))
+            error = ARUPDATER_ERROR_UPLOADER;
+        else
+            transferStarted = 1;
+    }
+
+    while ((error == ARUPDATER_OK) && (length > 0))
+    {
+        size_t toRead = (length < ARUPDATER_FTP_DATA_BUFFER_SIZE) ? (size_t)length : ARUPDATER_FTP_DATA_BUFFER_SIZE;
+
+        ret = read(fd, buffer, toRead);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+        {
+            error = ARUPDATER_ERROR_SYSTEM;
+        }
+        else if (ARUPDATER_Ftp_SendAll(connection->dataFd, buffer, ret) < 0)
+        {
+            error = ARUPDATER_ERROR_UPLOADER;
+        }
+        else
+        {
+            length -= ret;
+            if (progressCallback != NULL)
+                progressCallback(progressArg, ret);
+        }
+    }
+
+    ARUPDATER_Ftp_CloseData(connection);
+
+    if (transferStarted)
+    {
+        code = ARUPDATER_Ftp_ReadReply(connection, NULL, 0);
+        if ((error == ARUPDATER_OK) && (code != 226) && (code != 250))
+            error = ARUPDATER_ERROR_UPLOADER;
+    }
+
+    if (connection->isCanceled)
+        error = ARUPDATER_ERROR_UPLOADER;
+
+    if (fd >= 0)
+        close(fd);
+    free(buffer);
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Ftp_Rename(ARUPDATER_Ftp_Connection_t *connection, const char *oldPath, const char *newPath)
+{
+    if ((connection == NULL) || (oldPath == NULL) || (newPath == NULL))
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    if (ARUPDATER_Ftp_Command(connection, NULL, 0, "RNFR %s", oldPath) != 350)
+        return ARUPDATER_ERROR_UPLOADER;
+
+    if (ARUPDATER_Ftp_Command(connection, NULL, 0, "RNTO %s", newPath) != 250)
+        return ARUPDATER_ERROR_UPLOADER;
+
+    return ARUPDATER_OK;
+}
+
+eARUPDATER_ERROR ARUPDATER_Ftp_Delete(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath)
+{
+    int code;
+
+    if ((connection == NULL) || (remotePath == NULL))
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    code = ARUPDATER_Ftp_Command(connection, NULL, 0, "DELE %s", remotePath);
+    if (code == 550)
+        return ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+
+    if (code != 250)
+        return ARUPDATER_ERROR_UPLOADER;
+
+    return ARUPDATER_OK;
+}
+
+int ARUPDATER_Ftp_SupportsRest(ARUPDATER_Ftp_Connection_t *connection)
+{
+    if (connection == NULL)
+        return 0;
+
+    if (ARUPDATER_Ftp_Command(connection, NULL, 0, "REST 1") != 350)
+        return 0;
+
+    /* clear the restart marker */
+    ARUPDATER_Ftp_Command(connection, NULL, 0, "REST 0");
+
+    return 1;
+}
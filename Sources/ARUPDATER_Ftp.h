@@ -0,0 +1,141 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Ftp.h
+ * @brief libARUpdater minimal FTP client header file.
+ * @details Small passive mode FTP client used by the uploader when it needs
+ * commands that ARUtils does not expose (REST offsets and ranged reads).
+ **/
+
+#ifndef _ARUPDATER_FTP_PRIVATE_H_
+#define _ARUPDATER_FTP_PRIVATE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+typedef struct ARUPDATER_Ftp_Connection_t ARUPDATER_Ftp_Connection_t;
+
+/**
+ * @brief Progress callback of a ftp transfer
+ * @param arg The pointer of the user custom argument
+ * @param bytes The number of bytes transferred since the previous call
+ */
+typedef void (*ARUPDATER_Ftp_ProgressCallback_t) (void *arg, size_t bytes);
+
+/**
+ * @brief Connect and log in to a ftp server
+ * @warning This function allocates memory
+ * @param[in] server : server address
+ * @param[in] port : server port
+ * @param[in] username : user name, anonymous if NULL or empty
+ * @param[in] password : password, can be NULL
+ * @param[out] error : ARUPDATER_OK if operation went well, the description of the error otherwise. Can be null
+ * @return the new connection, NULL on error
+ * @see ARUPDATER_Ftp_Connection_Delete()
+ */
+ARUPDATER_Ftp_Connection_t *ARUPDATER_Ftp_Connection_New(const char *server, int port, const char *username, const char *password, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Log out and delete a ftp connection
+ * @warning This function frees memory
+ * @param connection : address of the pointer on the connection
+ * @see ARUPDATER_Ftp_Connection_New()
+ */
+void ARUPDATER_Ftp_Connection_Delete(ARUPDATER_Ftp_Connection_t **connection);
+
+/**
+ * @brief Abort the command in progress on a connection
+ * @details Can be called from any thread. Every following command fails.
+ * @param connection : pointer on the connection
+ */
+void ARUPDATER_Ftp_Connection_Cancel(ARUPDATER_Ftp_Connection_t *connection);
+
+/**
+ * @brief Get the size of a remote file
+ * @param connection : pointer on the connection
+ * @param[in] remotePath : remote file path
+ * @param[out] size : size of the remote file
+ * @return ARUPDATER_OK if operation went well, ARUPDATER_ERROR_PLF_FILE_NOT_FOUND if the file does not exist, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Ftp_Size(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, uint64_t *size);
+
+/**
+ * @brief Read a range of a remote file
+ * @param connection : pointer on the connection
+ * @param[in] remotePath : remote file path
+ * @param[in] offset : offset of the first byte to read
+ * @param[out] buffer : buffer receiving the data
+ * @param[in] length : number of bytes to read
+ * @param[out] readLength : number of bytes actually read, smaller than length at the end of the file
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Ftp_GetRange(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, uint64_t offset, uint8_t *buffer, size_t length, size_t *readLength);
+
+/**
+ * @brief Write a range of a local file into a remote file at the same offset
+ * @details The remote file is written from offset using REST, the bytes before offset are kept.
+ * @param connection : pointer on the connection
+ * @param[in] remotePath : remote file path
+ * @param[in] localPath : local file path
+ * @param[in] offset : offset of the first byte to send
+ * @param[in] length : number of bytes to send, 0 to send up to the end of the local file
+ * @param[in] progressCallback : progress callback, can be NULL
+ * @param[in] progressArg : arg given to the progressCallback
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Ftp_PutRange(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath, const char *localPath, uint64_t offset, uint64_t length, ARUPDATER_Ftp_ProgressCallback_t progressCallback, void *progressArg);
+
+/**
+ * @brief Rename a remote file
+ * @param connection : pointer on the connection
+ * @param[in] oldPath : current remote path
+ * @param[in] newPath : new remote path
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Ftp_Rename(ARUPDATER_Ftp_Connection_t *connection, const char *oldPath, const char *newPath);
+
+/**
+ * @brief Delete a remote file
+ * @param connection : pointer on the connection
+ * @param[in] remotePath : remote file path
+ * @return ARUPDATER_OK if operation went well, ARUPDATER_ERROR_PLF_FILE_NOT_FOUND if the file does not exist, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Ftp_Delete(ARUPDATER_Ftp_Connection_t *connection, const char *remotePath);
+
+/**
+ * @brief Check if the server accepts restart offsets
+ * @param connection : pointer on the connection
+ * @return 1 if REST is accepted, 0 otherwise
+ */
+int ARUPDATER_Ftp_SupportsRest(ARUPDATER_Ftp_Connection_t *connection);
+
+#endif /* _ARUPDATER_FTP_PRIVATE_H_ */
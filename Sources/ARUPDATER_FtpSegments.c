@@ -0,0 +1,392 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_FtpSegments.c
+ * @brief libARUpdater segmented ftp upload c file.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <libARSAL/ARSAL_Print.h>
+#include <libARSAL/ARSAL_Mutex.h>
+#include <libARSAL/ARSAL_Thread.h>
+
+#include "ARUPDATER_Ftp.h"
+#include "ARUPDATER_FtpSegments.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+#define ARUPDATER_FTP_SEGMENTS_TAG              "ARUPDATER_FtpSegments"
+/* below this size per connection, the connection setup costs more than it brings */
+#define ARUPDATER_FTP_SEGMENTS_MIN_SIZE         (512*1024)
+
+struct ARUPDATER_FtpSegments_t
+{
+    char *server;
+    int port;
+    char *username;
+    char *password;
+    int segmentCount;
+
+    /* connection 0 is also the control connection */
+    ARUPDATER_Ftp_Connection_t *connections[ARUPDATER_FTP_SEGMENTS_MAX];
+    int isCanceled;
+    ARSAL_Mutex_t lock;
+
+    uint64_t bytesDone;
+    uint64_t bytesTotal;
+    ARSAL_Mutex_t progressLock;
+    ARUPDATER_FtpSegments_ProgressCallback_t progressCallback;
+    void *progressArg;
+};
+
+typedef struct
+{
+    ARUPDATER_FtpSegments_t *segments;
+    int index;
+    const char *remotePath;
+    const char *localPath;
+    uint64_t offset;
+    uint64_t length;
+    eARUPDATER_ERROR error;
+} ARUPDATER_FtpSegment_t;
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+ARUPDATER_FtpSegments_t *ARUPDATER_FtpSegments_New(const char *server, int port, const char *username, const char *password, int segmentCount, ARUPDATER_FtpSegments_ProgressCallback_t progressCallback, void *progressArg, eARUPDATER_ERROR *error)
+{
+    ARUPDATER_FtpSegments_t *segments = NULL;
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+
+    if ((server == NULL) || (segmentCount < 1) || (segmentCount > ARUPDATER_FTP_SEGMENTS_MAX))
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        segments = calloc(1, sizeof(ARUPDATER_FtpSegments_t));
+        if (segments == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        segments->server = strdup(server);
+        segments->username = (username != NULL) ? strdup(username) : NULL;
+        segments->password = (password != NULL) ? strdup(password) : NULL;
+        if ((segments->server == NULL) ||
+            ((username != NULL) && (segments->username == NULL)) ||
+            ((password != NULL) && (segments->password == NULL)))
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        if ((ARSAL_Mutex_Init(&segments->lock) != 0) || (ARSAL_Mutex_Init(&segments->progressLock) != 0))
+        {
+            err = ARUPDATER_ERROR_SYSTEM;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        segments->port = port;
+        segments->segmentCount = segmentCount;
+        segments->progressCallback = progressCallback;
+        segments->progressArg = progressArg;
+    }
+    else if (segments != NULL)
+    {
+        free(segments->server);
+        free(segments->username);
+        free(segments->password);
+        free(segments);
+        segments = NULL;
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return segments;
+}
+
+void ARUPDATER_FtpSegments_Delete(ARUPDATER_FtpSegments_t **segments)
+{
+    if ((segments != NULL) && (*segments != NULL))
+    {
+        ARSAL_Mutex_Destroy(&(*segments)->lock);
+        ARSAL_Mutex_Destroy(&(*segments)->progressLock);
+        free((*segments)->server);
+        free((*segments)->username);
+        free((*segments)->password);
+        free(*segments);
+        *segments = NULL;
+    }
+}
+
+void ARUPDATER_FtpSegments_Cancel(ARUPDATER_FtpSegments_t *segments)
+{
+    int i;
+
+    if (segments != NULL)
+    {
+        ARSAL_Mutex_Lock(&segments->lock);
+        segments->isCanceled = 1;
+        for (i = 0; i < ARUPDATER_FTP_SEGMENTS_MAX; i++)
+        {
+            ARUPDATER_Ftp_Connection_Cancel(segments->connections[i]);
+        }
+        ARSAL_Mutex_Unlock(&segments->lock);
+    }
+}
+
+static eARUPDATER_ERROR ARUPDATER_FtpSegments_Connect(ARUPDATER_FtpSegments_t *segments, int index)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Ftp_Connection_t *connection = NULL;
+
+    connection = ARUPDATER_Ftp_Connection_New(segments->server, segments->port, segments->username, segments->password, &error);
+
+    ARSAL_Mutex_Lock(&segments->lock);
+    segments->connections[index] = connection;
+    if ((connection != NULL) && segments->isCanceled)
+    {
+        ARUPDATER_Ftp_Connection_Cancel(connection);
+    }
+    ARSAL_Mutex_Unlock(&segments->lock);
+
+    return error;
+}
+
+static void ARUPDATER_FtpSegments_Disconnect(ARUPDATER_FtpSegments_t *segments, int index)
+{
+    ARUPDATER_Ftp_Connection_t *connection = NULL;
+
+    ARSAL_Mutex_Lock(&segments->lock);
+    connection = segments->connections[index];
+    segments->connections[index] = NULL;
+    ARSAL_Mutex_Unlock(&segments->lock);
+
+    ARUPDATER_Ftp_Connection_Delete(&connection);
+}
+
+static void ARUPDATER_FtpSegments_ProgressCallback(void *arg, size_t bytes)
+{
+    ARUPDATER_FtpSegments_t *segments = (ARUPDATER_FtpSegments_t *)arg;
+
+    /* segments report from several threads: keep the callbacks ordered */
+    ARSAL_Mutex_Lock(&segments->progressLock);
+    segments->bytesDone += bytes;
+    if (segments->progressCallback != NULL)
+    {
+        segments->progressCallback(segments->progressArg, segments->bytesDone, segments->bytesTotal);
+    }
+    ARSAL_Mutex_Unlock(&segments->progressLock);
+}
+
+static void *ARUPDATER_FtpSegments_SegmentRun(void *segmentArg)
+{
+    ARUPDATER_FtpSegment_t *segment = (ARUPDATER_FtpSegment_t *)segmentArg;
+    ARUPDATER_FtpSegments_t *segments = segment->segments;
+
+    if (segment->index != 0)
+    {
+        segment->error = ARUPDATER_FtpSegments_Connect(segments, segment->index);
+    }
+
+    if (segment->error == ARUPDATER_OK)
+    {
+        segment->error = ARUPDATER_Ftp_PutRange(segments->connections[segment->index], segment->remotePath, segment->localPath, segment->offset, segment->length, ARUPDATER_FtpSegments_ProgressCallback, segments);
+    }
+
+    if (segment->error != ARUPDATER_OK)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_FTP_SEGMENTS_TAG, "segment %d [%llu, +%llu] failed", segment->index, (unsigned long long)segment->offset, (unsigned long long)segment->length);
+        /* no use going on with the other segments */
+        ARUPDATER_FtpSegments_Cancel(segments);
+    }
+
+    if (segment->index != 0)
+    {
+        ARUPDATER_FtpSegments_Disconnect(segments, segment->index);
+    }
+
+    return NULL;
+}
+
+eARUPDATER_ERROR ARUPDATER_FtpSegments_Upload(ARUPDATER_FtpSegments_t *segments, const char *remotePath, const char *localPath, uint64_t offset)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_FtpSegment_t segmentList[ARUPDATER_FTP_SEGMENTS_MAX];
+    ARSAL_Thread_t threads[ARUPDATER_FTP_SEGMENTS_MAX];
+    int threadStarted[ARUPDATER_FTP_SEGMENTS_MAX];
+    struct stat st;
+    uint64_t fileSize = 0;
+    uint64_t segmentSize = 0;
+    int segmentCount = 0;
+    int isCanceled = 0;
+    int i = 0;
+
+    if ((segments == NULL) || (remotePath == NULL) || (localPath == NULL))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (stat(localPath, &st) != 0)
+    {
+        error = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+    }
+    else
+    {
+        fileSize = st.st_size;
+        if (offset > fileSize)
+        {
+            error = ARUPDATER_ERROR_BAD_PARAMETER;
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        segments->bytesTotal = fileSize;
+        error = ARUPDATER_FtpSegments_Connect(segments, 0);
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        segmentCount = segments->segmentCount;
+        if ((fileSize - offset) / ARUPDATER_FTP_SEGMENTS_MIN_SIZE < (uint64_t)segmentCount)
+        {
+            segmentCount = (int)((fileSize - offset) / ARUPDATER_FTP_SEGMENTS_MIN_SIZE);
+        }
+        if (segmentCount < 1)
+        {
+            segmentCount = 1;
+        }
+
+        if (!ARUPDATER_Ftp_SupportsRest(segments->connections[0]))
+        {
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_FTP_SEGMENTS_TAG, "server refused REST, uploading in a single stream");
+            segmentCount = 1;
+            offset = 0;
+        }
+        else if ((segmentCount > 1) && (offset == 0))
+        {
+            /* STOR without REST truncates the file: send the first byte alone so
+             * that no segment can truncate what the others already wrote */
+            segments->bytesDone = 0;
+            error = ARUPDATER_Ftp_PutRange(segments->connections[0], remotePath, localPath, 0, 1, ARUPDATER_FtpSegments_ProgressCallback, segments);
+            offset = 1;
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        segments->bytesDone = offset;
+        segmentSize = (fileSize - offset) / segmentCount;
+
+        ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_FTP_SEGMENTS_TAG, "uploading %llu bytes from %llu in %d segments", (unsigned long long)(fileSize - offset), (unsigned long long)offset, segmentCount);
+
+        for (i = 0; i < segmentCount; i++)
+        {
+            segmentList[i].segments = segments;
+            segmentList[i].index = i;
+            segmentList[i].remotePath = remotePath;
+            segmentList[i].localPath = localPath;
+            segmentList[i].offset = offset + i * segmentSize;
+            segmentList[i].length = (i == segmentCount - 1) ? (fileSize - segmentList[i].offset) : segmentSize;
+            segmentList[i].error = ARUPDATER_OK;
+            threadStarted[i] = 0;
+        }
+
+        /* segment 0 runs on the control connection, in this thread */
+        for (i = 1; i < segmentCount; i++)
+        {
+            if (ARSAL_Thread_Create(&threads[i], ARUPDATER_FtpSegments_SegmentRun, &segmentList[i]) == 0)
+            {
+                threadStarted[i] = 1;
+            }
+            else
+            {
+                segmentList[i].error = ARUPDATER_ERROR_SYSTEM;
+                ARUPDATER_FtpSegments_Cancel(segments);
+            }
+        }
+
+        if (segmentList[0].length > 0)
+        {
+            ARUPDATER_FtpSegments_SegmentRun(&segmentList[0]);
+        }
+
+        for (i = 0; i < segmentCount; i++)
+        {
+            if (threadStarted[i])
+            {
+                ARSAL_Thread_Join(threads[i], NULL);
+                ARSAL_Thread_Destroy(&threads[i]);
+            }
+            if ((error == ARUPDATER_OK) && (segmentList[i].error != ARUPDATER_OK))
+            {
+                error = segmentList[i].error;
+            }
+        }
+    }
+
+    ARSAL_Mutex_Lock(&segments->lock);
+    isCanceled = segments->isCanceled;
+    ARSAL_Mutex_Unlock(&segments->lock);
+
+    if ((error == ARUPDATER_OK) && isCanceled)
+    {
+        error = ARUPDATER_ERROR_UPLOADER;
+    }
+
+    ARUPDATER_FtpSegments_Disconnect(segments, 0);
+
+    return error;
+}
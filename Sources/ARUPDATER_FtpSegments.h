@@ -0,0 +1,99 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_FtpSegments.h
+ * @brief libARUpdater segmented ftp upload header file.
+ * @details The file is split in ranges, each sent on its own ftp connection
+ * with a REST offset, so that the link is filled even with latency.
+ **/
+
+#ifndef _ARUPDATER_FTP_SEGMENTS_PRIVATE_H_
+#define _ARUPDATER_FTP_SEGMENTS_PRIVATE_H_
+
+#include <stdint.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+#define ARUPDATER_FTP_SEGMENTS_MAX         8
+
+typedef struct ARUPDATER_FtpSegments_t ARUPDATER_FtpSegments_t;
+
+/**
+ * @brief Progress callback of a segmented upload
+ * @param arg : user argument
+ * @param done : number of bytes of the file present on the server
+ * @param total : size of the file
+ */
+typedef void (*ARUPDATER_FtpSegments_ProgressCallback_t) (void *arg, uint64_t done, uint64_t total);
+
+/**
+ * @brief Create a segmented uploader
+ * @warning This function allocates memory
+ * @param[in] server : ftp server address
+ * @param[in] port : ftp server port
+ * @param[in] username : user name, can be NULL
+ * @param[in] password : password, can be NULL
+ * @param[in] segmentCount : number of data connections, from 1 to ARUPDATER_FTP_SEGMENTS_MAX
+ * @param[in] progressCallback : progress callback, can be NULL
+ * @param[in] progressArg : arg given to the progressCallback
+ * @param[out] error : the error, can be NULL
+ * @return the segmented uploader, NULL if an error occurred
+ */
+ARUPDATER_FtpSegments_t *ARUPDATER_FtpSegments_New(const char *server, int port, const char *username, const char *password, int segmentCount, ARUPDATER_FtpSegments_ProgressCallback_t progressCallback, void *progressArg, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Delete a segmented uploader
+ * @param segments : address of the pointer on the segmented uploader
+ */
+void ARUPDATER_FtpSegments_Delete(ARUPDATER_FtpSegments_t **segments);
+
+/**
+ * @brief Upload a local file from offset, on several connections
+ * @details The bytes of the remote file before offset are kept. Falls back to a
+ * single stream from the start of the file when the server refuses REST.
+ * An interrupted segmented upload leaves holes in the remote file: it must not be
+ * resumed from its size.
+ * A segmented uploader runs a single upload: once canceled, even before this
+ * call, it stays canceled.
+ * @param segments : pointer on the segmented uploader
+ * @param[in] remotePath : remote file path
+ * @param[in] localPath : local file path
+ * @param[in] offset : offset of the first byte to send
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_FtpSegments_Upload(ARUPDATER_FtpSegments_t *segments, const char *remotePath, const char *localPath, uint64_t offset);
+
+/**
+ * @brief Cancel a running upload, can be called from any thread
+ * @param segments : pointer on the segmented uploader
+ */
+void ARUPDATER_FtpSegments_Cancel(ARUPDATER_FtpSegments_t *segments);
+
+#endif /* _ARUPDATER_FTP_SEGMENTS_PRIVATE_H_ */
@@ -43,6 +43,7 @@
 #include <libARUpdater/ARUPDATER_Manager.h>
 #include "ARUPDATER_Manager.h"
 #include "ARUPDATER_Utils.h"
+#include "ARUPDATER_Arena.h"
 
 #define ARUPDATER_MANAGER_TAG   "ARUPDATER_Manager"
 
@@ -129,6 +130,10 @@ int ARUPDATER_Manager_PlfVersionIsUpToDate(ARUPDATER_Manager_t *manager,
     char *productFolder = NULL;
     char *plfFilename = NULL;
     char *sourceFilePath = NULL;
+    const char *separator = "";
+    ARUPDATER_Arena_t arena;
+    
+    ARUPDATER_Arena_Init(&arena);
     
     if ((manager == NULL) ||
         (rootFolder == NULL))
@@ -139,36 +144,37 @@ int ARUPDATER_Manager_PlfVersionIsUpToDate(ARUPDATER_Manager_t *manager,
     if (err == ARUPDATER_OK)
     {
         uint16_t productId = ARDISCOVERY_getProductID(product);
-        device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-        snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
+        device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
         
-        int productFolderLength = strlen(rootFolder) + strlen(ARUPDATER_MANAGER_PLF_FOLDER) + strlen(device) + strlen(ARUPDATER_MANAGER_FOLDER_SEPARATOR) + 1;
         char *slash = strrchr(rootFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR[0]);
         if ((slash != NULL) && (strcmp(slash, ARUPDATER_MANAGER_FOLDER_SEPARATOR) != 0))
         {
-            productFolderLength += 1;
+            separator = ARUPDATER_MANAGER_FOLDER_SEPARATOR;
         }
-        productFolder = (char*) malloc(productFolderLength);
-        strcpy(productFolder, rootFolder);
-        
-        if ((slash != NULL) && (strcmp(slash, ARUPDATER_MANAGER_FOLDER_SEPARATOR) != 0))
+        productFolder = (device != NULL) ? ARUPDATER_Arena_Concat(&arena, rootFolder, separator, ARUPDATER_MANAGER_PLF_FOLDER, device, ARUPDATER_MANAGER_FOLDER_SEPARATOR, NULL) : NULL;
+        if (productFolder == NULL)
         {
-            strcat(productFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
+            err = ARUPDATER_ERROR_ALLOC;
         }
-        strcat(productFolder, ARUPDATER_MANAGER_PLF_FOLDER);
-        strcat(productFolder, device);
-        strcat(productFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
-        
+    }
+    
+    if (err == ARUPDATER_OK)
+    {
         plfFilename = NULL;
         err = ARUPDATER_Utils_GetPlfInFolder(productFolder, &plfFilename);
     }
     
     if (err == ARUPDATER_OK)
     {
-        sourceFilePath = malloc(strlen(productFolder) + strlen(plfFilename) + 1);
-        strcpy(sourceFilePath, productFolder);
-        strcat(sourceFilePath, plfFilename);
-
+        sourceFilePath = ARUPDATER_Arena_Concat(&arena, productFolder, plfFilename, NULL);
+        if (sourceFilePath == NULL)
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+    
+    if (err == ARUPDATER_OK)
+    {
         /* Extract plf version from local file */
         err = ARUPDATER_Utils_ReadPlfVersion(sourceFilePath, &local);
     }
@@ -189,22 +195,11 @@ int ARUPDATER_Manager_PlfVersionIsUpToDate(ARUPDATER_Manager_t *manager,
         ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_MANAGER_TAG, "remote:'%s' local:'%s' uptodate=%d", remoteVersion, localVersionBuffer, retVal);
     }
     
-    if (productFolder)
-    {
-        free(productFolder);
-    }
-    if (sourceFilePath)
-    {
-        free(sourceFilePath);
-    }
-    if (device)
-    {
-        free(device);
-    }
     if (plfFilename)
     {
         free(plfFilename);
     }
+    ARUPDATER_Arena_Release(&arena);
     
     if (error != NULL)
     {
@@ -0,0 +1,296 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Manifest.c
+ * @brief libARUpdater chunk manifest c file.
+ **/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include <libARSAL/ARSAL_Print.h>
+
+#include "ARUPDATER_Manifest.h"
+#include "ARUPDATER_Crc32c.h"
+
+#define ARUPDATER_MANIFEST_TAG                   "ARUPDATER_Manifest"
+#define ARUPDATER_MANIFEST_MAX_CHUNK_COUNT       (1 << 20)
+
+static ARUPDATER_Manifest_t *ARUPDATER_Manifest_Alloc(uint64_t fileSize, uint32_t chunkSize)
+{
+    ARUPDATER_Manifest_t *manifest = NULL;
+    uint64_t chunkCount;
+
+    if (chunkSize == 0)
+        return NULL;
+
+    chunkCount = (fileSize + chunkSize - 1) / chunkSize;
+    if (chunkCount > ARUPDATER_MANIFEST_MAX_CHUNK_COUNT)
+        return NULL;
+
+    manifest = calloc(1, sizeof(ARUPDATER_Manifest_t));
+    if (manifest == NULL)
+        return NULL;
+
+    manifest->fileSize = fileSize;
+    manifest->chunkSize = chunkSize;
+    manifest->chunkCount = (uint32_t)chunkCount;
+    manifest->chunkCrcs = calloc((chunkCount > 0) ? chunkCount : 1, sizeof(uint32_t));
+    if (manifest->chunkCrcs == NULL)
+    {
+        free(manifest);
+        manifest = NULL;
+    }
+
+    return manifest;
+}
+
+ARUPDATER_Manifest_t *ARUPDATER_Manifest_New(const char *filePath, const char *md5Txt, uint32_t chunkSize, eARUPDATER_ERROR *error)
+{
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    ARUPDATER_Manifest_t *manifest = NULL;
+    uint8_t *buffer = NULL;
+    FILE *file = NULL;
+    long fileSize = 0;
+    uint32_t i;
+
+    if ((filePath == NULL) || (md5Txt == NULL) || (chunkSize == 0))
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        file = fopen(filePath, "rb");
+        if ((file == NULL) || (fseek(file, 0, SEEK_END) != 0) || ((fileSize = ftell(file)) < 0) || (fseek(file, 0, SEEK_SET) != 0))
+        {
+            err = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        manifest = ARUPDATER_Manifest_Alloc(fileSize, chunkSize);
+        buffer = malloc(chunkSize);
+        if ((manifest == NULL) || (buffer == NULL))
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        snprintf(manifest->md5, sizeof(manifest->md5), "%s", md5Txt);
+
+        for (i = 0; (err == ARUPDATER_OK) && (i < manifest->chunkCount); i++)
+        {
+            uint32_t size = ARUPDATER_Manifest_GetChunkSize(manifest, i);
+            if (fread(buffer, 1, size, file) != size)
+            {
+                err = ARUPDATER_ERROR_PLF;
+            }
+            else
+            {
+                manifest->chunkCrcs[i] = ARUPDATER_Crc32c_Update(0, buffer, size);
+            }
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    free(buffer);
+
+    if (err != ARUPDATER_OK)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_MANIFEST_TAG, "can't compute manifest of '%s': %s", filePath ? filePath : "null", ARUPDATER_Error_ToString(err));
+        ARUPDATER_Manifest_Delete(&manifest);
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return manifest;
+}
+
+ARUPDATER_Manifest_t *ARUPDATER_Manifest_Read(const char *manifestPath, eARUPDATER_ERROR *error)
+{
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    ARUPDATER_Manifest_t *manifest = NULL;
+    char md5[ARSAL_MD5_LENGTH * 2 + 1];
+    unsigned long long fileSize;
+    unsigned int chunkSize, chunkCount, crc;
+    FILE *file = NULL;
+    uint32_t i;
+
+    if (manifestPath == NULL)
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        file = fopen(manifestPath, "r");
+        if (file == NULL)
+        {
+            err = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+        }
+    }
+
+    /* header: md5, file size, chunk size and chunk count */
+    if (err == ARUPDATER_OK)
+    {
+        if (fscanf(file, "%32s %llu %u %u", md5, &fileSize, &chunkSize, &chunkCount) != 4)
+        {
+            err = ARUPDATER_ERROR_PLF;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        manifest = ARUPDATER_Manifest_Alloc(fileSize, chunkSize);
+        if ((manifest == NULL) || (manifest->chunkCount != chunkCount))
+        {
+            err = ARUPDATER_ERROR_PLF;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        snprintf(manifest->md5, sizeof(manifest->md5), "%s", md5);
+
+        for (i = 0; (err == ARUPDATER_OK) && (i < manifest->chunkCount); i++)
+        {
+            if (fscanf(file, "%x", &crc) != 1)
+            {
+                err = ARUPDATER_ERROR_PLF;
+            }
+            else
+            {
+                manifest->chunkCrcs[i] = crc;
+            }
+        }
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+
+    if (err != ARUPDATER_OK)
+    {
+        ARUPDATER_Manifest_Delete(&manifest);
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return manifest;
+}
+
+eARUPDATER_ERROR ARUPDATER_Manifest_Write(const ARUPDATER_Manifest_t *manifest, const char *manifestPath)
+{
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    FILE *file = NULL;
+    uint32_t i;
+
+    if ((manifest == NULL) || (manifestPath == NULL))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    file = fopen(manifestPath, "w");
+    if (file == NULL)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_MANIFEST_TAG, "fopen(%s): %s", manifestPath, strerror(errno));
+        return ARUPDATER_ERROR_SYSTEM;
+    }
+
+    fprintf(file, "%s %" PRIu64 " %u %u\n", manifest->md5, manifest->fileSize, manifest->chunkSize, manifest->chunkCount);
+    for (i = 0; i < manifest->chunkCount; i++)
+    {
+        fprintf(file, "%08x\n", manifest->chunkCrcs[i]);
+    }
+
+    if ((fflush(file) != 0) || ferror(file))
+    {
+        err = ARUPDATER_ERROR_SYSTEM;
+    }
+    fclose(file);
+
+    return err;
+}
+
+int ARUPDATER_Manifest_Equals(const ARUPDATER_Manifest_t *manifest1, const ARUPDATER_Manifest_t *manifest2)
+{
+    if ((manifest1 == NULL) || (manifest2 == NULL))
+        return 0;
+
+    if ((strcmp(manifest1->md5, manifest2->md5) != 0) ||
+        (manifest1->fileSize != manifest2->fileSize) ||
+        (manifest1->chunkSize != manifest2->chunkSize) ||
+        (manifest1->chunkCount != manifest2->chunkCount))
+        return 0;
+
+    return memcmp(manifest1->chunkCrcs, manifest2->chunkCrcs, manifest1->chunkCount * sizeof(uint32_t)) == 0;
+}
+
+uint32_t ARUPDATER_Manifest_GetChunkSize(const ARUPDATER_Manifest_t *manifest, uint32_t index)
+{
+    uint64_t offset;
+
+    if ((manifest == NULL) || (index >= manifest->chunkCount))
+        return 0;
+
+    offset = (uint64_t)index * manifest->chunkSize;
+    if (manifest->fileSize - offset < manifest->chunkSize)
+        return (uint32_t)(manifest->fileSize - offset);
+
+    return manifest->chunkSize;
+}
+
+void ARUPDATER_Manifest_Delete(ARUPDATER_Manifest_t **manifest)
+{
+    if ((manifest != NULL) && (*manifest != NULL))
+    {
+        free((*manifest)->chunkCrcs);
+        free(*manifest);
+        *manifest = NULL;
+    }
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Manifest.h
+ * @brief libARUpdater chunk manifest header file.
+ * @details A manifest describes a plf file as a list of fixed size chunks,
+ * each with its CRC32C. It is uploaded next to the plf so that a partial
+ * upload can be checked chunk by chunk before being resumed.
+ **/
+
+#ifndef _ARUPDATER_MANIFEST_PRIVATE_H_
+#define _ARUPDATER_MANIFEST_PRIVATE_H_
+
+#include <stdint.h>
+#include <libARSAL/ARSAL_MD5_Manager.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+typedef struct
+{
+    char md5[ARSAL_MD5_LENGTH * 2 + 1];     /* md5 of the whole file, in text */
+    uint64_t fileSize;                      /* size of the whole file */
+    uint32_t chunkSize;                     /* size of every chunk but the last one */
+    uint32_t chunkCount;                    /* number of chunks */
+    uint32_t *chunkCrcs;                    /* CRC32C of each chunk */
+} ARUPDATER_Manifest_t;
+
+/**
+ * @brief Compute the manifest of a local file
+ * @warning This function allocates memory
+ * @param[in] filePath : path of the file
+ * @param[in] md5Txt : md5 of the file, in text
+ * @param[in] chunkSize : size of the chunks
+ * @param[out] error : ARUPDATER_OK if operation went well, the description of the error otherwise. Can be null
+ * @return the new manifest, NULL on error
+ * @see ARUPDATER_Manifest_Delete()
+ */
+ARUPDATER_Manifest_t *ARUPDATER_Manifest_New(const char *filePath, const char *md5Txt, uint32_t chunkSize, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Read a manifest file
+ * @warning This function allocates memory
+ * @param[in] manifestPath : path of the manifest file
+ * @param[out] error : ARUPDATER_OK if operation went well, the description of the error otherwise. Can be null
+ * @return the manifest, NULL on error
+ * @see ARUPDATER_Manifest_Delete()
+ */
+ARUPDATER_Manifest_t *ARUPDATER_Manifest_Read(const char *manifestPath, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Write a manifest file
+ * @param[in] manifest : the manifest
+ * @param[in] manifestPath : path of the manifest file
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Manifest_Write(const ARUPDATER_Manifest_t *manifest, const char *manifestPath);
+
+/**
+ * @brief Check if two manifests describe the same file with the same chunks
+ * @param[in] manifest1 : first manifest, can be null
+ * @param[in] manifest2 : second manifest, can be null
+ * @return 1 if both manifests are equal, 0 otherwise
+ */
+int ARUPDATER_Manifest_Equals(const ARUPDATER_Manifest_t *manifest1, const ARUPDATER_Manifest_t *manifest2);
+
+/**
+ * @brief Get the size of a chunk
+ * @param[in] manifest : the manifest
+ * @param[in] index : index of the chunk
+ * @return the size of the chunk, 0 if index is out of range
+ */
+uint32_t ARUPDATER_Manifest_GetChunkSize(const ARUPDATER_Manifest_t *manifest, uint32_t index);
+
+/**
+ * @brief Delete a manifest
+ * @warning This function frees memory
+ * @param manifest : address of the pointer on the manifest
+ */
+void ARUPDATER_Manifest_Delete(ARUPDATER_Manifest_t **manifest);
+
+#endif /* _ARUPDATER_MANIFEST_PRIVATE_H_ */
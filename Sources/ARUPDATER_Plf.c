@@ -37,33 +37,197 @@
  *
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <libARSAL/ARSAL_Print.h>
+#include <libARSAL/ARSAL_Endianness.h>
+
 #include "ARUPDATER_Plf.h"
 
-eARUPDATER_ERROR ARUPDATER_Plf_GetHeader(const char *plf_filename, plf_phdr_t *header)
+#define ARUPDATER_PLF_TAG   "ARUPDATER_Plf"
+
+static uint32_t ARUPDATER_Plf_Word(const uint8_t *p)
 {
-    eARUPDATER_ERROR error =  ARUPDATER_OK;
-    if (header == NULL)
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return dtohl(word);
+}
+
+/* walk the section table from the end of the header */
+static eARUPDATER_ERROR ARUPDATER_Plf_IndexSections(ARUPDATER_Plf_t *plf)
+{
+    ARUPDATER_Plf_Section_t *sections = NULL;
+    ARUPDATER_Plf_Section_t *section = NULL;
+    size_t shdrSize = dtohl(plf->header.p_shdrsize);
+    size_t offset = dtohl(plf->header.p_phdrsize);
+    const uint8_t *shdr = NULL;
+    int capacity = 0;
+    size_t got = 0;
+
+    while (offset + shdrSize <= plf->size)
     {
-        error = ARUPDATER_ERROR_BAD_PARAMETER;
+        shdr = ARUPDATER_FileMap_Get(&plf->map, (off_t)offset, ARUPDATER_PLF_SECTION_HEADER_SIZE, &got);
+        if ((shdr == NULL) || (got < ARUPDATER_PLF_SECTION_HEADER_SIZE))
+        {
+            return ARUPDATER_ERROR_PLF;
+        }
+
+        if (plf->sectionCount == capacity)
+        {
+            capacity = (capacity == 0) ? 16 : capacity * 2;
+            sections = realloc(plf->sections, capacity * sizeof(ARUPDATER_Plf_Section_t));
+            if (sections == NULL)
+            {
+                return ARUPDATER_ERROR_ALLOC;
+            }
+            plf->sections = sections;
+        }
+
+        section = &plf->sections[plf->sectionCount];
+        section->type = ARUPDATER_Plf_Word(&shdr[0]);
+        section->size = ARUPDATER_Plf_Word(&shdr[4]);
+        section->crc = ARUPDATER_Plf_Word(&shdr[8]);
+        section->link = ARUPDATER_Plf_Word(&shdr[12]);
+        section->uncompressedSize = ARUPDATER_Plf_Word(&shdr[16]);
+        section->offset = offset + shdrSize;
+        if (section->size > plf->size - section->offset)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_PLF_TAG, "section %d of %u bytes at %zu ends after the file",
+                        plf->sectionCount, section->size, section->offset);
+            return ARUPDATER_ERROR_PLF;
+        }
+        plf->sectionCount++;
+
+        offset = section->offset + section->size;
+        offset = (offset + ARUPDATER_PLF_SECTION_ALIGN - 1) & ~(size_t)(ARUPDATER_PLF_SECTION_ALIGN - 1);
     }
-    
+
+    // too short for a section header: a trailer or some padding, the sections are all there
+    if (offset < plf->size)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_PLF_TAG, "%zu bytes after the last section, ignored", plf->size - offset);
+    }
+
+    return ARUPDATER_OK;
+}
+
+eARUPDATER_ERROR ARUPDATER_Plf_Open(ARUPDATER_Plf_t *plf, const char *path, size_t chunkSize)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    const void *header = NULL;
+    struct stat st;
+    size_t got = 0;
+
+    if ((plf == NULL) || (path == NULL) || (chunkSize < sizeof(plf_phdr_t)))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    memset(plf, 0, sizeof(*plf));
+    plf->fd = open(path, O_RDONLY);
+    if ((plf->fd < 0) || (fstat(plf->fd, &st) != 0))
+    {
+        error = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+    }
+    else if ((size_t)st.st_size < sizeof(plf_phdr_t))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_PLF_TAG, "%s: %lld bytes, too short for a plf", path, (long long)st.st_size);
+        error = ARUPDATER_ERROR_PLF;
+    }
+
     if (error == ARUPDATER_OK)
     {
-        plf_phdr_t h;
-        FILE *f = fopen(plf_filename, "rb");
-        if(f != NULL)
+        plf->size = st.st_size;
+        if (ARUPDATER_FileMap_Open(&plf->map, plf->fd, plf->size, chunkSize, 1) != 0)
         {
-            if(fread(&h, 1, sizeof(plf_phdr_t), f) == sizeof(plf_phdr_t))
-            {
-                memcpy(header, &h, sizeof(plf_phdr_t));
-            }
-            fclose(f);
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        header = ARUPDATER_FileMap_Get(&plf->map, 0, sizeof(plf_phdr_t), &got);
+        if ((header == NULL) || (got < sizeof(plf_phdr_t)))
+        {
+            error = ARUPDATER_ERROR_PLF;
         }
         else
         {
-            error = ARUPDATER_ERROR_PLF_FILE_NOT_FOUND;
+            memcpy(&plf->header, header, sizeof(plf_phdr_t));
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        if ((dtohl(plf->header.p_magic) != PLF_HEADER_MAGIC) ||
+            (dtohl(plf->header.p_phdrsize) < sizeof(plf_phdr_t)) || (dtohl(plf->header.p_phdrsize) > plf->size) ||
+            (dtohl(plf->header.p_shdrsize) < ARUPDATER_PLF_SECTION_HEADER_SIZE))
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_PLF_TAG, "%s: invalid header (magic 0x%08x, header %u, section header %u bytes)",
+                        path, dtohl(plf->header.p_magic), dtohl(plf->header.p_phdrsize), dtohl(plf->header.p_shdrsize));
+            error = ARUPDATER_ERROR_PLF;
+        }
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        error = ARUPDATER_Plf_IndexSections(plf);
+    }
+
+    if (error != ARUPDATER_OK)
+    {
+        ARUPDATER_FileMap_Close(&plf->map);
+        free(plf->sections);
+        if (plf->fd >= 0)
+        {
+            close(plf->fd);
         }
+        memset(plf, 0, sizeof(*plf));
+    }
+
+    return error;
+}
+
+void ARUPDATER_Plf_Close(ARUPDATER_Plf_t *plf)
+{
+    if (ARUPDATER_Plf_IsOpen(plf))
+    {
+        ARUPDATER_FileMap_Close(&plf->map);
+        free(plf->sections);
+        close(plf->fd);
+        memset(plf, 0, sizeof(*plf));
+    }
+}
+
+int ARUPDATER_Plf_IsOpen(const ARUPDATER_Plf_t *plf)
+{
+    return (plf != NULL) && ((plf->map.data != NULL) || (plf->map.buffer != NULL));
+}
+
+eARUPDATER_ERROR ARUPDATER_Plf_GetHeader(const char *plf_filename, plf_phdr_t *header)
+{
+    eARUPDATER_ERROR error =  ARUPDATER_OK;
+    ARUPDATER_Plf_t plf;
+
+    if (header == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    
+    if (error == ARUPDATER_OK)
+    {
+        error = ARUPDATER_Plf_Open(&plf, plf_filename, sizeof(plf_phdr_t));
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        memcpy(header, &plf.header, sizeof(plf_phdr_t));
+        ARUPDATER_Plf_Close(&plf);
     }
 	
 	return error;
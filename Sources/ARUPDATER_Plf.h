@@ -40,7 +40,10 @@
 #ifndef _ARUPDATER_PLF_PRIVATE_H_
 #define _ARUPDATER_PLF_PRIVATE_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include <libARUpdater/ARUPDATER_Error.h>
+#include "ARUPDATER_FileMap.h"
 
 #if defined(BUILD_LIBPLFNG)
 
@@ -77,6 +80,61 @@ typedef struct {
 
 #endif
 
+#ifndef PLF_HEADER_MAGIC
+#define PLF_HEADER_MAGIC     0x21464c50
+#endif
+
+/* section header of the file, little endian words; the header gives its size (p_shdrsize)
+ * and sections start on 4 bytes */
+#define ARUPDATER_PLF_SECTION_HEADER_SIZE   20
+#define ARUPDATER_PLF_SECTION_ALIGN         4
+
+//! PLF section, in the index of a reader
+typedef struct {
+    uint32_t    type;                       //!< Section type
+    uint32_t    size;                       //!< Size of the data in the file
+    uint32_t    crc;                        //!< Section CRC
+    uint32_t    link;                       //!< Load address or entry point
+    uint32_t    uncompressedSize;           //!< Size of the decompressed data, 0 if stored as is
+    size_t      offset;                     //!< Offset of the data in the file
+} ARUPDATER_Plf_Section_t;
+
+//! PLF file opened once for all its readers
+typedef struct {
+    int fd;
+    size_t size;
+    ARUPDATER_FileMap_t map;                //!< view of the whole file, mapped when possible
+    plf_phdr_t header;
+    ARUPDATER_Plf_Section_t *sections;      //!< index of the section table
+    int sectionCount;
+} ARUPDATER_Plf_t;
+
+/**
+ * @brief Open and check a plf file, and index its sections
+ * @details The file is mapped once, its header must have the plf magic and sizes within the
+ * file, and its sections must end within the file. Bytes after the last section, too few
+ * for a section header, are ignored.
+ * @param plf : the reader
+ * @param[in] path : path of the plf file
+ * @param[in] chunkSize : largest chunk read with ARUPDATER_FileMap_Get() on plf->map
+ * @return ARUPDATER_OK if operation went well, ARUPDATER_ERROR_PLF_FILE_NOT_FOUND if the file
+ * can't be opened, ARUPDATER_ERROR_PLF if it is not a valid plf
+ */
+eARUPDATER_ERROR ARUPDATER_Plf_Open(ARUPDATER_Plf_t *plf, const char *path, size_t chunkSize);
+
+/**
+ * @brief Close a reader, can be called on a reader zeroed, not opened or already closed
+ * @param plf : the reader
+ */
+void ARUPDATER_Plf_Close(ARUPDATER_Plf_t *plf);
+
+/**
+ * @brief Get if a reader is open
+ * @param plf : the reader
+ * @return 1 if the reader is open, 0 otherwise
+ */
+int ARUPDATER_Plf_IsOpen(const ARUPDATER_Plf_t *plf);
+
 /**
  * @brief read the header of a plf file
  * @param[in] plf_filepath : path of the plf file to read
@@ -0,0 +1,393 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_PlfIndex.c
+ * @brief libARUpdater plf file name index c file.
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ARUPDATER_PlfIndex.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+#define ARUPDATER_PLF_INDEX_FNV_OFFSET          2166136261U
+#define ARUPDATER_PLF_INDEX_FNV_PRIME           16777619U
+
+typedef struct
+{
+    uint32_t hash;
+    char *name;
+    ARUPDATER_PlfIndex_Entry_t entry;
+} ARUPDATER_PlfIndex_Item_t;
+
+struct ARUPDATER_PlfIndex_t
+{
+    ARUPDATER_PlfIndex_Item_t *items;
+    int count;
+    int capacity;
+    /* open addressing, item + 1 of each slot, 0 when free; at most half full */
+    int *slots;
+    uint32_t mask;
+    int refCount;                       /* references given by the cache, and its own */
+};
+
+typedef struct
+{
+    ARUPDATER_PlfIndex_Key_t key;
+    ARUPDATER_PlfIndex_t *index;
+    uint64_t lastUse;
+} ARUPDATER_PlfIndex_CacheEntry_t;
+
+/* the cache is shared by every caller of the library, an ARSAL mutex can't be
+ * initialized statically */
+static pthread_mutex_t ARUPDATER_PlfIndex_CacheLock = PTHREAD_MUTEX_INITIALIZER;
+static ARUPDATER_PlfIndex_CacheEntry_t ARUPDATER_PlfIndex_Cache[ARUPDATER_PLF_INDEX_CACHE_SIZE];
+static uint64_t ARUPDATER_PlfIndex_CacheUse = 0;
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+void ARUPDATER_PlfIndex_KeyFromStat(const struct stat *st, ARUPDATER_PlfIndex_Key_t *key)
+{
+    key->dev = (uint64_t)st->st_dev;
+    key->ino = (uint64_t)st->st_ino;
+    key->size = (uint64_t)st->st_size;
+    key->mtimeSec = (int64_t)st->st_mtime;
+#if defined(__APPLE__)
+    key->mtimeNsec = st->st_mtimespec.tv_nsec;
+#else
+    key->mtimeNsec = st->st_mtim.tv_nsec;
+#endif
+}
+
+static int ARUPDATER_PlfIndex_KeyEquals(const ARUPDATER_PlfIndex_Key_t *a, const ARUPDATER_PlfIndex_Key_t *b)
+{
+    return (a->dev == b->dev) && (a->ino == b->ino) && (a->size == b->size) &&
+        (a->mtimeSec == b->mtimeSec) && (a->mtimeNsec == b->mtimeNsec);
+}
+
+static uint32_t ARUPDATER_PlfIndex_Hash(const char *name)
+{
+    uint32_t hash = ARUPDATER_PLF_INDEX_FNV_OFFSET;
+
+    while (*name != '\0')
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= ARUPDATER_PLF_INDEX_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+ARUPDATER_PlfIndex_t *ARUPDATER_PlfIndex_New(int capacity, eARUPDATER_ERROR *error)
+{
+    ARUPDATER_PlfIndex_t *index = NULL;
+    eARUPDATER_ERROR err = ARUPDATER_OK;
+    uint32_t slotCount = 4;
+
+    if (capacity < 0)
+    {
+        err = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        while (slotCount < 2 * (uint32_t)capacity)
+        {
+            slotCount <<= 1;
+        }
+
+        index = calloc(1, sizeof(ARUPDATER_PlfIndex_t));
+        if (index != NULL)
+        {
+            index->items = calloc((capacity > 0) ? capacity : 1, sizeof(ARUPDATER_PlfIndex_Item_t));
+            index->slots = calloc(slotCount, sizeof(int));
+        }
+        if ((index == NULL) || (index->items == NULL) || (index->slots == NULL))
+        {
+            err = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (err == ARUPDATER_OK)
+    {
+        index->capacity = capacity;
+        index->mask = slotCount - 1;
+        index->refCount = 1;
+    }
+    else
+    {
+        ARUPDATER_PlfIndex_Delete(&index);
+    }
+
+    if (error != NULL)
+    {
+        *error = err;
+    }
+
+    return index;
+}
+
+void ARUPDATER_PlfIndex_Delete(ARUPDATER_PlfIndex_t **index)
+{
+    int i;
+
+    if ((index != NULL) && (*index != NULL))
+    {
+        if ((*index)->items != NULL)
+        {
+            for (i = 0; i < (*index)->count; i++)
+            {
+                free((*index)->items[i].name);
+            }
+        }
+        free((*index)->items);
+        free((*index)->slots);
+        free(*index);
+        *index = NULL;
+    }
+}
+
+/* slot of name, or the free slot where it goes */
+static uint32_t ARUPDATER_PlfIndex_Lookup(const ARUPDATER_PlfIndex_t *index, const char *name, uint32_t hash)
+{
+    uint32_t slot = hash & index->mask;
+    const ARUPDATER_PlfIndex_Item_t *item;
+
+    while (index->slots[slot] != 0)
+    {
+        item = &index->items[index->slots[slot] - 1];
+        if ((item->hash == hash) && (strcmp(item->name, name) == 0))
+        {
+            break;
+        }
+        slot = (slot + 1) & index->mask;
+    }
+
+    return slot;
+}
+
+eARUPDATER_ERROR ARUPDATER_PlfIndex_Add(ARUPDATER_PlfIndex_t *index, const char *name, const ARUPDATER_PlfIndex_Entry_t *entry)
+{
+    ARUPDATER_PlfIndex_Item_t *item;
+    uint32_t hash, slot;
+
+    if ((index == NULL) || (name == NULL) || (entry == NULL))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    hash = ARUPDATER_PlfIndex_Hash(name);
+    slot = ARUPDATER_PlfIndex_Lookup(index, name, hash);
+    if (index->slots[slot] != 0)
+    {
+        /* keep the first one */
+        return ARUPDATER_OK;
+    }
+
+    if (index->count >= index->capacity)
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    item = &index->items[index->count];
+    item->name = strdup(name);
+    if (item->name == NULL)
+    {
+        return ARUPDATER_ERROR_ALLOC;
+    }
+    item->hash = hash;
+    item->entry = *entry;
+    index->count++;
+    index->slots[slot] = index->count;
+
+    return ARUPDATER_OK;
+}
+
+int ARUPDATER_PlfIndex_Find(const ARUPDATER_PlfIndex_t *index, const char *name, ARUPDATER_PlfIndex_Entry_t *entry)
+{
+    uint32_t slot;
+
+    if ((index == NULL) || (name == NULL))
+    {
+        return 0;
+    }
+
+    slot = ARUPDATER_PlfIndex_Lookup(index, name, ARUPDATER_PlfIndex_Hash(name));
+    if (index->slots[slot] == 0)
+    {
+        return 0;
+    }
+
+    if (entry != NULL)
+    {
+        *entry = index->items[index->slots[slot] - 1].entry;
+    }
+
+    return 1;
+}
+
+int ARUPDATER_PlfIndex_GetCount(const ARUPDATER_PlfIndex_t *index)
+{
+    return (index != NULL) ? index->count : 0;
+}
+
+const char *ARUPDATER_PlfIndex_Get(const ARUPDATER_PlfIndex_t *index, int i, ARUPDATER_PlfIndex_Entry_t *entry)
+{
+    if ((index == NULL) || (i < 0) || (i >= index->count))
+    {
+        return NULL;
+    }
+
+    if (entry != NULL)
+    {
+        *entry = index->items[i].entry;
+    }
+
+    return index->items[i].name;
+}
+
+/* drop a reference taken on a cached index, called with the cache lock */
+static void ARUPDATER_PlfIndex_Unref(ARUPDATER_PlfIndex_t **index)
+{
+    if (*index != NULL)
+    {
+        (*index)->refCount--;
+        if ((*index)->refCount == 0)
+        {
+            ARUPDATER_PlfIndex_Delete(index);
+        }
+        *index = NULL;
+    }
+}
+
+int ARUPDATER_PlfIndex_CacheFind(const ARUPDATER_PlfIndex_Key_t *key, const char *name, int *found, ARUPDATER_PlfIndex_Entry_t *entry)
+{
+    ARUPDATER_PlfIndex_CacheEntry_t *cached;
+    int i, isCached = 0;
+
+    pthread_mutex_lock(&ARUPDATER_PlfIndex_CacheLock);
+    for (i = 0; (i < ARUPDATER_PLF_INDEX_CACHE_SIZE) && !isCached; i++)
+    {
+        cached = &ARUPDATER_PlfIndex_Cache[i];
+        if ((cached->index != NULL) && ARUPDATER_PlfIndex_KeyEquals(&cached->key, key))
+        {
+            isCached = 1;
+            cached->lastUse = ++ARUPDATER_PlfIndex_CacheUse;
+            *found = ARUPDATER_PlfIndex_Find(cached->index, name, entry);
+        }
+    }
+    pthread_mutex_unlock(&ARUPDATER_PlfIndex_CacheLock);
+
+    return isCached;
+}
+
+void ARUPDATER_PlfIndex_CacheStore(const ARUPDATER_PlfIndex_Key_t *key, ARUPDATER_PlfIndex_t **index)
+{
+    ARUPDATER_PlfIndex_CacheEntry_t *cached;
+    ARUPDATER_PlfIndex_CacheEntry_t *slot = NULL;
+    int i;
+
+    if ((key == NULL) || (index == NULL) || (*index == NULL))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&ARUPDATER_PlfIndex_CacheLock);
+    for (i = 0; i < ARUPDATER_PLF_INDEX_CACHE_SIZE; i++)
+    {
+        cached = &ARUPDATER_PlfIndex_Cache[i];
+        if ((cached->index != NULL) && ARUPDATER_PlfIndex_KeyEquals(&cached->key, key))
+        {
+            /* built by another thread meanwhile */
+            slot = NULL;
+            break;
+        }
+        if ((slot == NULL) || (cached->index == NULL) ||
+            ((slot->index != NULL) && (cached->lastUse < slot->lastUse)))
+        {
+            slot = cached;
+        }
+    }
+
+    if (slot != NULL)
+    {
+        ARUPDATER_PlfIndex_Unref(&slot->index);
+        slot->key = *key;
+        slot->index = *index;
+        slot->lastUse = ++ARUPDATER_PlfIndex_CacheUse;
+        *index = NULL;
+    }
+    pthread_mutex_unlock(&ARUPDATER_PlfIndex_CacheLock);
+
+    ARUPDATER_PlfIndex_Delete(index);
+}
+
+ARUPDATER_PlfIndex_t *ARUPDATER_PlfIndex_CacheGet(const ARUPDATER_PlfIndex_Key_t *key)
+{
+    ARUPDATER_PlfIndex_t *index = NULL;
+    ARUPDATER_PlfIndex_CacheEntry_t *cached;
+    int i;
+
+    pthread_mutex_lock(&ARUPDATER_PlfIndex_CacheLock);
+    for (i = 0; (i < ARUPDATER_PLF_INDEX_CACHE_SIZE) && (index == NULL); i++)
+    {
+        cached = &ARUPDATER_PlfIndex_Cache[i];
+        if ((cached->index != NULL) && ARUPDATER_PlfIndex_KeyEquals(&cached->key, key))
+        {
+            cached->lastUse = ++ARUPDATER_PlfIndex_CacheUse;
+            index = cached->index;
+            index->refCount++;
+        }
+    }
+    pthread_mutex_unlock(&ARUPDATER_PlfIndex_CacheLock);
+
+    return index;
+}
+
+void ARUPDATER_PlfIndex_CacheRelease(ARUPDATER_PlfIndex_t **index)
+{
+    if (index != NULL)
+    {
+        pthread_mutex_lock(&ARUPDATER_PlfIndex_CacheLock);
+        ARUPDATER_PlfIndex_Unref(index);
+        pthread_mutex_unlock(&ARUPDATER_PlfIndex_CacheLock);
+    }
+}
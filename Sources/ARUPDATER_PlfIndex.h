@@ -0,0 +1,160 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_PlfIndex.h
+ * @brief libARUpdater plf file name index header file.
+ * @details Maps the last path component of the U_UNIXFILE regular files of a plf to
+ * their section. A few indexes are cached, keyed by the identity of the file (device,
+ * inode, size and modification time), so the sections of a plf are only scanned once
+ * for all the files extracted from it.
+ **/
+
+#ifndef _ARUPDATER_PLF_INDEX_PRIVATE_H_
+#define _ARUPDATER_PLF_INDEX_PRIVATE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <libARUpdater/ARUPDATER_Error.h>
+
+#define ARUPDATER_PLF_INDEX_CACHE_SIZE      4
+
+typedef struct ARUPDATER_PlfIndex_t ARUPDATER_PlfIndex_t;
+
+//! Identity of a plf file, an index is used only for the file it was built from
+typedef struct
+{
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeSec;
+    long mtimeNsec;
+} ARUPDATER_PlfIndex_Key_t;
+
+//! A file of the index
+typedef struct
+{
+    int section;                        //!< Section of the file in the plf
+} ARUPDATER_PlfIndex_Entry_t;
+
+/**
+ * @brief Get the key of a plf from its stat
+ * @param[in] st : stat of the plf, of its open descriptor preferably
+ * @param[out] key : the key
+ */
+void ARUPDATER_PlfIndex_KeyFromStat(const struct stat *st, ARUPDATER_PlfIndex_Key_t *key);
+
+/**
+ * @brief Create an empty index
+ * @warning This function allocates memory
+ * @param[in] capacity : largest number of files, the section count of the plf
+ * @param[out] error : the error, can be NULL
+ * @return the index, NULL if an error occurred
+ */
+ARUPDATER_PlfIndex_t *ARUPDATER_PlfIndex_New(int capacity, eARUPDATER_ERROR *error);
+
+/**
+ * @brief Delete an index
+ * @param index : address of the pointer on the index
+ */
+void ARUPDATER_PlfIndex_Delete(ARUPDATER_PlfIndex_t **index);
+
+/**
+ * @brief Add a file to the index
+ * @details A name already in the index is kept with its first section, as the
+ * first matching section is the one extracted.
+ * @param index : pointer on the index
+ * @param[in] name : last component of the path of the file
+ * @param[in] entry : the file
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_PlfIndex_Add(ARUPDATER_PlfIndex_t *index, const char *name, const ARUPDATER_PlfIndex_Entry_t *entry);
+
+/**
+ * @brief Find a file in the index
+ * @param[in] index : pointer on the index
+ * @param[in] name : last component of the path of the file
+ * @param[out] entry : the file, if found
+ * @return 1 if the file is in the index, 0 otherwise
+ */
+int ARUPDATER_PlfIndex_Find(const ARUPDATER_PlfIndex_t *index, const char *name, ARUPDATER_PlfIndex_Entry_t *entry);
+
+/**
+ * @brief Get the number of files of an index
+ * @param[in] index : pointer on the index
+ * @return the number of files
+ */
+int ARUPDATER_PlfIndex_GetCount(const ARUPDATER_PlfIndex_t *index);
+
+/**
+ * @brief Get a file of an index, the files are in the order they were added
+ * @param[in] index : pointer on the index
+ * @param[in] i : number of the file, from 0 to ARUPDATER_PlfIndex_GetCount() - 1
+ * @param[out] entry : the file, can be NULL
+ * @return the last component of the path of the file, owned by the index, NULL if i is out of range
+ */
+const char *ARUPDATER_PlfIndex_Get(const ARUPDATER_PlfIndex_t *index, int i, ARUPDATER_PlfIndex_Entry_t *entry);
+
+/**
+ * @brief Find a file in the cached index of a plf, can be called from any thread
+ * @param[in] key : key of the plf
+ * @param[in] name : last component of the path of the file
+ * @param[out] found : 1 if the file is in the plf, 0 otherwise
+ * @param[out] entry : the file, if found
+ * @return 1 if the index of the plf is cached, 0 if it must be built
+ */
+int ARUPDATER_PlfIndex_CacheFind(const ARUPDATER_PlfIndex_Key_t *key, const char *name, int *found, ARUPDATER_PlfIndex_Entry_t *entry);
+
+/**
+ * @brief Cache the index of a plf, can be called from any thread
+ * @details The cache owns the index from now on, even if it is not kept. The least
+ * recently used index is evicted when the cache is full.
+ * @param[in] key : key of the plf
+ * @param index : address of the pointer on the index, set to NULL
+ */
+void ARUPDATER_PlfIndex_CacheStore(const ARUPDATER_PlfIndex_Key_t *key, ARUPDATER_PlfIndex_t **index);
+
+/**
+ * @brief Get the cached index of a plf, can be called from any thread
+ * @details The index stays valid, even if it is evicted, until ARUPDATER_PlfIndex_CacheRelease().
+ * It must not be modified.
+ * @param[in] key : key of the plf
+ * @return the index, NULL if the index of the plf is not cached
+ */
+ARUPDATER_PlfIndex_t *ARUPDATER_PlfIndex_CacheGet(const ARUPDATER_PlfIndex_Key_t *key);
+
+/**
+ * @brief Release an index given by ARUPDATER_PlfIndex_CacheGet(), can be called from any thread
+ * @param index : address of the pointer on the index, set to NULL
+ */
+void ARUPDATER_PlfIndex_CacheRelease(ARUPDATER_PlfIndex_t **index);
+
+#endif /* _ARUPDATER_PLF_INDEX_PRIVATE_H_ */
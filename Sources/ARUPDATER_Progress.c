@@ -0,0 +1,132 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Progress.c
+ * @brief libARUpdater upload progress c file.
+ **/
+
+#include <string.h>
+
+#include "ARUPDATER_Progress.h"
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+void ARUPDATER_Progress_SetLimit(ARUPDATER_Progress_t *progress, int intervalMs, float step)
+{
+    progress->intervalMs = (intervalMs > 0) ? intervalMs : 0;
+    progress->step = (step > 0) ? step : 0;
+}
+
+void ARUPDATER_Progress_Start(ARUPDATER_Progress_t *progress, uint64_t bytesTotal)
+{
+    progress->bytesDone = 0;
+    progress->bytesTotal = bytesTotal;
+    progress->hasReported = 0;
+    progress->reportPercent = 0;
+    ARUPDATER_Throughput_Reset(&progress->throughput);
+}
+
+int ARUPDATER_Progress_Update(ARUPDATER_Progress_t *progress, uint64_t bytesDone)
+{
+    struct timespec now;
+    double elapsedMs;
+    float percent;
+
+    progress->bytesDone = bytesDone;
+    ARUPDATER_Throughput_Update(&progress->throughput, bytesDone);
+    percent = ARUPDATER_Progress_GetPercent(progress);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (progress->hasReported && (percent < 100))
+    {
+        elapsedMs = (double)(now.tv_sec - progress->reportTime.tv_sec) * 1000 + (double)(now.tv_nsec - progress->reportTime.tv_nsec) / 1e6;
+        if ((elapsedMs < progress->intervalMs) || (percent - progress->reportPercent < progress->step))
+        {
+            return 0;
+        }
+    }
+    else if (progress->hasReported && (progress->reportPercent >= 100))
+    {
+        /* the completion is reported once */
+        return 0;
+    }
+
+    progress->hasReported = 1;
+    progress->reportTime = now;
+    progress->reportPercent = percent;
+    return 1;
+}
+
+float ARUPDATER_Progress_GetPercent(const ARUPDATER_Progress_t *progress)
+{
+    if (progress->bytesTotal == 0)
+    {
+        return 0;
+    }
+
+    if (progress->bytesDone >= progress->bytesTotal)
+    {
+        return 100;
+    }
+
+    return (float)(100.0 * progress->bytesDone / progress->bytesTotal);
+}
+
+double ARUPDATER_Progress_GetRate(const ARUPDATER_Progress_t *progress)
+{
+    return ARUPDATER_Throughput_GetRate(&progress->throughput);
+}
+
+double ARUPDATER_Progress_GetEta(const ARUPDATER_Progress_t *progress)
+{
+    double rate = ARUPDATER_Throughput_GetRate(&progress->throughput);
+
+    if (progress->bytesTotal == 0)
+    {
+        return -1;
+    }
+
+    if (progress->bytesDone >= progress->bytesTotal)
+    {
+        return 0;
+    }
+
+    if (rate <= 0)
+    {
+        return -1;
+    }
+
+    return (double)(progress->bytesTotal - progress->bytesDone) / rate;
+}
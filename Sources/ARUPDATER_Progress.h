@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Progress.h
+ * @brief libARUpdater upload progress header file.
+ **/
+
+#ifndef _ARUPDATER_PROGRESS_PRIVATE_H_
+#define _ARUPDATER_PROGRESS_PRIVATE_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "ARUPDATER_Throughput.h"
+
+typedef struct
+{
+    uint64_t bytesDone;
+    uint64_t bytesTotal;
+    ARUPDATER_Throughput_t throughput;  /* smoothed rate of the bytes done */
+    int intervalMs;                     /* shortest time between two reports */
+    float step;                         /* smallest percent change between two reports */
+    int hasReported;
+    struct timespec reportTime;         /* time of the last report */
+    float reportPercent;                /* percent of the last report */
+} ARUPDATER_Progress_t;
+
+/**
+ * @brief Set the limits of the reports, kept across the uploads
+ * @param progress : the progress
+ * @param[in] intervalMs : shortest time between two reports, 0 for no limit
+ * @param[in] step : smallest percent change between two reports, 0 for no limit
+ */
+void ARUPDATER_Progress_SetLimit(ARUPDATER_Progress_t *progress, int intervalMs, float step);
+
+/**
+ * @brief Start the progress of an upload
+ * @param progress : the progress
+ * @param[in] bytesTotal : size of the upload
+ */
+void ARUPDATER_Progress_Start(ARUPDATER_Progress_t *progress, uint64_t bytesTotal);
+
+/**
+ * @brief Give the number of bytes done so far
+ * @details The first update after the start and the one that completes the upload are always
+ * reported, the others once both limits are passed since the last report.
+ * @param progress : the progress
+ * @param[in] bytesDone : total number of bytes done, a resumed part included
+ * @return 1 if the progress should be reported, 0 otherwise
+ */
+int ARUPDATER_Progress_Update(ARUPDATER_Progress_t *progress, uint64_t bytesDone);
+
+/**
+ * @brief Get the percent done
+ * @param progress : the progress
+ * @return the percent done, 0 if the size is unknown
+ */
+float ARUPDATER_Progress_GetPercent(const ARUPDATER_Progress_t *progress);
+
+/**
+ * @brief Get the smoothed rate
+ * @param progress : the progress
+ * @return the rate in bytes/s, 0 if unknown yet
+ */
+double ARUPDATER_Progress_GetRate(const ARUPDATER_Progress_t *progress);
+
+/**
+ * @brief Get the estimated time left
+ * @param progress : the progress
+ * @return the number of seconds left, -1 if unknown yet
+ */
+double ARUPDATER_Progress_GetEta(const ARUPDATER_Progress_t *progress);
+
+#endif /* _ARUPDATER_PROGRESS_PRIVATE_H_ */
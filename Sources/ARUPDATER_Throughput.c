@@ -0,0 +1,119 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Throughput.c
+ * @brief libARUpdater throughput meter c file.
+ **/
+
+#include <string.h>
+
+#include "ARUPDATER_Throughput.h"
+
+/* ***************************************
+ *
+ *             define :
+ *
+ *****************************************/
+/* shortest interval taken into the rate, shorter ones are merged */
+#define ARUPDATER_THROUGHPUT_MIN_INTERVAL_SEC      0.2
+/* weight of the last interval in the smoothed rate */
+#define ARUPDATER_THROUGHPUT_SMOOTHING             0.3
+
+/* ***************************************
+ *
+ *             function implementation :
+ *
+ *****************************************/
+
+static double ARUPDATER_Throughput_Diff(const struct timespec *from, const struct timespec *to)
+{
+    return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+void ARUPDATER_Throughput_Reset(ARUPDATER_Throughput_t *throughput)
+{
+    memset(throughput, 0, sizeof(ARUPDATER_Throughput_t));
+}
+
+void ARUPDATER_Throughput_Update(ARUPDATER_Throughput_t *throughput, uint64_t bytes)
+{
+    struct timespec now;
+    double interval;
+    double rate;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (!throughput->isStarted)
+    {
+        throughput->isStarted = 1;
+        throughput->startTime = now;
+        throughput->sampleTime = now;
+        throughput->sampleBytes = bytes;
+        return;
+    }
+
+    interval = ARUPDATER_Throughput_Diff(&throughput->sampleTime, &now);
+    if ((interval < ARUPDATER_THROUGHPUT_MIN_INTERVAL_SEC) || (bytes < throughput->sampleBytes))
+    {
+        return;
+    }
+
+    rate = (double)(bytes - throughput->sampleBytes) / interval;
+    if (throughput->rate == 0)
+    {
+        throughput->rate = rate;
+    }
+    else
+    {
+        throughput->rate += ARUPDATER_THROUGHPUT_SMOOTHING * (rate - throughput->rate);
+    }
+
+    throughput->sampleTime = now;
+    throughput->sampleBytes = bytes;
+}
+
+double ARUPDATER_Throughput_GetRate(const ARUPDATER_Throughput_t *throughput)
+{
+    return throughput->rate;
+}
+
+double ARUPDATER_Throughput_GetElapsed(const ARUPDATER_Throughput_t *throughput)
+{
+    struct timespec now;
+
+    if (!throughput->isStarted)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ARUPDATER_Throughput_Diff(&throughput->startTime, &now);
+}
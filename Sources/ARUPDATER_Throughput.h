@@ -0,0 +1,79 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ARUPDATER_Throughput.h
+ * @brief libARUpdater throughput meter header file.
+ **/
+
+#ifndef _ARUPDATER_THROUGHPUT_PRIVATE_H_
+#define _ARUPDATER_THROUGHPUT_PRIVATE_H_
+
+#include <stdint.h>
+#include <time.h>
+
+typedef struct
+{
+    int isStarted;
+    struct timespec startTime;      /* time of the first sample */
+    struct timespec sampleTime;     /* time of the last sample taken into the rate */
+    uint64_t sampleBytes;           /* byte count of the last sample taken into the rate */
+    double rate;                    /* smoothed rate in bytes/s, 0 until a full interval was seen */
+} ARUPDATER_Throughput_t;
+
+/**
+ * @brief Restart a measure
+ * @param throughput : the meter
+ */
+void ARUPDATER_Throughput_Reset(ARUPDATER_Throughput_t *throughput);
+
+/**
+ * @brief Give the meter the number of bytes transferred so far
+ * @details The first sample after a reset is the reference of the measure.
+ * @param throughput : the meter
+ * @param[in] bytes : total number of bytes transferred
+ */
+void ARUPDATER_Throughput_Update(ARUPDATER_Throughput_t *throughput, uint64_t bytes);
+
+/**
+ * @brief Get the smoothed rate
+ * @param throughput : the meter
+ * @return the rate in bytes/s, 0 if unknown yet
+ */
+double ARUPDATER_Throughput_GetRate(const ARUPDATER_Throughput_t *throughput);
+
+/**
+ * @brief Get the duration of the measure
+ * @param throughput : the meter
+ * @return the number of seconds since the first sample
+ */
+double ARUPDATER_Throughput_GetElapsed(const ARUPDATER_Throughput_t *throughput);
+
+#endif /* _ARUPDATER_THROUGHPUT_PRIVATE_H_ */
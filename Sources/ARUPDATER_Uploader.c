@@ -39,12 +39,16 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <signal.h>
 #include <poll.h>
+#include <time.h>
+#include <unistd.h>
 
 #if defined BUILD_LIBMUX
 #include <libpomp.h>
@@ -52,6 +56,10 @@
 #include <libmux-update.h>
 #endif
 
+#if defined BUILD_ZLIB
+#include <zlib.h>
+#endif
+
 #include <libARSAL/ARSAL_Print.h>
 #include <libARUtils/ARUtils.h>
 #include <libARSAL/ARSAL_Error.h>
@@ -59,6 +67,10 @@
 
 #include "ARUPDATER_Uploader.h"
 #include "ARUPDATER_Utils.h"
+#include "ARUPDATER_Manifest.h"
+#include "ARUPDATER_Crc32c.h"
+#include "ARUPDATER_FtpSegments.h"
+#include "ARUPDATER_Arena.h"
 
 /* ***************************************
  *
@@ -68,9 +80,65 @@
 #define ARUPDATER_UPLOADER_TAG                   "ARUPDATER_Uploader"
 #define ARUPDATER_UPLOADER_REMOTE_FOLDER         "/"
 #define ARUPDATER_UPLOADER_MD5_FILENAME          "md5_check.md5"
+#define ARUPDATER_UPLOADER_MANIFEST_FILENAME     "md5_check.chunks"
 #define ARUPDATER_UPLOADER_UPLOADED_FILE_SUFFIX  ".tmp"
-#define ARUPDATER_UPLOADER_CHUNK_SIZE            32
 #define ARUPDATER_UPLOADER_MUX_CHUNK_SIZE        (128*1024)
+/* windowed mux update: extension of the libmux-update protocol */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_CAPS_REQ   0x100   /* host -> remote, window wanted */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_CAPS       0x101   /* remote -> host, window accepted, flags and buffer size */
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_CAPS_REQ  "%u"
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_CAPS      "%u%u%u"
+#define ARUPDATER_UPLOADER_MUX_CAPS_CUMULATIVE   0x1     /* acks cover all the chunks before them */
+#define ARUPDATER_UPLOADER_MUX_CAPS_CHUNK_SIZE   0x2     /* chunks of any size up to the buffer are accepted */
+#define ARUPDATER_UPLOADER_MUX_CAPS_RESUME       0x4     /* interrupted updates can be resumed */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_RESUME_REQ 0x102   /* host -> remote, chunk id and offset offered */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_RESUME     0x103   /* remote -> host, chunk id and offset to restart from */
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_RESUME    "%u%u"
+#define ARUPDATER_UPLOADER_MUX_CAPS_CHUNK_CRC    0x8     /* chunks carry a crc32c, corrupted ones are nacked */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_CRC  0x104   /* host -> remote, chunk id, crc32c and data */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_NACK 0x105   /* remote -> host, id of a corrupted chunk */
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_CRC "%u%u%p%u"
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_NACK "%u"
+#define ARUPDATER_UPLOADER_MUX_CAPS_DEFLATE      0x10    /* compressed chunks are accepted */
+#define ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_DEFLATE 0x106 /* host -> remote, chunk id, crc32c and size of the data, raw deflate data */
+#define ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_DEFLATE "%u%u%u%p%u"
+/* a compressed chunk is sent if it is at least 1/16 smaller, after an incompressible
+ * chunk the next ones are sent as they are */
+#define ARUPDATER_UPLOADER_MUX_DEFLATE_MIN_GAIN  16
+#define ARUPDATER_UPLOADER_MUX_DEFLATE_SKIP      4
+#define ARUPDATER_UPLOADER_MUX_JOURNAL_FILENAME  "mux_resume"
+/* adaptive chunk size bounds, and ack round trip time aimed at per chunk in flight */
+#define ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MIN    (16*1024)
+#define ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MAX    (1024*1024)
+#define ARUPDATER_UPLOADER_MUX_TARGET_RTT_MS     250
+/* chunks read ahead while the sent ones are in flight */
+#define ARUPDATER_UPLOADER_MUX_PREFETCH_CHUNKS   2
+#define ARUPDATER_UPLOADER_MUX_ACK_TIMEOUT_MS    2000
+#define ARUPDATER_UPLOADER_MUX_RETRY_PERIOD_MS   250
+#define ARUPDATER_UPLOADER_MUX_MAX_RETRIES       5
+#define ARUPDATER_UPLOADER_RESUME_MAX_CHECKS     4
+#define ARUPDATER_UPLOADER_PROBE_FILENAME        "transport_probe.tmp"
+/* plf path given to the Delos ftp, for its upload and its size */
+#define ARUPDATER_UPLOADER_DELOS_REMOTE_PATH     ""
+#define ARUPDATER_UPLOADER_DELOS_JOURNAL_FILENAME "delos_resume"
+#define ARUPDATER_UPLOADER_PROBE_SIZE            (512*1024)
+/* a transport is measured for this long before being compared to the other one */
+#define ARUPDATER_UPLOADER_TRANSPORT_WARMUP_SEC  2.0
+/* the other transport must be this much faster to switch to it */
+#define ARUPDATER_UPLOADER_TRANSPORT_MARGIN      1.5
+#define ARUPDATER_UPLOADER_TRANSPORT_MAX_SWITCH  2
+/* default limits of the progress callback: 10 per second, every 0.1% */
+#define ARUPDATER_UPLOADER_PROGRESS_INTERVAL_MS  100
+#define ARUPDATER_UPLOADER_PROGRESS_STEP         0.1f
+
+/* ***************************************
+ *
+ *             function declarations :
+ *
+ *****************************************/
+static eARUPDATER_UPLOADER_TRANSPORT ARUPDATER_Uploader_SelectTransport(ARUPDATER_Manager_t *manager);
+static void ARUPDATER_Uploader_AbortFtpTransfer(ARUPDATER_Uploader_t *uploader);
+
 /* ***************************************
  *
  *             function implementation :
@@ -82,7 +150,6 @@ eARUPDATER_ERROR ARUPDATER_Uploader_New(ARUPDATER_Manager_t* manager, const char
     ARUPDATER_Uploader_t *uploader = NULL;
     eARUPDATER_ERROR err = ARUPDATER_OK;
     int ret;
-    int pipefds[2];
     char *slash = NULL;
     
     // Check parameters
@@ -143,6 +210,48 @@ eARUPDATER_ERROR ARUPDATER_Uploader_New(ARUPDATER_Manager_t* manager, const char
         uploader->isAndroidApp = isAndroidApp;
         uploader->ftpManager = ftpManager;
         uploader->mux = mux;
+        uploader->ftpServer = NULL;
+        uploader->ftpPort = 0;
+        uploader->ftpUsername = NULL;
+        uploader->ftpPassword = NULL;
+        uploader->ftpConnection = NULL;
+        uploader->ftpBytesDone = 0;
+        uploader->ftpBytesTotal = 0;
+        uploader->ftpSegmentCount = 1;
+        uploader->ftpSegments = NULL;
+        uploader->muxChannel = 0;
+        uploader->muxWindow = 1;
+        uploader->muxAdaptive = 0;
+        uploader->muxResume = 0;
+        uploader->delosResume = 0;
+        uploader->bleMtu = 0;
+        uploader->bleWindow = 0;
+        uploader->bleWriteCallback = NULL;
+        uploader->bleWriteArg = NULL;
+        uploader->bleUpload = NULL;
+        memset(&uploader->plf, 0, sizeof(uploader->plf));
+        uploader->muxCrc = 0;
+        uploader->muxDeflate = 0;
+        uploader->muxDeflateStream = NULL;
+        uploader->muxDeflateBuffer = NULL;
+        uploader->events.fds[0] = -1;
+        uploader->events.fds[1] = -1;
+        uploader->muxWindowActive = 1;
+        uploader->muxCumulativeAck = 0;
+        uploader->deviceVersion = NULL;
+        uploader->deviceMd5 = NULL;
+        uploader->transportSelection = 0;
+        uploader->transportSelecting = 0;
+        uploader->transportSwitch = 0;
+        uploader->transportSwitchCount = 0;
+        uploader->ftpRate = 0;
+        uploader->muxRate = 0;
+        ARUPDATER_Throughput_Reset(&uploader->throughput);
+        memset(&uploader->progress, 0, sizeof(uploader->progress));
+        ARUPDATER_Progress_SetLimit(&uploader->progress, ARUPDATER_UPLOADER_PROGRESS_INTERVAL_MS, ARUPDATER_UPLOADER_PROGRESS_STEP);
+        uploader->hasPlfMd5 = 0;
+        uploader->plfManifest = NULL;
+        uploader->localFileSuffix = NULL;
 #if defined BUILD_LIBMUX
         if (uploader->mux)
             mux_ref(uploader->mux);
@@ -187,21 +296,33 @@ eARUPDATER_ERROR ARUPDATER_Uploader_New(ARUPDATER_Manager_t* manager, const char
     
     if (err == ARUPDATER_OK)
     {
-        /* create pair of pipes for mux update */
-        ret = pipe(pipefds);
+        int resultSys = ARSAL_Mutex_Init(&manager->uploader->muxLock);
+        
+        if (resultSys != 0)
+        {
+            err = ARUPDATER_ERROR_SYSTEM;
+        }
+    }
+    
+    if (err == ARUPDATER_OK)
+    {
+        int resultSys = ARSAL_Mutex_Init(&manager->uploader->progressLock);
+        
+        if (resultSys != 0)
+        {
+            err = ARUPDATER_ERROR_SYSTEM;
+        }
+    }
+    
+    if (err == ARUPDATER_OK)
+    {
+        /* create the event ring of mux updates */
+        ret = ARUPDATER_EventRing_Init(&manager->uploader->events);
         if (ret < 0) {
-             ret = -errno;
              ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-                  "pipe error %s", strerror(-ret));
+                  "event ring error %s", strerror(-ret));
              err = ARUPDATER_ERROR_SYSTEM;
         }
-
-        /* set pipes non blocking */
-        fcntl(pipefds[0], F_SETFL, fcntl(pipefds[0], F_GETFL, 0) | O_NONBLOCK);
-        fcntl(pipefds[1], F_SETFL, fcntl(pipefds[1], F_GETFL, 0) | O_NONBLOCK);
-
-        manager->uploader->pipefds[0] = pipefds[0];
-        manager->uploader->pipefds[1] = pipefds[1];
     }
 
     /* delete the uploader if an error occurred */
@@ -236,12 +357,19 @@ eARUPDATER_ERROR ARUPDATER_Uploader_Delete(ARUPDATER_Manager_t *manager)
             else
             {
                 ARSAL_Mutex_Destroy(&manager->uploader->uploadLock);
+                ARSAL_Mutex_Destroy(&manager->uploader->muxLock);
+                ARSAL_Mutex_Destroy(&manager->uploader->progressLock);
                 free(manager->uploader->rootFolder);
                 manager->uploader->rootFolder = NULL;
+                free(manager->uploader->ftpServer);
+                free(manager->uploader->ftpUsername);
+                free(manager->uploader->ftpPassword);
+                free(manager->uploader->localFileSuffix);
+                free(manager->uploader->deviceVersion);
+                free(manager->uploader->deviceMd5);
                 
                 ARDATATRANSFER_Manager_Delete(&manager->uploader->dataTransferManager);
-                close(manager->uploader->pipefds[0]);
-                close(manager->uploader->pipefds[1]);
+                ARUPDATER_EventRing_Destroy(&manager->uploader->events);
 #if defined BUILD_LIBMUX
                 if (manager->uploader->mux) {
                     mux_unref(manager->uploader->mux);
@@ -257,265 +385,1561 @@ eARUPDATER_ERROR ARUPDATER_Uploader_Delete(ARUPDATER_Manager_t *manager)
     return error;
 }
 
-void* ARUPDATER_Uploader_ThreadRun(void *managerArg)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetFtpServer(ARUPDATER_Manager_t *manager, const char *server, int port, const char *username, const char *password)
 {
     eARUPDATER_ERROR error = ARUPDATER_OK;
-    
-    ARUPDATER_Manager_t *manager = NULL;
-    if (managerArg != NULL)
+    ARUPDATER_Uploader_t *uploader = NULL;
+
+    if (manager == NULL)
     {
-        manager = (ARUPDATER_Manager_t*)managerArg;
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    else
+    else if (manager->uploader == NULL)
     {
-        error = ARUPDATER_ERROR_BAD_PARAMETER;
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
     }
-    
-    if ((manager != NULL) && (manager->uploader != NULL))
+    else if (manager->uploader->isRunning != 0)
     {
-        if ((manager->uploader->ftpManager->networkType == ARDISCOVERY_NETWORK_TYPE_BLE) &&
-            (manager->uploader->isAndroidApp == 1))
-        {
-            error = ARUPDATER_Uploader_ThreadRunAndroidDelos(manager);
-        }
-        else if (manager->uploader->mux &&
-                 ARDISCOVERY_getProductFamily(manager->uploader->product) == ARDISCOVERY_PRODUCT_FAMILY_SKYCONTROLLER)
-        {
-           // upload plf over mux
-           error = ARUPDATER_Uploader_ThreadRunMux(manager);
-        }
-        else
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (error == ARUPDATER_OK)
+    {
+        uploader = manager->uploader;
+
+        free(uploader->ftpServer);
+        free(uploader->ftpUsername);
+        free(uploader->ftpPassword);
+        uploader->ftpServer = NULL;
+        uploader->ftpUsername = NULL;
+        uploader->ftpPassword = NULL;
+        uploader->ftpPort = port;
+
+        if (server != NULL)
         {
-            // upload plf the normal way
-            error = ARUPDATER_Uploader_ThreadRunNormal(manager);
+            uploader->ftpServer = strdup(server);
+            uploader->ftpUsername = (username != NULL) ? strdup(username) : NULL;
+            uploader->ftpPassword = (password != NULL) ? strdup(password) : NULL;
+            if ((uploader->ftpServer == NULL) ||
+                ((username != NULL) && (uploader->ftpUsername == NULL)) ||
+                ((password != NULL) && (uploader->ftpPassword == NULL)))
+            {
+                error = ARUPDATER_ERROR_ALLOC;
+            }
         }
     }
-    else
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetFtpSegmentCount(ARUPDATER_Manager_t *manager, int segmentCount)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (segmentCount < 1) || (segmentCount > ARUPDATER_FTP_SEGMENTS_MAX))
     {
         error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    
-    return (void*)error;
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->ftpSegmentCount = segmentCount;
+    }
+
+    return error;
 }
 
-eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunAndroidDelos(ARUPDATER_Manager_t *manager)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetDeviceVersion(ARUPDATER_Manager_t *manager, const char *version, const char *md5Txt)
 {
     eARUPDATER_ERROR error = ARUPDATER_OK;
-    
-    if (manager && manager->uploader)
+    ARUPDATER_PlfVersion v;
+    char *versionCopy = NULL;
+    char *md5Copy = NULL;
+
+    if (manager == NULL)
     {
-        manager->uploader->isRunning = 1;
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    else
+    else if (manager->uploader == NULL)
     {
-        return ARUPDATER_ERROR_BAD_PARAMETER;
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
     }
-
-    eARDATATRANSFER_ERROR dataTransferError = ARDATATRANSFER_OK;
-    
-    char *sourceFileFolder = NULL;
-    char *sourceFilePath = NULL;
-    char *device = NULL;
-    char *fileName = NULL;
-    
-    uint16_t productId = ARDISCOVERY_getProductID(manager->uploader->product);
-    device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-    if (device == NULL)
+    else if (manager->uploader->isRunning != 0)
     {
-        error = ARUPDATER_ERROR_ALLOC;
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
     }
-    
-    if (error == ARUPDATER_OK)
+    else if ((version != NULL) && (ARUPDATER_Utils_PlfVersionFromString(version, &v) != ARUPDATER_OK))
     {
-        snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
-        
-        sourceFileFolder = malloc(strlen(manager->uploader->rootFolder) + strlen(ARUPDATER_MANAGER_PLF_FOLDER) + strlen(device) + strlen(ARUPDATER_MANAGER_FOLDER_SEPARATOR) + 1);
-        strcpy(sourceFileFolder, manager->uploader->rootFolder);
-        strcat(sourceFileFolder, ARUPDATER_MANAGER_PLF_FOLDER);
-        strcat(sourceFileFolder, device);
-        strcat(sourceFileFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
-        
-        error = ARUPDATER_Utils_GetPlfInFolder(sourceFileFolder, &fileName);
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    
-    if (error == ARUPDATER_OK)
+    else if ((md5Txt != NULL) && (strlen(md5Txt) != 2 * ARSAL_MD5_LENGTH))
     {
-        sourceFilePath = malloc(strlen(sourceFileFolder) + strlen(fileName) + 1);
-        if (sourceFilePath == NULL)
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    if ((ARUPDATER_OK == error) && (version != NULL))
+    {
+        versionCopy = strdup(version);
+        md5Copy = (md5Txt != NULL) ? strdup(md5Txt) : NULL;
+        if ((versionCopy == NULL) || ((md5Txt != NULL) && (md5Copy == NULL)))
         {
+            free(versionCopy);
+            free(md5Copy);
             error = ARUPDATER_ERROR_ALLOC;
         }
     }
-    
+
     if (ARUPDATER_OK == error)
     {
-        strcpy(sourceFilePath, sourceFileFolder);
-        strcat(sourceFilePath, fileName);
-        
-        // by default, do not resume an upload
-        eARDATATRANSFER_UPLOADER_RESUME resumeMode = ARDATATRANSFER_UPLOADER_RESUME_FALSE;
-        
-        ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
-        // create a new uploader
-        dataTransferError = ARDATATRANSFER_Uploader_New(manager->uploader->dataTransferManager, manager->uploader->ftpManager, "", sourceFilePath, ARUPDATER_Uploader_ProgressCallback, manager, ARUPDATER_Uploader_CompletionCallback, manager, resumeMode);
-        if (ARDATATRANSFER_OK != dataTransferError)
-        {
-            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
-        }
-        ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+        free(manager->uploader->deviceVersion);
+        free(manager->uploader->deviceMd5);
+        manager->uploader->deviceVersion = versionCopy;
+        manager->uploader->deviceMd5 = md5Copy;
     }
-    
-    if ((ARUPDATER_OK == error) && (manager->uploader->isCanceled == 0))
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxWindow(ARUPDATER_Manager_t *manager, int chunks)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (chunks < 1) || (chunks > ARUPDATER_UPLOADER_MUX_WINDOW_MAX))
     {
-        manager->uploader->isUploadThreadRunning = 1;
-        ARDATATRANSFER_Uploader_ThreadRun(manager->uploader->dataTransferManager);
-        manager->uploader->isUploadThreadRunning = 0;
-        if (manager->uploader->uploadError != ARDATATRANSFER_OK)
-        {
-            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "ARDataTransferError = %d", manager->uploader->uploadError);
-            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
-        }
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    
-    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
-    if (ARUPDATER_OK == error)
+    else if (manager->uploader == NULL)
     {
-        dataTransferError = ARDATATRANSFER_Uploader_Delete(manager->uploader->dataTransferManager);
-        if (ARDATATRANSFER_OK != dataTransferError)
-        {
-            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
-        }
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
     }
-    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
-    
-    if (error != ARUPDATER_OK)
+    else if (manager->uploader->isRunning != 0)
     {
-        ARSAL_PRINT (ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "error: %s", ARUPDATER_Error_ToString (error));
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
     }
-    
-    if (sourceFileFolder != NULL)
+
+    if (ARUPDATER_OK == error)
     {
-        free(sourceFileFolder);
+        manager->uploader->muxWindow = chunks;
     }
-    if (sourceFilePath != NULL)
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChunkAdaptive(ARUPDATER_Manager_t *manager, int enabled)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if (manager == NULL)
     {
-        free(sourceFilePath);
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
     }
-    if (device != NULL)
+    else if (manager->uploader == NULL)
     {
-        free(device);
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
     }
-    if (fileName != NULL)
+    else if (manager->uploader->isRunning != 0)
     {
-        free(fileName);
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
     }
 
-    manager->uploader->isRunning = 0;
-
-    if (manager->uploader->completionCallback != NULL)
+    if (ARUPDATER_OK == error)
     {
-        manager->uploader->completionCallback(manager->uploader->completionArg, error);
+        manager->uploader->muxAdaptive = (enabled != 0) ? 1 : 0;
     }
-    
+
     return error;
 }
 
-#if defined BUILD_LIBMUX
-static int updater_mux_write_msg(struct mux_ctx *mux, uint32_t msgid,
-		const char *fmt, ...)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxResume(ARUPDATER_Manager_t *manager, int enabled)
 {
-	int res = 0;
-	struct pomp_msg *msg = NULL;
-	va_list args;
-
-	msg = pomp_msg_new();
-	if (msg == NULL)
-		return -ENOMEM;
-
-	va_start(args, fmt);
-	res = pomp_msg_writev(msg, msgid, fmt, args);
-	va_end(args);
-	if (res < 0) {
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-				"pomp_msg_writev error: %s", strerror(-res));
-		goto out;
-	}
+    eARUPDATER_ERROR error = ARUPDATER_OK;
 
-	res = mux_encode(mux, MUX_UPDATE_CHANNEL_ID_UPDATE,
-			pomp_msg_get_buffer(msg));
-	if (res < 0 && res != -EPIPE) {
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
 
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-				"mux_encode error: %s", strerror(-res));
-		goto out;
-	}
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->muxResume = (enabled != 0) ? 1 : 0;
+    }
 
-out:
-	pomp_msg_destroy(msg);
-	return res;
+    return error;
 }
 
-static void update_mux_notify_status(ARUPDATER_Uploader_t *up,
-		eARUPDATER_ERROR status)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChannel(ARUPDATER_Manager_t *manager, uint32_t channelId)
 {
-	int ret;
-	int event = status;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->muxChannel = channelId;
+    }
 
-	do {
-		ret = write(up->pipefds[1], &event, sizeof(event));
-	} while (ret < 0 && errno == EINTR);
+    return error;
 }
 
-static void update_mux_notify_progression(ARUPDATER_Uploader_t *up,
-		float percent)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxChunkCrc(ARUPDATER_Manager_t *manager, int enabled)
 {
-	int ret;
-	int event = (int)percent;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
 
-	if (event <= 0)
-		return;
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->muxCrc = (enabled != 0) ? 1 : 0;
+    }
 
-	do {
-		ret = write(up->pipefds[1], &event, sizeof(event));
-	} while (ret < 0 && errno == EINTR);
+    return error;
 }
 
-static int updater_mux_send_next_chunk(ARUPDATER_Uploader_t *up)
+eARUPDATER_ERROR ARUPDATER_Uploader_SetMuxCompression(ARUPDATER_Manager_t *manager, int enabled)
 {
-	ssize_t ret;
-	uint32_t n_bytes;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
 
-	/* read file chunk */
-	ret = read(up->fd, up->chunk, ARUPDATER_UPLOADER_MUX_CHUNK_SIZE);
-	if (ret < 0) {
-		ret = -errno;
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-				"read update file error: %s", strerror(-ret));
-		return ret;
-	}
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+#if !defined BUILD_ZLIB
+    else if (enabled != 0)
+    {
+        /* built without zlib */
+        error = ARUPDATER_ERROR_SYSTEM;
+    }
+#endif
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->muxDeflate = (enabled != 0) ? 1 : 0;
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_GetMuxStats(ARUPDATER_Manager_t *manager, ARUPDATER_Uploader_MuxStats_t *stats)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (stats == NULL))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_Mutex_Lock(&manager->uploader->muxLock);
+        *stats = manager->uploader->muxStats;
+        ARSAL_Mutex_Unlock(&manager->uploader->muxLock);
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetDelosResume(ARUPDATER_Manager_t *manager, int enabled)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->delosResume = (enabled != 0) ? 1 : 0;
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetBleLink(ARUPDATER_Manager_t *manager, int mtu, int window, ARUPDATER_Uploader_BleWriteCallback_t writeCallback, void *writeArg)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) ||
+        ((writeCallback != NULL) && ((mtu < ARUPDATER_BLE_UPLOAD_MTU_MIN) || (mtu > ARUPDATER_BLE_UPLOAD_MTU_MAX) ||
+                                     (window < 1) || (window > ARUPDATER_BLE_UPLOAD_WINDOW_MAX))))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->bleMtu = mtu;
+        manager->uploader->bleWindow = window;
+        manager->uploader->bleWriteCallback = writeCallback;
+        manager->uploader->bleWriteArg = writeArg;
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_BleReceive(ARUPDATER_Manager_t *manager, const uint8_t *data, size_t len)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (data == NULL))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+        if (manager->uploader->bleUpload != NULL)
+        {
+            ARUPDATER_BleUpload_Receive(manager->uploader->bleUpload, data, len);
+        }
+        ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetProgressLimit(ARUPDATER_Manager_t *manager, int intervalMs, float stepPercent)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (intervalMs < 0) || (stepPercent < 0))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_Mutex_Lock(&manager->uploader->progressLock);
+        ARUPDATER_Progress_SetLimit(&manager->uploader->progress, intervalMs, stepPercent);
+        ARSAL_Mutex_Unlock(&manager->uploader->progressLock);
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_GetProgress(ARUPDATER_Manager_t *manager, ARUPDATER_Uploader_Progress_t *progress)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || (progress == NULL))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_Mutex_Lock(&manager->uploader->progressLock);
+        progress->bytesDone = manager->uploader->progress.bytesDone;
+        progress->bytesTotal = manager->uploader->progress.bytesTotal;
+        progress->percent = ARUPDATER_Progress_GetPercent(&manager->uploader->progress);
+        progress->rate = ARUPDATER_Progress_GetRate(&manager->uploader->progress);
+        progress->etaSec = ARUPDATER_Progress_GetEta(&manager->uploader->progress);
+        ARSAL_Mutex_Unlock(&manager->uploader->progressLock);
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetTransportSelection(ARUPDATER_Manager_t *manager, int enabled)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        manager->uploader->transportSelection = (enabled != 0);
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetPlfDigest(ARUPDATER_Manager_t *manager, const uint8_t *md5, const ARUPDATER_Manifest_t *manifest)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if ((manager == NULL) || ((md5 == NULL) && (manifest != NULL)))
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if ((ARUPDATER_OK == error) && (md5 != NULL))
+    {
+        memcpy(manager->uploader->plfMd5, md5, ARSAL_MD5_LENGTH);
+        manager->uploader->hasPlfMd5 = 1;
+        manager->uploader->plfManifest = manifest;
+    }
+    else if (ARUPDATER_OK == error)
+    {
+        /* forget the digest, the next run computes it again from the plf */
+        manager->uploader->hasPlfMd5 = 0;
+        manager->uploader->plfManifest = NULL;
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_SetLocalFileSuffix(ARUPDATER_Manager_t *manager, const char *suffix)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    char *suffixCopy = NULL;
+
+    if (manager == NULL)
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    else if (manager->uploader == NULL)
+    {
+        error = ARUPDATER_ERROR_MANAGER_NOT_INITIALIZED;
+    }
+    else if (manager->uploader->isRunning != 0)
+    {
+        error = ARUPDATER_ERROR_THREAD_PROCESSING;
+    }
+
+    if ((ARUPDATER_OK == error) && (suffix != NULL))
+    {
+        suffixCopy = strdup(suffix);
+        if (suffixCopy == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        free(manager->uploader->localFileSuffix);
+        manager->uploader->localFileSuffix = suffixCopy;
+    }
+
+    return error;
+}
+
+/* path of the plf, and of its folder when folder is not NULL, built in the arena of the caller */
+static eARUPDATER_ERROR ARUPDATER_Uploader_GetPlfPath(ARUPDATER_Uploader_t *uploader, ARUPDATER_Arena_t *arena, char **folder, char **filePath)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    char *plfFolder = NULL;
+    char *fileName = NULL;
+
+    plfFolder = ARUPDATER_Arena_Printf(arena, "%s%s%04x%s", uploader->rootFolder, ARUPDATER_MANAGER_PLF_FOLDER,
+                                       ARDISCOVERY_getProductID(uploader->product), ARUPDATER_MANAGER_FOLDER_SEPARATOR);
+    if (plfFolder == NULL)
+    {
+        error = ARUPDATER_ERROR_ALLOC;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Utils_GetPlfInFolder(plfFolder, &fileName);
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        *filePath = ARUPDATER_Arena_Concat(arena, plfFolder, fileName, NULL);
+        if (*filePath == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+
+    if ((ARUPDATER_OK == error) && (folder != NULL))
+    {
+        *folder = plfFolder;
+    }
+
+    free(fileName);
+
+    return error;
+}
+
+static eARUPDATER_ERROR ARUPDATER_Uploader_GetPlfMd5(ARUPDATER_Uploader_t *uploader, const char *filePath, uint8_t *md5)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    if (uploader->hasPlfMd5)
+    {
+        memcpy(md5, uploader->plfMd5, ARSAL_MD5_LENGTH);
+    }
+    else if (ARSAL_MD5_Manager_Compute(uploader->md5Manager, filePath, md5, ARSAL_MD5_LENGTH) != ARSAL_OK)
+    {
+        error = ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR;
+    }
+
+    return error;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_OpenPlf(ARUPDATER_Uploader_t *uploader)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Arena_t arena;
+    char *filePath = NULL;
+
+    ARUPDATER_Arena_Init(&arena);
+    error = ARUPDATER_Uploader_GetPlfPath(uploader, &arena, NULL, &filePath);
+
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Plf_Open(&uploader->plf, filePath, ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MAX);
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "%s: %zu bytes, %d sections", filePath, uploader->plf.size, uploader->plf.sectionCount);
+    }
+
+    ARUPDATER_Arena_Release(&arena);
+
+    return error;
+}
+
+/* start the progress of an upload of bytesTotal bytes, on any transport */
+static void ARUPDATER_Uploader_StartProgress(ARUPDATER_Uploader_t *uploader, uint64_t bytesTotal)
+{
+    ARSAL_Mutex_Lock(&uploader->progressLock);
+    ARUPDATER_Progress_Start(&uploader->progress, bytesTotal);
+    ARSAL_Mutex_Unlock(&uploader->progressLock);
+}
+
+/* give the bytes done so far, the progress callback is called within the limits of ARUPDATER_Uploader_SetProgressLimit */
+static void ARUPDATER_Uploader_ReportProgress(ARUPDATER_Uploader_t *uploader, uint64_t bytesDone)
+{
+    float percent = 0;
+    int isDue = 0;
+
+    ARSAL_Mutex_Lock(&uploader->progressLock);
+    isDue = ARUPDATER_Progress_Update(&uploader->progress, bytesDone);
+    percent = ARUPDATER_Progress_GetPercent(&uploader->progress);
+    ARSAL_Mutex_Unlock(&uploader->progressLock);
+
+    if (isDue && (uploader->progressCallback != NULL))
+    {
+        uploader->progressCallback(uploader->progressArg, percent);
+    }
+}
+
+/* measure the running transport, returns 1 if it should be left for the other one;
+ * bytes counts from the start of the plf, as the other transport is expected to restart */
+static int ARUPDATER_Uploader_TransportDegraded(ARUPDATER_Uploader_t *uploader, eARUPDATER_UPLOADER_TRANSPORT transport, uint64_t bytes)
+{
+    double rate = 0;
+    double otherRate = 0;
+
+    if ((uploader->transportSelecting == 0) || (uploader->transportSwitch != 0) ||
+        (uploader->transportSwitchCount >= ARUPDATER_UPLOADER_TRANSPORT_MAX_SWITCH))
+    {
+        return 0;
+    }
+
+    ARUPDATER_Throughput_Update(&uploader->throughput, bytes);
+    if (ARUPDATER_Throughput_GetElapsed(&uploader->throughput) < ARUPDATER_UPLOADER_TRANSPORT_WARMUP_SEC)
+    {
+        return 0;
+    }
+
+    rate = ARUPDATER_Throughput_GetRate(&uploader->throughput);
+    if (transport == ARUPDATER_UPLOADER_TRANSPORT_MUX)
+    {
+        uploader->muxRate = rate;
+        otherRate = uploader->ftpRate;
+    }
+    else
+    {
+        uploader->ftpRate = rate;
+        otherRate = uploader->muxRate;
+    }
+
+    // a switch restarts the transfer from byte 0: it must also beat what is left here
+    if ((rate > 0) && (otherRate > rate * ARUPDATER_UPLOADER_TRANSPORT_MARGIN) && (bytes < uploader->plf.size) &&
+        ((double)uploader->plf.size * rate < (double)(uploader->plf.size - bytes) * otherRate))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "%s degraded: %.0f B/s against %.0f B/s, switching transport",
+                    (transport == ARUPDATER_UPLOADER_TRANSPORT_MUX) ? "mux" : "ftp", rate, otherRate);
+        uploader->transportSwitch = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* returns 1 if the device reported the version (and md5) of the local plf */
+static int ARUPDATER_Uploader_DeviceIsUpToDate(ARUPDATER_Uploader_t *uploader)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_PlfVersion local;
+    ARUPDATER_PlfVersion device;
+    ARUPDATER_Arena_t arena;
+    char *filePath = NULL;
+    uint8_t md5[ARSAL_MD5_LENGTH];
+    char md5Txt[2 * ARSAL_MD5_LENGTH + 1];
+    int i;
+
+    if (uploader->deviceVersion == NULL)
+    {
+        return 0;
+    }
+
+    error = ARUPDATER_Utils_PlfVersionFromHeader(&uploader->plf.header, &local);
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Utils_PlfVersionFromString(uploader->deviceVersion, &device);
+    }
+    if ((ARUPDATER_OK != error) || (ARUPDATER_Utils_PlfVersionCompare(&local, &device) != 0))
+    {
+        return 0;
+    }
+
+    // same version, the md5 decides when the device gave it
+    if (uploader->deviceMd5 != NULL)
+    {
+        ARUPDATER_Arena_Init(&arena);
+        error = ARUPDATER_Uploader_GetPlfPath(uploader, &arena, NULL, &filePath);
+        if (ARUPDATER_OK == error)
+        {
+            error = ARUPDATER_Uploader_GetPlfMd5(uploader, filePath, md5);
+        }
+        ARUPDATER_Arena_Release(&arena);
+        if (ARUPDATER_OK != error)
+        {
+            return 0;
+        }
+        for (i = 0; i < ARSAL_MD5_LENGTH; i++)
+        {
+            snprintf(&md5Txt[i * 2], 3, "%02x", md5[i]);
+        }
+        if (strcasecmp(md5Txt, uploader->deviceMd5) != 0)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "device runs %s with another md5, uploading", uploader->deviceVersion);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void* ARUPDATER_Uploader_ThreadRun(void *managerArg)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    
+    ARUPDATER_Manager_t *manager = NULL;
+    if (managerArg != NULL)
+    {
+        manager = (ARUPDATER_Manager_t*)managerArg;
+    }
+    else
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    
+    if ((manager != NULL) && (manager->uploader != NULL))
+    {
+        manager->uploader->isRunning = 1;
+        
+        // every transport reads the plf opened here
+        error = ARUPDATER_Uploader_OpenPlf(manager->uploader);
+        
+        if (error != ARUPDATER_OK)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "no valid plf to upload: %s", ARUPDATER_Error_ToString(error));
+        }
+        else if (ARUPDATER_Uploader_DeviceIsUpToDate(manager->uploader))
+        {
+            ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "device already runs %s, nothing to upload", manager->uploader->deviceVersion);
+            error = ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE;
+        }
+        else
+        {
+            eARUPDATER_UPLOADER_TRANSPORT transport = ARUPDATER_Uploader_SelectTransport(manager);
+            
+            do
+            {
+                manager->uploader->transportSwitch = 0;
+                ARUPDATER_Throughput_Reset(&manager->uploader->throughput);
+                
+                if (transport == ARUPDATER_UPLOADER_TRANSPORT_DELOS)
+                {
+                    error = ARUPDATER_Uploader_ThreadRunAndroidDelos(manager);
+                }
+                else if (transport == ARUPDATER_UPLOADER_TRANSPORT_BLE)
+                {
+                    error = ARUPDATER_Uploader_ThreadRunBle(manager);
+                }
+                else if (transport == ARUPDATER_UPLOADER_TRANSPORT_MUX)
+                {
+                   // upload plf over mux
+                   error = ARUPDATER_Uploader_ThreadRunMux(manager);
+                }
+                else
+                {
+                    // upload plf the normal way
+                    error = ARUPDATER_Uploader_ThreadRunNormal(manager);
+                }
+                
+                // start over on the other transport if the running one was stopped for being too slow:
+                // the mux doesn't leave the md5 and manifest that an ftp resume checks, and the mux
+                // only resumes from its own journal
+                if ((manager->uploader->transportSwitch != 0) && (manager->uploader->isCanceled == 0))
+                {
+                    transport = (transport == ARUPDATER_UPLOADER_TRANSPORT_MUX) ? ARUPDATER_UPLOADER_TRANSPORT_FTP : ARUPDATER_UPLOADER_TRANSPORT_MUX;
+                    manager->uploader->transportSwitchCount++;
+                }
+                else
+                {
+                    manager->uploader->transportSwitch = 0;
+                }
+            } while (manager->uploader->transportSwitch != 0);
+        }
+        
+        ARUPDATER_Plf_Close(&manager->uploader->plf);
+        manager->uploader->isRunning = 0;
+        
+        if (manager->uploader->completionCallback != NULL)
+        {
+            manager->uploader->completionCallback(manager->uploader->completionArg, error);
+        }
+    }
+    else
+    {
+        error = ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+    
+    return (void*)error;
+}
+
+/* bytes confirmed by an interrupted Delos upload of the same plf, returns 1 if the journal matches it */
+static int ARUPDATER_Uploader_DelosJournalLoad(const char *journalPath, const char *md5Txt, uint64_t fileSize, uint64_t *confirmed)
+{
+    char journalMd5[ARSAL_MD5_LENGTH * 2 + 1];
+    unsigned long long journalSize = 0;
+    unsigned long long journalConfirmed = 0;
+    int matches = 0;
+    FILE *journal = fopen(journalPath, "r");
+
+    if (journal != NULL)
+    {
+        if ((fscanf(journal, "%32s %llu %llu", journalMd5, &journalSize, &journalConfirmed) == 3) &&
+            (strcasecmp(journalMd5, md5Txt) == 0) && (journalSize == fileSize) && (journalConfirmed <= fileSize))
+        {
+            *confirmed = journalConfirmed;
+            matches = 1;
+        }
+        fclose(journal);
+    }
+
+    return matches;
+}
+
+static void ARUPDATER_Uploader_DelosJournalSave(const char *journalPath, const char *md5Txt, uint64_t fileSize, uint64_t confirmed)
+{
+    FILE *journal = fopen(journalPath, "w");
+
+    if (journal == NULL)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "can't write '%s': %s", journalPath, strerror(errno));
+        return;
+    }
+
+    fprintf(journal, "%s %llu %llu\n", md5Txt, (unsigned long long)fileSize, (unsigned long long)confirmed);
+    fclose(journal);
+}
+
+/* resume mode of the Delos upload: only if the device holds the start of the plf of the journal */
+static eARDATATRANSFER_UPLOADER_RESUME ARUPDATER_Uploader_DelosResumeMode(ARUPDATER_Uploader_t *uploader, const char *journalPath, const char *md5Txt, uint64_t fileSize)
+{
+    eARUTILS_ERROR utilsError = ARUTILS_OK;
+    uint64_t confirmed = 0;
+    double remoteSize = 0;
+
+    if (!ARUPDATER_Uploader_DelosJournalLoad(journalPath, md5Txt, fileSize, &confirmed))
+    {
+        return ARDATATRANSFER_UPLOADER_RESUME_FALSE;
+    }
+
+    // the device may have received more than the last progress, or lost the end of it
+    utilsError = ARUTILS_Manager_Ftp_Size(uploader->ftpManager, ARUPDATER_UPLOADER_DELOS_REMOTE_PATH, &remoteSize);
+    if ((utilsError != ARUTILS_OK) || (remoteSize <= 0) || (remoteSize > fileSize))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "device has %.0f bytes of the %llu confirmed (error %d), restarting the upload",
+                    remoteSize, (unsigned long long)confirmed, utilsError);
+        return ARDATATRANSFER_UPLOADER_RESUME_FALSE;
+    }
+
+    ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "resuming the upload at %.0f of %llu bytes (%llu confirmed)",
+                remoteSize, (unsigned long long)fileSize, (unsigned long long)confirmed);
+    return ARDATATRANSFER_UPLOADER_RESUME_TRUE;
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunAndroidDelos(ARUPDATER_Manager_t *manager)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    
+    if (manager && manager->uploader)
+    {
+        manager->uploader->isRunning = 1;
+    }
+    else
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    eARDATATRANSFER_ERROR dataTransferError = ARDATATRANSFER_OK;
+    
+    char *sourceFileFolder = NULL;
+    char *sourceFilePath = NULL;
+    char *device = NULL;
+    char *fileName = NULL;
+    ARUPDATER_Arena_t arena;
+    char *journalPath = NULL;
+    char md5Txt[ARSAL_MD5_LENGTH * 2 + 1];
+    uint8_t md5[ARSAL_MD5_LENGTH];
+    uint64_t confirmed = 0;
+    int i = 0;
+    
+    uint16_t productId = ARDISCOVERY_getProductID(manager->uploader->product);
+    ARUPDATER_Arena_Init(&arena);
+    
+    device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
+    sourceFileFolder = ARUPDATER_Arena_Concat(&arena, manager->uploader->rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, device, ARUPDATER_MANAGER_FOLDER_SEPARATOR, NULL);
+    if ((device == NULL) || (sourceFileFolder == NULL))
+    {
+        error = ARUPDATER_ERROR_ALLOC;
+    }
+    
+    if (error == ARUPDATER_OK)
+    {
+        error = ARUPDATER_Utils_GetPlfInFolder(sourceFileFolder, &fileName);
+    }
+    
+    if (error == ARUPDATER_OK)
+    {
+        sourceFilePath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, fileName, NULL);
+        if (sourceFilePath == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+    }
+    
+    if (ARUPDATER_OK == error)
+    {
+        // the progress is given in percent of the plf
+        manager->uploader->ftpBytesTotal = manager->uploader->plf.size;
+        ARUPDATER_Uploader_StartProgress(manager->uploader, manager->uploader->ftpBytesTotal);
+        
+        // by default, do not resume an upload
+        eARDATATRANSFER_UPLOADER_RESUME resumeMode = ARDATATRANSFER_UPLOADER_RESUME_FALSE;
+        
+        // go on with the plf of an interrupted upload, the journal is kept until the upload completes
+        if ((manager->uploader->delosResume != 0) && (manager->uploader->ftpBytesTotal > 0) &&
+            (ARUPDATER_Uploader_GetPlfMd5(manager->uploader, sourceFilePath, md5) == ARUPDATER_OK))
+        {
+            for (i = 0; i < ARSAL_MD5_LENGTH; i++)
+            {
+                snprintf(&md5Txt[i * 2], 3, "%02x", md5[i]);
+            }
+            journalPath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, ARUPDATER_UPLOADER_DELOS_JOURNAL_FILENAME,
+                                                 (manager->uploader->localFileSuffix != NULL) ? manager->uploader->localFileSuffix : "", NULL);
+        }
+        if (journalPath != NULL)
+        {
+            resumeMode = ARUPDATER_Uploader_DelosResumeMode(manager->uploader, journalPath, md5Txt, manager->uploader->ftpBytesTotal);
+            if (resumeMode == ARDATATRANSFER_UPLOADER_RESUME_FALSE)
+            {
+                ARUPDATER_Uploader_DelosJournalSave(journalPath, md5Txt, manager->uploader->ftpBytesTotal, 0);
+            }
+        }
+        
+        ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+        // create a new uploader
+        dataTransferError = ARDATATRANSFER_Uploader_New(manager->uploader->dataTransferManager, manager->uploader->ftpManager, ARUPDATER_UPLOADER_DELOS_REMOTE_PATH, sourceFilePath, ARUPDATER_Uploader_ProgressCallback, manager, ARUPDATER_Uploader_CompletionCallback, manager, resumeMode);
+        if (ARDATATRANSFER_OK != dataTransferError)
+        {
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+        ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+    }
+    
+    if ((ARUPDATER_OK == error) && (manager->uploader->isCanceled == 0))
+    {
+        manager->uploader->isUploadThreadRunning = 1;
+        ARDATATRANSFER_Uploader_ThreadRun(manager->uploader->dataTransferManager);
+        manager->uploader->isUploadThreadRunning = 0;
+        if (manager->uploader->uploadError != ARDATATRANSFER_OK)
+        {
+            ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "ARDataTransferError = %d", manager->uploader->uploadError);
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+    }
+    
+    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+    if (ARUPDATER_OK == error)
+    {
+        dataTransferError = ARDATATRANSFER_Uploader_Delete(manager->uploader->dataTransferManager);
+        if (ARDATATRANSFER_OK != dataTransferError)
+        {
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+    }
+    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+    
+    // keep the bytes confirmed by an interrupted upload
+    if (journalPath != NULL)
+    {
+        if (ARUPDATER_OK == error)
+        {
+            unlink(journalPath);
+        }
+        else
+        {
+            ARSAL_Mutex_Lock(&manager->uploader->progressLock);
+            confirmed = manager->uploader->progress.bytesDone;
+            ARSAL_Mutex_Unlock(&manager->uploader->progressLock);
+            ARUPDATER_Uploader_DelosJournalSave(journalPath, md5Txt, manager->uploader->ftpBytesTotal, confirmed);
+        }
+    }
+    
+    if (error != ARUPDATER_OK)
+    {
+        ARSAL_PRINT (ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "error: %s", ARUPDATER_Error_ToString (error));
+    }
+    
+    if (fileName != NULL)
+    {
+        free(fileName);
+    }
+    ARUPDATER_Arena_Release(&arena);
+    
+    return error;
+}
+
+static void ARUPDATER_Uploader_BleProgressCallback(void *arg, uint64_t done, uint64_t total)
+{
+    ARUPDATER_Manager_t *manager = (ARUPDATER_Manager_t *)arg;
+
+    (void)total;
+    ARUPDATER_Uploader_ReportProgress(manager->uploader, done);
+}
+
+eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunBle(ARUPDATER_Manager_t *manager)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_BleUpload_t *bleUpload = NULL;
+    ARUPDATER_Arena_t arena;
+    char *filePath = NULL;
+    uint8_t md5[ARSAL_MD5_LENGTH];
+
+    if ((manager == NULL) || (manager->uploader == NULL))
+    {
+        return ARUPDATER_ERROR_BAD_PARAMETER;
+    }
+
+    ARUPDATER_Arena_Init(&arena);
+    error = ARUPDATER_Uploader_GetPlfPath(manager->uploader, &arena, NULL, &filePath);
+
+    if (ARUPDATER_OK == error)
+    {
+        // the device checks the plf with its md5 at the end of the upload
+        error = ARUPDATER_Uploader_GetPlfMd5(manager->uploader, filePath, md5);
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARUPDATER_Uploader_StartProgress(manager->uploader, manager->uploader->plf.size);
+        bleUpload = ARUPDATER_BleUpload_New(manager->uploader->bleMtu, manager->uploader->bleWindow,
+                                            manager->uploader->bleWriteCallback, manager->uploader->bleWriteArg,
+                                            ARUPDATER_Uploader_BleProgressCallback, manager, &error);
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+        manager->uploader->bleUpload = bleUpload;
+        if (manager->uploader->isCanceled != 0)
+        {
+            ARUPDATER_BleUpload_Cancel(bleUpload);
+        }
+        ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+
+        // the device answers the bytes it kept from an interrupted upload of this plf
+        error = ARUPDATER_BleUpload_Upload(bleUpload, &manager->uploader->plf.map, md5);
+
+        ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+        manager->uploader->bleUpload = NULL;
+        ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+    }
+
+    ARUPDATER_BleUpload_Delete(&bleUpload);
+    ARUPDATER_Arena_Release(&arena);
+
+    if (error != ARUPDATER_OK)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "error: %s", ARUPDATER_Error_ToString(error));
+    }
+
+    return error;
+}
+
+#if defined BUILD_LIBMUX
+static int updater_mux_write_msg(ARUPDATER_Uploader_t *up, uint32_t msgid,
+		const char *fmt, ...)
+{
+	int res = 0;
+	struct pomp_msg *msg = NULL;
+	va_list args;
+
+	msg = pomp_msg_new();
+	if (msg == NULL)
+		return -ENOMEM;
+
+	va_start(args, fmt);
+	res = pomp_msg_writev(msg, msgid, fmt, args);
+	va_end(args);
+	if (res < 0) {
+		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"pomp_msg_writev error: %s", strerror(-res));
+		goto out;
+	}
+
+	res = mux_encode(up->mux, up->muxChannelId, pomp_msg_get_buffer(msg));
+	if (res < 0 && res != -EPIPE) {
+
+		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"mux_encode error: %s", strerror(-res));
+		goto out;
+	}
+
+out:
+	pomp_msg_destroy(msg);
+	return res;
+}
+
+#if defined BUILD_ZLIB
+static int updater_mux_deflate_open(ARUPDATER_Uploader_t *up)
+{
+	z_stream *strm;
+
+	strm = calloc(1, sizeof(*strm));
+	up->muxDeflateBuffer = malloc(ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MAX);
+	if ((strm == NULL) || (up->muxDeflateBuffer == NULL))
+		goto error;
+
+	/* raw deflate, the chunk crc32c already covers the data */
+	if (deflateInit2(strm, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8,
+			Z_DEFAULT_STRATEGY) != Z_OK)
+		goto error;
+
+	up->muxDeflateStream = strm;
+	up->muxDeflateSkip = 0;
+	return 0;
+
+error:
+	free(strm);
+	free(up->muxDeflateBuffer);
+	up->muxDeflateBuffer = NULL;
+	return -ENOMEM;
+}
+
+static void updater_mux_deflate_close(ARUPDATER_Uploader_t *up)
+{
+	if (up->muxDeflateStream != NULL) {
+		deflateEnd(up->muxDeflateStream);
+		free(up->muxDeflateStream);
+		up->muxDeflateStream = NULL;
+	}
+	free(up->muxDeflateBuffer);
+	up->muxDeflateBuffer = NULL;
+}
+
+/* compress a chunk, returns its compressed size or 0 if it doesn't shrink */
+static size_t updater_mux_deflate(ARUPDATER_Uploader_t *up,
+		const void *chunk, size_t len)
+{
+	z_stream *strm = up->muxDeflateStream;
+
+	if (up->muxDeflateSkip > 0) {
+		up->muxDeflateSkip--;
+		return 0;
+	}
+
+	if ((len > ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MAX) ||
+	    (deflateReset(strm) != Z_OK))
+		return 0;
+
+	/* the output is bounded by the size worth sending, deflate stops
+	 * there for data that doesn't shrink */
+	strm->next_in = (Bytef *)chunk;
+	strm->avail_in = len;
+	strm->next_out = up->muxDeflateBuffer;
+	strm->avail_out = len - len / ARUPDATER_UPLOADER_MUX_DEFLATE_MIN_GAIN;
+	if (deflate(strm, Z_FINISH) != Z_STREAM_END) {
+		up->muxDeflateSkip = ARUPDATER_UPLOADER_MUX_DEFLATE_SKIP;
+		return 0;
+	}
+
+	return strm->total_out;
+}
+#endif
+
+/* send a chunk, compressed when it shrinks and the remote accepts it, and
+ * with the crc32c of its data when the remote checks it */
+static int updater_mux_write_chunk(ARUPDATER_Uploader_t *up, uint32_t id,
+		const void *chunk, uint32_t len)
+{
+#if defined BUILD_ZLIB
+	size_t zlen;
+
+	if (up->muxDeflateActive) {
+		zlen = updater_mux_deflate(up, chunk, len);
+		if (zlen > 0) {
+			up->muxStats.chunksCompressed++;
+			up->muxStats.bytesSent += len;
+			up->muxStats.bytesOnLink += zlen;
+			return updater_mux_write_msg(up,
+				ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_DEFLATE,
+				ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_DEFLATE, id,
+				ARUPDATER_Crc32c_Update(0, chunk, len), len,
+				up->muxDeflateBuffer, (uint32_t)zlen);
+		}
+	}
+#endif
+
+	up->muxStats.bytesSent += len;
+	up->muxStats.bytesOnLink += len;
+	if (!up->muxCrcActive)
+		return updater_mux_write_msg(up, MUX_UPDATE_MSG_ID_CHUNK,
+				MUX_UPDATE_MSG_FMT_ENC_CHUNK, id, chunk, len);
+
+	return updater_mux_write_msg(up,
+			ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_CRC,
+			ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_CRC, id,
+			ARUPDATER_Crc32c_Update(0, chunk, len), chunk, len);
+}
+
+/* events are only pushed from the mux thread */
+static void update_mux_notify_status(ARUPDATER_Uploader_t *up,
+		eARUPDATER_ERROR status)
+{
+	ARUPDATER_Event_t event;
+
+	event.type = ARUPDATER_EVENT_STATUS;
+	event.status = status;
+	event.chunkId = up->muxAckedId;
+	event.bytesAcked = up->muxAckedOffset;
+	ARUPDATER_EventRing_Push(&up->events, &event);
+}
+
+static void update_mux_notify_progression(ARUPDATER_Uploader_t *up)
+{
+	ARUPDATER_Event_t event;
+
+	event.type = ARUPDATER_EVENT_PROGRESS;
+	event.status = ARUPDATER_OK;
+	event.chunkId = up->muxAckedId;
+	event.bytesAcked = up->muxAckedOffset;
+	ARUPDATER_EventRing_Push(&up->events, &event);
+}
+
+/* bounds of the chunk size, buffer is the remote one or 0 for fixed chunks */
+static void updater_mux_chunk_bounds(ARUPDATER_Uploader_t *up, size_t buffer)
+{
+	size_t max = ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MAX;
+	size_t min = ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MIN;
+
+	if (buffer == 0) {
+		/* fixed chunks */
+		up->muxAdaptiveActive = 0;
+		min = max = ARUPDATER_UPLOADER_MUX_CHUNK_SIZE;
+	} else {
+		/* a full window must fit in the remote buffer */
+		up->muxAdaptiveActive = 1;
+		if (buffer / up->muxWindowActive < max)
+			max = buffer / up->muxWindowActive;
+		if (max < min)
+			min = max;
+	}
+
+	up->muxChunkSize = ARUPDATER_UPLOADER_MUX_CHUNK_SIZE;
+	if (up->muxChunkSize > max)
+		up->muxChunkSize = max;
+
+	memset(&up->muxStats, 0, sizeof(up->muxStats));
+	up->muxStats.chunkSize = up->muxChunkSize;
+	up->muxStats.chunkSizeMin = min;
+	up->muxStats.chunkSizeMax = max;
+}
+
+static void updater_mux_chunk_sent(ARUPDATER_Uploader_t *up, size_t len)
+{
+	int bucket = 0;
+
+	while ((bucket < ARUPDATER_UPLOADER_MUX_STATS_SIZES - 1) &&
+	       (len > ((size_t)ARUPDATER_UPLOADER_MUX_CHUNK_SIZE_MIN << bucket)))
+		bucket++;
+
+	up->muxStats.chunksSent++;
+	up->muxStats.chunksBySize[bucket]++;
+}
+
+static void updater_mux_chunk_resize(ARUPDATER_Uploader_t *up, size_t size)
+{
+	if (size < up->muxStats.chunkSizeMin)
+		size = up->muxStats.chunkSizeMin;
+	if (size > up->muxStats.chunkSizeMax)
+		size = up->muxStats.chunkSizeMax;
+	if (size == up->muxChunkSize)
+		return;
+
+	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+		"chunk size %zd -> %zd (rtt %u ms)", up->muxChunkSize, size,
+		up->muxStats.rttLastMs);
+	up->muxChunkSize = size;
+	up->muxStats.chunkSize = size;
+}
+
+/* ack of a chunk sent at sent, grow the next chunks while the acks come
+ * back quickly, shrink them when they are slow. A chunk sent again gives no
+ * sample: its ack may be the one of the first send */
+static void updater_mux_chunk_rtt(ARUPDATER_Uploader_t *up, size_t len,
+		const struct timespec *sent, int sample)
+{
+	struct timespec now;
+	uint32_t rtt, target;
+
+	if (!sample)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	rtt = (now.tv_sec - sent->tv_sec) * 1000 +
+		(now.tv_nsec - sent->tv_nsec) / 1000000;
+
+	up->muxStats.rttLastMs = rtt;
+	if ((up->muxStats.rttMinMs == 0) || (rtt < up->muxStats.rttMinMs))
+		up->muxStats.rttMinMs = rtt;
+	if (rtt > up->muxStats.rttMaxMs)
+		up->muxStats.rttMaxMs = rtt;
+	up->muxStats.rttSmoothedMs = (up->muxStats.rttSmoothedMs == 0) ? rtt :
+		(7 * up->muxStats.rttSmoothedMs + rtt) / 8;
+
+	/* only chunks of the current size tell about it */
+	if (!up->muxAdaptiveActive || (len != up->muxChunkSize))
+		return;
+
+	/* chunks in flight wait for each other */
+	target = ARUPDATER_UPLOADER_MUX_TARGET_RTT_MS * up->muxWindowActive;
+	if (rtt < target)
+		updater_mux_chunk_resize(up, up->muxChunkSize * 2);
+	else if (rtt > 2 * target)
+		updater_mux_chunk_resize(up, up->muxChunkSize / 2);
+}
+
+static int updater_mux_send_next_chunk(ARUPDATER_Uploader_t *up)
+{
+	ssize_t ret;
+	uint32_t n_bytes;
+	const void *chunk;
+	size_t len;
 
-	if (ret == 0) {
+	if (up->n_written >= up->size) {
 		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
 			"read update file eof");
 		return 0;
 	}
 
+	/* get file chunk, straight from the mapping when there is one */
+	chunk = ARUPDATER_FileMap_Get(&up->plf.map, (off_t)up->n_written,
+			up->muxChunkSize, &len);
+	if (chunk == NULL)
+		return -EIO;
+
 	/* send chunk over mux */
-	n_bytes = ret;
+	n_bytes = len;
 
 	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
 			"sending chunk: id=%zd size=%d", up->chunk_id, n_bytes);
 
-	ret = updater_mux_write_msg(up->mux, MUX_UPDATE_MSG_ID_CHUNK,
-			MUX_UPDATE_MSG_FMT_ENC_CHUNK, up->chunk_id,
-			up->chunk, n_bytes);
+	clock_gettime(CLOCK_MONOTONIC, &up->muxSentTime);
+	ret = updater_mux_write_chunk(up, (uint32_t)up->chunk_id, chunk,
+			n_bytes);
 	if (ret < 0)
 		return ret;
 
+	updater_mux_chunk_sent(up, n_bytes);
+	up->muxSentLength = n_bytes;
+
+	/* the chunk in flight, sent again if the remote nacks it */
+	up->muxSlots[0].id = up->chunk_id;
+	up->muxSlots[0].offset = up->n_written;
+	up->muxSlots[0].length = n_bytes;
+	up->muxSlots[0].acked = 0;
+	up->muxSlots[0].retries = 0;
+	up->muxSlots[0].sentTime = up->muxSentTime;
 	up->n_written += n_bytes;
+
+	/* read the next chunks while this one is in flight */
+	ARUPDATER_FileMap_Prefetch(&up->plf.map, (off_t)up->n_written,
+			ARUPDATER_UPLOADER_MUX_PREFETCH_CHUNKS * up->muxChunkSize);
+	return 0;
+}
+
+static int updater_mux_send_chunk(ARUPDATER_Uploader_t *up,
+		ARUPDATER_Uploader_MuxSlot_t *slot)
+{
+	ssize_t ret;
+	const void *chunk;
+	size_t len;
+
+	/* retransmissions get the chunk again from the file */
+	chunk = ARUPDATER_FileMap_Get(&up->plf.map, (off_t)slot->offset,
+			slot->length, &len);
+	if ((chunk == NULL) || (len != slot->length))
+		return -EIO;
+
+	ARSAL_PRINT(ARSAL_PRINT_DEBUG, ARUPDATER_UPLOADER_TAG,
+			"sending chunk: id=%zd size=%zd", slot->id, len);
+
+	clock_gettime(CLOCK_MONOTONIC, &slot->sentTime);
+	ret = updater_mux_write_chunk(up, (uint32_t)slot->id, chunk,
+			(uint32_t)len);
+	if (ret < 0)
+		return ret;
+
+	updater_mux_chunk_sent(up, len);
+	slot->acked = 0;
+	return 0;
+}
+
+/* send new chunks until the window or the remote buffer is full */
+static int updater_mux_window_fill(ARUPDATER_Uploader_t *up)
+{
+	ARUPDATER_Uploader_MuxSlot_t *slot;
+	size_t len;
+	int ret;
+
+	while ((up->muxNextOffset < up->size) &&
+	       (up->muxNext < up->muxBase + up->muxWindowActive)) {
+		len = up->size - up->muxNextOffset;
+		if (len > up->muxChunkSize)
+			len = up->muxChunkSize;
+
+		if ((up->muxRemoteBuffer > 0) && (up->muxNext > up->muxBase) &&
+		    (up->muxNextOffset + len - up->n_written > up->muxRemoteBuffer))
+			break;
+
+		slot = &up->muxSlots[up->muxNext % up->muxWindowActive];
+		slot->id = up->muxNext;
+		slot->offset = up->muxNextOffset;
+		slot->length = len;
+		slot->retries = 0;
+		ret = updater_mux_send_chunk(up, slot);
+		if (ret < 0)
+			return ret;
+		up->muxNext++;
+		up->muxNextOffset += len;
+	}
+
+	/* read the chunks sent when the window slides */
+	ARUPDATER_FileMap_Prefetch(&up->plf.map, (off_t)up->muxNextOffset,
+			ARUPDATER_UPLOADER_MUX_PREFETCH_CHUNKS * up->muxChunkSize);
 	return 0;
 }
 
+/* mark acknowledged chunks and slide the window */
+static void updater_mux_window_ack(ARUPDATER_Uploader_t *up, size_t id)
+{
+	ARUPDATER_Uploader_MuxSlot_t *slot;
+	size_t i;
+
+	/* duplicate or unknown ack */
+	if ((id < up->muxBase) || (id >= up->muxNext))
+		return;
+
+	slot = &up->muxSlots[id % up->muxWindowActive];
+	if (!slot->acked)
+		updater_mux_chunk_rtt(up, slot->length, &slot->sentTime,
+				slot->retries == 0);
+
+	if (up->muxCumulativeAck) {
+		for (i = up->muxBase; i <= id; i++)
+			up->muxSlots[i % up->muxWindowActive].acked = 1;
+	} else {
+		slot->acked = 1;
+	}
+
+	while ((up->muxBase < up->muxNext) &&
+	       up->muxSlots[up->muxBase % up->muxWindowActive].acked) {
+		up->n_written += up->muxSlots[up->muxBase % up->muxWindowActive].length;
+		up->muxBase++;
+	}
+}
+
+/* send again the chunks not acknowledged in time */
+static int updater_mux_window_check(ARUPDATER_Uploader_t *up)
+{
+	ARUPDATER_Uploader_MuxSlot_t *slot;
+	struct timespec now;
+	long elapsedMs;
+	size_t id;
+	int ret = 0;
+
+	ARSAL_Mutex_Lock(&up->muxLock);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	for (id = up->muxBase; (ret == 0) && (up->muxWindowActive > 1) && (id < up->muxNext); id++) {
+		slot = &up->muxSlots[id % up->muxWindowActive];
+		elapsedMs = (now.tv_sec - slot->sentTime.tv_sec) * 1000 +
+			(now.tv_nsec - slot->sentTime.tv_nsec) / 1000000;
+		if (slot->acked || (elapsedMs < ARUPDATER_UPLOADER_MUX_ACK_TIMEOUT_MS))
+			continue;
+
+		if (++slot->retries > ARUPDATER_UPLOADER_MUX_MAX_RETRIES) {
+			ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"chunk %zd not acknowledged after %d retries",
+				id, ARUPDATER_UPLOADER_MUX_MAX_RETRIES);
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG,
+			"chunk %zd not acknowledged, sending it again", id);
+		up->muxStats.retransmissions++;
+		ret = updater_mux_send_chunk(up, slot);
+
+		/* a lost chunk costs less when it is small */
+		if (up->muxAdaptiveActive)
+			updater_mux_chunk_resize(up, up->muxChunkSize / 2);
+	}
+	ARSAL_Mutex_Unlock(&up->muxLock);
+
+	return ret;
+}
+
+/* send again a chunk the remote found corrupted */
+static int updater_mux_chunk_nack(ARUPDATER_Uploader_t *up, size_t id)
+{
+	ARUPDATER_Uploader_MuxSlot_t *slot;
+
+	/* chunk already acknowledged or not sent, stale nack */
+	if (up->muxWindowActive > 1) {
+		if ((id < up->muxBase) || (id >= up->muxNext))
+			return 0;
+		slot = &up->muxSlots[id % up->muxWindowActive];
+	} else {
+		slot = &up->muxSlots[0];
+		if ((id != slot->id) || (id != up->chunk_id))
+			return 0;
+	}
+	if (slot->acked)
+		return 0;
+
+	if (++slot->retries > ARUPDATER_UPLOADER_MUX_MAX_RETRIES) {
+		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+			"chunk %zd corrupted %d times", id,
+			ARUPDATER_UPLOADER_MUX_MAX_RETRIES);
+		return -EIO;
+	}
+
+	ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG,
+		"chunk %zd corrupted, sending it again", id);
+	up->muxStats.nacks++;
+	return updater_mux_send_chunk(up, slot);
+}
+
 static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 			struct pomp_buffer *buf)
 {
@@ -523,15 +1947,75 @@ static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 	ARUPDATER_Uploader_t *up = mngr->uploader;
 	float percent;
 	int ret, status;
-	unsigned int id;
+	unsigned int id, window, flags, buffer, offset;
 
 	/* Create pomp message from buffer */
 	msg = pomp_msg_new_with_buffer(buf);
 	if (msg == NULL)
 		return;
 
+	ARSAL_Mutex_Lock(&up->muxLock);
+
 	/* Decode message */
 	switch (pomp_msg_get_id(msg)) {
+	case ARUPDATER_UPLOADER_MUX_MSG_ID_CAPS:
+		/* remote supports the windowed transfer */
+		ret = pomp_msg_read(msg, ARUPDATER_UPLOADER_MUX_MSG_FMT_CAPS,
+				&window, &flags, &buffer);
+		if (ret < 0) {
+			ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"pomp_msg_read error: %s", strerror(-ret));
+			goto error;
+		}
+
+		up->muxWindowActive = (window < (unsigned int)up->muxWindow) ?
+			(int)window : up->muxWindow;
+		if (up->muxWindowActive < 1)
+			up->muxWindowActive = 1;
+		up->muxCumulativeAck = (flags & ARUPDATER_UPLOADER_MUX_CAPS_CUMULATIVE) ? 1 : 0;
+		up->muxRemoteBuffer = buffer;
+		up->muxResumeActive = (up->muxResume &&
+			(flags & ARUPDATER_UPLOADER_MUX_CAPS_RESUME)) ? 1 : 0;
+		up->muxCrcActive = (up->muxCrc &&
+			(flags & ARUPDATER_UPLOADER_MUX_CAPS_CHUNK_CRC)) ? 1 : 0;
+		up->muxDeflateActive = ((up->muxDeflateStream != NULL) &&
+			(flags & ARUPDATER_UPLOADER_MUX_CAPS_DEFLATE)) ? 1 : 0;
+		if (up->muxAdaptive && (buffer > 0) &&
+		    (flags & ARUPDATER_UPLOADER_MUX_CAPS_CHUNK_SIZE))
+			updater_mux_chunk_bounds(up, buffer);
+
+		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+			"caps: window=%d cumulative=%d buffer=%u adaptive=%d "
+			"crc=%d deflate=%d", up->muxWindowActive,
+			up->muxCumulativeAck, buffer, up->muxAdaptiveActive,
+			up->muxCrcActive, up->muxDeflateActive);
+	break;
+
+	case ARUPDATER_UPLOADER_MUX_MSG_ID_RESUME:
+		/* chunk the remote restarts from, at most the one offered */
+		ret = pomp_msg_read(msg, ARUPDATER_UPLOADER_MUX_MSG_FMT_RESUME,
+				&id, &offset);
+		if (ret < 0) {
+			ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"pomp_msg_read error: %s", strerror(-ret));
+			goto error;
+		}
+
+		if ((id > up->muxOfferedId) || (offset > up->muxOfferedOffset) ||
+		    ((id == 0) != (offset == 0))) {
+			ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG,
+				"resume at chunk %u offset %u not offered, "
+				"restarting", id, offset);
+			id = 0;
+			offset = 0;
+		}
+
+		up->muxResumeId = id;
+		up->muxResumeOffset = offset;
+		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+			"resume: chunk=%u offset=%u", id, offset);
+	break;
+
 	case MUX_UPDATE_MSG_ID_UPDATE_RESP:
 		/* decode status */
 		ret = pomp_msg_read(msg, MUX_UPDATE_MSG_FMT_DEC_UPDATE_RESP,
@@ -552,10 +2036,26 @@ static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 			goto error;
 		}
 
-		/* update accepted: start sensing file */
-		up->n_written = 0;
-		up->chunk_id = 0;
-		lseek(up->fd, 0, SEEK_SET);
+		/* update accepted: start sensing file, from the chunk
+		 * accepted by the remote when resuming */
+		ARUPDATER_Throughput_Reset(&up->throughput);
+		ARUPDATER_Throughput_Reset(&up->muxThroughput);
+		up->n_written = up->muxResumeOffset;
+		up->chunk_id = up->muxResumeId;
+		up->muxAckedId = up->muxResumeId;
+		up->muxAckedOffset = up->muxResumeOffset;
+		update_mux_notify_progression(up);
+
+		if (up->muxWindowActive > 1) {
+			/* fill the window */
+			up->muxBase = up->muxResumeId;
+			up->muxNext = up->muxResumeId;
+			up->muxNextOffset = up->muxResumeOffset;
+			ret = updater_mux_window_fill(up);
+			if (ret < 0)
+				goto error;
+			break;
+		}
 
 		/* send 1st chunk */
 		ret = updater_mux_send_next_chunk(up);
@@ -575,20 +2075,55 @@ static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
 			"chunk ack: id=%d", id);
 
-		if (id != up->chunk_id) {
+		if (up->muxWindowActive > 1) {
+			updater_mux_window_ack(up, id);
+		} else if (id != up->chunk_id) {
 			ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
 				"chunk id mismatch %d != %zd", id, up->chunk_id);
 			goto error;
+		} else {
+			updater_mux_chunk_rtt(up, up->muxSentLength,
+					&up->muxSentTime,
+					up->muxSlots[0].retries == 0);
+			up->muxSlots[0].acked = 1;
+		}
+
+		/* resume point if the update is interrupted */
+		if (up->muxWindowActive > 1) {
+			up->muxAckedId = up->muxBase;
+			up->muxAckedOffset = up->n_written;
+		} else {
+			up->muxAckedId = up->chunk_id + 1;
+			up->muxAckedOffset = up->n_written;
 		}
 
+		/* image bytes acknowledged per second */
+		ARUPDATER_Throughput_Update(&up->muxThroughput,
+				up->n_written - up->muxResumeOffset);
+		up->muxStats.effectiveRate = (uint32_t)ARUPDATER_Throughput_GetRate(
+				&up->muxThroughput);
+
 		/* notify progression */
 		percent = (double) (100.f * up->n_written) / (double)up->size;
 		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
 				"progression: %f%%", percent);
-		update_mux_notify_progression(up, percent);
+		update_mux_notify_progression(up);
+
+		/* leave mux for ftp if it is much slower */
+		if (ARUPDATER_Uploader_TransportDegraded(up,
+				ARUPDATER_UPLOADER_TRANSPORT_MUX, up->n_written)) {
+			update_mux_notify_status(up, ARUPDATER_ERROR_UPLOADER);
+			break;
+		}
 
-		/* send next chunk */
-		if (up->n_written < up->size) {
+		/* send next chunks */
+		if (up->muxWindowActive > 1) {
+			ret = updater_mux_window_fill(up);
+			if (ret < 0)
+				goto error;
+			if (up->n_written < up->size)
+				break;
+		} else if (up->n_written < up->size) {
 			up->chunk_id++;
 			ret = updater_mux_send_next_chunk(up);
 			if (ret < 0)
@@ -601,6 +2136,21 @@ static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 			"image sent waiting for status");
 	break;
 
+	case ARUPDATER_UPLOADER_MUX_MSG_ID_CHUNK_NACK:
+		/* the crc32c of a chunk didn't match on the remote */
+		ret = pomp_msg_read(msg, ARUPDATER_UPLOADER_MUX_MSG_FMT_CHUNK_NACK,
+				&id);
+		if (ret < 0) {
+			ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+				"pomp_msg_read error: %s", strerror(-ret));
+			goto error;
+		}
+
+		ret = updater_mux_chunk_nack(up, id);
+		if (ret < 0)
+			goto error;
+	break;
+
 	case MUX_UPDATE_MSG_ID_STATUS:
 
 		/* decode update status */
@@ -632,10 +2182,12 @@ static void updater_mux_channel_recv(ARUPDATER_Manager_t *mngr,
 	break;
 	}
 
+	ARSAL_Mutex_Unlock(&up->muxLock);
 	pomp_msg_destroy(msg);
 	return;
 
 error:
+	ARSAL_Mutex_Unlock(&up->muxLock);
 	pomp_msg_destroy(msg);
 	update_mux_notify_status(up, ARUPDATER_ERROR_UPLOADER);
 	return;
@@ -668,7 +2220,61 @@ static char *md5_to_str(const uint8_t *md5, char *str)
 	for (i = 0; i < ARSAL_MD5_LENGTH; i++)
 		snprintf(&str[i * 2], 3, "%02x", md5[i]);
 
-	return str;
+	return str;
+}
+
+static char *updater_mux_journal_path(ARUPDATER_Uploader_t *up,
+		ARUPDATER_Arena_t *arena, const char *dirpath)
+{
+	return ARUPDATER_Arena_Concat(arena, dirpath,
+			ARUPDATER_UPLOADER_MUX_JOURNAL_FILENAME,
+			up->localFileSuffix ? up->localFileSuffix : "", NULL);
+}
+
+/* resume point of an interrupted update of the same plf, 0 if none */
+static void updater_mux_journal_load(ARUPDATER_Uploader_t *up,
+		const char *path, const char *md5_str, const char *version)
+{
+	char j_md5[2*ARSAL_MD5_LENGTH + 1];
+	char j_version[128];
+	size_t j_size, j_id, j_offset;
+	FILE *f;
+
+	up->muxOfferedId = 0;
+	up->muxOfferedOffset = 0;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return;
+
+	if ((fscanf(f, "%32s %127s %zu %zu %zu", j_md5, j_version, &j_size,
+			&j_id, &j_offset) == 5) &&
+	    (strcmp(j_md5, md5_str) == 0) &&
+	    (strcmp(j_version, version) == 0) &&
+	    (j_size == up->size) && (j_offset < up->size) &&
+	    ((j_id == 0) == (j_offset == 0))) {
+		up->muxOfferedId = j_id;
+		up->muxOfferedOffset = j_offset;
+	}
+
+	fclose(f);
+}
+
+static void updater_mux_journal_save(ARUPDATER_Uploader_t *up,
+		const char *path, const char *md5_str, const char *version)
+{
+	FILE *f;
+
+	f = fopen(path, "w");
+	if (f == NULL) {
+		ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG,
+			"can't write '%s': %s", path, strerror(errno));
+		return;
+	}
+
+	fprintf(f, "%s %s %zu %zu %zu\n", md5_str, version, up->size,
+			up->muxAckedId, up->muxAckedOffset);
+	fclose(f);
 }
 #endif
 
@@ -678,28 +2284,44 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunMux(ARUPDATER_Manager_t *manager)
 	int res;
 	ARUPDATER_PlfVersion v;
 	eARUPDATER_ERROR ret, status;
-	eARSAL_ERROR aret;
 	ARUPDATER_Uploader_t *up = manager->uploader;
-	uint16_t product;
-	struct stat statbuf;
 	char version[128];
 	uint8_t md5[ARSAL_MD5_LENGTH];
 	char md5_str[2*ARSAL_MD5_LENGTH + 1];
-	char dirpath[256];
-	char filepath[256];
-	char *filename = NULL;
+	ARUPDATER_Arena_t arena;
+	char *dirpath = NULL;
+	char *filepath = NULL;
+	char *journalpath = NULL;
 	struct pollfd fds[1];
-	int event;
-	float percent;
+	ARUPDATER_Event_t events[16];
+	int count, i, done;
+	int64_t progress;
 
 	up->isRunning = 1;
-	up->fd = -1;
-	up->chunk = NULL;
+	up->muxChannelId = (up->muxChannel != 0) ? up->muxChannel :
+		MUX_UPDATE_CHANNEL_ID_UPDATE;
+	ARUPDATER_EventRing_Reset(&up->events);
+	up->muxWindowActive = 1;
+	up->muxCumulativeAck = 0;
+	up->muxRemoteBuffer = 0;
+	up->muxResumeActive = 0;
+	up->muxCrcActive = 0;
+	up->muxDeflateActive = 0;
+	up->muxOfferedId = 0;
+	up->muxOfferedOffset = 0;
+	up->muxResumeId = 0;
+	up->muxResumeOffset = 0;
+	up->muxAckedId = 0;
+	up->muxAckedOffset = 0;
+	ARUPDATER_Arena_Init(&arena);
+	ARSAL_Mutex_Lock(&up->muxLock);
+	updater_mux_chunk_bounds(up, 0);
+	ARSAL_Mutex_Unlock(&up->muxLock);
 	memset(md5_str, 0, sizeof(md5_str));
 	memset(md5, 0, sizeof(md5));
 
 	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
-			"starting update over mux");
+			"starting update over mux channel %u", up->muxChannelId);
 
 	/* first check we have a mux context */
 	if (!up->mux) {
@@ -709,161 +2331,608 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunMux(ARUPDATER_Manager_t *manager)
 		goto out;
 	}
 
-	/* get product id */
-	product = ARDISCOVERY_getProductID(up->product);
-
-	/* format directory path containing upload image files */
-	snprintf(dirpath, sizeof(dirpath), "%s%s%04x%s", up->rootFolder,
-			ARUPDATER_MANAGER_PLF_FOLDER, product,
-			ARUPDATER_MANAGER_FOLDER_SEPARATOR);
-
-	/* get image file name */
-	ret = ARUPDATER_Utils_GetPlfInFolder(dirpath, &filename);
+	/* get image file path, and the directory containing it */
+	ret = ARUPDATER_Uploader_GetPlfPath(up, &arena, &dirpath, &filepath);
 	if (ret != ARUPDATER_OK) {
 		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"ARUPDATER_Utils_GetPlfInFolder error %d", ret);
+			"ARUPDATER_Uploader_GetPlfPath error %d", ret);
 		status = ARUPDATER_ERROR_SYSTEM;
 		goto out;
 	}
 
-	/* format image file path */
-	snprintf(filepath, sizeof(filepath), "%s%s", dirpath, filename);
-
 	/* get update file md5 */
-	aret = ARSAL_MD5_Manager_Compute(up->md5Manager, filepath, md5,
-			sizeof(md5));
-	if (aret != ARSAL_OK) {
+	ret = ARUPDATER_Uploader_GetPlfMd5(up, filepath, md5);
+	if (ret != ARUPDATER_OK) {
 		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"ARSAL_MD5_Manager_Compute error %d", aret);
+			"ARSAL_MD5_Manager_Compute error %d", ret);
 		status = ARUPDATER_ERROR_SYSTEM;
 		goto out;
 	}
 
-	/* get update file version */
-	ret = ARUPDATER_Utils_ReadPlfVersion(filepath, &v);
+	/* get update file version from the plf opened by
+	 * ARUPDATER_Uploader_ThreadRun; it is mapped, so chunks are then
+	 * given to pomp without being read into a buffer first */
+	ret = ARUPDATER_Utils_PlfVersionFromHeader(&up->plf.header, &v);
 	if (ret != ARUPDATER_OK) {
 		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"ARUPDATER_Utils_ReadPlfVersion error %d", ret);
+			"ARUPDATER_Utils_PlfVersionFromHeader error %d", ret);
 		status = ret;
 		goto out;
 	}
 
-	ARUPDATER_Utils_PlfVersionToString(&v, version, sizeof(version));
+	ARUPDATER_Utils_PlfVersionToString(&v, version, sizeof(version));
+
+	up->size = up->plf.size;
+	ARUPDATER_Uploader_StartProgress(up, up->size);
+
+#if defined BUILD_ZLIB
+	/* compressor, used if the remote accepts compressed chunks */
+	if (up->muxDeflate && (updater_mux_deflate_open(up) < 0)) {
+		status = ARUPDATER_ERROR_ALLOC;
+		goto out;
+	}
+#endif
+
+	/* open mux update channel */
+	res = mux_channel_open(up->mux, up->muxChannelId,
+			&update_mux_channel_cb, manager);
+	if (res < 0) {
+		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
+			"mux_channel_open: error %s", strerror(-res));
+		status = ARUPDATER_ERROR_UPLOADER;
+		goto out;
+	}
+
+	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "version:%s "
+		"md5:%s size:%zd", version, md5_to_str(md5, md5_str), up->size);
+
+	/* resume point left by an interrupted update of this plf */
+	if (up->muxResume) {
+		journalpath = updater_mux_journal_path(up, &arena, dirpath);
+		if (journalpath != NULL)
+			updater_mux_journal_load(up, journalpath, md5_str,
+					version);
+	}
+
+	/* ask for the windowed transfer, the remote buffer size, the
+	 * resume and chunk crc support, remotes that don't support it answer
+	 * the update request only */
+	if ((up->muxWindow > 1) || up->muxAdaptive || up->muxResume ||
+	    up->muxCrc || up->muxDeflate) {
+		res = updater_mux_write_msg(up,
+				ARUPDATER_UPLOADER_MUX_MSG_ID_CAPS_REQ,
+				ARUPDATER_UPLOADER_MUX_MSG_FMT_CAPS_REQ,
+				(uint32_t)up->muxWindow);
+		if (res < 0) {
+			status = ARUPDATER_ERROR_UPLOADER;
+			goto out;
+		}
+	}
+
+	/* offer the resume point, only known when the remote supported it
+	 * before. No answer means no resume */
+	if (up->muxOfferedOffset > 0) {
+		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+			"offering resume at chunk %zd offset %zd",
+			up->muxOfferedId, up->muxOfferedOffset);
+		res = updater_mux_write_msg(up,
+				ARUPDATER_UPLOADER_MUX_MSG_ID_RESUME_REQ,
+				ARUPDATER_UPLOADER_MUX_MSG_FMT_RESUME,
+				(uint32_t)up->muxOfferedId,
+				(uint32_t)up->muxOfferedOffset);
+		if (res < 0) {
+			status = ARUPDATER_ERROR_UPLOADER;
+			goto out;
+		}
+	}
+
+	/* read the first chunks while the remote answers */
+	ARUPDATER_FileMap_Prefetch(&up->plf.map, (off_t)up->muxOfferedOffset,
+			ARUPDATER_UPLOADER_MUX_PREFETCH_CHUNKS * up->muxChunkSize);
+
+	/* send update request */
+	res = updater_mux_write_msg(up, MUX_UPDATE_MSG_ID_UPDATE_REQ,
+			MUX_UPDATE_MSG_FMT_ENC_UPDATE_REQ, version, md5,
+			sizeof(md5), up->size);
+	if (res < 0) {
+		status = ARUPDATER_ERROR_UPLOADER;
+		goto out;
+	}
+
+	/* wait mux thread events */
+	status = ARUPDATER_ERROR_UPLOADER;
+	done = 0;
+	while (!done) {
+
+		/* poll event ring */
+		fds[0].fd = ARUPDATER_EventRing_GetFd(&up->events);
+		fds[0].events = POLLIN;
+		do {
+			res = poll(fds, 1, (up->muxWindow > 1) ?
+					ARUPDATER_UPLOADER_MUX_RETRY_PERIOD_MS : -1);
+		} while (res < 0 && errno == EINTR);
+
+		if (res < 0)
+			break;
+
+		/* windowed transfer: send again the lost chunks */
+		if (updater_mux_window_check(up) < 0) {
+			status = ARUPDATER_ERROR_UPLOADER;
+			break;
+		}
+
+		/* canceled from another thread, which only wakes the ring */
+		if (up->isCanceled)
+			break;
+
+		if (!(fds[0].revents & POLLIN))
+			continue;
+
+		/* drain the pending events, only the last progress of a
+		 * batch is reported */
+		count = ARUPDATER_EventRing_Pop(&up->events, events,
+				sizeof(events) / sizeof(events[0]));
+		progress = -1;
+		for (i = 0; (i < count) && !done; i++) {
+			if (events[i].type == ARUPDATER_EVENT_PROGRESS) {
+				progress = (int64_t)events[i].bytesAcked;
+			} else {
+				status = events[i].status;
+				done = 1;
+			}
+		}
+
+		if (progress >= 0)
+			ARUPDATER_Uploader_ReportProgress(up, progress);
+	}
+
+out:
+	/* close all */
+	if (up->mux)
+		mux_channel_close(up->mux, up->muxChannelId);
+
+#if defined BUILD_ZLIB
+	updater_mux_deflate_close(up);
+#endif
+
+	if (up->muxStats.bytesOnLink > 0)
+		ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+			"%u of %u chunks compressed, ratio %.2f, %u B/s",
+			up->muxStats.chunksCompressed, up->muxStats.chunksSent,
+			(double)up->muxStats.bytesSent /
+			(double)up->muxStats.bytesOnLink,
+			up->muxStats.effectiveRate);
+
+	/* keep the resume point of an interrupted update */
+	if (journalpath != NULL) {
+		if ((status != ARUPDATER_OK) && up->muxResumeActive &&
+		    (up->muxAckedOffset > 0) && (up->muxAckedOffset < up->size))
+			updater_mux_journal_save(up, journalpath, md5_str,
+					version);
+		else if (status == ARUPDATER_OK)
+			unlink(journalpath);
+	}
+
+	ARUPDATER_Arena_Release(&arena);
+
+	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
+			"update over mux completed status: %d", status);
+	return status;
+#else
+    return ARUPDATER_ERROR_SYSTEM;
+#endif
+}
+
+static eARUPDATER_ERROR ARUPDATER_Uploader_FetchFile(ARUPDATER_Manager_t *manager, const char *remotePath, const char *localPath)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    eARDATATRANSFER_ERROR dataTransferError = ARDATATRANSFER_OK;
+
+    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+    dataTransferError = ARDATATRANSFER_Downloader_New(manager->uploader->dataTransferManager, manager->uploader->ftpManager, remotePath, localPath, NULL, NULL, ARUPDATER_Uploader_CompletionCallback, manager, ARDATATRANSFER_DOWNLOADER_RESUME_FALSE);
+    if (ARDATATRANSFER_OK != dataTransferError)
+    {
+        error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+    }
+    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+
+    if ((ARUPDATER_OK == error) && (manager->uploader->isCanceled == 0))
+    {
+        manager->uploader->uploadError = ARDATATRANSFER_OK;
+        manager->uploader->isDownloadMd5ThreadRunning = 1;
+        ARDATATRANSFER_Downloader_ThreadRun(manager->uploader->dataTransferManager);
+        manager->uploader->isDownloadMd5ThreadRunning = 0;
+        if (manager->uploader->uploadError != ARDATATRANSFER_OK)
+        {
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+    }
+
+    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+    if (ARDATATRANSFER_OK == dataTransferError)
+    {
+        ARDATATRANSFER_Downloader_Delete(manager->uploader->dataTransferManager);
+    }
+    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+
+    return error;
+}
+
+static eARUPDATER_ERROR ARUPDATER_Uploader_SendFile(ARUPDATER_Manager_t *manager, const char *remotePath, const char *localPath)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    eARDATATRANSFER_ERROR dataTransferError = ARDATATRANSFER_OK;
+
+    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+    dataTransferError = ARDATATRANSFER_Uploader_New(manager->uploader->dataTransferManager, manager->uploader->ftpManager, remotePath, localPath, NULL, NULL, ARUPDATER_Uploader_CompletionCallback, manager, ARDATATRANSFER_UPLOADER_RESUME_FALSE);
+    if (ARDATATRANSFER_OK != dataTransferError)
+    {
+        error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+    }
+    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+
+    if ((ARUPDATER_OK == error) && (manager->uploader->isCanceled == 0))
+    {
+        manager->uploader->uploadError = ARDATATRANSFER_OK;
+        manager->uploader->isUploadThreadRunning = 1;
+        ARDATATRANSFER_Uploader_ThreadRun(manager->uploader->dataTransferManager);
+        manager->uploader->isUploadThreadRunning = 0;
+        if (manager->uploader->uploadError != ARDATATRANSFER_OK)
+        {
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+    }
+
+    ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
+    if (ARDATATRANSFER_OK == dataTransferError)
+    {
+        dataTransferError = ARDATATRANSFER_Uploader_Delete(manager->uploader->dataTransferManager);
+        if ((ARUPDATER_OK == error) && (ARDATATRANSFER_OK != dataTransferError))
+        {
+            error = ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR;
+        }
+    }
+    ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
+
+    return error;
+}
+
+static eARUPDATER_ERROR ARUPDATER_Uploader_OpenDirectFtp(ARUPDATER_Uploader_t *uploader)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Ftp_Connection_t *connection = NULL;
+
+    connection = ARUPDATER_Ftp_Connection_New(uploader->ftpServer, uploader->ftpPort, uploader->ftpUsername, uploader->ftpPassword, &error);
+
+    ARSAL_Mutex_Lock(&uploader->uploadLock);
+    uploader->ftpConnection = connection;
+    if ((connection != NULL) && (uploader->isCanceled != 0))
+    {
+        ARUPDATER_Ftp_Connection_Cancel(connection);
+    }
+    ARSAL_Mutex_Unlock(&uploader->uploadLock);
+
+    return error;
+}
+
+static void ARUPDATER_Uploader_CloseDirectFtp(ARUPDATER_Uploader_t *uploader)
+{
+    ARUPDATER_Ftp_Connection_t *connection = NULL;
+
+    ARSAL_Mutex_Lock(&uploader->uploadLock);
+    connection = uploader->ftpConnection;
+    uploader->ftpConnection = NULL;
+    ARSAL_Mutex_Unlock(&uploader->uploadLock);
+
+    ARUPDATER_Ftp_Connection_Delete(&connection);
+}
+
+/* stop the running ftp transfer, without canceling the upload */
+static void ARUPDATER_Uploader_AbortFtpTransfer(ARUPDATER_Uploader_t *uploader)
+{
+    ARSAL_Mutex_Lock(&uploader->uploadLock);
+    if (uploader->isUploadThreadRunning == 1)
+    {
+        ARDATATRANSFER_Uploader_CancelThread(uploader->dataTransferManager);
+    }
+    if (uploader->ftpConnection != NULL)
+    {
+        ARUPDATER_Ftp_Connection_Cancel(uploader->ftpConnection);
+    }
+    if (uploader->ftpSegments != NULL)
+    {
+        ARUPDATER_FtpSegments_Cancel(uploader->ftpSegments);
+    }
+    ARSAL_Mutex_Unlock(&uploader->uploadLock);
+}
+
+/* time the upload of the beginning of the plf to the ftp server */
+static eARUPDATER_ERROR ARUPDATER_Uploader_ProbeFtp(ARUPDATER_Uploader_t *uploader, double *rate)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Arena_t arena;
+    char *filePath = NULL;
+    struct timespec start, end;
+    uint64_t probeSize = ARUPDATER_UPLOADER_PROBE_SIZE;
+    double duration = 0;
+
+    *rate = 0;
+
+    ARUPDATER_Arena_Init(&arena);
+    error = ARUPDATER_Uploader_GetPlfPath(uploader, &arena, NULL, &filePath);
+
+    if ((ARUPDATER_OK == error) && ((uint64_t)uploader->plf.size < probeSize))
+    {
+        probeSize = uploader->plf.size;
+    }
+
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Uploader_OpenDirectFtp(uploader);
+    }
+
+    if ((ARUPDATER_OK == error) && (probeSize > 0))
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        error = ARUPDATER_Ftp_PutRange(uploader->ftpConnection, ARUPDATER_UPLOADER_REMOTE_FOLDER ARUPDATER_UPLOADER_PROBE_FILENAME, filePath, 0, probeSize, NULL, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ARUPDATER_Ftp_Delete(uploader->ftpConnection, ARUPDATER_UPLOADER_REMOTE_FOLDER ARUPDATER_UPLOADER_PROBE_FILENAME);
+
+        duration = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+        if ((ARUPDATER_OK == error) && (duration > 0))
+        {
+            *rate = (double)probeSize / duration;
+        }
+    }
+
+    ARUPDATER_Uploader_CloseDirectFtp(uploader);
+    ARUPDATER_Arena_Release(&arena);
+
+    return error;
+}
+
+static eARUPDATER_UPLOADER_TRANSPORT ARUPDATER_Uploader_SelectTransport(ARUPDATER_Manager_t *manager)
+{
+    ARUPDATER_Uploader_t *uploader = manager->uploader;
+
+    uploader->transportSelecting = 0;
+    uploader->transportSwitch = 0;
+    uploader->transportSwitchCount = 0;
+    uploader->ftpRate = 0;
+    uploader->muxRate = 0;
+
+    if (uploader->bleWriteCallback != NULL)
+    {
+        return ARUPDATER_UPLOADER_TRANSPORT_BLE;
+    }
+
+    if ((uploader->ftpManager->networkType == ARDISCOVERY_NETWORK_TYPE_BLE) &&
+        (uploader->isAndroidApp == 1))
+    {
+        return ARUPDATER_UPLOADER_TRANSPORT_DELOS;
+    }
+
+    // a device attached to the skycontroller is updated through its mux
+    if (!uploader->mux ||
+        ((ARDISCOVERY_getProductFamily(uploader->product) != ARDISCOVERY_PRODUCT_FAMILY_SKYCONTROLLER) &&
+         (uploader->muxChannel == 0)))
+    {
+        return ARUPDATER_UPLOADER_TRANSPORT_FTP;
+    }
+
+    // mux and ftp are both usable
+    if (uploader->transportSelection == 0)
+    {
+        return ARUPDATER_UPLOADER_TRANSPORT_MUX;
+    }
+
+    if (uploader->ftpServer == NULL)
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "transport selection needs a direct ftp access, using mux");
+        return ARUPDATER_UPLOADER_TRANSPORT_MUX;
+    }
+
+    if ((ARUPDATER_Uploader_ProbeFtp(uploader, &uploader->ftpRate) != ARUPDATER_OK) || (uploader->ftpRate == 0))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "ftp probe failed, using mux");
+        return ARUPDATER_UPLOADER_TRANSPORT_MUX;
+    }
+
+    // mux can't be probed without starting the update: it is measured on its first chunks
+    ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "ftp probe: %.0f B/s", uploader->ftpRate);
+    uploader->transportSelecting = 1;
+
+    return ARUPDATER_UPLOADER_TRANSPORT_MUX;
+}
+
+/* find how much of the remote partial file matches the manifest, walking back
+ * from its last complete chunk; the partial tail is compared to the local plf */
+static eARUPDATER_ERROR ARUPDATER_Uploader_VerifyRemoteChunks(ARUPDATER_Uploader_t *uploader, const ARUPDATER_Manifest_t *manifest, const char *remotePath, uint64_t *verifiedSize, uint64_t *remoteSize)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    uint8_t *remoteBuffer = NULL;
+    const void *localChunk = NULL;
+    size_t localSize = 0;
+    uint32_t completeChunks = 0;
+    uint32_t index = 0;
+    uint32_t checks = 0;
+    uint64_t tailSize = 0;
+    size_t readSize = 0;
+
+    *verifiedSize = 0;
+    *remoteSize = 0;
+
+    error = ARUPDATER_Uploader_OpenDirectFtp(uploader);
+
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Ftp_Size(uploader->ftpConnection, remotePath, remoteSize);
+        if (ARUPDATER_ERROR_PLF_FILE_NOT_FOUND == error)
+        {
+            *remoteSize = 0;
+            error = ARUPDATER_OK;
+        }
+    }
+
+    if ((ARUPDATER_OK == error) && (*remoteSize > manifest->fileSize))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "remote partial file is bigger than the plf, restarting");
+        *remoteSize = 0;
+    }
+
+    if ((ARUPDATER_OK == error) && (*remoteSize > 0))
+    {
+        remoteBuffer = malloc(manifest->chunkSize);
+        if (remoteBuffer == NULL)
+        {
+            error = ARUPDATER_ERROR_ALLOC;
+        }
+        completeChunks = (uint32_t)(*remoteSize / manifest->chunkSize);
+        tailSize = *remoteSize - (uint64_t)completeChunks * manifest->chunkSize;
+    }
+
+    for (index = completeChunks; (ARUPDATER_OK == error) && (index > 0) && (checks < ARUPDATER_UPLOADER_RESUME_MAX_CHECKS); index--, checks++)
+    {
+        error = ARUPDATER_Ftp_GetRange(uploader->ftpConnection, remotePath, (uint64_t)(index - 1) * manifest->chunkSize, remoteBuffer, manifest->chunkSize, &readSize);
+        if ((ARUPDATER_OK == error) && (readSize == manifest->chunkSize) &&
+            (ARUPDATER_Crc32c_Update(0, remoteBuffer, readSize) == manifest->chunkCrcs[index - 1]))
+        {
+            *verifiedSize = (uint64_t)index * manifest->chunkSize;
+            break;
+        }
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "chunk %u of the remote partial file is corrupted", index - 1);
+    }
+
+    if ((ARUPDATER_OK == error) && (tailSize > 0) && (*verifiedSize == (uint64_t)completeChunks * manifest->chunkSize))
+    {
+        error = ARUPDATER_Ftp_GetRange(uploader->ftpConnection, remotePath, *verifiedSize, remoteBuffer, tailSize, &readSize);
+        if ((ARUPDATER_OK == error) && (readSize == tailSize))
+        {
+            localChunk = ARUPDATER_FileMap_Get(&uploader->plf.map, (off_t)*verifiedSize, tailSize, &localSize);
+            if ((localChunk != NULL) && (localSize == tailSize) &&
+                (memcmp(localChunk, remoteBuffer, tailSize) == 0))
+            {
+                *verifiedSize = *remoteSize;
+            }
+        }
+    }
+
+    ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "remote partial file: %llu bytes, %llu verified", (unsigned long long)*remoteSize, (unsigned long long)*verifiedSize);
+
+    free(remoteBuffer);
+    ARUPDATER_Uploader_CloseDirectFtp(uploader);
+
+    return error;
+}
+
+static void ARUPDATER_Uploader_DirectProgressCallback(void *arg, size_t bytes)
+{
+    ARUPDATER_Manager_t *manager = (ARUPDATER_Manager_t *)arg;
+    ARUPDATER_Uploader_t *uploader = manager->uploader;
+
+    uploader->ftpBytesDone += bytes;
+    ARUPDATER_Uploader_ReportProgress(uploader, uploader->ftpBytesDone);
+    
+    if (ARUPDATER_Uploader_TransportDegraded(uploader, ARUPDATER_UPLOADER_TRANSPORT_FTP, uploader->ftpBytesDone))
+    {
+        ARUPDATER_Uploader_AbortFtpTransfer(uploader);
+    }
+}
 
-	/* open image file */
-	up->fd = open(filepath, O_RDONLY);
-	if (up->fd < 0) {
-		res = errno;
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"can't open mux update file '%s': error %s", filepath,
-			strerror(res));
-		status = ARUPDATER_ERROR_PLF;
-		goto out;
-	}
+/* upload the plf from offset with a REST, then rename it */
+static eARUPDATER_ERROR ARUPDATER_Uploader_DirectUpload(ARUPDATER_Manager_t *manager, const char *localPath, const char *tmpRemotePath, const char *finalRemotePath, uint64_t offset, uint64_t fileSize)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Uploader_t *uploader = manager->uploader;
 
-	/* get file size */
-	res = fstat(up->fd, &statbuf);
-	if (res < 0) {
-		res = errno;
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"can't stat mux update file '%s': error %s", filepath,
-			strerror(res));
-		status = ARUPDATER_ERROR_SYSTEM;
-		goto out;
-	}
+    uploader->ftpBytesDone = offset;
+    uploader->ftpBytesTotal = fileSize;
+    ARUPDATER_Uploader_StartProgress(uploader, fileSize);
 
-	up->size = statbuf.st_size;
+    error = ARUPDATER_Uploader_OpenDirectFtp(uploader);
 
-	/* allocate chunk buffer */
-	up->chunk = malloc(ARUPDATER_UPLOADER_MUX_CHUNK_SIZE);
-	if (!up->chunk) {
-		status = ARUPDATER_ERROR_ALLOC;
-		goto out;
-	}
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Ftp_PutRange(uploader->ftpConnection, tmpRemotePath, localPath, offset, 0, ARUPDATER_Uploader_DirectProgressCallback, manager);
+    }
 
-	/* open mux update channel */
-	res = mux_channel_open(up->mux, MUX_UPDATE_CHANNEL_ID_UPDATE,
-			&update_mux_channel_cb, manager);
-	if (res < 0) {
-		ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG,
-			"mux_channel_open: error %s", strerror(-res));
-		status = ARUPDATER_ERROR_UPLOADER;
-		goto out;
-	}
+    if ((ARUPDATER_OK == error) && (uploader->isCanceled == 0))
+    {
+        error = ARUPDATER_Ftp_Rename(uploader->ftpConnection, tmpRemotePath, finalRemotePath);
+    }
 
-	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG, "version:%s "
-		"md5:%s size:%zd", version, md5_to_str(md5, md5_str), up->size);
+    ARUPDATER_Uploader_CloseDirectFtp(uploader);
 
-	/* send update request */
-	res = updater_mux_write_msg(up->mux, MUX_UPDATE_MSG_ID_UPDATE_REQ,
-			MUX_UPDATE_MSG_FMT_ENC_UPDATE_REQ, version, md5,
-			sizeof(md5), up->size);
-	if (res < 0) {
-		status = ARUPDATER_ERROR_UPLOADER;
-		goto out;
-	}
+    return error;
+}
 
-	/* wait pipe events */
-	status = ARUPDATER_ERROR_UPLOADER;
-	while (1) {
+static void ARUPDATER_Uploader_SegmentsProgressCallback(void *arg, uint64_t done, uint64_t total)
+{
+    ARUPDATER_Manager_t *manager = (ARUPDATER_Manager_t *)arg;
 
-		/* poll pipe fds */
-		fds[0].fd = up->pipefds[0];
-		fds[0].events = POLLIN;
-		do {
-			res = poll(fds, 1, -1);
-		} while (res < 0 && errno == EINTR);
+    (void)total;
+    ARUPDATER_Uploader_ReportProgress(manager->uploader, done);
+    
+    if (ARUPDATER_Uploader_TransportDegraded(manager->uploader, ARUPDATER_UPLOADER_TRANSPORT_FTP, done))
+    {
+        ARUPDATER_Uploader_AbortFtpTransfer(manager->uploader);
+    }
+}
 
-		if (res < 0)
-			break;
+/* upload the plf from offset on several ftp connections, then rename it */
+static eARUPDATER_ERROR ARUPDATER_Uploader_SegmentedUpload(ARUPDATER_Manager_t *manager, const char *localPath, const char *tmpRemotePath, const char *finalRemotePath, const char *manifestRemotePath, uint64_t offset)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Uploader_t *uploader = manager->uploader;
+    ARUPDATER_FtpSegments_t *segments = NULL;
 
-		/* check read pipe data available */
-		if (fds[0].revents & POLLIN) {
-			/* read pipe status */
-			do {
-				res = read(up->pipefds[0], &event,
-						sizeof(event));
-			} while (res < 0 && errno == EINTR);
-
-			if (res != sizeof(event))
-				continue;
-
-			/* positive event upload progression */
-			if (event > 0) {
-				percent = (float)event;
-				up->progressCallback(up->progressArg, percent);
-			} else {
-				/* negative event are status (or error) */
-				status = (eARUPDATER_ERROR) event;
-				break;
-			}
-		}
-	}
+    // an interrupted segmented upload leaves holes in the remote file: without
+    // its manifest it will be restarted instead of resumed
+    error = ARUPDATER_Uploader_OpenDirectFtp(uploader);
+    if (ARUPDATER_OK == error)
+    {
+        error = ARUPDATER_Ftp_Delete(uploader->ftpConnection, manifestRemotePath);
+        if (ARUPDATER_ERROR_PLF_FILE_NOT_FOUND == error)
+        {
+            error = ARUPDATER_OK;
+        }
+    }
+    ARUPDATER_Uploader_CloseDirectFtp(uploader);
 
-out:
-	/* close all */
-	if (up->mux)
-		mux_channel_close(up->mux, MUX_UPDATE_CHANNEL_ID_UPDATE);
+    if (ARUPDATER_OK == error)
+    {
+        segments = ARUPDATER_FtpSegments_New(uploader->ftpServer, uploader->ftpPort, uploader->ftpUsername, uploader->ftpPassword, uploader->ftpSegmentCount, ARUPDATER_Uploader_SegmentsProgressCallback, manager, &error);
+    }
 
-	if (up->fd != -1) {
-		close(up->fd);
-		up->fd = -1;
-	}
+    ARSAL_Mutex_Lock(&uploader->uploadLock);
+    uploader->ftpSegments = segments;
+    if ((segments != NULL) && (uploader->isCanceled != 0))
+    {
+        ARUPDATER_FtpSegments_Cancel(segments);
+    }
+    ARSAL_Mutex_Unlock(&uploader->uploadLock);
 
-	free(filename);
-	free(up->chunk);
-	up->chunk = NULL;
+    if ((ARUPDATER_OK == error) && (uploader->isCanceled == 0))
+    {
+        error = ARUPDATER_FtpSegments_Upload(segments, tmpRemotePath, localPath, offset);
+    }
 
-	/* notify status before return */
-	up->isRunning = 0;
-	up->completionCallback(up->completionArg, status);
+    ARSAL_Mutex_Lock(&uploader->uploadLock);
+    uploader->ftpSegments = NULL;
+    ARSAL_Mutex_Unlock(&uploader->uploadLock);
+    ARUPDATER_FtpSegments_Delete(&segments);
 
-	ARSAL_PRINT(ARSAL_PRINT_INFO, ARUPDATER_UPLOADER_TAG,
-			"update over mux completed status: %d", status);
-	return status;
-#else
-    return ARUPDATER_ERROR_SYSTEM;
-#endif
+    if ((ARUPDATER_OK == error) && (uploader->isCanceled == 0))
+    {
+        error = ARUPDATER_Uploader_OpenDirectFtp(uploader);
+        if (ARUPDATER_OK == error)
+        {
+            error = ARUPDATER_Ftp_Rename(uploader->ftpConnection, tmpRemotePath, finalRemotePath);
+        }
+        ARUPDATER_Uploader_CloseDirectFtp(uploader);
+    }
+
+    return error;
 }
 
 eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager)
@@ -892,154 +2961,91 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
     uint8_t *md5 = NULL;
     double pflFileSize = 0.f;
     int existingFinalFile = 0;
+    char *manifestRemotePath = NULL;
+    char *manifestLocalPath = NULL;
+    ARUPDATER_Manifest_t *ownManifest = NULL;
+    const ARUPDATER_Manifest_t *manifest = NULL;
+    const char *localFileSuffix = "";
+    uint64_t verifiedSize = 0;
+    uint64_t remoteTmpSize = 0;
+    int restartFromVerifiedChunk = 0;
+    int segmentedUpload = 0;
+    ARUPDATER_Arena_t arena;
     
-    uint16_t productId = ARDISCOVERY_getProductID(manager->uploader->product);
-    device = malloc(ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE);
-    if (device == NULL)
-    {
-        error = ARUPDATER_ERROR_ALLOC;
-    }
-    
-    if (ARUPDATER_OK == error)
-    {
-        snprintf(device, ARUPDATER_MANAGER_DEVICE_STRING_MAX_SIZE, "%04x", productId);
-        
-        sourceFileFolder = malloc(strlen(manager->uploader->rootFolder) + strlen(ARUPDATER_MANAGER_PLF_FOLDER) + strlen(device) + strlen(ARUPDATER_MANAGER_FOLDER_SEPARATOR) + 1);
-        if (sourceFileFolder == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(sourceFileFolder, manager->uploader->rootFolder);
-            strcat(sourceFileFolder, ARUPDATER_MANAGER_PLF_FOLDER);
-            strcat(sourceFileFolder, device);
-            strcat(sourceFileFolder, ARUPDATER_MANAGER_FOLDER_SEPARATOR);
-        }
-    }
-    
-    if (ARUPDATER_OK == error)
-    {
-        error = ARUPDATER_Utils_GetPlfInFolder(sourceFileFolder, &fileName);
-    }
-    
-    if (ARUPDATER_OK == error)
+    if (manager->uploader->localFileSuffix != NULL)
     {
-        tmpDestFilePath = malloc(strlen(ARUPDATER_UPLOADER_REMOTE_FOLDER) + strlen(fileName) + strlen(ARUPDATER_UPLOADER_UPLOADED_FILE_SUFFIX) + 1);
-        if (tmpDestFilePath == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(tmpDestFilePath, ARUPDATER_UPLOADER_REMOTE_FOLDER);
-            strcat(tmpDestFilePath, fileName);
-            strcat(tmpDestFilePath, ARUPDATER_UPLOADER_UPLOADED_FILE_SUFFIX);
-        }
+        localFileSuffix = manager->uploader->localFileSuffix;
     }
-    
-    if (ARUPDATER_OK == error)
+    if ((manager->uploader->ftpServer != NULL) && (manager->uploader->ftpSegmentCount > 1))
     {
-        finalDestFilePath = malloc(strlen(ARUPDATER_UPLOADER_REMOTE_FOLDER) + strlen(fileName) + 1);
-        if (finalDestFilePath == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(finalDestFilePath, ARUPDATER_UPLOADER_REMOTE_FOLDER);
-            strcat(finalDestFilePath, fileName);
-        }
+        segmentedUpload = 1;
     }
     
-    if (ARUPDATER_OK == error)
-    {
-        sourceFilePath = malloc(strlen(sourceFileFolder) + strlen(fileName) + 1);
-        if (sourceFilePath == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(sourceFilePath, sourceFileFolder);
-            strcat(sourceFilePath, fileName);
-        }
-    }
+    uint16_t productId = ARDISCOVERY_getProductID(manager->uploader->product);
+    ARUPDATER_Arena_Init(&arena);
     
-    if (ARUPDATER_OK == error)
+    device = ARUPDATER_Arena_Printf(&arena, "%04x", productId);
+    sourceFileFolder = ARUPDATER_Arena_Concat(&arena, manager->uploader->rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, device, ARUPDATER_MANAGER_FOLDER_SEPARATOR, NULL);
+    if ((device == NULL) || (sourceFileFolder == NULL))
     {
-        plfDestLocalPath = malloc(strlen(sourceFileFolder) + strlen(fileName) + 1);
-        if (plfDestLocalPath == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(plfDestLocalPath, sourceFileFolder);
-            strcat(plfDestLocalPath, fileName);
-        }
+        error = ARUPDATER_ERROR_ALLOC;
     }
     
     if (ARUPDATER_OK == error)
     {
-        md5LocalPath = malloc(strlen(sourceFileFolder) + strlen(ARUPDATER_UPLOADER_MD5_FILENAME) + 1);
-        if (md5LocalPath == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-        else
-        {
-            strcpy(md5LocalPath, sourceFileFolder);
-            strcat(md5LocalPath, ARUPDATER_UPLOADER_MD5_FILENAME);
-        }
+        error = ARUPDATER_Utils_GetPlfInFolder(sourceFileFolder, &fileName);
     }
     
     if (ARUPDATER_OK == error)
     {
-        md5RemotePath = malloc(strlen(ARUPDATER_UPLOADER_REMOTE_FOLDER) + strlen(ARUPDATER_UPLOADER_MD5_FILENAME) + 1);
-        if (md5RemotePath == NULL)
+        tmpDestFilePath = ARUPDATER_Arena_Concat(&arena, ARUPDATER_UPLOADER_REMOTE_FOLDER, fileName, ARUPDATER_UPLOADER_UPLOADED_FILE_SUFFIX, NULL);
+        finalDestFilePath = ARUPDATER_Arena_Concat(&arena, ARUPDATER_UPLOADER_REMOTE_FOLDER, fileName, NULL);
+        sourceFilePath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, fileName, NULL);
+        plfDestLocalPath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, fileName, NULL);
+        md5LocalPath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, ARUPDATER_UPLOADER_MD5_FILENAME, localFileSuffix, NULL);
+        md5RemotePath = ARUPDATER_Arena_Concat(&arena, ARUPDATER_UPLOADER_REMOTE_FOLDER, ARUPDATER_UPLOADER_MD5_FILENAME, NULL);
+        manifestLocalPath = ARUPDATER_Arena_Concat(&arena, sourceFileFolder, ARUPDATER_UPLOADER_MANIFEST_FILENAME, localFileSuffix, NULL);
+        manifestRemotePath = ARUPDATER_Arena_Concat(&arena, ARUPDATER_UPLOADER_REMOTE_FOLDER, ARUPDATER_UPLOADER_MANIFEST_FILENAME, NULL);
+        md5 = ARUPDATER_Arena_Alloc(&arena, ARSAL_MD5_LENGTH);
+        md5Txt = ARUPDATER_Arena_Alloc(&arena, ARSAL_MD5_LENGTH * 2 + 1);
+        
+        if ((tmpDestFilePath == NULL) || (finalDestFilePath == NULL) || (sourceFilePath == NULL) ||
+            (plfDestLocalPath == NULL) || (md5LocalPath == NULL) || (md5RemotePath == NULL) ||
+            (manifestLocalPath == NULL) || (manifestRemotePath == NULL) || (md5 == NULL) || (md5Txt == NULL))
         {
             error = ARUPDATER_ERROR_ALLOC;
         }
-        else
-        {
-            strcpy(md5RemotePath, ARUPDATER_UPLOADER_REMOTE_FOLDER);
-            strcat(md5RemotePath, ARUPDATER_UPLOADER_MD5_FILENAME);
-        }
     }
     
     // get md5 of the plf file to upload
     if (error == ARUPDATER_OK)
     {
-        md5 = malloc(ARSAL_MD5_LENGTH);
-        if (md5 == NULL)
-        {
-            error = ARUPDATER_ERROR_ALLOC;
-        }
-    }
-    if (error == ARUPDATER_OK)
-    {
-        eARSAL_ERROR arsalError = ARSAL_MD5_Manager_Compute(manager->uploader->md5Manager, sourceFilePath, md5, ARSAL_MD5_LENGTH);
-        if (ARSAL_OK == arsalError)
+        error = ARUPDATER_Uploader_GetPlfMd5(manager->uploader, sourceFilePath, md5);
+        if (ARUPDATER_OK == error)
         {
             // get md5 in text
-            md5Txt = malloc(ARSAL_MD5_LENGTH * 2 + 1);
             int i = 0;
             for (i = 0; i < ARSAL_MD5_LENGTH; i++)
             {
                 snprintf(&md5Txt[i * 2], 3, "%02x", md5[i]);
             }
         }
-        else
-        {
-            error = ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR;
-        }
     }
     
-    if (md5 != NULL)
+    // get the chunk manifest of the plf file to upload
+    if ((error == ARUPDATER_OK) && (manager->uploader->plfManifest != NULL))
+    {
+        manifest = manager->uploader->plfManifest;
+    }
+    else if (error == ARUPDATER_OK)
+    {
+        ownManifest = ARUPDATER_Manifest_New(sourceFilePath, md5Txt, ARUPDATER_UPLOADER_RESUME_CHUNK_SIZE, &error);
+        manifest = ownManifest;
+    }
+    if (error == ARUPDATER_OK)
     {
-        free(md5);
-        md5 = NULL;
+        manager->uploader->ftpBytesTotal = manifest->fileSize;
+        ARUPDATER_Uploader_StartProgress(manager->uploader, manifest->fileSize);
     }
     
     // by default, do not resume an upload
@@ -1089,49 +3095,27 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
         FILE *md5File = fopen(md5LocalPath, "rb");
         if (md5File != NULL)
         {
-            int size = 0;
-            char line[ARUPDATER_UPLOADER_CHUNK_SIZE];
-            int allocatedSize = 1;
-            char *uploadedMD5 = malloc(allocatedSize);
+            // one byte more than an md5 tells a longer file apart
+            char *uploadedMD5 = ARUPDATER_Arena_Alloc(&arena, ARSAL_MD5_LENGTH * 2 + 2);
+            size_t size = 0;
             if (uploadedMD5 != NULL)
             {
-                strcpy(uploadedMD5, "");
+                size = fread(uploadedMD5, 1, ARSAL_MD5_LENGTH * 2 + 1, md5File);
+                uploadedMD5[size] = '\0';
+                
+                // md5s match, so we can resume the upload
+                if (strcmp(md5Txt, uploadedMD5) == 0)
+                {
+                    resumeMode = ARDATATRANSFER_UPLOADER_RESUME_TRUE;
+                } // ELSE md5s don't match, so keep the default value of resumeMode (=> begin a new upload)
             }
             else
             {
                 error = ARUPDATER_ERROR_ALLOC;
             }
-            
-            while ((ARUPDATER_OK == error) && (size = fread(line, 1, ARUPDATER_UPLOADER_CHUNK_SIZE, md5File)) != 0)
-            {
-                char *uploadedMD5Reallocated = realloc(uploadedMD5, allocatedSize + size + 1);
-                if (uploadedMD5Reallocated != NULL)
-                {
-                    allocatedSize += size;
-                    uploadedMD5 = uploadedMD5Reallocated;
-                    strncat(uploadedMD5, line, size);
-                    uploadedMD5[allocatedSize] = '\0';
-                }
-                else
-                {
-                    error = ARUPDATER_ERROR_ALLOC;
-                }
-            }
             fclose(md5File);
             md5File = NULL;
             
-            if (ARUPDATER_OK == error)
-            {
-                // md5s match, so we can resume the upload
-                if (strcmp(md5Txt, uploadedMD5) == 0)
-                {
-                    resumeMode = ARDATATRANSFER_UPLOADER_RESUME_TRUE;
-                } // ELSE md5s don't match, so keep the default value of resumeMode (=> begin a new upload)
-            }
-            
-            free(uploadedMD5);
-            uploadedMD5 = NULL;
-            
             // delete the md5LocalPath file
             unlink(md5LocalPath);
         }
@@ -1172,6 +3156,55 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
         ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
     }
     
+    // a partial upload is resumed only from its chunks matching the manifest
+    if ((ARUPDATER_OK == error) && (resumeMode == ARDATATRANSFER_UPLOADER_RESUME_TRUE) && (existingFinalFile == 0))
+    {
+        ARUPDATER_Manifest_t *remoteManifest = NULL;
+        
+        unlink(manifestLocalPath);
+        if (ARUPDATER_OK == ARUPDATER_Uploader_FetchFile(manager, manifestRemotePath, manifestLocalPath))
+        {
+            remoteManifest = ARUPDATER_Manifest_Read(manifestLocalPath, NULL);
+        }
+        unlink(manifestLocalPath);
+        
+        if (!ARUPDATER_Manifest_Equals(manifest, remoteManifest))
+        {
+            // the partial file was not sent with this manifest, its chunks can't be trusted
+            resumeMode = ARDATATRANSFER_UPLOADER_RESUME_FALSE;
+        }
+        else if (manager->uploader->ftpServer != NULL)
+        {
+            if ((ARUPDATER_Uploader_VerifyRemoteChunks(manager->uploader, manifest, tmpDestFilePath, &verifiedSize, &remoteTmpSize) != ARUPDATER_OK) ||
+                (verifiedSize == 0))
+            {
+                resumeMode = ARDATATRANSFER_UPLOADER_RESUME_FALSE;
+            }
+            else if (verifiedSize < remoteTmpSize)
+            {
+                restartFromVerifiedChunk = 1;
+            }
+        }
+        else
+        {
+            ARSAL_PRINT(ARSAL_PRINT_WARNING, ARUPDATER_UPLOADER_TAG, "no direct ftp access, resuming without chunk verification");
+        }
+        
+        ARUPDATER_Manifest_Delete(&remoteManifest);
+    }
+    
+    // store the manifest next to the md5 if the upload is a new one; it is sent first
+    // so that a remote md5 file always comes with its manifest
+    if ((ARUPDATER_OK == error) && (resumeMode == ARDATATRANSFER_UPLOADER_RESUME_FALSE))
+    {
+        error = ARUPDATER_Manifest_Write(manifest, manifestLocalPath);
+        if (ARUPDATER_OK == error)
+        {
+            error = ARUPDATER_Uploader_SendFile(manager, manifestRemotePath, manifestLocalPath);
+        }
+        unlink(manifestLocalPath);
+    }
+    
     // store in md5LocalPath the md5 of the file that will be uploaded if the upload is a new one
     if ((ARUPDATER_OK == error) && (resumeMode == ARDATATRANSFER_UPLOADER_RESUME_FALSE))
     {
@@ -1225,14 +3258,20 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
         unlink(md5LocalPath);
     }
     
-    if (md5Txt != NULL)
+    // send the plf on several connections, from the verified part of the remote partial file if any
+    if ((ARUPDATER_OK == error) && (existingFinalFile == 0) && (segmentedUpload == 1))
+    {
+        error = ARUPDATER_Uploader_SegmentedUpload(manager, sourceFilePath, tmpDestFilePath, finalDestFilePath, manifestRemotePath, (resumeMode == ARDATATRANSFER_UPLOADER_RESUME_TRUE) ? verifiedSize : 0);
+    }
+    
+    // rewrite the remote partial file from its last verified chunk
+    if ((ARUPDATER_OK == error) && (existingFinalFile == 0) && (segmentedUpload == 0) && (restartFromVerifiedChunk == 1))
     {
-        free(md5Txt);
-        md5Txt = NULL;
+        error = ARUPDATER_Uploader_DirectUpload(manager, sourceFilePath, tmpDestFilePath, finalDestFilePath, verifiedSize, manifest->fileSize);
     }
     
     //existing tmp plf with right md5
-    if ((ARUPDATER_OK == error) && (existingFinalFile == 0))
+    if ((ARUPDATER_OK == error) && (existingFinalFile == 0) && (segmentedUpload == 0) && (restartFromVerifiedChunk == 0))
     {
         ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
         // create a new uploader
@@ -1281,52 +3320,9 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
         ARSAL_PRINT (ARSAL_PRINT_ERROR, ARUPDATER_UPLOADER_TAG, "error: %s", ARUPDATER_Error_ToString (error));
     }
     
-    if (sourceFileFolder != NULL)
-    {
-        free(sourceFileFolder);
-    }
-    if (md5LocalPath != NULL)
-    {
-        free(md5LocalPath);
-    }
-    if (md5RemotePath != NULL)
-    {
-        free(md5RemotePath);
-    }
-    if (sourceFilePath != NULL)
-    {
-        free(sourceFilePath);
-    }
-    if (device != NULL)
-    {
-        free(device);
-    }
-    if (fileName != NULL)
-    {
-        free(fileName);
-    }
-    if (tmpDestFilePath != NULL)
-    {
-        free(tmpDestFilePath);
-    }
-    if (finalDestFilePath != NULL)
-    {
-        free(finalDestFilePath);
-    }
-    if (plfDestLocalPath != NULL)
-    {
-        free(plfDestLocalPath);
-    }
-    
-    if ((manager != NULL) && (manager->uploader != NULL))
-    {
-        manager->uploader->isRunning = 0;
-    }
-    
-    if (manager->uploader->completionCallback != NULL)
-    {
-        manager->uploader->completionCallback(manager->uploader->completionArg, error);
-    }
+    ARUPDATER_Manifest_Delete(&ownManifest);
+    free(fileName);
+    ARUPDATER_Arena_Release(&arena);
     
     return error;
 }
@@ -1334,9 +3330,12 @@ eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager
 void ARUPDATER_Uploader_ProgressCallback(void* arg, float percent)
 {
     ARUPDATER_Manager_t *manager = (ARUPDATER_Manager_t *)arg;
-    if (manager->uploader->progressCallback != NULL)
+    
+    ARUPDATER_Uploader_ReportProgress(manager->uploader, (uint64_t)(percent * manager->uploader->ftpBytesTotal / 100.0));
+    
+    if (ARUPDATER_Uploader_TransportDegraded(manager->uploader, ARUPDATER_UPLOADER_TRANSPORT_FTP, (uint64_t)(percent * manager->uploader->ftpBytesTotal / 100.0)))
     {
-        manager->uploader->progressCallback(manager->uploader->progressArg, percent);
+        ARUPDATER_Uploader_AbortFtpTransfer(manager->uploader);
     }
 }
 
@@ -1368,7 +3367,7 @@ eARUPDATER_ERROR ARUPDATER_Uploader_CancelThread(ARUPDATER_Manager_t *manager)
         manager->uploader->isCanceled = 1;
 
 #if defined BUILD_LIBMUX
-        update_mux_notify_status(manager->uploader, ARUPDATER_ERROR_UPLOADER);
+        ARUPDATER_EventRing_Wake(&manager->uploader->events);
 #endif
 
         ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
@@ -1378,13 +3377,14 @@ eARUPDATER_ERROR ARUPDATER_Uploader_CancelThread(ARUPDATER_Manager_t *manager)
         }
         ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
         
+        ARUPDATER_Uploader_AbortFtpTransfer(manager->uploader);
+
         ARSAL_Mutex_Lock(&manager->uploader->uploadLock);
-        if (manager->uploader->isUploadThreadRunning == 1)
+        if (manager->uploader->bleUpload != NULL)
         {
-            ARDATATRANSFER_Uploader_CancelThread(manager->uploader->dataTransferManager);
+            ARUPDATER_BleUpload_Cancel(manager->uploader->bleUpload);
         }
         ARSAL_Mutex_Unlock(&manager->uploader->uploadLock);
-
     }
     
     return error;
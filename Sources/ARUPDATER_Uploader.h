@@ -42,9 +42,45 @@
 #include <libARDataTransfer/ARDATATRANSFER_Uploader.h>
 #include <libARDataTransfer/ARDATATRANSFER_Downloader.h>
 #include <libARSAL/ARSAL_Mutex.h>
+#include "ARUPDATER_Ftp.h"
+#include "ARUPDATER_Manifest.h"
+#include "ARUPDATER_FtpSegments.h"
+#include "ARUPDATER_BleUpload.h"
+#include "ARUPDATER_FileMap.h"
+#include "ARUPDATER_Plf.h"
+#include "ARUPDATER_EventRing.h"
+#include "ARUPDATER_Throughput.h"
+#include "ARUPDATER_Progress.h"
 
 /* forward declaration */
 struct mux_ctx;
+struct z_stream_s;
+
+/* transports of the plf upload */
+typedef enum
+{
+    ARUPDATER_UPLOADER_TRANSPORT_DELOS = 0,     /* ARDataTransfer over BLE, android only */
+    ARUPDATER_UPLOADER_TRANSPORT_MUX,           /* mux update channel, usb */
+    ARUPDATER_UPLOADER_TRANSPORT_FTP,           /* ftp server of the device */
+    ARUPDATER_UPLOADER_TRANSPORT_BLE,           /* BLE link of the application, minidrones */
+} eARUPDATER_UPLOADER_TRANSPORT;
+
+/* most chunks in flight in a windowed mux update */
+#define ARUPDATER_UPLOADER_MUX_WINDOW_MAX 16
+
+/* a chunk in flight in a windowed mux update */
+typedef struct
+{
+    size_t id;
+    size_t offset;
+    size_t length;
+    int acked;
+    int retries;
+    struct timespec sentTime;
+} ARUPDATER_Uploader_MuxSlot_t;
+
+/* size of the chunks of the plf manifest */
+#define ARUPDATER_UPLOADER_RESUME_CHUNK_SIZE     (1024*1024)
 
 struct ARUPDATER_Uploader_t
 {
@@ -55,13 +91,90 @@ struct ARUPDATER_Uploader_t
     /* transport layer: ftp or mux */
     ARUTILS_Manager_t *ftpManager;
     struct mux_ctx *mux;
+    /* optional direct ftp access, see ARUPDATER_Uploader_SetFtpServer */
+    char *ftpServer;
+    int ftpPort;
+    char *ftpUsername;
+    char *ftpPassword;
+    ARUPDATER_Ftp_Connection_t *ftpConnection;
+    uint64_t ftpBytesDone;
+    uint64_t ftpBytesTotal;
+    int ftpSegmentCount;
+    ARUPDATER_FtpSegments_t *ftpSegments;
+    /* digest of the plf computed once for several uploaders, see ARUPDATER_Fleet */
+    uint8_t plfMd5[ARSAL_MD5_LENGTH];
+    int hasPlfMd5;
+    const ARUPDATER_Manifest_t *plfManifest;
+    /* transport selection, see ARUPDATER_Uploader_SetTransportSelection */
+    int transportSelection;
+    int transportSelecting;         /* both transports usable and measured during this upload */
+    int transportSwitch;            /* the running transport is stopped to go on with the other one */
+    int transportSwitchCount;
+    double ftpRate;                 /* last measured rates in bytes/s, 0 if unknown */
+    double muxRate;
+    ARUPDATER_Throughput_t throughput;
+    /* progress of the running upload, whatever its transport */
+    ARUPDATER_Progress_t progress;
+    ARSAL_Mutex_t progressLock;
+    /* firmware reported by the device, see ARUPDATER_Uploader_SetDeviceVersion */
+    char *deviceVersion;
+    char *deviceMd5;
+    /* resume of the Delos uploads, see ARUPDATER_Uploader_SetDelosResume */
+    int delosResume;
+    /* BLE link of the application, see ARUPDATER_Uploader_SetBleLink */
+    int bleMtu;
+    int bleWindow;
+    ARUPDATER_Uploader_BleWriteCallback_t bleWriteCallback;
+    void *bleWriteArg;
+    ARUPDATER_BleUpload_t *bleUpload;   /* running upload, under uploadLock */
+    /* suffix of the local temporary files, to keep uploaders sharing a root folder apart */
+    char *localFileSuffix;
+    /* plf of the running upload, opened and checked once for all the transports; its
+     * chunks are sent without copy when it is mapped */
+    ARUPDATER_Plf_t plf;
     /* mux vars */
-    int fd;
     size_t size;
     size_t n_written;
-    void *chunk;
     size_t chunk_id;
-    int pipefds[2];
+    ARUPDATER_EventRing_t events;   /* from the mux thread to ARUPDATER_Uploader_ThreadRunMux */
+    uint32_t muxChannel;            /* see ARUPDATER_Uploader_SetMuxChannel, 0 for the update channel */
+    uint32_t muxChannelId;          /* channel of the running update */
+    /* windowed mux transfer, see ARUPDATER_Uploader_SetMuxWindow */
+    int muxWindow;                  /* window asked to the remote, 1 for stop-and-wait */
+    int muxWindowActive;            /* window accepted by the remote for this update */
+    int muxCumulativeAck;           /* an ack covers all the chunks before it */
+    size_t muxBase;                 /* first chunk not acknowledged */
+    size_t muxNext;                 /* next chunk to send */
+    size_t muxNextOffset;           /* offset of the next chunk to send */
+    size_t muxRemoteBuffer;         /* most bytes in flight, 0 if unknown */
+    /* adaptive chunk size, see ARUPDATER_Uploader_SetMuxChunkAdaptive */
+    int muxAdaptive;
+    int muxAdaptiveActive;          /* the remote accepts chunks of any size */
+    size_t muxChunkSize;
+    size_t muxSentLength;           /* chunk in flight of the stop-and-wait transfer */
+    struct timespec muxSentTime;
+    ARUPDATER_Uploader_MuxStats_t muxStats;
+    /* resumed mux transfer, see ARUPDATER_Uploader_SetMuxResume */
+    int muxResume;
+    int muxResumeActive;            /* the remote keeps the chunks of an interrupted update */
+    size_t muxOfferedId;            /* resume point left by an interrupted update */
+    size_t muxOfferedOffset;
+    size_t muxResumeId;             /* chunk the transfer starts from, accepted by the remote */
+    size_t muxResumeOffset;
+    size_t muxAckedId;              /* first chunk not acknowledged */
+    size_t muxAckedOffset;
+    /* chunk crc32c, see ARUPDATER_Uploader_SetMuxChunkCrc */
+    int muxCrc;
+    int muxCrcActive;               /* the remote checks the chunks and nacks the corrupted ones */
+    /* chunk compression, see ARUPDATER_Uploader_SetMuxCompression */
+    int muxDeflate;
+    int muxDeflateActive;           /* the remote accepts compressed chunks */
+    struct z_stream_s *muxDeflateStream;
+    uint8_t *muxDeflateBuffer;
+    int muxDeflateSkip;             /* chunks left to send as they are after an incompressible one */
+    ARUPDATER_Throughput_t muxThroughput;   /* image bytes acknowledged */
+    ARUPDATER_Uploader_MuxSlot_t muxSlots[ARUPDATER_UPLOADER_MUX_WINDOW_MAX];
+    ARSAL_Mutex_t muxLock;          /* window state, shared by the mux and uploader threads */
 
     int isRunning;
     int isCanceled;
@@ -85,8 +198,35 @@ struct ARUPDATER_Uploader_t
 void ARUPDATER_Uploader_ProgressCallback(void* arg, float percent);
 void ARUPDATER_Uploader_CompletionCallback(void* arg, eARDATATRANSFER_ERROR error);
 
+/**
+ * @brief Give the uploader the digest of the plf so it is not computed again
+ * @param manager : pointer on the manager
+ * @param[in] md5 : md5 of the plf, ARSAL_MD5_LENGTH bytes, or NULL to forget a digest given before
+ * @param[in] manifest : chunk manifest of the plf, can be NULL. It must stay valid until the digest is forgotten
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetPlfDigest(ARUPDATER_Manager_t *manager, const uint8_t *md5, const ARUPDATER_Manifest_t *manifest);
+
+/**
+ * @brief Set the suffix appended to the local temporary files of the upload
+ * @param manager : pointer on the manager
+ * @param[in] suffix : the suffix, NULL for none
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_SetLocalFileSuffix(ARUPDATER_Manager_t *manager, const char *suffix);
+
+/**
+ * @brief Open and check the plf of the upload into uploader->plf
+ * @details Done by ARUPDATER_Uploader_ThreadRun() before any transport runs, the largest chunk read from it is a mux one.
+ * It is closed with ARUPDATER_Plf_Close().
+ * @param uploader : pointer on the uploader
+ * @return ARUPDATER_OK if operation went well, the description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Uploader_OpenPlf(ARUPDATER_Uploader_t *uploader);
+
 eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunAndroidDelos(ARUPDATER_Manager_t *manager);
 eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunNormal(ARUPDATER_Manager_t *manager);
 eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunMux(ARUPDATER_Manager_t *manager);
+eARUPDATER_ERROR ARUPDATER_Uploader_ThreadRunBle(ARUPDATER_Manager_t *manager);
 
 #endif
@@ -46,16 +46,41 @@
 #include <stdint.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fnmatch.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <fcntl.h>
 
 #include <libARSAL/ARSAL_Print.h>
 #include <libARSAL/ARSAL_Endianness.h>
 
 #include "ARUPDATER_Utils.h"
 #include "ARUPDATER_Plf.h"
+#include "ARUPDATER_PlfIndex.h"
 #include "ARUPDATER_Manager.h"
 
+#if defined BUILD_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
 #define ARUPDATER_UTILS_TAG                   "ARUPDATER_Utils"
+/* largest read of a plf section that is not mapped */
+#define ARUPDATER_UTILS_PLF_CHUNK_SIZE        (64*1024)
+
+#if defined(BUILD_LIBPLFNG)
+/* a file stored as is keeps the plf open for its view of the mapping */
+struct ARUPDATER_PlfFileView
+{
+    ARUPDATER_Plf_t reader;
+    uint8_t *buffer;                        /* copied or decoded data, NULL for a view */
+};
+#endif
 
 eARUPDATER_ERROR ARUPDATER_Utils_PlfVersionFromString(const char *str, ARUPDATER_PlfVersion *v)
 {
@@ -144,28 +169,40 @@ eARUPDATER_ERROR ARUPDATER_Utils_PlfVersionToString(const ARUPDATER_PlfVersion *
 eARUPDATER_ERROR ARUPDATER_Utils_ReadPlfVersion(const char *plfFilePath, ARUPDATER_PlfVersion *v)
 {
 	eARUPDATER_ERROR ret;
-	plf_phdr_t hdr;
-	uint32_t lg;
-	char lang[4];
+	ARUPDATER_Plf_t plf;
 
 	if (!plfFilePath || !v)
 		return ARUPDATER_ERROR_BAD_PARAMETER;
 
-	ret = ARUPDATER_Plf_GetHeader(plfFilePath, &hdr);
+	ret = ARUPDATER_Plf_Open(&plf, plfFilePath, sizeof(plf_phdr_t));
 	if (ret != ARUPDATER_OK)
 		return ret;
 
-	v->ver = hdr.p_ver;
-	v->edit = hdr.p_edit;
-	v->ext = hdr.p_ext;
+	ret = ARUPDATER_Utils_PlfVersionFromHeader(&plf.header, v);
+	ARUPDATER_Plf_Close(&plf);
+
+	return ret;
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_PlfVersionFromHeader(const plf_phdr_t *header, ARUPDATER_PlfVersion *v)
+{
+	uint32_t lg;
+	char lang[4];
+
+	if (!header || !v)
+		return ARUPDATER_ERROR_BAD_PARAMETER;
+
+	v->ver = header->p_ver;
+	v->edit = header->p_edit;
+	v->ext = header->p_ext;
 
 	/* lang is set to 0 on production version */
-	if (hdr.p_lang == 0) {
+	if (header->p_lang == 0) {
 		v->type = ARUPDATER_PLF_TYPE_PROD;
 		v->patch = 0;
 	} else {
 		/* lang field is little endian */
-		lg = dtohl(hdr.p_lang);
+		lg = dtohl(header->p_lang);
 		memcpy(lang, &lg, 4);
 
 		switch (lang[0]) {
@@ -274,6 +311,53 @@ eARUPDATER_ERROR ARUPDATER_Utils_GetPlfInFolder(const char *const plfFolder, cha
     return error;
 }
 
+int ARUPDATER_Utils_CopyRange(int in, const uint8_t *mapped, off_t offset, int out, size_t size)
+{
+    size_t left = size;
+    ssize_t n;
+#if defined(__linux__)
+    off_t inOffset = offset;
+
+#if defined(__NR_copy_file_range)
+    /* fails with ENOSYS before linux 4.5, and EXDEV across file systems
+     * before 5.3: sendfile goes on from where it stopped */
+    while (left > 0) {
+	n = syscall(__NR_copy_file_range, in, &inOffset, out, NULL, left, 0);
+	if (n > 0)
+	    left -= (size_t)n;
+	else if ((n < 0) && (errno == EINTR))
+	    continue;
+	else
+	    break;
+    }
+#endif
+
+    /* to a regular file since linux 2.6.33 */
+    while (left > 0) {
+	n = sendfile(out, in, &inOffset, left);
+	if (n > 0)
+	    left -= (size_t)n;
+	else if ((n < 0) && (errno == EINTR))
+	    continue;
+	else
+	    break;
+    }
+#endif
+
+    /* no kernel copy, write from the mapping */
+    while (left > 0) {
+	n = write(out, mapped + offset + (size - left), left);
+	if (n > 0)
+	    left -= (size_t)n;
+	else if ((n < 0) && (errno == EINTR))
+	    continue;
+	else
+	    return -1;
+    }
+
+    return 0;
+}
+
 #if defined(BUILD_LIBPLFNG)
 
 static void ARUPDATER_Utils_ExtractUnixFileFromPlf_Logger(void *priv, int prio, const char *fmt, va_list args)
@@ -293,48 +377,74 @@ static void ARUPDATER_Utils_ExtractUnixFileFromPlf_Logger(void *priv, int prio,
     ARSAL_PRINT(priotab[prio], ARUPDATER_UTILS_TAG, "libplfng: %s", buf);
 }
 
-eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFileFromPlf(const char *plfFileName, const char *outFolder, const char *unixFileName)
+/* open the plf with the reader, the key of its index is read from the open file */
+static eARUPDATER_ERROR ARUPDATER_Utils_OpenPlfReader(const char *plfFileName, ARUPDATER_Plf_t *reader, size_t chunkSize, ARUPDATER_PlfIndex_Key_t *key)
 {
-    FILE *fp;
-    int ret, i, count, pos = -1;
-    plf_unixhdr hdr;
-    char *p, *buf = NULL;
-    const char *filename;
-    struct plfng *plf = NULL;
-    const int bufsize = 4096; /* avoid PATH_MAX headaches */
+    eARUPDATER_ERROR ret;
+    struct stat st;
 
-    fp = fopen(plfFileName, "rb");
-    if (fp == NULL) {
-	ret = errno;
-	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "fopen(%s): %s", plfFileName, strerror(ret));
-	ret = ARUPDATER_ERROR;
-	goto finish;
-    }
+    ret = ARUPDATER_Plf_Open(reader, plfFileName, chunkSize);
+    if (ret != ARUPDATER_OK)
+	return ret;
 
-    plf = plfng_new_from_file(fp);
-    if (plf == NULL) {
-	ret = ARUPDATER_ERROR_ALLOC;
-	goto finish;
-    }
+    /* the index of the plf is cached for the next files extracted from it */
+    if (fstat(reader->fd, &st) < 0)
+	return ARUPDATER_ERROR_SYSTEM;
+    ARUPDATER_PlfIndex_KeyFromStat(&st, key);
 
-    buf = malloc(bufsize);
-    if (buf == NULL) {
-	ret = ARUPDATER_ERROR_ALLOC;
-	goto finish;
+    return ARUPDATER_OK;
+}
+
+/* open libplfng on the descriptor of the reader */
+static eARUPDATER_ERROR ARUPDATER_Utils_OpenPlfngOnReader(const char *plfFileName, ARUPDATER_Plf_t *reader, FILE **fp, struct plfng **plf)
+{
+    int fd;
+
+    fd = dup(reader->fd);
+    *fp = (fd >= 0) ? fdopen(fd, "rb") : NULL;
+    if (*fp == NULL) {
+	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "fdopen(%s): %s", plfFileName, strerror(errno));
+	if (fd >= 0)
+	    close(fd);
+	return ARUPDATER_ERROR;
     }
 
-    plfng_set_log_fn(plf, ARUPDATER_Utils_ExtractUnixFileFromPlf_Logger, NULL);
+    *plf = plfng_new_from_file(*fp);
+    if (*plf == NULL)
+	return ARUPDATER_ERROR_ALLOC;
+
+    plfng_set_log_fn(*plf, ARUPDATER_Utils_ExtractUnixFileFromPlf_Logger, NULL);
+
+    return ARUPDATER_OK;
+}
+
+static void ARUPDATER_Utils_ClosePlfng(ARUPDATER_Plf_t *reader, FILE *fp, struct plfng *plf)
+{
+    plfng_destroy(plf);
+    if (fp)
+	fclose(fp);
+    ARUPDATER_Plf_Close(reader);
+}
+
+/* index the U_UNIXFILE regular files of the plf by the trailing component of their path */
+static eARUPDATER_ERROR ARUPDATER_Utils_IndexPlf(struct plfng *plf, char *buf, int bufsize, ARUPDATER_PlfIndex_t **index)
+{
+    eARUPDATER_ERROR ret;
+    ARUPDATER_PlfIndex_Entry_t entry;
+    plf_unixhdr hdr;
+    const char *filename;
+    char *p;
+    int i, count;
 
     count = plfng_get_section_count(plf);
-    if (count < 0) {
-	ret = ARUPDATER_ERROR_PLF;
-	goto finish;
-    }
+    if (count < 0)
+	return ARUPDATER_ERROR_PLF;
+
+    *index = ARUPDATER_PlfIndex_New(count, &ret);
 
-    for (i = 0; i < count; i++) {
+    for (i = 0; (i < count) && (ret == ARUPDATER_OK); i++) {
 	/* probe section */
-	ret = plfng_get_unixfile_path(plf, i, &hdr, buf, bufsize);
-	if ((ret < 0) || !S_ISREG((mode_t)hdr.s_mode))
+	if ((plfng_get_unixfile_path(plf, i, &hdr, buf, bufsize) < 0) || !S_ISREG((mode_t)hdr.s_mode))
 	    /* probably not a U_UNIXFILE regular file */
 	    continue;
 
@@ -342,35 +452,415 @@ eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFileFromPlf(const char *plfFileName,
 	p = strrchr(buf, '/');
 	filename = p ? p+1 : buf;
 
-	if (strcmp(filename, unixFileName) == 0) {
-	    /* we have a match */
-	    pos = i;
-	    break;
+	memset(&entry, 0, sizeof(entry));
+	entry.section = i;
+	ret = ARUPDATER_PlfIndex_Add(*index, filename, &entry);
+    }
+
+    if (ret != ARUPDATER_OK)
+	ARUPDATER_PlfIndex_Delete(index);
+
+    return ret;
+}
+
+/* section of a file, libplfng is only opened when the index of the plf is not cached */
+static eARUPDATER_ERROR ARUPDATER_Utils_FindUnixFile(const char *plfFileName, ARUPDATER_Plf_t *reader, const ARUPDATER_PlfIndex_Key_t *key,
+						    const char *unixFileName, ARUPDATER_PlfIndex_Entry_t *entry)
+{
+    FILE *fp = NULL;
+    eARUPDATER_ERROR ret = ARUPDATER_OK;
+    int found = 0;
+    char *buf = NULL;
+    struct plfng *plf = NULL;
+    ARUPDATER_PlfIndex_t *index = NULL;
+    const int bufsize = 4096; /* avoid PATH_MAX headaches */
+
+    if (!ARUPDATER_PlfIndex_CacheFind(key, unixFileName, &found, entry)) {
+	ret = ARUPDATER_Utils_OpenPlfngOnReader(plfFileName, reader, &fp, &plf);
+	if (ret == ARUPDATER_OK) {
+	    buf = malloc(bufsize);
+	    ret = (buf != NULL) ? ARUPDATER_Utils_IndexPlf(plf, buf, bufsize, &index) : ARUPDATER_ERROR_ALLOC;
+	}
+	if (ret == ARUPDATER_OK) {
+	    found = ARUPDATER_PlfIndex_Find(index, unixFileName, entry);
+	    ARUPDATER_PlfIndex_CacheStore(key, &index);
 	}
+	plfng_destroy(plf);
+	if (fp)
+	    fclose(fp);
+	free(buf);
     }
 
-    if (pos < 0) {
-	/* file was not found */
+    if ((ret == ARUPDATER_OK) && !found) {
 	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "file '%s' not found in PLF file %s", unixFileName, plfFileName);
 	ret = ARUPDATER_ERROR_PLF;
+    }
+
+    return ret;
+}
+
+/* data of a section: a view of the mapped plf when it is stored as is and
+ * mapped, or a buffer, to free, with the read or decoded data */
+static eARUPDATER_ERROR ARUPDATER_Utils_LoadSection(ARUPDATER_Plf_t *reader, const ARUPDATER_Plf_Section_t *section,
+						   uint8_t **buffer, const uint8_t **content, size_t *contentSize)
+{
+    const void *chunk;
+    size_t done, got;
+#if defined BUILD_ZLIB
+    z_stream zs;
+    int zret = Z_OK;
+#endif
+
+    if (section->uncompressedSize == 0) {
+	*contentSize = section->size;
+	if (reader->map.data != NULL) {
+	    *content = reader->map.data + section->offset;
+	    return ARUPDATER_OK;
+	}
+
+	*buffer = malloc((section->size > 0) ? section->size : 1);
+	if (*buffer == NULL)
+	    return ARUPDATER_ERROR_ALLOC;
+
+	for (done = 0; done < section->size; done += got) {
+	    got = section->size - done;
+	    if (got > ARUPDATER_UTILS_PLF_CHUNK_SIZE)
+		got = ARUPDATER_UTILS_PLF_CHUNK_SIZE;
+	    chunk = ARUPDATER_FileMap_Get(&reader->map, (off_t)(section->offset + done), got, &got);
+	    if (chunk == NULL)
+		return ARUPDATER_ERROR_SYSTEM;
+	    memcpy(*buffer + done, chunk, got);
+	}
+
+	*content = *buffer;
+	return ARUPDATER_OK;
+    }
+
+#if defined BUILD_ZLIB
+    /* zlib or gzip stream, of uncompressedSize bytes once decoded */
+    *buffer = malloc(section->uncompressedSize);
+    if (*buffer == NULL)
+	return ARUPDATER_ERROR_ALLOC;
+
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 + 32) != Z_OK)
+	return ARUPDATER_ERROR_ALLOC;
+
+    zs.next_out = *buffer;
+    zs.avail_out = section->uncompressedSize;
+    for (done = 0; (done < section->size) && (zret == Z_OK); done += got) {
+	got = section->size - done;
+	if (got > ARUPDATER_UTILS_PLF_CHUNK_SIZE)
+	    got = ARUPDATER_UTILS_PLF_CHUNK_SIZE;
+	chunk = ARUPDATER_FileMap_Get(&reader->map, (off_t)(section->offset + done), got, &got);
+	if (chunk == NULL) {
+	    zret = Z_ERRNO;
+	    break;
+	}
+	zs.next_in = (Bytef *)chunk;
+	zs.avail_in = got;
+	zret = inflate(&zs, Z_NO_FLUSH);
+    }
+    inflateEnd(&zs);
+
+    if ((zret != Z_STREAM_END) || (zs.total_out != section->uncompressedSize)) {
+	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "can't decode section at %zu: %d", section->offset, zret);
+	return ARUPDATER_ERROR_PLF;
+    }
+
+    *content = *buffer;
+    *contentSize = section->uncompressedSize;
+    return ARUPDATER_OK;
+#else
+    ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "section at %zu is compressed, no zlib", section->offset);
+    return ARUPDATER_ERROR_PLF;
+#endif
+}
+
+/* data of a U_UNIXFILE regular file in the content of its section: the unix
+ * header, the path and then the data */
+static eARUPDATER_ERROR ARUPDATER_Utils_ParseUnixFile(const uint8_t *content, size_t contentSize, const char *unixFileName,
+						     const void **data, size_t *size, mode_t *fileMode)
+{
+    uint32_t mode;
+    const char *path, *end, *filename;
+
+    if (contentSize < sizeof(plf_unixhdr))
+	return ARUPDATER_ERROR_PLF;
+
+    memcpy(&mode, content + offsetof(plf_unixhdr, s_mode), sizeof(mode));
+    path = (const char *)content + sizeof(plf_unixhdr);
+    end = memchr(path, '\0', contentSize - sizeof(plf_unixhdr));
+    if (!S_ISREG((mode_t)dtohl(mode)) || (end == NULL))
+	return ARUPDATER_ERROR_PLF;
+
+    /* the section is the one libplfng indexed */
+    filename = strrchr(path, '/');
+    filename = filename ? filename+1 : path;
+    if (strcmp(filename, unixFileName) != 0) {
+	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "section of '%s' holds '%s'", unixFileName, path);
+	return ARUPDATER_ERROR_PLF;
+    }
+
+    *data = end + 1;
+    *size = contentSize - (size_t)((const uint8_t *)(end + 1) - content);
+    if (fileMode != NULL)
+	*fileMode = (mode_t)dtohl(mode);
+    return ARUPDATER_OK;
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_OpenUnixFileFromPlf(const char *plfFileName, const char *unixFileName, ARUPDATER_PlfFileView **view, const void **data, size_t *size)
+{
+    eARUPDATER_ERROR ret;
+    const uint8_t *content = NULL;
+    size_t contentSize = 0;
+    ARUPDATER_PlfFileView *v;
+    ARUPDATER_PlfIndex_Key_t key;
+    ARUPDATER_PlfIndex_Entry_t entry;
+
+    if ((plfFileName == NULL) || (unixFileName == NULL) || (view == NULL) || (data == NULL) || (size == NULL))
+	return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    v = calloc(1, sizeof(*v));
+    if (v == NULL)
+	return ARUPDATER_ERROR_ALLOC;
+
+    ret = ARUPDATER_Utils_OpenPlfReader(plfFileName, &v->reader, ARUPDATER_UTILS_PLF_CHUNK_SIZE, &key);
+    if (ret == ARUPDATER_OK)
+	ret = ARUPDATER_Utils_FindUnixFile(plfFileName, &v->reader, &key, unixFileName, &entry);
+
+    if ((ret == ARUPDATER_OK) && ((entry.section < 0) || (entry.section >= v->reader.sectionCount)))
+	ret = ARUPDATER_ERROR_PLF;
+
+    if (ret == ARUPDATER_OK)
+	ret = ARUPDATER_Utils_LoadSection(&v->reader, &v->reader.sections[entry.section], &v->buffer, &content, &contentSize);
+
+    if (ret == ARUPDATER_OK)
+	ret = ARUPDATER_Utils_ParseUnixFile(content, contentSize, unixFileName, data, size, NULL);
+
+    /* a copy needs the plf no more */
+    if ((ret == ARUPDATER_OK) && (v->buffer != NULL))
+	ARUPDATER_Plf_Close(&v->reader);
+
+    if (ret != ARUPDATER_OK)
+	ARUPDATER_Utils_CloseUnixFileFromPlf(&v);
+
+    *view = v;
+    return ret;
+}
+
+void ARUPDATER_Utils_CloseUnixFileFromPlf(ARUPDATER_PlfFileView **view)
+{
+    if ((view != NULL) && (*view != NULL)) {
+	ARUPDATER_Plf_Close(&(*view)->reader);
+	free((*view)->buffer);
+	free(*view);
+	*view = NULL;
+    }
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_ReadUnixFileFromPlf(const char *plfFileName, const char *unixFileName, void *buffer, size_t bufferSize, size_t *size)
+{
+    eARUPDATER_ERROR ret;
+    ARUPDATER_PlfFileView *view = NULL;
+    const void *data = NULL;
+
+    if ((size == NULL) || ((buffer == NULL) && (bufferSize > 0)))
+	return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    ret = ARUPDATER_Utils_OpenUnixFileFromPlf(plfFileName, unixFileName, &view, &data, size);
+    if (ret != ARUPDATER_OK)
+	return ret;
+
+    if (*size > bufferSize)
+	ret = ARUPDATER_ERROR_MANAGER_BUFFER_TOO_SMALL;
+    else if (*size > 0)
+	memcpy(buffer, data, *size);
+
+    ARUPDATER_Utils_CloseUnixFileFromPlf(&view);
+    return ret;
+}
+
+/* a file stored as is in a mapped plf is copied without libplfng, its data
+ * doesn't go through a buffer; returns 0 when libplfng must extract it */
+static int ARUPDATER_Utils_CopyUnixFile(ARUPDATER_Plf_t *reader, const ARUPDATER_Plf_Section_t *section, const char *unixFileName,
+				       const char *outPath, eARUPDATER_ERROR *ret)
+{
+    const void *data = NULL;
+    size_t size = 0;
+    mode_t mode = 0;
+    int fd;
+
+    if ((section->uncompressedSize != 0) || (reader->map.data == NULL))
+	return 0;
+
+    *ret = ARUPDATER_Utils_ParseUnixFile(reader->map.data + section->offset, section->size, unixFileName, &data, &size, &mode);
+    if (*ret != ARUPDATER_OK)
+	return 1;
+
+    fd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, ((mode & 0777) != 0) ? (mode & 0777) : 0644);
+    if (fd < 0) {
+	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "open(%s): %s", outPath, strerror(errno));
+	*ret = ARUPDATER_ERROR_SYSTEM;
+	return 1;
+    }
+
+    if (ARUPDATER_Utils_CopyRange(reader->fd, reader->map.data, (off_t)((const uint8_t *)data - reader->map.data), fd, size) < 0) {
+	ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "write(%s): %s", outPath, strerror(errno));
+	*ret = ARUPDATER_ERROR_SYSTEM;
+    }
+    if ((close(fd) < 0) && (*ret == ARUPDATER_OK))
+	*ret = ARUPDATER_ERROR_SYSTEM;
+
+    if (*ret != ARUPDATER_OK)
+	unlink(outPath);
+
+    return 1;
+}
+
+/* extract a section, libplfng is opened on the reader the first time it decodes one */
+static eARUPDATER_ERROR ARUPDATER_Utils_ExtractSection(const char *plfFileName, ARUPDATER_Plf_t *reader, FILE **fp, struct plfng **plf,
+						      int section, const char *unixFileName, const char *outPath)
+{
+    eARUPDATER_ERROR ret = ARUPDATER_OK;
+
+    if ((section < 0) || (section >= reader->sectionCount))
+	return ARUPDATER_ERROR_PLF;
+
+    if (ARUPDATER_Utils_CopyUnixFile(reader, &reader->sections[section], unixFileName, outPath, &ret))
+	return ret;
+
+    if (*plf == NULL)
+	ret = ARUPDATER_Utils_OpenPlfngOnReader(plfFileName, reader, fp, plf);
+
+    if ((ret == ARUPDATER_OK) && (plfng_extract_unixfile(*plf, section, outPath) < 0))
+	ret = ARUPDATER_ERROR_PLF;
+
+    return ret;
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFileFromPlf(const char *plfFileName, const char *outFolder, const char *unixFileName)
+{
+    FILE *fp = NULL;
+    int ret;
+    char *buf = NULL;
+    struct plfng *plf = NULL;
+    ARUPDATER_Plf_t reader;
+    ARUPDATER_PlfIndex_Key_t key;
+    ARUPDATER_PlfIndex_Entry_t entry;
+    const int bufsize = 4096; /* avoid PATH_MAX headaches */
+
+    memset(&reader, 0, sizeof(reader));
+    ret = ARUPDATER_Utils_OpenPlfReader(plfFileName, &reader, ARUPDATER_UTILS_PLF_CHUNK_SIZE, &key);
+    if (ret != ARUPDATER_OK)
+	goto finish;
+
+    ret = ARUPDATER_Utils_FindUnixFile(plfFileName, &reader, &key, unixFileName, &entry);
+    if (ret != ARUPDATER_OK)
+	goto finish;
+
+    buf = malloc(bufsize);
+    if (buf == NULL) {
+	ret = ARUPDATER_ERROR_ALLOC;
 	goto finish;
     }
 
     /* now do the extraction */
     snprintf(buf, bufsize, "%s/%s", outFolder, unixFileName);
-    ret = plfng_extract_unixfile(plf, pos, buf);
-    if (ret < 0) {
-	ret = ARUPDATER_ERROR_PLF;
+    ret = ARUPDATER_Utils_ExtractSection(plfFileName, &reader, &fp, &plf, entry.section, unixFileName, buf);
+
+ finish:
+    ARUPDATER_Utils_ClosePlfng(&reader, fp, plf);
+    free(buf);
+
+    return ret;
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFilesFromPlf(const char *plfFileName, const char *outFolder, const char * const *unixFileNames, int count,
+							 ARUPDATER_Utils_ExtractCallback_t extractCallback, void *extractArg)
+{
+    FILE *fp = NULL;
+    eARUPDATER_ERROR ret, status = ARUPDATER_OK;
+    int i, j, isSelected, isCached = 0;
+    int *matches = NULL;
+    char *buf = NULL;
+    const char *filename;
+    struct plfng *plf = NULL;
+    ARUPDATER_Plf_t reader;
+    ARUPDATER_PlfIndex_t *index = NULL;
+    ARUPDATER_PlfIndex_Key_t key;
+    ARUPDATER_PlfIndex_Entry_t entry;
+    const int bufsize = 4096; /* avoid PATH_MAX headaches */
+
+    if ((plfFileName == NULL) || (outFolder == NULL) || (unixFileNames == NULL) || (count <= 0))
+	return ARUPDATER_ERROR_BAD_PARAMETER;
+
+    memset(&reader, 0, sizeof(reader));
+    ret = ARUPDATER_Utils_OpenPlfReader(plfFileName, &reader, ARUPDATER_UTILS_PLF_CHUNK_SIZE, &key);
+    if (ret != ARUPDATER_OK)
+	goto finish;
+
+    buf = malloc(bufsize);
+    matches = calloc(count, sizeof(*matches));
+    if ((buf == NULL) || (matches == NULL)) {
+	ret = ARUPDATER_ERROR_ALLOC;
 	goto finish;
     }
 
-    /* everything went smoothly */
-    ret = ARUPDATER_OK;
+    index = ARUPDATER_PlfIndex_CacheGet(&key);
+    isCached = (index != NULL);
+    if (!isCached) {
+	ret = ARUPDATER_Utils_OpenPlfngOnReader(plfFileName, &reader, &fp, &plf);
+	if (ret == ARUPDATER_OK)
+	    ret = ARUPDATER_Utils_IndexPlf(plf, buf, bufsize, &index);
+	if (ret != ARUPDATER_OK)
+	    goto finish;
+    }
+
+    /* the files are in the order of their sections, so the plf is read in
+     * one pass from its start to its end */
+    for (i = 0; i < ARUPDATER_PlfIndex_GetCount(index); i++) {
+	filename = ARUPDATER_PlfIndex_Get(index, i, &entry);
+
+	isSelected = 0;
+	for (j = 0; j < count; j++) {
+	    if (fnmatch(unixFileNames[j], filename, 0) == 0) {
+		matches[j]++;
+		isSelected = 1;
+	    }
+	}
+	if (!isSelected)
+	    continue;
+
+	snprintf(buf, bufsize, "%s/%s", outFolder, filename);
+	ret = ARUPDATER_Utils_ExtractSection(plfFileName, &reader, &fp, &plf, entry.section, filename, buf);
+	if ((ret != ARUPDATER_OK) && (status == ARUPDATER_OK))
+	    status = ret;
+
+	if (extractCallback != NULL)
+	    extractCallback(extractArg, filename, ret);
+    }
+
+    /* a name, or a pattern, that is in none of the files */
+    for (j = 0; j < count; j++) {
+	if (matches[j] == 0) {
+	    ARSAL_PRINT(ARSAL_PRINT_ERROR, ARUPDATER_UTILS_TAG, "file '%s' not found in PLF file %s", unixFileNames[j], plfFileName);
+	    if (status == ARUPDATER_OK)
+		status = ARUPDATER_ERROR_PLF;
+	    if (extractCallback != NULL)
+		extractCallback(extractArg, unixFileNames[j], ARUPDATER_ERROR_PLF);
+	}
+    }
+
+    ret = status;
 
  finish:
-    if (fp)
-	fclose(fp);
-    plfng_destroy(plf);
+    if (isCached)
+	ARUPDATER_PlfIndex_CacheRelease(&index);
+    else
+	ARUPDATER_PlfIndex_CacheStore(&key, &index);
+    ARUPDATER_Utils_ClosePlfng(&reader, fp, plf);
+    free(matches);
     free(buf);
 
     return ret;
@@ -383,4 +873,24 @@ eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFileFromPlf(const char *plfFileName,
     return ARUPDATER_ERROR;
 }
 
+eARUPDATER_ERROR ARUPDATER_Utils_ExtractUnixFilesFromPlf(const char *plfFileName, const char *outFolder, const char * const *unixFileNames, int count,
+							 ARUPDATER_Utils_ExtractCallback_t extractCallback, void *extractArg)
+{
+    return ARUPDATER_ERROR;
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_OpenUnixFileFromPlf(const char *plfFileName, const char *unixFileName, ARUPDATER_PlfFileView **view, const void **data, size_t *size)
+{
+    return ARUPDATER_ERROR;
+}
+
+void ARUPDATER_Utils_CloseUnixFileFromPlf(ARUPDATER_PlfFileView **view)
+{
+}
+
+eARUPDATER_ERROR ARUPDATER_Utils_ReadUnixFileFromPlf(const char *plfFileName, const char *unixFileName, void *buffer, size_t bufferSize, size_t *size)
+{
+    return ARUPDATER_ERROR;
+}
+
 #endif /* BUILD_LIBPLFNG */
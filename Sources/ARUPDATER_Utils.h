@@ -40,6 +40,7 @@
 
 #include <libARUpdater/ARUPDATER_Error.h>
 #include <libARUpdater/ARUPDATER_Utils.h>
+#include "ARUPDATER_Plf.h"
 
 /**
  * @brief get the plf path of the first plf file found in a given folder
@@ -49,4 +50,25 @@
  */
 eARUPDATER_ERROR ARUPDATER_Utils_GetPlfInFolder(const char *const plfFolder, char **plfFileName);
 
+/**
+ * @brief Get the version of a plf from its header
+ * @param[in] header : header of the plf, see ARUPDATER_Plf_Open()
+ * @param[out] version : the version of the plf
+ * @return ARUPDATER_OK if operation went well, a description of the error otherwise
+ */
+eARUPDATER_ERROR ARUPDATER_Utils_PlfVersionFromHeader(const plf_phdr_t *header, ARUPDATER_PlfVersion *version);
+
+/**
+ * @brief Copy a range of a mapped file to another file, in the kernel when it can
+ * @details Uses copy_file_range, then sendfile, and writes from the mapping when the kernel
+ * can't copy, e.g. when in is not a valid descriptor.
+ * @param[in] in : descriptor of the mapped file
+ * @param[in] mapped : the mapping of the whole file
+ * @param[in] offset : offset of the range in the file
+ * @param[in] out : descriptor of the file written from its current offset
+ * @param[in] size : size of the range
+ * @return 0 if operation went well, -1 with errno set otherwise
+ */
+int ARUPDATER_Utils_CopyRange(int in, const uint8_t *mapped, off_t offset, int out, size_t size);
+
 #endif
@@ -0,0 +1,251 @@
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-segmented-upload
+LOCAL_DESCRIPTION := ARSDK Updater segmented ftp upload test
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_LDLIBS := \
+	-lpthread \
+	-lm
+
+LOCAL_SRC_FILES := \
+	segmentedUploadTest.c \
+	ftpStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-upload-bench
+LOCAL_DESCRIPTION := ARSDK Updater upload throughput benchmark
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUtils \
+	libARUpdater
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_LDLIBS := \
+	-lpthread \
+	-lm
+
+LOCAL_SRC_FILES := \
+	uploadBench.c \
+	ftpStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-mux-chunk-bench
+LOCAL_DESCRIPTION := ARSDK Updater mux update chunk cpu benchmark
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater \
+	libpomp \
+	libmux
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_SRC_FILES := \
+	muxChunkBench.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-mux-update-bench
+LOCAL_DESCRIPTION := ARSDK Updater mux update throughput benchmark
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUtils \
+	libARUpdater \
+	libpomp \
+	libmux
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_CONDITIONAL_LIBRARIES := \
+	OPTIONAL:zlib
+
+LOCAL_LDLIBS := \
+	-lpthread
+
+LOCAL_SRC_FILES := \
+	muxUpdateBench.c \
+	muxStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-mux-dual-update-bench
+LOCAL_DESCRIPTION := ARSDK Updater skycontroller and drone update over one mux
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUtils \
+	libARUpdater \
+	libpomp \
+	libmux
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_CONDITIONAL_LIBRARIES := \
+	OPTIONAL:zlib
+
+LOCAL_LDLIBS := \
+	-lpthread
+
+LOCAL_SRC_FILES := \
+	muxDualUpdateBench.c \
+	muxStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-delos-resume-bench
+LOCAL_DESCRIPTION := ARSDK Updater Delos upload resume over a dropping BLE link
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUtils \
+	libARDataTransfer \
+	libARUpdater
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_LDLIBS := \
+	-lpthread
+
+LOCAL_SRC_FILES := \
+	delosResumeBench.c \
+	bleFtpStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-ble-upload-bench
+LOCAL_DESCRIPTION := ARSDK Updater BLE upload over a simulated link
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUtils \
+	libARDataTransfer \
+	libARUpdater
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_LDLIBS := \
+	-lpthread
+
+LOCAL_SRC_FILES := \
+	bleUploadBench.c \
+	bleFtpStandIn.c \
+	bleLinkStandIn.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-plf-extract-bench
+LOCAL_DESCRIPTION := ARSDK Updater extraction of files from a plf
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater \
+	libplfng
+
+LOCAL_SRC_FILES := \
+	plfExtractBench.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-plf-reader
+LOCAL_DESCRIPTION := ARSDK Updater plf reader checks on valid and broken files
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater
+
+LOCAL_CONDITIONAL_LIBRARIES := \
+	OPTIONAL:libplfng
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_SRC_FILES := \
+	plfReaderTest.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-plf-extract
+LOCAL_DESCRIPTION := ARSDK Updater checks of the files read and extracted from a plf
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater \
+	libplfng \
+	zlib
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_SRC_FILES := \
+	plfExtractTest.c
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := tst-arupdater-event-ring
+LOCAL_DESCRIPTION := ARSDK Updater mux status event ring checks
+LOCAL_CATEGORY_PATH := dragon/libs
+
+LOCAL_LIBRARIES := \
+	libARSAL \
+	libARUpdater
+
+LOCAL_C_INCLUDES := \
+	$(LOCAL_PATH)/../../Sources
+
+LOCAL_LDLIBS := \
+	-lpthread
+
+LOCAL_SRC_FILES := \
+	eventRingTest.c
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,226 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file bleFtpStandIn.c
+ * @brief libARUpdater TestBench in-process device side of the BLE ftp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL_Print.h>
+#include <libARUtils/ARUtils.h>
+
+#include "bleFtpStandIn.h"
+
+#define BLE_FTP_STAND_IN_TAG        "BleFtpStandIn"
+#define BLE_FTP_STAND_IN_PACKET_MAX (64*1024)
+
+static struct
+{
+    pthread_mutex_t lock;
+    BleFtpStandIn_Config_t config;
+    BleFtpStandIn_Counters_t counters;
+    char path[512];
+    int isCanceled;
+} bleFtpStandIn = { PTHREAD_MUTEX_INITIALIZER };
+
+static double BleFtpStandIn_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t BleFtpStandIn_Size(const char *path)
+{
+    struct stat statbuf;
+
+    return (stat(path, &statbuf) == 0) ? (uint64_t)statbuf.st_size : 0;
+}
+
+int BleFtpStandIn_Init(const char *folder, const BleFtpStandIn_Config_t *config)
+{
+    if ((folder == NULL) || (config == NULL) || (config->packetSize <= 0) || (config->packetSize > BLE_FTP_STAND_IN_PACKET_MAX))
+        return -1;
+
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    bleFtpStandIn.config = *config;
+    snprintf(bleFtpStandIn.path, sizeof(bleFtpStandIn.path), "%s/delos.plf", folder);
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+
+    BleFtpStandIn_Reset();
+    return 0;
+}
+
+void BleFtpStandIn_Reset(void)
+{
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    unlink(bleFtpStandIn.path);
+    memset(&bleFtpStandIn.counters, 0, sizeof(bleFtpStandIn.counters));
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+}
+
+void BleFtpStandIn_GetCounters(BleFtpStandIn_Counters_t *counters)
+{
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    *counters = bleFtpStandIn.counters;
+    counters->bytesReceived = BleFtpStandIn_Size(bleFtpStandIn.path);
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+}
+
+const char *BleFtpStandIn_GetPath(void)
+{
+    return bleFtpStandIn.path;
+}
+
+/* ARUtils functions used by the Delos upload */
+
+eARUTILS_ERROR ARUTILS_Manager_Ftp_Put(ARUTILS_Manager_t *manager, const char *namePath, const char *srcFile, ARUTILS_Ftp_ProgressCallback_t progressCallback, void *progressArg, eARUTILS_FTP_RESUME resume)
+{
+    eARUTILS_ERROR error = ARUTILS_OK;
+    BleFtpStandIn_Config_t config;
+    char *packet = NULL;
+    FILE *src = NULL;
+    FILE *dst = NULL;
+    uint64_t offset = 0, size, sent = 0;
+    size_t len;
+    double start, ahead;
+
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    config = bleFtpStandIn.config;
+    bleFtpStandIn.isCanceled = 0;
+    bleFtpStandIn.counters.connections++;
+    if (resume == FTP_RESUME_TRUE)
+    {
+        offset = BleFtpStandIn_Size(bleFtpStandIn.path);
+        bleFtpStandIn.counters.resumedAt = offset;
+    }
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+
+    src = fopen(srcFile, "rb");
+    dst = fopen(bleFtpStandIn.path, (offset > 0) ? "r+b" : "wb");
+    packet = malloc(config.packetSize);
+    if ((src == NULL) || (dst == NULL) || (packet == NULL))
+    {
+        error = ARUTILS_ERROR_FTP_FILE;
+        goto out;
+    }
+
+    fseek(src, 0, SEEK_END);
+    size = ftell(src);
+    if (offset > size)
+        offset = 0;
+    fseek(src, offset, SEEK_SET);
+    fseek(dst, offset, SEEK_SET);
+
+    start = BleFtpStandIn_Now();
+    while ((len = fread(packet, 1, config.packetSize, src)) > 0)
+    {
+        if ((config.disconnectAfterBytes > 0) && (sent + len > config.disconnectAfterBytes))
+        {
+            pthread_mutex_lock(&bleFtpStandIn.lock);
+            bleFtpStandIn.counters.disconnects++;
+            pthread_mutex_unlock(&bleFtpStandIn.lock);
+            error = ARUTILS_ERROR_FTP_CONNECT;
+            break;
+        }
+
+        /* the link is busy sending the previous packets */
+        ahead = (config.bandwidth > 0) ? start + (sent + len) / config.bandwidth - BleFtpStandIn_Now() : 0;
+        if (ahead > 0)
+            usleep((useconds_t)(ahead * 1e6));
+
+        fwrite(packet, 1, len, dst);
+        fflush(dst);
+        sent += len;
+
+        pthread_mutex_lock(&bleFtpStandIn.lock);
+        bleFtpStandIn.counters.bytesSent += len;
+        error = bleFtpStandIn.isCanceled ? ARUTILS_ERROR_FTP_CANCELED : ARUTILS_OK;
+        pthread_mutex_unlock(&bleFtpStandIn.lock);
+        if (error != ARUTILS_OK)
+            break;
+
+        if (progressCallback != NULL)
+            progressCallback(progressArg, (float)(100.0 * (offset + sent) / size));
+    }
+
+out:
+    if (error != ARUTILS_OK)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, BLE_FTP_STAND_IN_TAG, "upload stopped at %llu bytes: %d", (unsigned long long)(offset + sent), error);
+    if (src != NULL)
+        fclose(src);
+    if (dst != NULL)
+        fclose(dst);
+    free(packet);
+    return error;
+}
+
+eARUTILS_ERROR ARUTILS_Manager_Ftp_Size(ARUTILS_Manager_t *manager, const char *namePath, double *fileSize)
+{
+    eARUTILS_ERROR error = ARUTILS_OK;
+    struct stat statbuf;
+
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    if (!bleFtpStandIn.config.answersSize)
+        error = ARUTILS_ERROR_FTP_SIZE;
+    else if (stat(bleFtpStandIn.path, &statbuf) != 0)
+        error = ARUTILS_ERROR_FTP_FILE;
+    else
+        *fileSize = (double)statbuf.st_size;
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+
+    return error;
+}
+
+eARUTILS_ERROR ARUTILS_Manager_Ftp_Delete(ARUTILS_Manager_t *manager, const char *namePath)
+{
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    unlink(bleFtpStandIn.path);
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+
+    return ARUTILS_OK;
+}
+
+eARUTILS_ERROR ARUTILS_Manager_Ftp_Connection_Cancel(ARUTILS_Manager_t *manager)
+{
+    pthread_mutex_lock(&bleFtpStandIn.lock);
+    bleFtpStandIn.isCanceled = 1;
+    pthread_mutex_unlock(&bleFtpStandIn.lock);
+
+    return ARUTILS_OK;
+}
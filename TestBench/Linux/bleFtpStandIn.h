@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file bleFtpStandIn.h
+ * @brief libARUpdater TestBench in-process device side of the BLE ftp
+ * @details Provides the ARUtils ftp functions the Delos upload ends up calling
+ * (ARUTILS_Manager_Ftp_Put, ARUTILS_Manager_Ftp_Size, ARUTILS_Manager_Ftp_Delete and
+ * ARUTILS_Manager_Ftp_Connection_Cancel); linked in the executable, they are used instead of
+ * the ARUtils ones whatever the ftp manager given. The plf is written in a folder at the
+ * pace of a BLE link, and the connection can drop after a number of bytes.
+ */
+
+#ifndef _BLE_FTP_STAND_IN_H_
+#define _BLE_FTP_STAND_IN_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    double bandwidth;               /**< host to device bytes/s, 0 for unlimited */
+    int packetSize;                 /**< bytes written at once */
+    uint64_t disconnectAfterBytes;  /**< each connection drops after this much, 0 for never */
+    int answersSize;                /**< the device gives the size it received */
+} BleFtpStandIn_Config_t;
+
+typedef struct
+{
+    uint64_t bytesSent;             /**< bytes over the link, all connections */
+    uint64_t bytesReceived;         /**< size of the plf on the device */
+    uint32_t connections;           /**< uploads started */
+    uint32_t disconnects;
+    uint64_t resumedAt;             /**< offset of the last resumed upload */
+} BleFtpStandIn_Counters_t;
+
+/**
+ * @brief Set up the device, there is one per executable
+ * @param[in] folder : folder where the received plf is written
+ * @param[in] config : link and device settings
+ * @return 0 if operation went well, -1 otherwise
+ */
+int BleFtpStandIn_Init(const char *folder, const BleFtpStandIn_Config_t *config);
+
+/**
+ * @brief Remove the received plf and clear the counters
+ */
+void BleFtpStandIn_Reset(void);
+
+/**
+ * @brief Get the counters since the last reset
+ */
+void BleFtpStandIn_GetCounters(BleFtpStandIn_Counters_t *counters);
+
+/**
+ * @brief Path of the plf received by the device
+ */
+const char *BleFtpStandIn_GetPath(void);
+
+#endif /* _BLE_FTP_STAND_IN_H_ */
@@ -0,0 +1,401 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file bleLinkStandIn.c
+ * @brief libARUpdater TestBench in-process BLE link and device side of the BLE upload
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL_Print.h>
+
+#include "ARUPDATER_BleUpload.h"
+#include "bleLinkStandIn.h"
+
+#define BLE_LINK_STAND_IN_TAG       "BleLinkStandIn"
+#define BLE_LINK_STAND_IN_QUEUE_MAX 1024
+#define BLE_LINK_STAND_IN_NOTIF_MAX 8
+
+typedef struct
+{
+    uint8_t data[BLE_LINK_STAND_IN_NOTIF_MAX];
+    size_t len;
+} BleLinkStandIn_Notification_t;
+
+static struct
+{
+    pthread_mutex_t lock;
+    BleLinkStandIn_Config_t config;
+    BleLinkStandIn_Counters_t counters;
+    ARSAL_MD5_Manager_t *md5Manager;
+    char path[512];
+
+    /* link */
+    ARUPDATER_Manager_t *manager;
+    pthread_t thread;
+    int isConnected;
+    int stop;
+    uint8_t *queue;
+    size_t *queueLen;
+    int head;
+    int count;
+    uint64_t connectionBytes;
+    unsigned int seed;
+
+    /* device */
+    int fd;
+    uint64_t size;
+    uint8_t id[8];
+    uint64_t received;
+    int window;
+    int packetsSinceAck;
+    int gapNacked;
+    int duplicateAcked;
+} bleLinkStandIn = { PTHREAD_MUTEX_INITIALIZER };
+
+static void BleLinkStandIn_Put32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t BleLinkStandIn_Get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void BleLinkStandIn_Answer(BleLinkStandIn_Notification_t *notif, uint8_t type, uint32_t offset)
+{
+    notif->data[0] = type;
+    BleLinkStandIn_Put32(&notif->data[1], offset);
+    notif->len = ARUPDATER_BLE_UPLOAD_ACK_SIZE;
+    if (type == ARUPDATER_BLE_UPLOAD_TYPE_ACK)
+        bleLinkStandIn.counters.acks++;
+    else
+        bleLinkStandIn.counters.nacks++;
+}
+
+static int BleLinkStandIn_CheckMd5(const uint8_t *md5)
+{
+    uint8_t received[ARSAL_MD5_LENGTH];
+
+    if ((bleLinkStandIn.received != bleLinkStandIn.size) ||
+        (ARSAL_MD5_Manager_Compute(bleLinkStandIn.md5Manager, bleLinkStandIn.path, received, sizeof(received)) != ARSAL_OK))
+        return 0;
+
+    return memcmp(received, md5, sizeof(received)) == 0;
+}
+
+/* the device handles a packet, returns 1 if it answers with a notification */
+static int BleLinkStandIn_Device(const uint8_t *packet, size_t len, BleLinkStandIn_Notification_t *notif)
+{
+    uint64_t offset;
+    uint64_t size;
+    size_t dataLen;
+
+    switch (packet[0])
+    {
+    case ARUPDATER_BLE_UPLOAD_TYPE_START:
+        if (len < ARUPDATER_BLE_UPLOAD_START_SIZE)
+            return 0;
+        size = BleLinkStandIn_Get32(&packet[2]);
+        /* the bytes of an interrupted upload of the same plf are kept */
+        if ((bleLinkStandIn.fd < 0) || (size != bleLinkStandIn.size) || (memcmp(&packet[6], bleLinkStandIn.id, sizeof(bleLinkStandIn.id)) != 0))
+        {
+            if (bleLinkStandIn.fd >= 0)
+                close(bleLinkStandIn.fd);
+            bleLinkStandIn.fd = open(bleLinkStandIn.path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            bleLinkStandIn.size = size;
+            memcpy(bleLinkStandIn.id, &packet[6], sizeof(bleLinkStandIn.id));
+            bleLinkStandIn.received = 0;
+        }
+        bleLinkStandIn.window = packet[1];
+        bleLinkStandIn.packetsSinceAck = 0;
+        bleLinkStandIn.gapNacked = 0;
+        bleLinkStandIn.duplicateAcked = 0;
+        bleLinkStandIn.counters.resumedAt = bleLinkStandIn.received;
+        BleLinkStandIn_Answer(notif, ARUPDATER_BLE_UPLOAD_TYPE_ACK, bleLinkStandIn.received);
+        return 1;
+
+    case ARUPDATER_BLE_UPLOAD_TYPE_DATA:
+        if ((len <= ARUPDATER_BLE_UPLOAD_DATA_HEADER) || (bleLinkStandIn.fd < 0))
+            return 0;
+        offset = BleLinkStandIn_Get32(&packet[1]);
+        dataLen = len - ARUPDATER_BLE_UPLOAD_DATA_HEADER;
+        if (offset == bleLinkStandIn.received)
+        {
+            if (pwrite(bleLinkStandIn.fd, &packet[ARUPDATER_BLE_UPLOAD_DATA_HEADER], dataLen, offset) != (ssize_t)dataLen)
+                return 0;
+            bleLinkStandIn.received += dataLen;
+            bleLinkStandIn.gapNacked = 0;
+            bleLinkStandIn.duplicateAcked = 0;
+            /* acks every half window, and at the end of the plf */
+            if ((++bleLinkStandIn.packetsSinceAck >= (bleLinkStandIn.window + 1) / 2) ||
+                (bleLinkStandIn.received == bleLinkStandIn.size))
+            {
+                bleLinkStandIn.packetsSinceAck = 0;
+                BleLinkStandIn_Answer(notif, ARUPDATER_BLE_UPLOAD_TYPE_ACK, bleLinkStandIn.received);
+                return 1;
+            }
+        }
+        else if ((offset > bleLinkStandIn.received) && !bleLinkStandIn.gapNacked)
+        {
+            /* a packet was lost, once per gap */
+            bleLinkStandIn.gapNacked = 1;
+            BleLinkStandIn_Answer(notif, ARUPDATER_BLE_UPLOAD_TYPE_NACK, bleLinkStandIn.received);
+            return 1;
+        }
+        else if ((offset < bleLinkStandIn.received) && !bleLinkStandIn.duplicateAcked)
+        {
+            /* sent again after a lost ack */
+            bleLinkStandIn.duplicateAcked = 1;
+            BleLinkStandIn_Answer(notif, ARUPDATER_BLE_UPLOAD_TYPE_ACK, bleLinkStandIn.received);
+            return 1;
+        }
+        return 0;
+
+    case ARUPDATER_BLE_UPLOAD_TYPE_END:
+        if (len < ARUPDATER_BLE_UPLOAD_END_SIZE)
+            return 0;
+        notif->data[0] = ARUPDATER_BLE_UPLOAD_TYPE_STATUS;
+        notif->data[1] = BleLinkStandIn_CheckMd5(&packet[1]) ? ARUPDATER_BLE_UPLOAD_STATUS_OK : ARUPDATER_BLE_UPLOAD_STATUS_MD5;
+        notif->len = ARUPDATER_BLE_UPLOAD_STATUS_SIZE;
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/* one connection event every interval: a few queued packets reach the device, it answers */
+static void *BleLinkStandIn_Run(void *arg)
+{
+    BleLinkStandIn_Notification_t notifs[BLE_LINK_STAND_IN_QUEUE_MAX];
+    ARUPDATER_Manager_t *manager = NULL;
+    struct timespec next;
+    size_t packetSize;
+    const uint8_t *packet;
+    size_t len;
+    int stop = 0;
+    int count, i;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!stop)
+    {
+        next.tv_nsec += (long)(bleLinkStandIn.config.intervalMs * 1e6);
+        while (next.tv_nsec >= 1000000000)
+        {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        count = 0;
+        pthread_mutex_lock(&bleLinkStandIn.lock);
+        packetSize = bleLinkStandIn.config.mtu - ARUPDATER_BLE_UPLOAD_ATT_HEADER;
+        for (i = 0; (i < bleLinkStandIn.config.packetsPerInterval) && (bleLinkStandIn.count > 0) && bleLinkStandIn.isConnected; i++)
+        {
+            packet = &bleLinkStandIn.queue[bleLinkStandIn.head * packetSize];
+            len = bleLinkStandIn.queueLen[bleLinkStandIn.head];
+            bleLinkStandIn.head = (bleLinkStandIn.head + 1) % bleLinkStandIn.config.queueSize;
+            bleLinkStandIn.count--;
+            bleLinkStandIn.counters.packets++;
+
+            if (packet[0] == ARUPDATER_BLE_UPLOAD_TYPE_DATA)
+            {
+                bleLinkStandIn.counters.bytesSent += len - ARUPDATER_BLE_UPLOAD_DATA_HEADER;
+                bleLinkStandIn.connectionBytes += len - ARUPDATER_BLE_UPLOAD_DATA_HEADER;
+                if ((bleLinkStandIn.config.disconnectAfterBytes > 0) &&
+                    (bleLinkStandIn.connectionBytes > bleLinkStandIn.config.disconnectAfterBytes))
+                {
+                    bleLinkStandIn.isConnected = 0;
+                    bleLinkStandIn.counters.disconnects++;
+                    break;
+                }
+                if (rand_r(&bleLinkStandIn.seed) < RAND_MAX / 100.0 * bleLinkStandIn.config.lossPercent)
+                {
+                    bleLinkStandIn.counters.packetsLost++;
+                    continue;
+                }
+            }
+
+            if (BleLinkStandIn_Device(packet, len, &notifs[count]))
+                count++;
+        }
+        manager = bleLinkStandIn.manager;
+        stop = bleLinkStandIn.stop || !bleLinkStandIn.isConnected;
+        pthread_mutex_unlock(&bleLinkStandIn.lock);
+
+        /* notifications of the event, outside of the link lock */
+        for (i = 0; i < count; i++)
+            ARUPDATER_Uploader_BleReceive(manager, notifs[i].data, notifs[i].len);
+    }
+
+    return NULL;
+}
+
+int BleLinkStandIn_Init(const char *folder, const BleLinkStandIn_Config_t *config, ARSAL_MD5_Manager_t *md5Manager)
+{
+    if ((folder == NULL) || (config == NULL) || (md5Manager == NULL) ||
+        (config->mtu < ARUPDATER_BLE_UPLOAD_MTU_MIN) || (config->mtu > ARUPDATER_BLE_UPLOAD_MTU_MAX) ||
+        (config->intervalMs <= 0) || (config->packetsPerInterval <= 0) || (config->packetsPerInterval > BLE_LINK_STAND_IN_QUEUE_MAX) ||
+        (config->queueSize <= 0) || (config->queueSize > BLE_LINK_STAND_IN_QUEUE_MAX))
+        return -1;
+
+    BleLinkStandIn_Disconnect();
+
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    if (bleLinkStandIn.queue == NULL)
+        bleLinkStandIn.fd = -1;
+    free(bleLinkStandIn.queue);
+    free(bleLinkStandIn.queueLen);
+    bleLinkStandIn.queue = malloc(config->queueSize * (config->mtu - ARUPDATER_BLE_UPLOAD_ATT_HEADER));
+    bleLinkStandIn.queueLen = malloc(config->queueSize * sizeof(size_t));
+    bleLinkStandIn.config = *config;
+    bleLinkStandIn.md5Manager = md5Manager;
+    bleLinkStandIn.seed = 1;
+    snprintf(bleLinkStandIn.path, sizeof(bleLinkStandIn.path), "%s/ble.plf", folder);
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+
+    if ((bleLinkStandIn.queue == NULL) || (bleLinkStandIn.queueLen == NULL))
+        return -1;
+
+    BleLinkStandIn_Reset();
+    return 0;
+}
+
+int BleLinkStandIn_Connect(ARUPDATER_Manager_t *manager)
+{
+    int ret;
+
+    BleLinkStandIn_Disconnect();
+
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    bleLinkStandIn.isConnected = 1;
+    bleLinkStandIn.stop = 0;
+    bleLinkStandIn.head = 0;
+    bleLinkStandIn.count = 0;
+    bleLinkStandIn.connectionBytes = 0;
+    bleLinkStandIn.counters.connections++;
+    ret = pthread_create(&bleLinkStandIn.thread, NULL, BleLinkStandIn_Run, NULL);
+    if (ret == 0)
+        bleLinkStandIn.manager = manager;
+    else
+        bleLinkStandIn.isConnected = 0;
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+
+    return (ret == 0) ? 0 : -1;
+}
+
+void BleLinkStandIn_Disconnect(void)
+{
+    int join;
+
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    join = (bleLinkStandIn.manager != NULL);
+    bleLinkStandIn.stop = 1;
+    bleLinkStandIn.isConnected = 0;
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+
+    if (join)
+        pthread_join(bleLinkStandIn.thread, NULL);
+
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    bleLinkStandIn.manager = NULL;
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+}
+
+int BleLinkStandIn_Write(void *arg, const uint8_t *packet, size_t len)
+{
+    size_t packetSize;
+    int tail;
+    int ret = 0;
+
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    packetSize = bleLinkStandIn.config.mtu - ARUPDATER_BLE_UPLOAD_ATT_HEADER;
+    if (!bleLinkStandIn.isConnected)
+    {
+        ret = -ENOTCONN;
+    }
+    else if ((len == 0) || (len > packetSize))
+    {
+        ret = -EINVAL;
+    }
+    else if (bleLinkStandIn.count == bleLinkStandIn.config.queueSize)
+    {
+        ret = -EAGAIN;
+    }
+    else
+    {
+        tail = (bleLinkStandIn.head + bleLinkStandIn.count) % bleLinkStandIn.config.queueSize;
+        memcpy(&bleLinkStandIn.queue[tail * packetSize], packet, len);
+        bleLinkStandIn.queueLen[tail] = len;
+        bleLinkStandIn.count++;
+    }
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+
+    return ret;
+}
+
+void BleLinkStandIn_Reset(void)
+{
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    if (bleLinkStandIn.fd >= 0)
+        close(bleLinkStandIn.fd);
+    bleLinkStandIn.fd = -1;
+    bleLinkStandIn.size = 0;
+    bleLinkStandIn.received = 0;
+    unlink(bleLinkStandIn.path);
+    memset(&bleLinkStandIn.counters, 0, sizeof(bleLinkStandIn.counters));
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+}
+
+void BleLinkStandIn_GetCounters(BleLinkStandIn_Counters_t *counters)
+{
+    pthread_mutex_lock(&bleLinkStandIn.lock);
+    *counters = bleLinkStandIn.counters;
+    counters->bytesReceived = bleLinkStandIn.received;
+    pthread_mutex_unlock(&bleLinkStandIn.lock);
+}
+
+const char *BleLinkStandIn_GetPath(void)
+{
+    return bleLinkStandIn.path;
+}
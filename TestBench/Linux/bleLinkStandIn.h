@@ -0,0 +1,111 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file bleLinkStandIn.h
+ * @brief libARUpdater TestBench in-process BLE link and device side of the BLE upload
+ * @details Packets written without response are queued by the link and delivered to the
+ * device a few per connection event, as a BLE controller does; the device answers the
+ * ARUPDATER_BleUpload protocol by notifications given to ARUPDATER_Uploader_BleReceive() at
+ * the end of the event. Packets can be lost, and the link can drop after a number of bytes.
+ */
+
+#ifndef _BLE_LINK_STAND_IN_H_
+#define _BLE_LINK_STAND_IN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libARSAL/ARSAL_MD5_Manager.h>
+#include <libARUpdater/ARUpdater.h>
+
+typedef struct
+{
+    int mtu;                        /**< ATT MTU, packets are at most mtu - 3 bytes */
+    double intervalMs;              /**< connection interval */
+    int packetsPerInterval;         /**< packets delivered per connection event */
+    int queueSize;                  /**< packets queued by the link before writes get -EAGAIN */
+    double lossPercent;             /**< data packets lost */
+    uint64_t disconnectAfterBytes;  /**< each connection drops after this much data, 0 for never */
+} BleLinkStandIn_Config_t;
+
+typedef struct
+{
+    uint64_t packets;               /**< packets delivered, lost ones included */
+    uint64_t packetsLost;
+    uint64_t bytesSent;             /**< data bytes over the link, retransmissions included */
+    uint64_t bytesReceived;         /**< size of the plf received in order by the device */
+    uint32_t acks;
+    uint32_t nacks;
+    uint32_t connections;
+    uint32_t disconnects;
+    uint64_t resumedAt;             /**< offset answered to the last START */
+} BleLinkStandIn_Counters_t;
+
+/**
+ * @brief Set up the link and the device, there is one per executable
+ * @param[in] folder : folder where the received plf is written
+ * @param[in] config : link and device settings
+ * @param[in] md5Manager : md5 manager of the device, to check the plf at the end of the upload
+ * @return 0 if operation went well, -1 otherwise
+ */
+int BleLinkStandIn_Init(const char *folder, const BleLinkStandIn_Config_t *config, ARSAL_MD5_Manager_t *md5Manager);
+
+/**
+ * @brief Connect the link, the notifications are given to the uploader of manager
+ * @return 0 if operation went well, -1 otherwise
+ */
+int BleLinkStandIn_Connect(ARUPDATER_Manager_t *manager);
+
+/**
+ * @brief Disconnect the link, the device keeps what it received
+ */
+void BleLinkStandIn_Disconnect(void);
+
+/**
+ * @brief Write without response, an ARUPDATER_Uploader_BleWriteCallback_t
+ */
+int BleLinkStandIn_Write(void *arg, const uint8_t *packet, size_t len);
+
+/**
+ * @brief Remove the received plf and clear the counters
+ */
+void BleLinkStandIn_Reset(void);
+
+/**
+ * @brief Get the counters since the last reset
+ */
+void BleLinkStandIn_GetCounters(BleLinkStandIn_Counters_t *counters);
+
+/**
+ * @brief Path of the plf received by the device
+ */
+const char *BleLinkStandIn_GetPath(void);
+
+#endif /* _BLE_LINK_STAND_IN_H_ */
@@ -0,0 +1,334 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file bleUploadBench.c
+ * @brief libARUpdater TestBench BLE upload of a minidrone plf over a simulated link
+ * @details Uploads the same plf over a simulated BLE link of a few packets per connection
+ * event: first through the Delos path, with bleFtpStandIn paced as its writes with response
+ * of 20 bytes, one per connection event; then with ARUPDATER_Uploader_SetBleLink() and
+ * bleLinkStandIn as the link and the device, stop-and-wait and pipelined, at the minimum and
+ * at a larger MTU, with packets lost, and over a link that drops, resumed. Reports the time,
+ * the rate, the packets and the retransmissions, and checks the plf received.
+ * usage: tst-arupdater-ble-upload-bench [-s sizeKiB] [-i intervalMs] [-p packetsPerInterval]
+ *        [-m mtu] [-l lossPercent]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUtils/ARUtils.h>
+#include <libARUpdater/ARUpdater.h>
+
+#include "ARUPDATER_Plf.h"
+#include "ARUPDATER_BleUpload.h"
+#include "bleFtpStandIn.h"
+#include "bleLinkStandIn.h"
+
+#define BLE_BENCH_TAG           "BleUploadBench"
+#define BLE_BENCH_PRODUCT       ARDISCOVERY_PRODUCT_MINIDRONE
+/* payload of an ATT write at the minimum MTU */
+#define BLE_BENCH_LEGACY_PACKET (ARUPDATER_BLE_UPLOAD_MTU_MIN - ARUPDATER_BLE_UPLOAD_ATT_HEADER)
+#define BLE_BENCH_QUEUE_SIZE    64
+#define BLE_BENCH_MAX_ATTEMPTS  4
+
+static char plfPath[512];
+static char rootFolder[] = "/tmp/arupdater-ble-bench-local-XXXXXX";
+static ARSAL_MD5_Manager_t *md5Manager = NULL;
+static ARUTILS_Manager_t *ftpManager = NULL;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the single section of a bench plf, its data follows up to the end of the file */
+static void writeSection(FILE *f, size_t size)
+{
+    uint32_t words[ARUPDATER_PLF_SECTION_HEADER_SIZE / 4] = { 1, (uint32_t)size, 0, 0, 0 };
+    size_t i;
+
+    for (i = 0; i < ARUPDATER_PLF_SECTION_HEADER_SIZE; i++)
+        fputc((words[i / 4] >> (8 * (i % 4))) & 0xff, f);
+}
+
+/* a plf with a production header, its version is read by the uploader */
+static int createPlf(size_t size)
+{
+    plf_phdr_t header;
+    size_t i;
+    FILE *f;
+
+    snprintf(plfPath, sizeof(plfPath), "%s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+    mkdir(plfPath, 0755);
+    snprintf(plfPath, sizeof(plfPath), "%s/%s%04x", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(BLE_BENCH_PRODUCT));
+    mkdir(plfPath, 0755);
+    snprintf(plfPath, sizeof(plfPath), "%s/%s%04x/bench.plf", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(BLE_BENCH_PRODUCT));
+
+    f = fopen(plfPath, "wb");
+    if ((f == NULL) || (size < sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE))
+    {
+        if (f != NULL)
+            fclose(f);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = PLF_CURRENT_VERSION;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    header.p_ext = 1;
+    header.p_size = size;
+    fwrite(&header, 1, sizeof(header), f);
+    writeSection(f, size - sizeof(header) - ARUPDATER_PLF_SECTION_HEADER_SIZE);
+    for (i = sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE; i < size; i++)
+        fputc(rand() & 0xff, f);
+
+    fclose(f);
+    return 0;
+}
+
+/* 1 if the device received the whole plf */
+static int samePlf(const char *path)
+{
+    FILE *a = fopen(plfPath, "rb");
+    FILE *b = fopen(path, "rb");
+    int ca, cb, same = (a != NULL) && (b != NULL);
+
+    while (same)
+    {
+        ca = fgetc(a);
+        cb = fgetc(b);
+        same = (ca == cb);
+        if (ca == EOF)
+            break;
+    }
+
+    if (a != NULL)
+        fclose(a);
+    if (b != NULL)
+        fclose(b);
+    return same;
+}
+
+static void progressCallback(void *arg, float percent)
+{
+}
+
+static void completionCallback(void *arg, eARUPDATER_ERROR error)
+{
+}
+
+static eARUPDATER_ERROR upload(int mtu, int window)
+{
+    ARUPDATER_Manager_t *manager = NULL;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+
+    manager = ARUPDATER_Manager_New(&error);
+    if (error == ARUPDATER_OK)
+        error = ARUPDATER_Uploader_New(manager, rootFolder, NULL, ftpManager, md5Manager, 1, BLE_BENCH_PRODUCT,
+                                       progressCallback, NULL, completionCallback, NULL);
+    if ((error == ARUPDATER_OK) && (mtu > 0))
+        error = ARUPDATER_Uploader_SetBleLink(manager, mtu, window, BleLinkStandIn_Write, NULL);
+    if ((error == ARUPDATER_OK) && (mtu > 0) && (BleLinkStandIn_Connect(manager) != 0))
+        error = ARUPDATER_ERROR_SYSTEM;
+    if (error == ARUPDATER_OK)
+        error = (eARUPDATER_ERROR)(intptr_t)ARUPDATER_Uploader_ThreadRun(manager);
+    if (mtu > 0)
+        BleLinkStandIn_Disconnect();
+    ARUPDATER_Manager_Delete(&manager);
+
+    return error;
+}
+
+static void printRow(const char *mode, int mtu, int window, double loss, int attempts, double elapsed, double sizeKiB,
+                     uint64_t packets, double retransmitted, eARUPDATER_ERROR error, int received)
+{
+    printf("%-8s %4d %6d %6.1f %8d %8.2f %8.2f %8llu %8.1f %s\n", mode, mtu, window, loss, attempts, elapsed,
+           received ? sizeKiB / elapsed : 0, (unsigned long long)packets, retransmitted,
+           received ? "No error" : ((error == ARUPDATER_OK) ? "plf differs" : ARUPDATER_Error_ToString(error)));
+    fflush(stdout);
+}
+
+/* the Delos path, at the pace of writes with response of the minimum MTU */
+static int benchDelos(const char *remoteFolder, double sizeKiB, double intervalMs)
+{
+    BleFtpStandIn_Config_t config;
+    BleFtpStandIn_Counters_t counters;
+    eARUPDATER_ERROR error;
+    double start, elapsed;
+    int received;
+
+    memset(&config, 0, sizeof(config));
+    config.bandwidth = BLE_BENCH_LEGACY_PACKET * 1000.0 / intervalMs;
+    config.packetSize = BLE_BENCH_LEGACY_PACKET;
+    if (BleFtpStandIn_Init(remoteFolder, &config) != 0)
+        return 0;
+
+    start = nowSec();
+    error = upload(0, 0);
+    elapsed = nowSec() - start;
+    BleFtpStandIn_GetCounters(&counters);
+    received = (error == ARUPDATER_OK) && samePlf(BleFtpStandIn_GetPath());
+
+    printRow("delos", ARUPDATER_BLE_UPLOAD_MTU_MIN, 1, 0, 1, elapsed, sizeKiB,
+             (counters.bytesSent + BLE_BENCH_LEGACY_PACKET - 1) / BLE_BENCH_LEGACY_PACKET, 0, error, received);
+    return received;
+}
+
+static int benchBle(const char *remoteFolder, double sizeKiB, const BleLinkStandIn_Config_t *link, int window)
+{
+    BleLinkStandIn_Counters_t counters;
+    eARUPDATER_ERROR error = ARUPDATER_ERROR;
+    double start, elapsed;
+    int attempts, received;
+
+    if (BleLinkStandIn_Init(remoteFolder, link, md5Manager) != 0)
+        return 0;
+
+    start = nowSec();
+    /* the app retries once the drone is connected again */
+    for (attempts = 0; (attempts < BLE_BENCH_MAX_ATTEMPTS) && (error != ARUPDATER_OK); attempts++)
+        error = upload(link->mtu, window);
+    elapsed = nowSec() - start;
+
+    BleLinkStandIn_GetCounters(&counters);
+    received = (error == ARUPDATER_OK) && samePlf(BleLinkStandIn_GetPath());
+
+    printRow(link->disconnectAfterBytes ? "ble-drop" : "ble", link->mtu, window, link->lossPercent, attempts, elapsed, sizeKiB,
+             counters.packets, (counters.bytesSent > counters.bytesReceived) ? 100.0 * (counters.bytesSent - counters.bytesReceived) / counters.bytesSent : 0,
+             error, received);
+    return received;
+}
+
+int main(int argc, char *argv[])
+{
+    double sizeKiB = 16, intervalMs = 7.5, lossPercent = 2;
+    int packetsPerInterval = 4, mtu = 185;
+    char remoteFolder[] = "/tmp/arupdater-ble-bench-remote-XXXXXX";
+    eARSAL_ERROR arsalError = ARSAL_OK;
+    eARUTILS_ERROR ftpError = ARUTILS_OK;
+    BleLinkStandIn_Config_t link;
+    int failed = 0;
+    int opt;
+    char cmd[600];
+
+    while ((opt = getopt(argc, argv, "s:i:p:m:l:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sizeKiB = atof(optarg);
+            break;
+        case 'i':
+            intervalMs = atof(optarg);
+            break;
+        case 'p':
+            packetsPerInterval = atoi(optarg);
+            break;
+        case 'm':
+            mtu = atoi(optarg);
+            break;
+        case 'l':
+            lossPercent = atof(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s sizeKiB] [-i intervalMs] [-p packetsPerInterval] [-m mtu] [-l lossPercent]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((mkdtemp(rootFolder) == NULL) || (mkdtemp(remoteFolder) == NULL))
+        return 1;
+
+    md5Manager = ARSAL_MD5_Manager_New(&arsalError);
+    if (arsalError == ARSAL_OK)
+        arsalError = ARSAL_MD5_Manager_Init(md5Manager);
+    /* without a BLE link, the Delos path is taken for BLE ftp managers of android apps */
+    ftpManager = ARUTILS_Manager_New(&ftpError);
+    if (ftpManager != NULL)
+        ftpManager->networkType = ARDISCOVERY_NETWORK_TYPE_BLE;
+
+    if ((arsalError != ARSAL_OK) || (ftpError != ARUTILS_OK) || (createPlf((size_t)(sizeKiB * 1024)) != 0))
+    {
+        failed = 1;
+        goto out;
+    }
+
+    printf("%-8s %4s %6s %6s %8s %8s %8s %8s %8s %s\n", "mode", "mtu", "window", "loss%", "attempts", "time(s)", "KiB/s",
+           "packets", "retx%", "result");
+
+    if (!benchDelos(remoteFolder, sizeKiB, intervalMs))
+        failed = 1;
+
+    memset(&link, 0, sizeof(link));
+    link.intervalMs = intervalMs;
+    link.packetsPerInterval = packetsPerInterval;
+    link.queueSize = BLE_BENCH_QUEUE_SIZE;
+
+    /* stop-and-wait, then pipelined at the minimum MTU and at the negotiated one */
+    link.mtu = ARUPDATER_BLE_UPLOAD_MTU_MIN;
+    if (!benchBle(remoteFolder, sizeKiB, &link, 1) || !benchBle(remoteFolder, sizeKiB, &link, 16))
+        failed = 1;
+    link.mtu = mtu;
+    if (!benchBle(remoteFolder, sizeKiB, &link, 32))
+        failed = 1;
+
+    /* lost packets are sent again from the first one missing */
+    link.lossPercent = lossPercent;
+    if (!benchBle(remoteFolder, sizeKiB, &link, 32))
+        failed = 1;
+
+    /* a link dropping at 40% of the plf, the next connection resumes */
+    link.lossPercent = 0;
+    link.disconnectAfterBytes = (uint64_t)(sizeKiB * 1024 * 0.4);
+    if (!benchBle(remoteFolder, sizeKiB, &link, 32))
+        failed = 1;
+
+out:
+    BleLinkStandIn_Disconnect();
+    if (ftpManager != NULL)
+        ARUTILS_Manager_Delete(&ftpManager);
+    ARSAL_MD5_Manager_Delete(&md5Manager);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", rootFolder, remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, BLE_BENCH_TAG, "can't remove the bench folders");
+
+    return failed;
+}
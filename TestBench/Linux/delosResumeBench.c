@@ -0,0 +1,259 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file delosResumeBench.c
+ * @brief libARUpdater TestBench Delos upload over an unreliable BLE link
+ * @details Uploads a minidrone plf through the Delos path, with bleFtpStandIn as the device,
+ * over a link that drops after a part of the plf, until it succeeds or too many attempts
+ * failed; first restarting each attempt from the beginning, then with
+ * ARUPDATER_Uploader_SetDelosResume(). Reports the attempts, the bytes sent and the time, and
+ * checks the plf received.
+ * usage: tst-arupdater-delos-resume-bench [-s sizeKiB] [-b bandwidthKiBps] [-x disconnectPercent]
+ *        [-n maxAttempts]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUtils/ARUtils.h>
+#include <libARUpdater/ARUpdater.h>
+
+#include "ARUPDATER_Plf.h"
+#include "bleFtpStandIn.h"
+
+#define DELOS_BENCH_TAG         "DelosResumeBench"
+#define DELOS_BENCH_PRODUCT     ARDISCOVERY_PRODUCT_MINIDRONE
+/* payload of a BLE ftp packet */
+#define DELOS_BENCH_PACKET_SIZE 132
+
+static char plfPath[512];
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the single section of a bench plf, its data follows up to the end of the file */
+static void writeSection(FILE *f, size_t size)
+{
+    uint32_t words[ARUPDATER_PLF_SECTION_HEADER_SIZE / 4] = { 1, (uint32_t)size, 0, 0, 0 };
+    size_t i;
+
+    for (i = 0; i < ARUPDATER_PLF_SECTION_HEADER_SIZE; i++)
+        fputc((words[i / 4] >> (8 * (i % 4))) & 0xff, f);
+}
+
+/* a plf with a production header, its version is read by the uploader */
+static int createPlf(const char *rootFolder, size_t size)
+{
+    plf_phdr_t header;
+    size_t i;
+    FILE *f;
+
+    snprintf(plfPath, sizeof(plfPath), "%s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+    mkdir(plfPath, 0755);
+    snprintf(plfPath, sizeof(plfPath), "%s/%s%04x", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(DELOS_BENCH_PRODUCT));
+    mkdir(plfPath, 0755);
+    snprintf(plfPath, sizeof(plfPath), "%s/%s%04x/bench.plf", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(DELOS_BENCH_PRODUCT));
+
+    f = fopen(plfPath, "wb");
+    if ((f == NULL) || (size < sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE))
+    {
+        if (f != NULL)
+            fclose(f);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = PLF_CURRENT_VERSION;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    header.p_ext = 1;
+    header.p_size = size;
+    fwrite(&header, 1, sizeof(header), f);
+    writeSection(f, size - sizeof(header) - ARUPDATER_PLF_SECTION_HEADER_SIZE);
+    for (i = sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE; i < size; i++)
+        fputc(rand() & 0xff, f);
+
+    fclose(f);
+    return 0;
+}
+
+/* 1 if the device received the whole plf */
+static int samePlf(const char *path)
+{
+    FILE *a = fopen(plfPath, "rb");
+    FILE *b = fopen(path, "rb");
+    int ca, cb, same = (a != NULL) && (b != NULL);
+
+    while (same)
+    {
+        ca = fgetc(a);
+        cb = fgetc(b);
+        same = (ca == cb);
+        if (ca == EOF)
+            break;
+    }
+
+    if (a != NULL)
+        fclose(a);
+    if (b != NULL)
+        fclose(b);
+    return same;
+}
+
+static void progressCallback(void *arg, float percent)
+{
+}
+
+static void completionCallback(void *arg, eARUPDATER_ERROR error)
+{
+}
+
+int main(int argc, char *argv[])
+{
+    double sizeKiB = 256, bandwidthKiB = 64, disconnectPercent = 30;
+    int maxAttempts = 6;
+    char rootFolder[] = "/tmp/arupdater-delos-bench-local-XXXXXX";
+    char remoteFolder[] = "/tmp/arupdater-delos-bench-remote-XXXXXX";
+    eARSAL_ERROR arsalError = ARSAL_OK;
+    eARUTILS_ERROR ftpError = ARUTILS_OK;
+    ARSAL_MD5_Manager_t *md5Manager = NULL;
+    ARUTILS_Manager_t *ftpManager = NULL;
+    ARUPDATER_Manager_t *manager = NULL;
+    BleFtpStandIn_Config_t config;
+    BleFtpStandIn_Counters_t counters;
+    eARUPDATER_ERROR error;
+    int failed = 0;
+    int opt, resume, attempts, received;
+    double start, elapsed;
+    char cmd[600];
+
+    while ((opt = getopt(argc, argv, "s:b:x:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sizeKiB = atof(optarg);
+            break;
+        case 'b':
+            bandwidthKiB = atof(optarg);
+            break;
+        case 'x':
+            disconnectPercent = atof(optarg);
+            break;
+        case 'n':
+            maxAttempts = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s sizeKiB] [-b bandwidthKiBps] [-x disconnectPercent] [-n maxAttempts]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((mkdtemp(rootFolder) == NULL) || (mkdtemp(remoteFolder) == NULL))
+        return 1;
+
+    md5Manager = ARSAL_MD5_Manager_New(&arsalError);
+    if (arsalError == ARSAL_OK)
+        arsalError = ARSAL_MD5_Manager_Init(md5Manager);
+    /* the Delos path is taken for BLE ftp managers of android apps */
+    ftpManager = ARUTILS_Manager_New(&ftpError);
+    if (ftpManager != NULL)
+        ftpManager->networkType = ARDISCOVERY_NETWORK_TYPE_BLE;
+
+    memset(&config, 0, sizeof(config));
+    config.bandwidth = bandwidthKiB * 1024;
+    config.packetSize = DELOS_BENCH_PACKET_SIZE;
+    config.disconnectAfterBytes = (uint64_t)(sizeKiB * 1024 * disconnectPercent / 100);
+    config.answersSize = 1;
+    if ((arsalError != ARSAL_OK) || (ftpError != ARUTILS_OK) || (BleFtpStandIn_Init(remoteFolder, &config) != 0) ||
+        (createPlf(rootFolder, (size_t)(sizeKiB * 1024)) != 0))
+    {
+        failed = 1;
+        goto out;
+    }
+
+    printf("%6s %8s %10s %8s %8s %s\n", "resume", "attempts", "sent(KiB)", "time(s)", "KiB/s", "result");
+
+    for (resume = 0; resume <= 1; resume++)
+    {
+        BleFtpStandIn_Reset();
+        error = ARUPDATER_ERROR;
+        start = nowSec();
+
+        /* the app retries once the drone is connected again */
+        for (attempts = 0; (attempts < maxAttempts) && (error != ARUPDATER_OK); attempts++)
+        {
+            manager = ARUPDATER_Manager_New(&error);
+            if (error == ARUPDATER_OK)
+                error = ARUPDATER_Uploader_New(manager, rootFolder, NULL, ftpManager, md5Manager, 1, DELOS_BENCH_PRODUCT,
+                                               progressCallback, NULL, completionCallback, NULL);
+            if (error == ARUPDATER_OK)
+                error = ARUPDATER_Uploader_SetDelosResume(manager, resume);
+            if (error == ARUPDATER_OK)
+                error = (eARUPDATER_ERROR)(intptr_t)ARUPDATER_Uploader_ThreadRun(manager);
+            ARUPDATER_Manager_Delete(&manager);
+        }
+
+        elapsed = nowSec() - start;
+        BleFtpStandIn_GetCounters(&counters);
+        received = (error == ARUPDATER_OK) && samePlf(BleFtpStandIn_GetPath());
+
+        printf("%6d %8d %10.1f %8.2f %8.2f %s\n", resume, attempts, counters.bytesSent / 1024.0, elapsed,
+               received ? sizeKiB / elapsed : 0,
+               received ? "No error" : ((error == ARUPDATER_OK) ? "plf differs" : ARUPDATER_Error_ToString(error)));
+        fflush(stdout);
+
+        /* without resume, a link that drops before the end never completes an upload */
+        if (!received && (resume || (disconnectPercent >= 100)))
+            failed = 1;
+    }
+
+out:
+    if (ftpManager != NULL)
+        ARUTILS_Manager_Delete(&ftpManager);
+    ARSAL_MD5_Manager_Delete(&md5Manager);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", rootFolder, remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, DELOS_BENCH_TAG, "can't remove the bench folders");
+
+    return failed;
+}
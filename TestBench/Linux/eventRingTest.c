@@ -0,0 +1,256 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file eventRingTest.c
+ * @brief libARUpdater TestBench checks of the mux status event ring
+ * @details Checks a status pushed into a full ring, the wakeup left when a pop doesn't
+ * take every event, and then streams events from a producer thread to a consumer
+ * sleeping on the wakeup: a lost wakeup shows as a poll timeout. Build it with
+ * -fsanitize=thread to also check the ordering of the ring.
+ * usage: tst-arupdater-event-ring [events]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <libARSAL/ARSAL.h>
+
+#include "ARUPDATER_EventRing.h"
+
+#define EVENT_RING_TEST_TAG             "EventRingTest"
+#define EVENT_RING_TEST_EVENTS          2000000
+#define EVENT_RING_TEST_POP_MAX         5
+#define EVENT_RING_TEST_TIMEOUT_MS      5000
+
+typedef struct
+{
+    ARUPDATER_EventRing_t ring;
+    unsigned int eventCount;
+    unsigned int retries;               /* progress events pushed again after a drop */
+    int isStopped;                      /* set by the consumer when it gives up */
+} EventRingTest_t;
+
+static int isReadable(ARUPDATER_EventRing_t *ring, int timeoutMs)
+{
+    struct pollfd fds[1];
+
+    fds[0].fd = ARUPDATER_EventRing_GetFd(ring);
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    return (poll(fds, 1, timeoutMs) == 1) && (fds[0].revents & POLLIN);
+}
+
+static void pushProgress(ARUPDATER_EventRing_t *ring, uint64_t bytes, int *ret)
+{
+    ARUPDATER_Event_t event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = ARUPDATER_EVENT_PROGRESS;
+    event.bytesAcked = bytes;
+    *ret = ARUPDATER_EventRing_Push(ring, &event);
+}
+
+static int pushStatus(ARUPDATER_EventRing_t *ring, eARUPDATER_ERROR status)
+{
+    ARUPDATER_Event_t event;
+
+    memset(&event, 0, sizeof(event));
+    event.type = ARUPDATER_EVENT_STATUS;
+    event.status = status;
+    return ARUPDATER_EventRing_Push(ring, &event);
+}
+
+/* a status pushed into a full ring comes after the events before it, and keeps the wakeup */
+static int testFullRing(void)
+{
+    ARUPDATER_EventRing_t ring;
+    ARUPDATER_Event_t events[ARUPDATER_EVENTRING_SIZE];
+    int ret, count, i;
+    int ok = (ARUPDATER_EventRing_Init(&ring) == 0);
+
+    for (i = 0; ok && (i < ARUPDATER_EVENTRING_SIZE); i++)
+    {
+        pushProgress(&ring, i, &ret);
+        ok = (ret == 0);
+    }
+
+    pushProgress(&ring, ARUPDATER_EVENTRING_SIZE, &ret);
+    ok = ok && (ret == -ENOBUFS) && (ring.dropped == 1);
+    ok = ok && (pushStatus(&ring, ARUPDATER_ERROR_UPLOADER) == 0) && (ring.overflowStatus != 0);
+    /* a second status doesn't replace the first one */
+    ok = ok && (pushStatus(&ring, ARUPDATER_OK) == 0);
+
+    /* the ring fills the pop: the status is left for the next one, which must be woken */
+    count = ok ? ARUPDATER_EventRing_Pop(&ring, events, ARUPDATER_EVENTRING_SIZE) : 0;
+    ok = ok && (count == ARUPDATER_EVENTRING_SIZE) && (events[count - 1].type == ARUPDATER_EVENT_PROGRESS) &&
+         (events[count - 1].bytesAcked == ARUPDATER_EVENTRING_SIZE - 1);
+    ok = ok && isReadable(&ring, 0);
+
+    count = ok ? ARUPDATER_EventRing_Pop(&ring, events, ARUPDATER_EVENTRING_SIZE) : 0;
+    ok = ok && (count == 1) && (events[0].type == ARUPDATER_EVENT_STATUS) && (events[0].status == ARUPDATER_ERROR_UPLOADER);
+    ok = ok && !isReadable(&ring, 0) && (ARUPDATER_EventRing_Pop(&ring, events, ARUPDATER_EVENTRING_SIZE) == 0);
+
+    ARUPDATER_EventRing_Destroy(&ring);
+    fprintf(stderr, "status in a full ring: %s\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+/* the wakeup is signaled again as long as a pop leaves events */
+static int testPartialPop(void)
+{
+    ARUPDATER_EventRing_t ring;
+    ARUPDATER_Event_t events[EVENT_RING_TEST_POP_MAX];
+    int ret, count, i;
+    uint64_t expected = 0;
+    int ok = (ARUPDATER_EventRing_Init(&ring) == 0);
+
+    for (i = 0; ok && (i < 3 * EVENT_RING_TEST_POP_MAX + 1); i++)
+    {
+        pushProgress(&ring, i, &ret);
+        ok = (ret == 0);
+    }
+
+    while (ok && isReadable(&ring, 0))
+    {
+        count = ARUPDATER_EventRing_Pop(&ring, events, EVENT_RING_TEST_POP_MAX);
+        for (i = 0; i < count; i++)
+        {
+            ok = ok && (events[i].bytesAcked == expected++);
+        }
+    }
+    ok = ok && (expected == 3 * EVENT_RING_TEST_POP_MAX + 1);
+
+    ARUPDATER_EventRing_Destroy(&ring);
+    fprintf(stderr, "partial pops: %s\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+static void *producerRun(void *arg)
+{
+    EventRingTest_t *test = arg;
+    unsigned int i;
+    int ret;
+
+    /* a dropped event is pushed again, so that the consumer gets them all */
+    for (i = 1; i <= test->eventCount; i++)
+    {
+        pushProgress(&test->ring, i, &ret);
+        while ((ret == -ENOBUFS) && !__atomic_load_n(&test->isStopped, __ATOMIC_RELAXED))
+        {
+            test->retries++;
+            sched_yield();
+            pushProgress(&test->ring, i, &ret);
+        }
+    }
+    pushStatus(&test->ring, ARUPDATER_OK);
+
+    return NULL;
+}
+
+/* a consumer that only pops when woken must see every event, in order, then the status */
+static int testStream(unsigned int eventCount)
+{
+    EventRingTest_t test;
+    ARSAL_Thread_t producer = NULL;
+    ARUPDATER_Event_t events[EVENT_RING_TEST_POP_MAX];
+    uint64_t last = 0;
+    unsigned int received = 0;
+    int hasStatus = 0;
+    int count, i;
+    int ok = 1;
+
+    memset(&test, 0, sizeof(test));
+    test.eventCount = eventCount;
+    if ((ARUPDATER_EventRing_Init(&test.ring) != 0) || (ARSAL_Thread_Create(&producer, producerRun, &test) != 0))
+    {
+        return 0;
+    }
+
+    while (ok && !hasStatus)
+    {
+        if (!isReadable(&test.ring, EVENT_RING_TEST_TIMEOUT_MS))
+        {
+            fprintf(stderr, "no wakeup after %u events\n", received);
+            ok = 0;
+            break;
+        }
+
+        count = ARUPDATER_EventRing_Pop(&test.ring, events, EVENT_RING_TEST_POP_MAX);
+        for (i = 0; ok && (i < count); i++)
+        {
+            if (hasStatus)
+            {
+                ok = 0;
+            }
+            else if (events[i].type == ARUPDATER_EVENT_STATUS)
+            {
+                hasStatus = 1;
+                ok = (events[i].status == ARUPDATER_OK);
+            }
+            else
+            {
+                ok = (events[i].bytesAcked == last + 1);
+                last = events[i].bytesAcked;
+                received++;
+            }
+        }
+    }
+
+    __atomic_store_n(&test.isStopped, 1, __ATOMIC_RELAXED);
+    ARSAL_Thread_Join(producer, NULL);
+    ARSAL_Thread_Destroy(&producer);
+
+    ok = ok && (received == eventCount);
+    fprintf(stderr, "stream of %u events: %s (%u received, %u pushed again)\n", eventCount, ok ? "PASS" : "FAIL", received, test.retries);
+
+    ARUPDATER_EventRing_Destroy(&test.ring);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int eventCount = EVENT_RING_TEST_EVENTS;
+    int failures = 0;
+
+    if (argc > 1)
+    {
+        eventCount = (unsigned int)strtoul(argv[1], NULL, 10);
+    }
+
+    failures += !testFullRing();
+    failures += !testPartialPop();
+    failures += !testStream(eventCount);
+
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,474 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ftpStandIn.c
+ * @brief libARUpdater TestBench minimal local ftp server
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <math.h>
+#include <libARSAL/ARSAL_Print.h>
+
+#include "ftpStandIn.h"
+
+#define FTP_STAND_IN_TAG            "FtpStandIn"
+#define FTP_STAND_IN_LINE_SIZE      1024
+#define FTP_STAND_IN_BUFFER_SIZE    (64*1024)
+#define FTP_STAND_IN_SEGMENT_SIZE   1448
+
+struct FtpStandIn_t
+{
+    char rootFolder[512];
+    int refuseRest;
+    int rttMs;
+    double lossPercent;
+    int listenFd;
+    int port;
+    int isStopped;
+    pthread_t thread;
+};
+
+typedef struct
+{
+    FtpStandIn_t *server;
+    int fd;
+    int pasvFd;
+    unsigned long long rest;
+    char cwd[FTP_STAND_IN_LINE_SIZE];
+    char renameFrom[FTP_STAND_IN_LINE_SIZE];
+    int rttMs;
+    double windowLoss;          /* probability of a lost segment in a window */
+    unsigned int seed;
+} FtpStandIn_Session_t;
+
+static void FtpStandIn_Delay(FtpStandIn_Session_t *session, int roundTrips)
+{
+    if ((session->rttMs > 0) && (roundTrips > 0))
+        usleep(roundTrips * session->rttMs * 1000);
+}
+
+static int FtpStandIn_Listen(int *port)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return -1;
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen(fd, 16) < 0) ||
+        (getsockname(fd, (struct sockaddr *)&addr, &len) < 0))
+    {
+        close(fd);
+        return -1;
+    }
+
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static void FtpStandIn_Reply(FtpStandIn_Session_t *session, const char *fmt, ...)
+{
+    char line[FTP_STAND_IN_LINE_SIZE];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line) - 2, fmt, args);
+    va_end(args);
+    if (len < 0 || len >= (int)sizeof(line) - 2)
+        return;
+    line[len++] = '\r';
+    line[len++] = '\n';
+    FtpStandIn_Delay(session, 1);
+    send(session->fd, line, len, MSG_NOSIGNAL);
+}
+
+static int FtpStandIn_ReadLine(int fd, char *line, size_t size)
+{
+    size_t len = 0;
+    char c;
+
+    while (len < size - 1)
+    {
+        if (recv(fd, &c, 1, 0) != 1)
+            return -1;
+        if (c == '\n')
+            break;
+        if (c != '\r')
+            line[len++] = c;
+    }
+    line[len] = '\0';
+    return 0;
+}
+
+static void FtpStandIn_Path(FtpStandIn_Session_t *session, const char *name, char *path, size_t size)
+{
+    /* absolute names are given from the ftp root */
+    if (*name == '/')
+    {
+        while (*name == '/')
+            name++;
+        snprintf(path, size, "%s/%s", session->server->rootFolder, name);
+    }
+    else
+        snprintf(path, size, "%s/%s%s", session->server->rootFolder, session->cwd, name);
+}
+
+static int FtpStandIn_AcceptData(FtpStandIn_Session_t *session)
+{
+    int fd;
+
+    if (session->pasvFd < 0)
+        return -1;
+
+    fd = accept(session->pasvFd, NULL, NULL);
+    close(session->pasvFd);
+    session->pasvFd = -1;
+    FtpStandIn_Delay(session, 1);
+    return fd;
+}
+
+static void FtpStandIn_Stor(FtpStandIn_Session_t *session, const char *name, int append)
+{
+    char path[FTP_STAND_IN_LINE_SIZE];
+    char *buffer = malloc(FTP_STAND_IN_BUFFER_SIZE);
+    int fd, dataFd;
+    ssize_t ret;
+    int ok = 1;
+
+    FtpStandIn_Path(session, name, path, sizeof(path));
+    if (append)
+        fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    else
+        fd = open(path, O_WRONLY | O_CREAT | ((session->rest == 0) ? O_TRUNC : 0), 0644);
+    if ((fd < 0) || (buffer == NULL) || (!append && (lseek(fd, session->rest, SEEK_SET) < 0)))
+    {
+        FtpStandIn_Reply(session, "550 can't open %s", name);
+        ok = 0;
+    }
+
+    if (ok)
+    {
+        FtpStandIn_Reply(session, "150 ok");
+        dataFd = FtpStandIn_AcceptData(session);
+        while ((dataFd >= 0) && ((ret = recv(dataFd, buffer, FTP_STAND_IN_BUFFER_SIZE, MSG_WAITALL)) > 0))
+        {
+            FtpStandIn_Delay(session, 1);
+            if ((session->windowLoss > 0) && (rand_r(&session->seed) < session->windowLoss * RAND_MAX))
+                FtpStandIn_Delay(session, 1);
+            if (write(fd, buffer, ret) != ret)
+            {
+                ok = 0;
+                break;
+            }
+        }
+        if (dataFd >= 0)
+            close(dataFd);
+        FtpStandIn_Reply(session, ok ? "226 done" : "451 write error");
+    }
+
+    if (fd >= 0)
+        close(fd);
+    free(buffer);
+    session->rest = 0;
+}
+
+static void FtpStandIn_Retr(FtpStandIn_Session_t *session, const char *name)
+{
+    char path[FTP_STAND_IN_LINE_SIZE];
+    char *buffer = malloc(FTP_STAND_IN_BUFFER_SIZE);
+    int fd, dataFd;
+    ssize_t ret;
+    int ok = 1;
+
+    FtpStandIn_Path(session, name, path, sizeof(path));
+    fd = open(path, O_RDONLY);
+    if ((fd < 0) || (buffer == NULL) || (lseek(fd, session->rest, SEEK_SET) < 0))
+    {
+        FtpStandIn_Reply(session, "550 can't open %s", name);
+        ok = 0;
+    }
+
+    if (ok)
+    {
+        FtpStandIn_Reply(session, "150 ok");
+        dataFd = FtpStandIn_AcceptData(session);
+        while ((dataFd >= 0) && ((ret = read(fd, buffer, FTP_STAND_IN_BUFFER_SIZE)) > 0))
+        {
+            if (send(dataFd, buffer, ret, MSG_NOSIGNAL) != ret)
+            {
+                ok = 0;
+                break;
+            }
+        }
+        if (dataFd >= 0)
+            close(dataFd);
+        FtpStandIn_Reply(session, ok ? "226 done" : "426 aborted");
+    }
+
+    if (fd >= 0)
+        close(fd);
+    free(buffer);
+    session->rest = 0;
+}
+
+static void *FtpStandIn_SessionRun(void *arg)
+{
+    FtpStandIn_Session_t *session = arg;
+    char line[FTP_STAND_IN_LINE_SIZE];
+    char path[FTP_STAND_IN_LINE_SIZE];
+    char path2[FTP_STAND_IN_LINE_SIZE];
+    struct stat st;
+    char *param;
+    int port;
+
+    FtpStandIn_Reply(session, "220 stand-in ready");
+
+    while (FtpStandIn_ReadLine(session->fd, line, sizeof(line)) == 0)
+    {
+        param = strchr(line, ' ');
+        if (param != NULL)
+            *param++ = '\0';
+        else
+            param = "";
+
+        if (strcasecmp(line, "USER") == 0)
+            FtpStandIn_Reply(session, "331 password please");
+        else if (strcasecmp(line, "PASS") == 0)
+            FtpStandIn_Reply(session, "230 logged in");
+        else if (strcasecmp(line, "TYPE") == 0)
+            FtpStandIn_Reply(session, "200 ok");
+        else if (strcasecmp(line, "PASV") == 0)
+        {
+            if (session->pasvFd >= 0)
+                close(session->pasvFd);
+            session->pasvFd = FtpStandIn_Listen(&port);
+            if (session->pasvFd < 0)
+                FtpStandIn_Reply(session, "425 can't open data connection");
+            else
+                FtpStandIn_Reply(session, "227 Entering Passive Mode (127,0,0,1,%d,%d)", port >> 8, port & 0xff);
+        }
+        else if (strcasecmp(line, "REST") == 0)
+        {
+            if (session->server->refuseRest)
+                FtpStandIn_Reply(session, "502 REST not implemented");
+            else
+            {
+                session->rest = strtoull(param, NULL, 10);
+                FtpStandIn_Reply(session, "350 restarting at %llu", session->rest);
+            }
+        }
+        else if (strcasecmp(line, "STOR") == 0)
+            FtpStandIn_Stor(session, param, 0);
+        else if (strcasecmp(line, "APPE") == 0)
+            FtpStandIn_Stor(session, param, 1);
+        else if (strcasecmp(line, "PWD") == 0)
+            FtpStandIn_Reply(session, "257 \"/%s\"", session->cwd);
+        else if (strcasecmp(line, "CWD") == 0)
+        {
+            FtpStandIn_Path(session, param, path, sizeof(path));
+            if ((stat(path, &st) == 0) && S_ISDIR(st.st_mode))
+            {
+                if (*param == '/')
+                    session->cwd[0] = '\0';
+                while (*param == '/')
+                    param++;
+                if (*param != '\0')
+                {
+                    strncat(session->cwd, param, sizeof(session->cwd) - strlen(session->cwd) - 2);
+                    strcat(session->cwd, "/");
+                }
+                FtpStandIn_Reply(session, "250 ok");
+            }
+            else
+                FtpStandIn_Reply(session, "550 no such directory");
+        }
+        else if (strcasecmp(line, "NOOP") == 0)
+            FtpStandIn_Reply(session, "200 ok");
+        else if (strcasecmp(line, "RETR") == 0)
+            FtpStandIn_Retr(session, param);
+        else if (strcasecmp(line, "SIZE") == 0)
+        {
+            FtpStandIn_Path(session, param, path, sizeof(path));
+            if (stat(path, &st) == 0)
+                FtpStandIn_Reply(session, "213 %llu", (unsigned long long)st.st_size);
+            else
+                FtpStandIn_Reply(session, "550 no such file");
+        }
+        else if (strcasecmp(line, "RNFR") == 0)
+        {
+            snprintf(session->renameFrom, sizeof(session->renameFrom), "%s", param);
+            FtpStandIn_Reply(session, "350 ready for RNTO");
+        }
+        else if (strcasecmp(line, "RNTO") == 0)
+        {
+            FtpStandIn_Path(session, session->renameFrom, path, sizeof(path));
+            FtpStandIn_Path(session, param, path2, sizeof(path2));
+            if (rename(path, path2) == 0)
+                FtpStandIn_Reply(session, "250 renamed");
+            else
+                FtpStandIn_Reply(session, "550 rename failed");
+        }
+        else if (strcasecmp(line, "DELE") == 0)
+        {
+            FtpStandIn_Path(session, param, path, sizeof(path));
+            if (unlink(path) == 0)
+                FtpStandIn_Reply(session, "250 deleted");
+            else
+                FtpStandIn_Reply(session, "550 no such file");
+        }
+        else if (strcasecmp(line, "QUIT") == 0)
+        {
+            FtpStandIn_Reply(session, "221 bye");
+            break;
+        }
+        else
+            FtpStandIn_Reply(session, "502 not implemented");
+    }
+
+    if (session->pasvFd >= 0)
+        close(session->pasvFd);
+    close(session->fd);
+    free(session);
+    return NULL;
+}
+
+static void *FtpStandIn_Run(void *arg)
+{
+    FtpStandIn_t *server = arg;
+    FtpStandIn_Session_t *session;
+    pthread_t thread;
+    int fd;
+
+    while (!server->isStopped)
+    {
+        fd = accept(server->listenFd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        session = calloc(1, sizeof(*session));
+        if (session == NULL)
+        {
+            close(fd);
+            continue;
+        }
+        session->server = server;
+        session->fd = fd;
+        session->pasvFd = -1;
+        session->rttMs = server->rttMs;
+        session->windowLoss = 1.0 - pow(1.0 - server->lossPercent / 100.0, FTP_STAND_IN_BUFFER_SIZE / FTP_STAND_IN_SEGMENT_SIZE);
+        session->seed = (unsigned int)fd;
+
+        /* sessions end with their client */
+        if (pthread_create(&thread, NULL, FtpStandIn_SessionRun, session) == 0)
+            pthread_detach(thread);
+        else
+        {
+            close(fd);
+            free(session);
+        }
+    }
+
+    return NULL;
+}
+
+FtpStandIn_t *FtpStandIn_Start(const char *rootFolder, int refuseRest)
+{
+    FtpStandIn_t *server = calloc(1, sizeof(FtpStandIn_t));
+
+    if (server == NULL)
+        return NULL;
+
+    snprintf(server->rootFolder, sizeof(server->rootFolder), "%s", rootFolder);
+    server->refuseRest = refuseRest;
+    server->listenFd = FtpStandIn_Listen(&server->port);
+    if ((server->listenFd < 0) ||
+        (pthread_create(&server->thread, NULL, FtpStandIn_Run, server) != 0))
+    {
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, FTP_STAND_IN_TAG, "can't start server");
+        if (server->listenFd >= 0)
+            close(server->listenFd);
+        free(server);
+        return NULL;
+    }
+
+    return server;
+}
+
+int FtpStandIn_GetPort(FtpStandIn_t *server)
+{
+    return server->port;
+}
+
+void FtpStandIn_SetLink(FtpStandIn_t *server, int rttMs, double lossPercent)
+{
+    server->rttMs = rttMs;
+    server->lossPercent = lossPercent;
+}
+
+void FtpStandIn_Stop(FtpStandIn_t **server)
+{
+    if ((server != NULL) && (*server != NULL))
+    {
+        (*server)->isStopped = 1;
+        shutdown((*server)->listenFd, SHUT_RDWR);
+        pthread_join((*server)->thread, NULL);
+        close((*server)->listenFd);
+        free(*server);
+        *server = NULL;
+    }
+}
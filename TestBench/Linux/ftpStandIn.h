@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file ftpStandIn.h
+ * @brief libARUpdater TestBench minimal local ftp server
+ * @details Serves a local folder on 127.0.0.1, enough for the uploader:
+ * USER, PASS, TYPE, PASV, REST, STOR, APPE, RETR, SIZE, RNFR, RNTO, DELE, PWD, CWD, NOOP, QUIT.
+ * A slower link can be simulated, see FtpStandIn_SetLink().
+ */
+
+#ifndef _FTP_STAND_IN_H_
+#define _FTP_STAND_IN_H_
+
+typedef struct FtpStandIn_t FtpStandIn_t;
+
+/**
+ * @brief Start a server in its own thread
+ * @param[in] rootFolder : served folder
+ * @param[in] refuseRest : 1 to answer 502 to REST
+ * @return the server, NULL on error
+ */
+FtpStandIn_t *FtpStandIn_Start(const char *rootFolder, int refuseRest);
+
+/**
+ * @brief Get the port the server listens on
+ */
+int FtpStandIn_GetPort(FtpStandIn_t *server);
+
+/**
+ * @brief Simulate a slower link, for the sessions opened afterwards
+ * @details Each command reply and data connection costs one round trip, and stored data is
+ * read by 64 KiB windows costing one round trip each. A window with a lost 1448 bytes
+ * segment costs one more round trip, as a fast retransmit would.
+ * @param[in] rttMs : round trip time in milliseconds
+ * @param[in] lossPercent : segment loss rate in percent
+ */
+void FtpStandIn_SetLink(FtpStandIn_t *server, int rttMs, double lossPercent);
+
+/**
+ * @brief Stop the server and free it
+ */
+void FtpStandIn_Stop(FtpStandIn_t **server);
+
+#endif /* _FTP_STAND_IN_H_ */
@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file muxChunkBench.c
+ * @brief libARUpdater TestBench cpu cost of the mux update chunks on the controller
+ * @details Builds the pomp messages of the chunks of a file as the mux uploader does, once
+ * with the chunks read into a buffer and once with the file memory mapped, and reports the
+ * cpu time per MB of both. The file is in the page cache, so only the copies are measured.
+ * usage: tst-arupdater-mux-chunk-bench [-s sizeMiB] [-p passes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <libpomp.h>
+#include <libmux-update.h>
+
+#include "ARUPDATER_FileMap.h"
+
+/* same as the mux uploader */
+#define MUX_CHUNK_BENCH_CHUNK_SIZE  (128*1024)
+
+static double cpuSec(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static int createFile(const char *path, size_t size)
+{
+    char buffer[4096];
+    size_t written = 0;
+    size_t i;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+    if (fd < 0)
+        return -1;
+
+    for (i = 0; i < sizeof(buffer); i++)
+        buffer[i] = (char)(i * 31 + 7);
+
+    while (written < size)
+    {
+        size_t len = (size - written < sizeof(buffer)) ? size - written : sizeof(buffer);
+        if (write(fd, buffer, len) != (ssize_t)len)
+        {
+            close(fd);
+            return -1;
+        }
+        written += len;
+    }
+
+    close(fd);
+    return 0;
+}
+
+/* returns the cpu seconds spent building the messages of all the chunks */
+static double runPasses(const char *path, size_t size, int passes, int useMmap, int *mapped)
+{
+    ARUPDATER_FileMap_t map;
+    struct pomp_msg *msg;
+    const void *chunk;
+    size_t len, offset;
+    uint32_t id;
+    double cpu = -1;
+    int fd, p;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    if (ARUPDATER_FileMap_Open(&map, fd, size, MUX_CHUNK_BENCH_CHUNK_SIZE, useMmap) == 0)
+    {
+        *mapped = (map.data != NULL);
+        cpu = cpuSec();
+        for (p = 0; p < passes; p++)
+        {
+            for (offset = 0, id = 0; offset < size; offset += len, id++)
+            {
+                chunk = ARUPDATER_FileMap_Get(&map, (off_t)offset, MUX_CHUNK_BENCH_CHUNK_SIZE, &len);
+                if (chunk == NULL)
+                    break;
+
+                msg = pomp_msg_new();
+                if (msg == NULL)
+                    break;
+                pomp_msg_write(msg, MUX_UPDATE_MSG_ID_CHUNK, MUX_UPDATE_MSG_FMT_ENC_CHUNK, id, chunk, (uint32_t)len);
+                pomp_msg_destroy(msg);
+            }
+        }
+        cpu = cpuSec() - cpu;
+        ARUPDATER_FileMap_Close(&map);
+    }
+
+    close(fd);
+    return cpu;
+}
+
+int main(int argc, char *argv[])
+{
+    char path[] = "/tmp/arupdater-mux-chunk-bench-XXXXXX";
+    size_t size = 64 * 1024 * 1024;
+    int passes = 8;
+    double readCpu, mapCpu, mb;
+    int opt, fd, mapped = 0;
+
+    while ((opt = getopt(argc, argv, "s:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            size = (size_t)(atof(optarg) * 1024 * 1024);
+            break;
+        case 'p':
+            passes = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s sizeMiB] [-p passes]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    fd = mkstemp(path);
+    if ((fd < 0) || (size == 0) || (passes <= 0))
+        return 1;
+    close(fd);
+
+    if (createFile(path, size) != 0)
+    {
+        unlink(path);
+        return 1;
+    }
+
+    /* warm the page cache */
+    runPasses(path, size, 1, 0, &mapped);
+
+    readCpu = runPasses(path, size, passes, 0, &mapped);
+    mapCpu = runPasses(path, size, passes, 1, &mapped);
+    unlink(path);
+
+    if ((readCpu < 0) || (mapCpu < 0))
+        return 1;
+
+    mb = (double)size * passes / (1024 * 1024);
+    printf("%10s %12s\n", "chunks", "cpu(ms/MB)");
+    printf("%10s %12.3f\n", "read", readCpu * 1000 / mb);
+    printf("%10s %12.3f%s\n", "mmap", mapCpu * 1000 / mb, mapped ? "" : " (mmap failed, read)");
+
+    return 0;
+}
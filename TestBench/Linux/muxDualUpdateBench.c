@@ -0,0 +1,296 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file muxDualUpdateBench.c
+ * @brief libARUpdater TestBench update of a skycontroller and its drone over one mux
+ * @details Updates a skycontroller on the mux update channel and its drone on a second
+ * channel of the same mux, with muxStandIn as the remote, first one after the other and then
+ * at the same time with ARUPDATER_Fleet_AddProductTarget() and
+ * ARUPDATER_Uploader_SetMuxChannel(), and reports the time of each target and of the whole.
+ * usage: tst-arupdater-mux-dual-update-bench [-s skycontrollerMiB] [-S droneMiB] [-b bandwidthMBps]
+ *        [-l latencyMs] [-w window]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUtils/ARUtils.h>
+#include <libARUpdater/ARUpdater.h>
+#include <libmux-update.h>
+
+#include "ARUPDATER_Plf.h"
+#include "muxStandIn.h"
+
+#define MUX_DUAL_TAG            "MuxDualUpdateBench"
+#define MUX_DUAL_TARGETS        2
+#define MUX_DUAL_DRONE_CHANNEL  0x30
+/* remote capabilities: chunks of any size, selective acks */
+#define MUX_DUAL_CAPS_FLAGS     0x2
+#define MUX_DUAL_REMOTE_WINDOW  16
+
+typedef struct
+{
+    double start;
+    double done[MUX_DUAL_TARGETS];
+    float percent[MUX_DUAL_TARGETS];
+} MuxDual_Run_t;
+
+static const eARDISCOVERY_PRODUCT products[MUX_DUAL_TARGETS] = { ARDISCOVERY_PRODUCT_SKYCONTROLLER, ARDISCOVERY_PRODUCT_BEBOP_2 };
+static const uint32_t channels[MUX_DUAL_TARGETS] = { 0, MUX_DUAL_DRONE_CHANNEL };
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the single section of a bench plf, its data follows up to the end of the file */
+static void writeSection(FILE *f, size_t size)
+{
+    uint32_t words[ARUPDATER_PLF_SECTION_HEADER_SIZE / 4] = { 1, (uint32_t)size, 0, 0, 0 };
+    size_t i;
+
+    for (i = 0; i < ARUPDATER_PLF_SECTION_HEADER_SIZE; i++)
+        fputc((words[i / 4] >> (8 * (i % 4))) & 0xff, f);
+}
+
+/* a plf with a production header in the folder of the product */
+static int createPlf(const char *rootFolder, eARDISCOVERY_PRODUCT product, size_t size)
+{
+    char path[512];
+    plf_phdr_t header;
+    char *buffer;
+    size_t i, len;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(product));
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x/bench.plf", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(product));
+
+    f = fopen(path, "wb");
+    buffer = malloc(64 * 1024);
+    if ((f == NULL) || (buffer == NULL) || (size < sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE))
+    {
+        if (f != NULL)
+            fclose(f);
+        free(buffer);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = PLF_CURRENT_VERSION;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    header.p_ext = 1;
+    header.p_size = size;
+    fwrite(&header, 1, sizeof(header), f);
+    writeSection(f, size - sizeof(header) - ARUPDATER_PLF_SECTION_HEADER_SIZE);
+
+    for (i = 0; i < 64 * 1024; i++)
+        buffer[i] = (char)rand();
+    for (i = sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE; i < size; i += len)
+    {
+        len = (size - i < 64 * 1024) ? size - i : 64 * 1024;
+        fwrite(buffer, 1, len, f);
+    }
+
+    fclose(f);
+    free(buffer);
+    return 0;
+}
+
+static void progressCallback(void *arg, int targetIndex, float percent)
+{
+    MuxDual_Run_t *run = arg;
+
+    run->percent[targetIndex] = percent;
+}
+
+static void completionCallback(void *arg, int targetIndex, eARUPDATER_ERROR error)
+{
+    MuxDual_Run_t *run = arg;
+
+    run->done[targetIndex] = nowSec() - run->start;
+}
+
+/* updates both targets, at the same time if parallel */
+static eARUPDATER_ERROR runFleet(const char *rootFolder, struct mux_ctx *mux, ARUTILS_Manager_t *ftpManager,
+                                 ARSAL_MD5_Manager_t *md5Manager, int parallel, int window, MuxDual_Run_t *run)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_Fleet_t *fleet;
+    ARUPDATER_Manager_t *manager;
+    int i, index;
+
+    memset(run, 0, sizeof(*run));
+    fleet = ARUPDATER_Fleet_New(rootFolder, md5Manager, products[0], parallel ? 0 : 1, progressCallback, run,
+                                completionCallback, run, &error);
+
+    for (i = 0; (error == ARUPDATER_OK) && (i < MUX_DUAL_TARGETS); i++)
+    {
+        index = ARUPDATER_Fleet_AddProductTarget(fleet, mux, ftpManager, 0, products[i], &error);
+        manager = ARUPDATER_Fleet_GetTargetManager(fleet, index);
+        if ((error == ARUPDATER_OK) && (channels[i] != 0))
+            error = ARUPDATER_Uploader_SetMuxChannel(manager, channels[i]);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_SetMuxWindow(manager, window);
+    }
+
+    run->start = nowSec();
+    if (error == ARUPDATER_OK)
+        error = (eARUPDATER_ERROR)(intptr_t)ARUPDATER_Fleet_ThreadRun(fleet);
+
+    ARUPDATER_Fleet_Delete(&fleet);
+    return error;
+}
+
+int main(int argc, char *argv[])
+{
+    double sizesMiB[MUX_DUAL_TARGETS] = { 8, 24 };
+    double bandwidth = 20;
+    int latency = 10, window = 1;
+    char rootFolder[] = "/tmp/arupdater-mux-dual-local-XXXXXX";
+    char remoteFolder[] = "/tmp/arupdater-mux-dual-remote-XXXXXX";
+    eARSAL_ERROR arsalError = ARSAL_OK;
+    eARUTILS_ERROR ftpError = ARUTILS_OK;
+    ARSAL_MD5_Manager_t *md5Manager = NULL;
+    ARUTILS_Manager_t *ftpManager = NULL;
+    MuxStandIn_Config_t config;
+    MuxStandIn_Counters_t counters;
+    MuxDual_Run_t run;
+    struct mux_ctx *mux = NULL;
+    eARUPDATER_ERROR error;
+    double elapsed;
+    int failed = 0;
+    int opt, parallel, i;
+    char cmd[600];
+
+    while ((opt = getopt(argc, argv, "s:S:b:l:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sizesMiB[0] = atof(optarg);
+            break;
+        case 'S':
+            sizesMiB[1] = atof(optarg);
+            break;
+        case 'b':
+            bandwidth = atof(optarg);
+            break;
+        case 'l':
+            latency = atoi(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s skycontrollerMiB] [-S droneMiB] [-b bandwidthMBps] [-l latencyMs] "
+                    "[-w window]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((mkdtemp(rootFolder) == NULL) || (mkdtemp(remoteFolder) == NULL))
+        return 1;
+
+    md5Manager = ARSAL_MD5_Manager_New(&arsalError);
+    if (arsalError == ARSAL_OK)
+        arsalError = ARSAL_MD5_Manager_Init(md5Manager);
+    /* the ftp is not used by mux updates */
+    ftpManager = ARUTILS_Manager_New(&ftpError);
+    memset(&config, 0, sizeof(config));
+    config.latencyMs = latency;
+    config.bandwidth = bandwidth * 1024 * 1024;
+    config.window = MUX_DUAL_REMOTE_WINDOW;
+    config.capsFlags = MUX_DUAL_CAPS_FLAGS;
+    config.bufferSize = 2 * 1024 * 1024;
+    mux = MuxStandIn_New(remoteFolder, &config);
+    if ((arsalError != ARSAL_OK) || (ftpError != ARUTILS_OK) || (mux == NULL))
+    {
+        failed = 1;
+        goto out;
+    }
+
+    for (i = 0; i < MUX_DUAL_TARGETS; i++)
+    {
+        if (createPlf(rootFolder, products[i], (size_t)(sizesMiB[i] * 1024 * 1024)) != 0)
+        {
+            failed = 1;
+            goto out;
+        }
+    }
+
+    printf("%10s %14s %14s %10s %8s %s\n", "mode", "skyctrl(s)", "drone(s)", "total(s)", "MB/s", "result");
+
+    for (parallel = 0; parallel <= 1; parallel++)
+    {
+        MuxStandIn_SetConfig(mux, &config);
+        error = runFleet(rootFolder, mux, ftpManager, md5Manager, parallel, window, &run);
+        elapsed = nowSec() - run.start;
+
+        printf("%10s %14.2f %14.2f %10.2f %8.2f %s\n", parallel ? "concurrent" : "sequential", run.done[0],
+               run.done[1], elapsed, (error == ARUPDATER_OK) ? (sizesMiB[0] + sizesMiB[1]) / elapsed : 0,
+               ARUPDATER_Error_ToString(error));
+
+        /* each remote image is checked by its md5 before the status */
+        for (i = 0; i < MUX_DUAL_TARGETS; i++)
+        {
+            MuxStandIn_GetCounters(mux, channels[i] ? channels[i] : MUX_UPDATE_CHANNEL_ID_UPDATE, &counters);
+            if ((counters.status != 0) || (run.percent[i] < 100))
+                error = ARUPDATER_ERROR_UPLOADER;
+        }
+        if (error != ARUPDATER_OK)
+            failed = 1;
+        fflush(stdout);
+    }
+
+out:
+    MuxStandIn_Delete(&mux);
+    if (ftpManager != NULL)
+        ARUTILS_Manager_Delete(&ftpManager);
+    ARSAL_MD5_Manager_Delete(&md5Manager);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", rootFolder, remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, MUX_DUAL_TAG, "can't remove the bench folders");
+
+    return failed;
+}
@@ -0,0 +1,802 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file muxStandIn.c
+ * @brief libARUpdater TestBench in-process remote side of the mux update channel
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <libpomp.h>
+#include <libmux.h>
+#include <libmux-update.h>
+#include <libARSAL/ARSAL_Print.h>
+#include <libARSAL/ARSAL_MD5_Manager.h>
+
+#if defined BUILD_ZLIB
+#include <zlib.h>
+#endif
+
+#include "ARUPDATER_Crc32c.h"
+#include "muxStandIn.h"
+
+#define MUX_STAND_IN_TAG            "MuxStandIn"
+#define MUX_STAND_IN_PENDING_MAX    32
+#define MUX_STAND_IN_CHANNELS_MAX   4
+
+/* extensions of the update protocol, as defined by the uploader */
+#define MUX_STAND_IN_MSG_ID_CAPS_REQ    0x100
+#define MUX_STAND_IN_MSG_ID_CAPS        0x101
+#define MUX_STAND_IN_MSG_ID_RESUME_REQ  0x102
+#define MUX_STAND_IN_MSG_ID_RESUME      0x103
+#define MUX_STAND_IN_MSG_ID_CHUNK_CRC   0x104
+#define MUX_STAND_IN_MSG_ID_CHUNK_NACK  0x105
+#define MUX_STAND_IN_MSG_ID_CHUNK_DEFLATE 0x106
+#define MUX_STAND_IN_CAPS_CUMULATIVE    0x1
+#define MUX_STAND_IN_CAPS_RESUME        0x4
+#define MUX_STAND_IN_CAPS_CHUNK_CRC     0x8
+
+typedef struct MuxStandIn_Item_t
+{
+    struct MuxStandIn_Item_t *next;
+    struct MuxStandIn_Channel_t *channel;
+    double at;                  /* delivery time */
+    int toRemote;
+    int reset;                  /* a channel reset instead of a message */
+    int corrupt;                /* a byte of the chunk is changed on delivery */
+    struct pomp_buffer *buf;
+} MuxStandIn_Item_t;
+
+typedef struct
+{
+    uint32_t id;
+    void *data;
+    uint32_t len;
+} MuxStandIn_Chunk_t;
+
+/* an update channel, kept once opened for the resume of its update */
+typedef struct MuxStandIn_Channel_t
+{
+    /* host side */
+    uint32_t chanid;
+    mux_channel_cb_t cb;
+    void *userdata;
+    int isOpen;
+
+    /* remote side, only used by the link thread */
+    char imagePath[600];
+    FILE *image;
+    uint8_t md5[ARSAL_MD5_LENGTH];
+    uint64_t size;
+    uint32_t expectedId;
+    uint64_t received;
+    MuxStandIn_Chunk_t pending[MUX_STAND_IN_PENDING_MAX];
+    int pendingCount;
+    int resetDone;              /* the simulated reset already happened */
+    int hasOffer;
+    uint32_t offerId;
+    uint64_t offerOffset;
+    int hasPartial;             /* an interrupted update is kept for resume */
+    uint8_t partialMd5[ARSAL_MD5_LENGTH];
+    uint32_t partialId;
+    uint64_t partialOffset;
+    MuxStandIn_Counters_t counters;
+} MuxStandIn_Channel_t;
+
+struct mux_ctx
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    int refcount;
+    int isStopped;
+    MuxStandIn_Config_t config;
+    char folder[512];
+    unsigned int seed;
+    ARSAL_MD5_Manager_t *md5Manager;
+
+    /* link, shared by the channels */
+    MuxStandIn_Item_t *queue;
+    double linkFreeAt;
+
+    MuxStandIn_Channel_t channels[MUX_STAND_IN_CHANNELS_MAX];
+    int channelCount;
+};
+
+static double MuxStandIn_Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* with the lock held */
+static void MuxStandIn_Enqueue(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, double at, int toRemote, int reset, int corrupt, struct pomp_buffer *buf)
+{
+    MuxStandIn_Item_t *item = calloc(1, sizeof(*item));
+    MuxStandIn_Item_t **pos = &ctx->queue;
+
+    if (item == NULL)
+        return;
+
+    item->channel = ch;
+    item->at = at;
+    item->toRemote = toRemote;
+    item->reset = reset;
+    item->corrupt = corrupt;
+    item->buf = buf;
+    if (buf != NULL)
+        pomp_buffer_ref(buf);
+
+    /* in delivery order, first in first out for the same time */
+    while ((*pos != NULL) && ((*pos)->at <= at))
+        pos = &(*pos)->next;
+    item->next = *pos;
+    *pos = item;
+    pthread_cond_signal(&ctx->cond);
+}
+
+static void MuxStandIn_Send(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, uint32_t msgid, const char *fmt, ...)
+{
+    struct pomp_msg *msg = pomp_msg_new();
+    va_list args;
+
+    if (msg == NULL)
+        return;
+
+    va_start(args, fmt);
+    if (pomp_msg_writev(msg, msgid, fmt, args) == 0)
+    {
+        pthread_mutex_lock(&ctx->lock);
+        MuxStandIn_Enqueue(ctx, ch, MuxStandIn_Now() + ctx->config.latencyMs / 1000.0, 0, 0, 0, pomp_msg_get_buffer(msg));
+        pthread_mutex_unlock(&ctx->lock);
+    }
+    va_end(args);
+
+    pomp_msg_destroy(msg);
+}
+
+static void MuxStandIn_ClearPending(MuxStandIn_Channel_t *ch)
+{
+    int i;
+
+    for (i = 0; i < ch->pendingCount; i++)
+        free(ch->pending[i].data);
+    ch->pendingCount = 0;
+}
+
+static void MuxStandIn_EndUpdate(MuxStandIn_Channel_t *ch)
+{
+    if (ch->image != NULL)
+    {
+        fclose(ch->image);
+        ch->image = NULL;
+    }
+    MuxStandIn_ClearPending(ch);
+}
+
+static void MuxStandIn_Ack(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, uint32_t id)
+{
+    if (ctx->config.capsFlags & MUX_STAND_IN_CAPS_CUMULATIVE)
+    {
+        if (ch->expectedId == 0)
+            return;
+        id = ch->expectedId - 1;
+    }
+    MuxStandIn_Send(ctx, ch, MUX_UPDATE_MSG_ID_CHUNK_ACK, MUX_UPDATE_MSG_FMT_ENC_CHUNK_ACK, id);
+}
+
+static void MuxStandIn_Append(MuxStandIn_Channel_t *ch, const void *data, uint32_t len)
+{
+    int i, found;
+
+    fwrite(data, 1, len, ch->image);
+    ch->expectedId++;
+    ch->received += len;
+
+    /* chunks received out of order that now follow */
+    do
+    {
+        found = 0;
+        for (i = 0; i < ch->pendingCount; i++)
+        {
+            if (ch->pending[i].id == ch->expectedId)
+            {
+                fwrite(ch->pending[i].data, 1, ch->pending[i].len, ch->image);
+                ch->expectedId++;
+                ch->received += ch->pending[i].len;
+                free(ch->pending[i].data);
+                ch->pending[i] = ch->pending[--ch->pendingCount];
+                found = 1;
+                break;
+            }
+        }
+    } while (found);
+}
+
+static void MuxStandIn_Finish(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch)
+{
+    uint8_t md5[ARSAL_MD5_LENGTH];
+    int status = -1;
+
+    MuxStandIn_EndUpdate(ch);
+    if ((ARSAL_MD5_Manager_Compute(ctx->md5Manager, ch->imagePath, md5, ARSAL_MD5_LENGTH) == ARSAL_OK) &&
+        (memcmp(md5, ch->md5, ARSAL_MD5_LENGTH) == 0))
+        status = 0;
+    else
+        ARSAL_PRINT(ARSAL_PRINT_ERROR, MUX_STAND_IN_TAG, "md5 of the received image doesn't match");
+
+    ch->size = 0;
+    ch->hasPartial = 0;
+    ch->counters.status = status;
+    MuxStandIn_Send(ctx, ch, MUX_UPDATE_MSG_ID_STATUS, MUX_UPDATE_MSG_FMT_ENC_STATUS, status);
+}
+
+static void MuxStandIn_HandleUpdateReq(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, struct pomp_msg *msg)
+{
+    char *version = NULL;
+    const void *md5 = NULL;
+    uint32_t md5Len = 0, size = 0;
+    uint32_t resumeId = 0;
+    uint64_t resumeOffset = 0;
+
+    if ((pomp_msg_read(msg, MUX_UPDATE_MSG_FMT_DEC_UPDATE_REQ, &version, &md5, &md5Len, &size) < 0) ||
+        (md5Len != ARSAL_MD5_LENGTH))
+    {
+        free(version);
+        MuxStandIn_Send(ctx, ch, MUX_UPDATE_MSG_ID_UPDATE_RESP, MUX_UPDATE_MSG_FMT_ENC_UPDATE_RESP, -1);
+        return;
+    }
+
+    MuxStandIn_EndUpdate(ch);
+    memset(&ch->counters, 0, sizeof(ch->counters));
+    ch->counters.status = -1;
+
+    /* resume the interrupted update of the same image, from at most the offered chunk */
+    if (ch->hasOffer)
+    {
+        if (ch->hasPartial && (memcmp(ch->partialMd5, md5, ARSAL_MD5_LENGTH) == 0) &&
+            (ch->offerId <= ch->partialId) && (ch->offerOffset <= ch->partialOffset))
+        {
+            resumeId = ch->offerId;
+            resumeOffset = ch->offerOffset;
+        }
+        ch->hasOffer = 0;
+        MuxStandIn_Send(ctx, ch, MUX_STAND_IN_MSG_ID_RESUME, "%u%u", resumeId, (uint32_t)resumeOffset);
+    }
+
+    ch->image = fopen(ch->imagePath, (resumeOffset > 0) ? "r+b" : "wb");
+    if ((ch->image == NULL) || (fseek(ch->image, (long)resumeOffset, SEEK_SET) != 0))
+    {
+        free(version);
+        MuxStandIn_EndUpdate(ch);
+        MuxStandIn_Send(ctx, ch, MUX_UPDATE_MSG_ID_UPDATE_RESP, MUX_UPDATE_MSG_FMT_ENC_UPDATE_RESP, -1);
+        return;
+    }
+
+    memcpy(ch->md5, md5, ARSAL_MD5_LENGTH);
+    ch->size = size;
+    ch->expectedId = resumeId;
+    ch->received = resumeOffset;
+    ch->counters.resumedAt = resumeOffset;
+    ch->hasPartial = 0;
+
+    ARSAL_PRINT(ARSAL_PRINT_INFO, MUX_STAND_IN_TAG, "update %s: %u bytes from %llu", version, size, (unsigned long long)resumeOffset);
+    free(version);
+    MuxStandIn_Send(ctx, ch, MUX_UPDATE_MSG_ID_UPDATE_RESP, MUX_UPDATE_MSG_FMT_ENC_UPDATE_RESP, 0);
+}
+
+#if defined BUILD_ZLIB
+/* returns the chunk data, NULL if the compressed data is corrupted */
+static uint8_t *MuxStandIn_Inflate(const void *data, uint32_t len, uint32_t rawLen)
+{
+    z_stream strm;
+    uint8_t *raw = malloc(rawLen);
+    int ret;
+
+    memset(&strm, 0, sizeof(strm));
+    if ((raw == NULL) || (inflateInit2(&strm, -MAX_WBITS) != Z_OK))
+    {
+        free(raw);
+        return NULL;
+    }
+
+    strm.next_in = (Bytef *)data;
+    strm.avail_in = len;
+    strm.next_out = raw;
+    strm.avail_out = rawLen;
+    ret = inflate(&strm, Z_FINISH);
+    inflateEnd(&strm);
+    if ((ret != Z_STREAM_END) || (strm.total_out != rawLen))
+    {
+        free(raw);
+        return NULL;
+    }
+
+    return raw;
+}
+#endif
+
+static void MuxStandIn_HandleChunk(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, struct pomp_msg *msg, int corrupt)
+{
+    uint32_t id = 0, len = 0, crc = 0, rawLen = 0;
+    const void *data = NULL;
+    uint8_t *copy = NULL;
+    uint8_t *raw = NULL;
+    uint32_t msgid = pomp_msg_get_id(msg);
+    int hasCrc = (msgid != MUX_UPDATE_MSG_ID_CHUNK);
+    int ret, i;
+
+    if (msgid == MUX_STAND_IN_MSG_ID_CHUNK_DEFLATE)
+        ret = pomp_msg_read(msg, "%u%u%u%p%u", &id, &crc, &rawLen, &data, &len);
+    else if (msgid == MUX_STAND_IN_MSG_ID_CHUNK_CRC)
+        ret = pomp_msg_read(msg, "%u%u%p%u", &id, &crc, &data, &len);
+    else
+        ret = pomp_msg_read(msg, MUX_UPDATE_MSG_FMT_DEC_CHUNK, &id, &data, &len);
+    if ((ch->image == NULL) || (ret < 0))
+        return;
+
+    ch->counters.chunksReceived++;
+
+    /* the message buffer is shared with the host, change a copy */
+    if (corrupt && (len > 0))
+    {
+        copy = malloc(len);
+        if (copy == NULL)
+            return;
+        memcpy(copy, data, len);
+        copy[len / 2] ^= 0x01;
+        data = copy;
+        ch->counters.chunksCorrupted++;
+    }
+
+    if (msgid == MUX_STAND_IN_MSG_ID_CHUNK_DEFLATE)
+    {
+        ch->counters.chunksCompressed++;
+#if defined BUILD_ZLIB
+        raw = MuxStandIn_Inflate(data, len, rawLen);
+#endif
+        data = raw;
+        len = rawLen;
+    }
+
+    if (hasCrc && ((data == NULL) || (ARUPDATER_Crc32c_Update(0, data, len) != crc)))
+    {
+        ch->counters.chunksNacked++;
+        MuxStandIn_Send(ctx, ch, MUX_STAND_IN_MSG_ID_CHUNK_NACK, "%u", id);
+        goto out;
+    }
+
+    if (id < ch->expectedId)
+    {
+        /* its ack was late, answer again */
+        ch->counters.chunksDuplicated++;
+    }
+    else if (id == ch->expectedId)
+    {
+        MuxStandIn_Append(ch, data, len);
+    }
+    else if (!(ctx->config.capsFlags & MUX_STAND_IN_CAPS_CUMULATIVE))
+    {
+        /* kept until the chunks before it arrive */
+        for (i = 0; (i < ch->pendingCount) && (ch->pending[i].id != id); i++)
+            ;
+        if (i < ch->pendingCount)
+        {
+            ch->counters.chunksDuplicated++;
+        }
+        else if (ch->pendingCount < MUX_STAND_IN_PENDING_MAX)
+        {
+            ch->pending[ch->pendingCount].data = malloc(len);
+            if (ch->pending[ch->pendingCount].data == NULL)
+                goto out;
+            memcpy(ch->pending[ch->pendingCount].data, data, len);
+            ch->pending[ch->pendingCount].id = id;
+            ch->pending[ch->pendingCount].len = len;
+            ch->pendingCount++;
+        }
+        else
+        {
+            goto out;
+        }
+    }
+    ch->counters.bytesReceived = ch->received;
+
+    /* simulated usb glitch, the received part is kept for a resume */
+    if ((ctx->config.resetAfterBytes > 0) && !ch->resetDone && (ch->received >= ctx->config.resetAfterBytes))
+    {
+        ch->resetDone = 1;
+        if (ctx->config.capsFlags & MUX_STAND_IN_CAPS_RESUME)
+        {
+            ch->hasPartial = 1;
+            memcpy(ch->partialMd5, ch->md5, ARSAL_MD5_LENGTH);
+            ch->partialId = ch->expectedId;
+            ch->partialOffset = ch->received;
+        }
+        MuxStandIn_EndUpdate(ch);
+        pthread_mutex_lock(&ctx->lock);
+        MuxStandIn_Enqueue(ctx, ch, MuxStandIn_Now() + ctx->config.latencyMs / 1000.0, 0, 1, 0, NULL);
+        pthread_mutex_unlock(&ctx->lock);
+        goto out;
+    }
+
+    MuxStandIn_Ack(ctx, ch, id);
+
+    if (ch->received >= ch->size)
+        MuxStandIn_Finish(ctx, ch);
+
+out:
+    free(raw);
+    free(copy);
+}
+
+static void MuxStandIn_HandleRemote(struct mux_ctx *ctx, MuxStandIn_Channel_t *ch, struct pomp_buffer *buf, int corrupt)
+{
+    struct pomp_msg *msg = pomp_msg_new_with_buffer(buf);
+    uint32_t window = 0, id = 0, offset = 0;
+
+    if (msg == NULL)
+        return;
+
+    switch (pomp_msg_get_id(msg))
+    {
+    case MUX_STAND_IN_MSG_ID_CAPS_REQ:
+        /* a remote without capabilities doesn't answer */
+        if ((ctx->config.window > 0) && (pomp_msg_read(msg, "%u", &window) == 0))
+        {
+            if (window > (uint32_t)ctx->config.window)
+                window = ctx->config.window;
+            MuxStandIn_Send(ctx, ch, MUX_STAND_IN_MSG_ID_CAPS, "%u%u%u", window, ctx->config.capsFlags, ctx->config.bufferSize);
+        }
+        break;
+
+    case MUX_STAND_IN_MSG_ID_RESUME_REQ:
+        /* answered with the update response */
+        if ((ctx->config.capsFlags & MUX_STAND_IN_CAPS_RESUME) && (pomp_msg_read(msg, "%u%u", &id, &offset) == 0))
+        {
+            ch->hasOffer = 1;
+            ch->offerId = id;
+            ch->offerOffset = offset;
+        }
+        break;
+
+    case MUX_UPDATE_MSG_ID_UPDATE_REQ:
+        MuxStandIn_HandleUpdateReq(ctx, ch, msg);
+        break;
+
+    case MUX_UPDATE_MSG_ID_CHUNK:
+    case MUX_STAND_IN_MSG_ID_CHUNK_CRC:
+    case MUX_STAND_IN_MSG_ID_CHUNK_DEFLATE:
+        MuxStandIn_HandleChunk(ctx, ch, msg, corrupt);
+        break;
+
+    default:
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, MUX_STAND_IN_TAG, "unknown message %u", pomp_msg_get_id(msg));
+        break;
+    }
+
+    pomp_msg_destroy(msg);
+}
+
+static void *MuxStandIn_Run(void *arg)
+{
+    struct mux_ctx *ctx = arg;
+    MuxStandIn_Item_t *item;
+    MuxStandIn_Channel_t *ch;
+    mux_channel_cb_t cb;
+    void *userdata;
+    struct timespec ts;
+    double now;
+
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->isStopped)
+    {
+        if (ctx->queue == NULL)
+        {
+            pthread_cond_wait(&ctx->cond, &ctx->lock);
+            continue;
+        }
+
+        now = MuxStandIn_Now();
+        if (ctx->queue->at > now)
+        {
+            ts.tv_sec = (time_t)ctx->queue->at;
+            ts.tv_nsec = (long)((ctx->queue->at - ts.tv_sec) * 1e9);
+            pthread_cond_timedwait(&ctx->cond, &ctx->lock, &ts);
+            continue;
+        }
+
+        item = ctx->queue;
+        ctx->queue = item->next;
+        ch = item->channel;
+        cb = ch->isOpen ? ch->cb : NULL;
+        userdata = ch->userdata;
+        pthread_mutex_unlock(&ctx->lock);
+
+        if (item->toRemote)
+            MuxStandIn_HandleRemote(ctx, ch, item->buf, item->corrupt);
+        else if (cb != NULL)
+            cb(ctx, ch->chanid, item->reset ? MUX_CHANNEL_RESET : MUX_CHANNEL_DATA, item->buf, userdata);
+
+        if (item->buf != NULL)
+            pomp_buffer_unref(item->buf);
+        free(item);
+        pthread_mutex_lock(&ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return NULL;
+}
+
+struct mux_ctx *MuxStandIn_New(const char *folder, const MuxStandIn_Config_t *config)
+{
+    struct mux_ctx *ctx = calloc(1, sizeof(*ctx));
+    pthread_condattr_t attr;
+    eARSAL_ERROR error = ARSAL_OK;
+
+    if ((ctx == NULL) || (folder == NULL) || (config == NULL))
+    {
+        free(ctx);
+        return NULL;
+    }
+
+    ctx->refcount = 1;
+    ctx->config = *config;
+    ctx->seed = 1;
+    snprintf(ctx->folder, sizeof(ctx->folder), "%s", folder);
+
+    ctx->md5Manager = ARSAL_MD5_Manager_New(&error);
+    if (error == ARSAL_OK)
+        error = ARSAL_MD5_Manager_Init(ctx->md5Manager);
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ctx->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if ((error != ARSAL_OK) || (pthread_create(&ctx->thread, NULL, MuxStandIn_Run, ctx) != 0))
+    {
+        ARSAL_MD5_Manager_Delete(&ctx->md5Manager);
+        pthread_cond_destroy(&ctx->cond);
+        pthread_mutex_destroy(&ctx->lock);
+        free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void MuxStandIn_SetConfig(struct mux_ctx *mux, const MuxStandIn_Config_t *config)
+{
+    int i;
+
+    pthread_mutex_lock(&mux->lock);
+    mux->config = *config;
+    for (i = 0; i < mux->channelCount; i++)
+        mux->channels[i].resetDone = 0;
+    pthread_mutex_unlock(&mux->lock);
+}
+
+void MuxStandIn_GetCounters(struct mux_ctx *mux, uint32_t chanid, MuxStandIn_Counters_t *counters)
+{
+    int i;
+
+    memset(counters, 0, sizeof(*counters));
+    counters->status = -1;
+
+    pthread_mutex_lock(&mux->lock);
+    for (i = 0; i < mux->channelCount; i++)
+    {
+        if (mux->channels[i].chanid == chanid)
+            *counters = mux->channels[i].counters;
+    }
+    pthread_mutex_unlock(&mux->lock);
+}
+
+void MuxStandIn_Delete(struct mux_ctx **mux)
+{
+    if ((mux != NULL) && (*mux != NULL))
+    {
+        pthread_mutex_lock(&(*mux)->lock);
+        (*mux)->isStopped = 1;
+        pthread_cond_signal(&(*mux)->cond);
+        pthread_mutex_unlock(&(*mux)->lock);
+        pthread_join((*mux)->thread, NULL);
+
+        mux_unref(*mux);
+        *mux = NULL;
+    }
+}
+
+/* libmux functions used by the uploader */
+
+void mux_ref(struct mux_ctx *ctx)
+{
+    pthread_mutex_lock(&ctx->lock);
+    ctx->refcount++;
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+void mux_unref(struct mux_ctx *ctx)
+{
+    MuxStandIn_Item_t *item;
+    int refcount;
+    int i;
+
+    pthread_mutex_lock(&ctx->lock);
+    refcount = --ctx->refcount;
+    pthread_mutex_unlock(&ctx->lock);
+
+    if (refcount > 0)
+        return;
+
+    while (ctx->queue != NULL)
+    {
+        item = ctx->queue;
+        ctx->queue = item->next;
+        if (item->buf != NULL)
+            pomp_buffer_unref(item->buf);
+        free(item);
+    }
+    for (i = 0; i < ctx->channelCount; i++)
+        MuxStandIn_EndUpdate(&ctx->channels[i]);
+    ARSAL_MD5_Manager_Delete(&ctx->md5Manager);
+    pthread_cond_destroy(&ctx->cond);
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx);
+}
+
+/* with the lock held */
+static MuxStandIn_Channel_t *MuxStandIn_FindChannel(struct mux_ctx *ctx, uint32_t chanid)
+{
+    int i;
+
+    for (i = 0; i < ctx->channelCount; i++)
+    {
+        if (ctx->channels[i].chanid == chanid)
+            return &ctx->channels[i];
+    }
+
+    return NULL;
+}
+
+int mux_channel_open(struct mux_ctx *ctx, uint32_t chanid, mux_channel_cb_t cb, void *userdata)
+{
+    MuxStandIn_Channel_t *ch;
+    int ret = 0;
+
+    pthread_mutex_lock(&ctx->lock);
+    ch = MuxStandIn_FindChannel(ctx, chanid);
+    if ((ch == NULL) && (ctx->channelCount < MUX_STAND_IN_CHANNELS_MAX))
+    {
+        /* each channel updates its own remote image */
+        ch = &ctx->channels[ctx->channelCount++];
+        ch->chanid = chanid;
+        ch->counters.status = -1;
+        snprintf(ch->imagePath, sizeof(ch->imagePath), "%s/update-%u.plf", ctx->folder, chanid);
+    }
+
+    if (ch == NULL)
+    {
+        ret = -ENOMEM;
+    }
+    else if (ch->isOpen)
+    {
+        ret = -EBUSY;
+    }
+    else
+    {
+        ch->isOpen = 1;
+        ch->cb = cb;
+        ch->userdata = userdata;
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return ret;
+}
+
+int mux_channel_close(struct mux_ctx *ctx, uint32_t chanid)
+{
+    MuxStandIn_Channel_t *ch;
+    int ret = -ENOENT;
+
+    pthread_mutex_lock(&ctx->lock);
+    ch = MuxStandIn_FindChannel(ctx, chanid);
+    if ((ch != NULL) && ch->isOpen)
+    {
+        ch->isOpen = 0;
+        ch->cb = NULL;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return ret;
+}
+
+int mux_encode(struct mux_ctx *ctx, uint32_t chanid, struct pomp_buffer *buf)
+{
+    MuxStandIn_Channel_t *ch;
+    struct pomp_msg *msg;
+    const void *data = NULL;
+    size_t len = 0;
+    double now, at;
+    int isChunk = 0;
+    int corrupt;
+    int ret = 0;
+
+    msg = pomp_msg_new_with_buffer(buf);
+    if (msg != NULL)
+    {
+        isChunk = ((pomp_msg_get_id(msg) == MUX_UPDATE_MSG_ID_CHUNK) ||
+                   (pomp_msg_get_id(msg) == MUX_STAND_IN_MSG_ID_CHUNK_CRC) ||
+                   (pomp_msg_get_id(msg) == MUX_STAND_IN_MSG_ID_CHUNK_DEFLATE));
+        pomp_msg_destroy(msg);
+    }
+    pomp_buffer_get_cdata(buf, &data, &len, NULL);
+
+    pthread_mutex_lock(&ctx->lock);
+    ch = MuxStandIn_FindChannel(ctx, chanid);
+    if ((ch == NULL) || !ch->isOpen)
+    {
+        ret = -EPIPE;
+    }
+    else
+    {
+        /* the link is busy sending the previous messages of every channel */
+        now = MuxStandIn_Now();
+        if (ctx->linkFreeAt < now)
+            ctx->linkFreeAt = now;
+        if (ctx->config.bandwidth > 0)
+            ctx->linkFreeAt += len / ctx->config.bandwidth;
+        at = ctx->linkFreeAt + ctx->config.latencyMs / 1000.0;
+
+        if (isChunk && (ctx->config.dropPercent > 0) &&
+            (rand_r(&ctx->seed) < (RAND_MAX / 100.0) * ctx->config.dropPercent))
+        {
+            ch->counters.chunksDropped++;
+        }
+        else
+        {
+            corrupt = (isChunk && (ctx->config.corruptPercent > 0) &&
+                       (rand_r(&ctx->seed) < (RAND_MAX / 100.0) * ctx->config.corruptPercent));
+            MuxStandIn_Enqueue(ctx, ch, at, 1, 0, corrupt, buf);
+        }
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return ret;
+}
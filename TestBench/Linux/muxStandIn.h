@@ -0,0 +1,100 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file muxStandIn.h
+ * @brief libARUpdater TestBench in-process remote side of the mux update channel
+ * @details Provides the libmux functions the uploader calls (mux_ref, mux_unref,
+ * mux_channel_open, mux_channel_close and mux_encode); linked in the executable, they are
+ * used instead of the libmux ones. Messages cross a simulated link with a latency, a
+ * bandwidth, a chunk loss rate and a chunk corruption rate, and are handled by a fake
+ * remote: UPDATE_REQ, CHUNK, CHUNK_ACK and STATUS, plus the capabilities, resume, chunk
+ * crc and compressed chunk (when built with zlib) extensions when enabled. The received image is written in a folder and its md5 checked
+ * before STATUS. Several update channels can be open at once, each with its own remote
+ * image (update-<chanid>.plf); they share the link and its bandwidth.
+ */
+
+#ifndef _MUX_STAND_IN_H_
+#define _MUX_STAND_IN_H_
+
+#include <stdint.h>
+
+struct mux_ctx;
+
+typedef struct
+{
+    int latencyMs;              /**< one way latency */
+    double bandwidth;           /**< host to remote bytes/s, 0 for unlimited */
+    double dropPercent;         /**< chunks lost on the way to the remote */
+    double corruptPercent;      /**< chunks with a byte changed on the way to the remote */
+    int window;                 /**< window answered to the capabilities request, 0 for a remote without capabilities */
+    uint32_t capsFlags;         /**< flags of the capabilities answer */
+    uint32_t bufferSize;        /**< buffer size of the capabilities answer */
+    uint64_t resetAfterBytes;   /**< reset the channel once after receiving this much, 0 for never */
+} MuxStandIn_Config_t;
+
+typedef struct
+{
+    uint32_t chunksReceived;
+    uint32_t chunksDropped;     /**< lost on the link */
+    uint32_t chunksDuplicated;  /**< received more than once */
+    uint32_t chunksCorrupted;   /**< changed on the link */
+    uint32_t chunksNacked;      /**< found corrupted by their crc */
+    uint32_t chunksCompressed;
+    uint64_t bytesReceived;     /**< in order bytes of the image */
+    uint64_t resumedAt;         /**< offset accepted by the last resume request */
+    int status;                 /**< last status sent, -1 if none */
+} MuxStandIn_Counters_t;
+
+/**
+ * @brief Create a remote, its link runs in its own thread
+ * @param[in] folder : folder where the received image is written
+ * @param[in] config : link and remote settings
+ * @return the mux context to give to ARUPDATER_Uploader_New(), NULL on error
+ */
+struct mux_ctx *MuxStandIn_New(const char *folder, const MuxStandIn_Config_t *config);
+
+/**
+ * @brief Change the settings, for the updates started afterwards
+ */
+void MuxStandIn_SetConfig(struct mux_ctx *mux, const MuxStandIn_Config_t *config);
+
+/**
+ * @brief Get the counters of the last update of a channel
+ * @param[in] chanid : channel of the update, zeroed counters if it was never opened
+ */
+void MuxStandIn_GetCounters(struct mux_ctx *mux, uint32_t chanid, MuxStandIn_Counters_t *counters);
+
+/**
+ * @brief Stop the link and drop the reference of MuxStandIn_New()
+ */
+void MuxStandIn_Delete(struct mux_ctx **mux);
+
+#endif /* _MUX_STAND_IN_H_ */
@@ -0,0 +1,395 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file muxUpdateBench.c
+ * @brief libARUpdater TestBench mux update benchmark against the in-process remote
+ * @details Runs ARUPDATER_Uploader_ThreadRunMux over a matrix of windows, chunk size
+ * adaptation, chunk crcs, chunk compression, latencies and loss rates, with muxStandIn as the
+ * remote, and reports the throughput, the chunk sizes, ack round trip times and compression
+ * ratio of ARUPDATER_Uploader_GetMuxStats and the chunks the remote received twice. A run
+ * that doesn't end in time is canceled. The -p part of the image is compressible.
+ * usage: tst-arupdater-mux-update-bench [-s sizeMiB] [-p compressiblePercent] [-b bandwidthMBps]
+ *        [-B remoteBufferKiB] [-t timeoutSec] [-c corruptPercent] [-w window,...]
+ *        [-a adaptive,...] [-k crc,...] [-z compress,...] [-l latencyMs,...] [-d dropPercent,...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUtils/ARUtils.h>
+#include <libARUpdater/ARUpdater.h>
+#include <libmux-update.h>
+
+#include "ARUPDATER_Manager.h"
+#include "ARUPDATER_Uploader.h"
+#include "ARUPDATER_Plf.h"
+#include "muxStandIn.h"
+
+#define MUX_BENCH_TAG           "MuxUpdateBench"
+#define MUX_BENCH_MAX_VALUES    16
+#define MUX_BENCH_PRODUCT       ARDISCOVERY_PRODUCT_SKYCONTROLLER
+/* remote capabilities: chunks of any size, chunk crcs, compressed chunks, selective acks */
+#define MUX_BENCH_CAPS_FLAGS    (0x2 | 0x8 | 0x10)
+#define MUX_BENCH_REMOTE_WINDOW 16
+
+typedef struct
+{
+    ARUPDATER_Manager_t *manager;
+    eARUPDATER_ERROR error;
+    int isDone;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} MuxBench_Run_t;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int parseList(const char *str, double *values)
+{
+    char *copy = strdup(str);
+    char *save = NULL;
+    char *token;
+    int count = 0;
+
+    for (token = strtok_r(copy, ",", &save); (token != NULL) && (count < MUX_BENCH_MAX_VALUES); token = strtok_r(NULL, ",", &save))
+        values[count++] = atof(token);
+
+    free(copy);
+    return count;
+}
+
+/* the single section of a bench plf, its data follows up to the end of the file */
+static void writeSection(FILE *f, size_t size)
+{
+    uint32_t words[ARUPDATER_PLF_SECTION_HEADER_SIZE / 4] = { 1, (uint32_t)size, 0, 0, 0 };
+    size_t i;
+
+    for (i = 0; i < ARUPDATER_PLF_SECTION_HEADER_SIZE; i++)
+        fputc((words[i / 4] >> (8 * (i % 4))) & 0xff, f);
+}
+
+/* a plf with a production header, its version is read by the uploader */
+static int createPlf(const char *rootFolder, size_t size, double compressiblePercent)
+{
+    static const char text[] = "libARUpdater mux update benchmark ";
+    char path[512];
+    plf_phdr_t header;
+    char *buffer;
+    size_t i, len;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(MUX_BENCH_PRODUCT));
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x/bench.plf", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(MUX_BENCH_PRODUCT));
+
+    f = fopen(path, "wb");
+    buffer = malloc(64 * 1024);
+    if ((f == NULL) || (buffer == NULL) || (size < sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE))
+    {
+        if (f != NULL)
+            fclose(f);
+        free(buffer);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = PLF_CURRENT_VERSION;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    header.p_ext = 1;
+    header.p_size = size;
+    fwrite(&header, 1, sizeof(header), f);
+    writeSection(f, size - sizeof(header) - ARUPDATER_PLF_SECTION_HEADER_SIZE);
+
+    /* the start of each block repeats a text, the rest is random */
+    for (i = 0; i < 64 * 1024; i++)
+        buffer[i] = (i < 64 * 1024 * compressiblePercent / 100) ? text[i % (sizeof(text) - 1)] : (char)rand();
+    for (i = sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE; i < size; i += len)
+    {
+        len = (size - i < 64 * 1024) ? size - i : 64 * 1024;
+        fwrite(buffer, 1, len, f);
+    }
+
+    fclose(f);
+    free(buffer);
+    return 0;
+}
+
+static void progressCallback(void *arg, float percent)
+{
+}
+
+static void completionCallback(void *arg, eARUPDATER_ERROR error)
+{
+}
+
+static void *runThread(void *arg)
+{
+    MuxBench_Run_t *run = arg;
+    eARUPDATER_ERROR error = ARUPDATER_Uploader_OpenPlf(run->manager->uploader);
+
+    /* ARUPDATER_Uploader_ThreadRun opens the plf before it runs a transport */
+    if (error == ARUPDATER_OK)
+        error = ARUPDATER_Uploader_ThreadRunMux(run->manager);
+    ARUPDATER_Plf_Close(&run->manager->uploader->plf);
+
+    pthread_mutex_lock(&run->lock);
+    run->error = error;
+    run->isDone = 1;
+    pthread_cond_signal(&run->cond);
+    pthread_mutex_unlock(&run->lock);
+    return NULL;
+}
+
+/* runs the update, canceled after timeout seconds */
+static eARUPDATER_ERROR runUpdate(ARUPDATER_Manager_t *manager, int timeout, int *timedOut)
+{
+    MuxBench_Run_t run;
+    struct timespec deadline;
+    pthread_t thread;
+
+    memset(&run, 0, sizeof(run));
+    run.manager = manager;
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.cond, NULL);
+    *timedOut = 0;
+
+    if (pthread_create(&thread, NULL, runThread, &run) != 0)
+        return ARUPDATER_ERROR_SYSTEM;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout;
+    pthread_mutex_lock(&run.lock);
+    while (!run.isDone)
+    {
+        if ((pthread_cond_timedwait(&run.cond, &run.lock, &deadline) != 0) && !run.isDone)
+        {
+            *timedOut = 1;
+            pthread_mutex_unlock(&run.lock);
+            ARUPDATER_Uploader_CancelThread(manager);
+            pthread_mutex_lock(&run.lock);
+            while (!run.isDone)
+                pthread_cond_wait(&run.cond, &run.lock);
+        }
+    }
+    pthread_mutex_unlock(&run.lock);
+
+    pthread_join(thread, NULL);
+    pthread_cond_destroy(&run.cond);
+    pthread_mutex_destroy(&run.lock);
+    return run.error;
+}
+
+int main(int argc, char *argv[])
+{
+    double windows[MUX_BENCH_MAX_VALUES] = { 1, 4, 8 };
+    double adaptives[MUX_BENCH_MAX_VALUES] = { 0, 1 };
+    double crcs[MUX_BENCH_MAX_VALUES] = { 0 };
+    double compressions[MUX_BENCH_MAX_VALUES] = { 0 };
+    double latencies[MUX_BENCH_MAX_VALUES] = { 1, 10, 50 };
+    double drops[MUX_BENCH_MAX_VALUES] = { 0, 1 };
+    int windowCount = 3, adaptiveCount = 2, crcCount = 1, compressionCount = 1, latencyCount = 3, dropCount = 2;
+    double sizeMiB = 16, compressiblePercent = 50, bandwidth = 20, bufferKiB = 2048, corruptPercent = 0;
+    int timeout = 60;
+    char rootFolder[] = "/tmp/arupdater-mux-bench-local-XXXXXX";
+    char remoteFolder[] = "/tmp/arupdater-mux-bench-remote-XXXXXX";
+    eARSAL_ERROR arsalError = ARSAL_OK;
+    eARUTILS_ERROR ftpError = ARUTILS_OK;
+    ARSAL_MD5_Manager_t *md5Manager = NULL;
+    ARUTILS_Manager_t *ftpManager = NULL;
+    ARUPDATER_Manager_t *manager = NULL;
+    ARUPDATER_Uploader_MuxStats_t stats;
+    MuxStandIn_Config_t config;
+    MuxStandIn_Counters_t counters;
+    struct mux_ctx *mux = NULL;
+    eARUPDATER_ERROR error;
+    int failed = 0;
+    int opt, run, runCount, w, a, k, z, l, d, timedOut, expected;
+    double start, elapsed;
+    char cmd[600];
+
+    while ((opt = getopt(argc, argv, "s:p:b:B:t:c:w:a:k:z:l:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            sizeMiB = atof(optarg);
+            break;
+        case 'p':
+            compressiblePercent = atof(optarg);
+            break;
+        case 'b':
+            bandwidth = atof(optarg);
+            break;
+        case 'B':
+            bufferKiB = atof(optarg);
+            break;
+        case 't':
+            timeout = atoi(optarg);
+            break;
+        case 'c':
+            corruptPercent = atof(optarg);
+            break;
+        case 'w':
+            windowCount = parseList(optarg, windows);
+            break;
+        case 'a':
+            adaptiveCount = parseList(optarg, adaptives);
+            break;
+        case 'k':
+            crcCount = parseList(optarg, crcs);
+            break;
+        case 'z':
+            compressionCount = parseList(optarg, compressions);
+            break;
+        case 'l':
+            latencyCount = parseList(optarg, latencies);
+            break;
+        case 'd':
+            dropCount = parseList(optarg, drops);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s sizeMiB] [-p compressiblePercent] [-b bandwidthMBps] [-B remoteBufferKiB] "
+                    "[-t timeoutSec] [-c corruptPercent] [-w window,...] [-a adaptive,...] [-k crc,...] "
+                    "[-z compress,...] [-l latencyMs,...] [-d dropPercent,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((mkdtemp(rootFolder) == NULL) || (mkdtemp(remoteFolder) == NULL))
+        return 1;
+
+    md5Manager = ARSAL_MD5_Manager_New(&arsalError);
+    if (arsalError == ARSAL_OK)
+        arsalError = ARSAL_MD5_Manager_Init(md5Manager);
+    /* the ftp is not used by mux updates */
+    ftpManager = ARUTILS_Manager_New(&ftpError);
+    memset(&config, 0, sizeof(config));
+    mux = MuxStandIn_New(remoteFolder, &config);
+    if ((arsalError != ARSAL_OK) || (ftpError != ARUTILS_OK) || (mux == NULL) ||
+        (createPlf(rootFolder, (size_t)(sizeMiB * 1024 * 1024), compressiblePercent) != 0))
+    {
+        failed = 1;
+        goto out;
+    }
+
+    printf("%6s %8s %3s %3s %8s %7s %8s %10s %10s %8s %7s %7s %5s %5s %6s %s\n", "window", "adaptive", "crc", "zip",
+           "lat(ms)", "drop(%)", "MB/s", "chunk(KiB)", "range(KiB)", "rtt(ms)", "sent", "resent", "nack", "dup", "ratio",
+           "result");
+
+    /* every combination, the last option varying first */
+    runCount = windowCount * adaptiveCount * crcCount * compressionCount * latencyCount * dropCount;
+    for (run = 0; run < runCount; run++)
+    {
+        d = run % dropCount;
+        l = (run / dropCount) % latencyCount;
+        z = (run / (dropCount * latencyCount)) % compressionCount;
+        k = (run / (dropCount * latencyCount * compressionCount)) % crcCount;
+        a = (run / (dropCount * latencyCount * compressionCount * crcCount)) % adaptiveCount;
+        w = run / (dropCount * latencyCount * compressionCount * crcCount * adaptiveCount);
+
+        config.latencyMs = (int)latencies[l];
+        config.bandwidth = bandwidth * 1024 * 1024;
+        config.dropPercent = drops[d];
+        config.corruptPercent = corruptPercent;
+        config.window = MUX_BENCH_REMOTE_WINDOW;
+        config.capsFlags = MUX_BENCH_CAPS_FLAGS;
+        config.bufferSize = (uint32_t)(bufferKiB * 1024);
+        config.resetAfterBytes = 0;
+        MuxStandIn_SetConfig(mux, &config);
+
+        manager = ARUPDATER_Manager_New(&error);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_New(manager, rootFolder, mux, ftpManager, md5Manager, 0, MUX_BENCH_PRODUCT,
+                                           progressCallback, NULL, completionCallback, NULL);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_SetMuxWindow(manager, (int)windows[w]);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_SetMuxChunkAdaptive(manager, (int)adaptives[a]);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_SetMuxChunkCrc(manager, (int)crcs[k]);
+        if (error == ARUPDATER_OK)
+            error = ARUPDATER_Uploader_SetMuxCompression(manager, (int)compressions[z]);
+
+        timedOut = 0;
+        start = nowSec();
+        if (error == ARUPDATER_OK)
+            error = runUpdate(manager, timeout, &timedOut);
+        elapsed = nowSec() - start;
+
+        memset(&stats, 0, sizeof(stats));
+        if (manager != NULL)
+        {
+            ARUPDATER_Uploader_GetMuxStats(manager, &stats);
+            ARUPDATER_Manager_Delete(&manager);
+        }
+        MuxStandIn_GetCounters(mux, MUX_UPDATE_CHANNEL_ID_UPDATE, &counters);
+
+        printf("%6d %8d %3d %3d %8d %7.2f %8.2f %10u %4u-%-5u %8u %7u %7u %5u %5u %6.2f %s\n", (int)windows[w],
+               (int)adaptives[a], (int)crcs[k], (int)compressions[z], (int)latencies[l], drops[d],
+               (error == ARUPDATER_OK) ? sizeMiB / elapsed : 0, stats.chunkSize / 1024, stats.chunkSizeMin / 1024,
+               stats.chunkSizeMax / 1024, stats.rttSmoothedMs, stats.chunksSent, stats.retransmissions, stats.nacks,
+               counters.chunksDuplicated, (stats.bytesOnLink > 0) ? (double)stats.bytesSent / stats.bytesOnLink : 0,
+               timedOut ? "timeout" : ARUPDATER_Error_ToString(error));
+        fflush(stdout);
+
+        /* stop-and-wait has no retransmission, a loss stalls it, and without chunk crcs a corrupted chunk is
+         * only found by the md5 of the whole image */
+        expected = (timedOut && (windows[w] <= 1) && (drops[d] > 0)) ||
+            (!timedOut && (crcs[k] == 0) && (counters.chunksCorrupted > 0));
+        if ((error != ARUPDATER_OK) && !expected)
+            failed = 1;
+    }
+
+out:
+    MuxStandIn_Delete(&mux);
+    if (ftpManager != NULL)
+        ARUTILS_Manager_Delete(&ftpManager);
+    ARSAL_MD5_Manager_Delete(&md5Manager);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", rootFolder, remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, MUX_BENCH_TAG, "can't remove the bench folders");
+
+    return failed;
+}
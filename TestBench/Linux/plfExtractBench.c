@@ -0,0 +1,168 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file plfExtractBench.c
+ * @brief libARUpdater TestBench extraction of U_UNIXFILE files from a plf
+ * @details Extracts the given files of a plf with ARUPDATER_Utils_ExtractUnixFileFromPlf
+ * over several rounds, and reports the time per file of the first one, which indexes
+ * the sections of the plf, and of the next ones, which find the files in the index.
+ * With -b, each round extracts all the files with one ARUPDATER_Utils_ExtractUnixFilesFromPlf call,
+ * and the names can be patterns. With -m, the files are opened in memory with
+ * ARUPDATER_Utils_OpenUnixFileFromPlf and read, nothing is written in outFolder.
+ * usage: tst-arupdater-plf-extract-bench [-r rounds] [-b|-m] plfFile outFolder unixFileName...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUpdater/ARUpdater.h>
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define PLF_EXTRACT_BENCH_FILE     0
+#define PLF_EXTRACT_BENCH_BATCH    1
+#define PLF_EXTRACT_BENCH_MEMORY   2
+
+static int extracted = 0;
+static unsigned int checksum = 0;
+
+static void extractCallback(void *arg, const char *unixFileName, eARUPDATER_ERROR error)
+{
+    if (error == ARUPDATER_OK)
+        extracted++;
+    else
+        fprintf(stderr, "%s: %s\n", unixFileName, ARUPDATER_Error_ToString(error));
+}
+
+/* the data is read, as a caller of the memory extraction would */
+static eARUPDATER_ERROR readFile(const char *plfFile, const char *name)
+{
+    ARUPDATER_PlfFileView *view = NULL;
+    const unsigned char *data = NULL;
+    size_t size = 0, i;
+    eARUPDATER_ERROR error;
+
+    error = ARUPDATER_Utils_OpenUnixFileFromPlf(plfFile, name, &view, (const void **)&data, &size);
+    if (error == ARUPDATER_OK)
+    {
+        for (i = 0; i < size; i++)
+            checksum += data[i];
+        ARUPDATER_Utils_CloseUnixFileFromPlf(&view);
+    }
+
+    return error;
+}
+
+/* returns the seconds spent extracting all the files once, -1 if one failed */
+static double runRound(const char *plfFile, const char *outFolder, char **names, int count, int mode)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    double start = nowSec();
+    int i;
+
+    if (mode == PLF_EXTRACT_BENCH_BATCH)
+    {
+        error = ARUPDATER_Utils_ExtractUnixFilesFromPlf(plfFile, outFolder, (const char * const *)names, count, extractCallback, NULL);
+    }
+    else
+    {
+        for (i = 0; (i < count) && (error == ARUPDATER_OK); i++)
+        {
+            if (mode == PLF_EXTRACT_BENCH_MEMORY)
+                error = readFile(plfFile, names[i]);
+            else
+                error = ARUPDATER_Utils_ExtractUnixFileFromPlf(plfFile, outFolder, names[i]);
+            extractCallback(NULL, names[i], error);
+        }
+    }
+
+    return (error == ARUPDATER_OK) ? nowSec() - start : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = 16;
+    double first, next = 0, sec;
+    int opt, r, count, perRound, mode = PLF_EXTRACT_BENCH_FILE;
+
+    while ((opt = getopt(argc, argv, "r:bm")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r':
+            rounds = atoi(optarg);
+            break;
+        case 'b':
+            mode = PLF_EXTRACT_BENCH_BATCH;
+            break;
+        case 'm':
+            mode = PLF_EXTRACT_BENCH_MEMORY;
+            break;
+        default:
+            rounds = 0;
+            break;
+        }
+    }
+
+    if ((argc - optind < 3) || (rounds < 2))
+    {
+        fprintf(stderr, "usage: %s [-r rounds] [-b|-m] plfFile outFolder unixFileName...\n", argv[0]);
+        return 1;
+    }
+    count = argc - optind - 2;
+
+    first = runRound(argv[optind], argv[optind + 1], &argv[optind + 2], count, mode);
+    perRound = extracted;
+    for (r = 1; (r < rounds) && (first >= 0); r++)
+    {
+        sec = runRound(argv[optind], argv[optind + 1], &argv[optind + 2], count, mode);
+        if (sec < 0)
+            return 1;
+        next += sec;
+    }
+    if ((first < 0) || (perRound == 0))
+        return 1;
+
+    printf("%d files per round\n", perRound);
+    printf("%10s %12s\n", "round", "ms/file");
+    printf("%10s %12.3f\n", "first", first * 1000 / perRound);
+    printf("%10s %12.3f\n", "next", next * 1000 / ((rounds - 1) * perRound));
+
+    return 0;
+}
@@ -0,0 +1,393 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file plfExtractTest.c
+ * @brief libARUpdater TestBench checks of the files read and extracted from a plf
+ * @details Writes a plf with a stored and a zlib compressed U_UNIXFILE file, and checks
+ * the content given by ARUPDATER_Utils_ReadUnixFileFromPlf, ARUPDATER_Utils_OpenUnixFileFromPlf,
+ * ARUPDATER_Utils_ExtractUnixFileFromPlf and ARUPDATER_Utils_ExtractUnixFilesFromPlf byte for byte,
+ * and the copy of a range of the plf with and without the kernel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUpdater/ARUpdater.h>
+
+#include "ARUPDATER_Plf.h"
+#include "ARUPDATER_Utils.h"
+
+#define PLF_EXTRACT_TEST_TAG            "PlfExtractTest"
+#define PLF_EXTRACT_TEST_U_UNIXFILE     9
+#define PLF_EXTRACT_TEST_FILE_COUNT     2
+#define PLF_EXTRACT_TEST_CODE_SIZE      1000
+
+typedef struct
+{
+    const char *path;                       /* path in the plf */
+    const char *name;                       /* last component of the path */
+    mode_t mode;
+    int isCompressed;
+    size_t size;
+    uint8_t *data;
+} PlfExtractTest_File_t;
+
+static PlfExtractTest_File_t files[PLF_EXTRACT_TEST_FILE_COUNT] =
+{
+    { "data/etc/config.txt", "config.txt", 0750, 0, 100001, NULL },
+    { "data/lib/calib.bin", "calib.bin", 0640, 1, 200003, NULL },
+};
+
+static void writeWord(FILE *f, uint32_t word)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        fputc((word >> (8 * i)) & 0xff, f);
+}
+
+static void writeSection(FILE *f, uint32_t type, const uint8_t *data, uint32_t size, uint32_t uncompressedSize)
+{
+    uint32_t i;
+
+    writeWord(f, type);
+    writeWord(f, size);
+    writeWord(f, 0);
+    writeWord(f, 0);
+    writeWord(f, uncompressedSize);
+    fwrite(data, 1, size, f);
+    for (i = size; (i % ARUPDATER_PLF_SECTION_ALIGN) != 0; i++)
+        fputc(0, f);
+}
+
+/* a code section, then the U_UNIXFILE sections: unix header, path, data */
+static int createPlf(const char *path)
+{
+    plf_phdr_t header;
+    uint8_t code[PLF_EXTRACT_TEST_CODE_SIZE];
+    uint8_t *content = NULL;
+    uint8_t *compressed = NULL;
+    uLongf compressedSize;
+    size_t contentSize, pathSize;
+    FILE *f = fopen(path, "wb");
+    int i, ret = 0;
+
+    if (f == NULL)
+        return -1;
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = 10;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    fwrite(&header, 1, sizeof(header), f);
+
+    memset(code, 0xa5, sizeof(code));
+    writeSection(f, 3, code, sizeof(code), 0);
+
+    for (i = 0; (ret == 0) && (i < PLF_EXTRACT_TEST_FILE_COUNT); i++)
+    {
+        pathSize = strlen(files[i].path) + 1;
+        contentSize = 16 + pathSize + files[i].size;
+        content = malloc(contentSize);
+        compressedSize = compressBound(contentSize);
+        compressed = malloc(compressedSize);
+        if ((content == NULL) || (compressed == NULL))
+        {
+            ret = -1;
+        }
+        else
+        {
+            /* s_mode, s_uid, s_gid, s_mtime, little endian */
+            memset(content, 0, 16);
+            content[0] = (S_IFREG | files[i].mode) & 0xff;
+            content[1] = ((S_IFREG | files[i].mode) >> 8) & 0xff;
+            memcpy(content + 16, files[i].path, pathSize);
+            memcpy(content + 16 + pathSize, files[i].data, files[i].size);
+
+            if (!files[i].isCompressed)
+                writeSection(f, PLF_EXTRACT_TEST_U_UNIXFILE, content, contentSize, 0);
+            else if (compress(compressed, &compressedSize, content, contentSize) == Z_OK)
+                writeSection(f, PLF_EXTRACT_TEST_U_UNIXFILE, compressed, compressedSize, contentSize);
+            else
+                ret = -1;
+        }
+        free(content);
+        free(compressed);
+    }
+
+    fclose(f);
+    return ret;
+}
+
+static int sameContent(const PlfExtractTest_File_t *file, const void *data, size_t size)
+{
+    return (size == file->size) && (memcmp(data, file->data, size) == 0);
+}
+
+static int sameFile(const PlfExtractTest_File_t *file, const char *folder, int checkMode)
+{
+    char path[512];
+    struct stat st;
+    uint8_t *data;
+    FILE *f;
+    int same = 0;
+
+    snprintf(path, sizeof(path), "%s/%s", folder, file->name);
+    f = fopen(path, "rb");
+    data = malloc(file->size + 1);
+    if ((f != NULL) && (data != NULL) && (fstat(fileno(f), &st) == 0))
+    {
+        same = (fread(data, 1, file->size + 1, f) == file->size) && sameContent(file, data, file->size);
+        /* a stored file is copied by the library, with its mode */
+        if (checkMode && ((st.st_mode & 0777) != file->mode))
+        {
+            fprintf(stderr, "%s: mode %o instead of %o\n", path, (unsigned int)(st.st_mode & 0777), (unsigned int)file->mode);
+            same = 0;
+        }
+    }
+
+    if (f != NULL)
+        fclose(f);
+    free(data);
+    unlink(path);
+    return same;
+}
+
+static int report(const char *name, int ok, eARUPDATER_ERROR error)
+{
+    fprintf(stderr, "%s: %s (%s)\n", name, ok ? "PASS" : "FAIL", ARUPDATER_Error_ToString(error));
+    return ok;
+}
+
+static int testRead(const char *plfPath)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    uint8_t *buffer = NULL;
+    size_t size = 0;
+    int i, ok = 1;
+
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+    {
+        buffer = malloc(files[i].size);
+        error = ARUPDATER_Utils_ReadUnixFileFromPlf(plfPath, files[i].name, buffer, files[i].size, &size);
+        ok = ok && (buffer != NULL) && (error == ARUPDATER_OK) && sameContent(&files[i], buffer, size);
+
+        /* one byte short: the error gives the size to allocate */
+        size = 0;
+        error = ARUPDATER_Utils_ReadUnixFileFromPlf(plfPath, files[i].name, buffer, files[i].size - 1, &size);
+        ok = ok && (error == ARUPDATER_ERROR_MANAGER_BUFFER_TOO_SMALL) && (size == files[i].size);
+
+        size = 0;
+        error = ARUPDATER_Utils_ReadUnixFileFromPlf(plfPath, files[i].name, NULL, 0, &size);
+        ok = ok && (error == ARUPDATER_ERROR_MANAGER_BUFFER_TOO_SMALL) && (size == files[i].size);
+        free(buffer);
+    }
+
+    error = ARUPDATER_Utils_ReadUnixFileFromPlf(plfPath, "missing.txt", NULL, 0, &size);
+    ok = ok && (error == ARUPDATER_ERROR_PLF);
+
+    return report("read into a buffer", ok, error);
+}
+
+static int testOpen(const char *plfPath)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    ARUPDATER_PlfFileView *view = NULL;
+    const void *data = NULL;
+    size_t size = 0;
+    int i, ok = 1;
+
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+    {
+        error = ARUPDATER_Utils_OpenUnixFileFromPlf(plfPath, files[i].name, &view, &data, &size);
+        ok = ok && (error == ARUPDATER_OK) && (view != NULL) && sameContent(&files[i], data, size);
+        ARUPDATER_Utils_CloseUnixFileFromPlf(&view);
+        ok = ok && (view == NULL);
+    }
+
+    error = ARUPDATER_Utils_OpenUnixFileFromPlf(plfPath, "missing.txt", &view, &data, &size);
+    ok = ok && (error == ARUPDATER_ERROR_PLF) && (view == NULL);
+
+    return report("open in memory", ok, error);
+}
+
+static int testExtract(const char *plfPath, const char *folder)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    int i, ok = 1;
+
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+    {
+        error = ARUPDATER_Utils_ExtractUnixFileFromPlf(plfPath, folder, files[i].name);
+        ok = ok && (error == ARUPDATER_OK) && sameFile(&files[i], folder, !files[i].isCompressed);
+    }
+
+    error = ARUPDATER_Utils_ExtractUnixFileFromPlf(plfPath, folder, "missing.txt");
+    ok = ok && (error == ARUPDATER_ERROR_PLF);
+
+    return report("extract one file", ok, error);
+}
+
+typedef struct
+{
+    int extracted;
+    int failed;
+    const char *failedName;
+} PlfExtractTest_Results_t;
+
+static void extractCallback(void *arg, const char *unixFileName, eARUPDATER_ERROR error)
+{
+    PlfExtractTest_Results_t *results = arg;
+
+    if (error == ARUPDATER_OK)
+    {
+        results->extracted++;
+    }
+    else
+    {
+        results->failed++;
+        results->failedName = unixFileName;
+    }
+}
+
+static int testExtractMany(const char *plfPath, const char *folder)
+{
+    const char *names[] = { "*.txt", "calib.bin", "*.missing" };
+    PlfExtractTest_Results_t results;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    int i, ok = 1;
+
+    /* every name matches */
+    memset(&results, 0, sizeof(results));
+    error = ARUPDATER_Utils_ExtractUnixFilesFromPlf(plfPath, folder, names, 2, extractCallback, &results);
+    ok = (error == ARUPDATER_OK) && (results.extracted == PLF_EXTRACT_TEST_FILE_COUNT) && (results.failed == 0);
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+        ok = ok && sameFile(&files[i], folder, !files[i].isCompressed);
+
+    /* a pattern that matches nothing fails, the others are still extracted */
+    memset(&results, 0, sizeof(results));
+    error = ARUPDATER_Utils_ExtractUnixFilesFromPlf(plfPath, folder, names, 3, extractCallback, &results);
+    ok = ok && (error == ARUPDATER_ERROR_PLF) && (results.extracted == PLF_EXTRACT_TEST_FILE_COUNT) &&
+         (results.failed == 1) && (results.failedName != NULL) && (strcmp(results.failedName, "*.missing") == 0);
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+        ok = ok && sameFile(&files[i], folder, !files[i].isCompressed);
+
+    return report("extract files by name and pattern", ok, error);
+}
+
+/* the stored file, copied from the mapped plf as the extraction does */
+static int testCopyRange(const char *plfPath, const char *folder)
+{
+    char outPath[512];
+    const uint8_t *mapped = MAP_FAILED;
+    /* after the header, the code section, and the unix header and path of the file */
+    off_t offset = sizeof(plf_phdr_t) + 2 * ARUPDATER_PLF_SECTION_HEADER_SIZE + PLF_EXTRACT_TEST_CODE_SIZE + 16 + strlen(files[0].path) + 1;
+    struct stat st;
+    int in, out;
+    int pass, ok = 1;
+
+    snprintf(outPath, sizeof(outPath), "%s/%s", folder, files[0].name);
+    in = open(plfPath, O_RDONLY);
+    if ((in >= 0) && (fstat(in, &st) == 0))
+        mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, in, 0);
+    ok = (mapped != MAP_FAILED);
+
+    /* in the kernel, then with a descriptor the kernel can't copy from: written from the mapping */
+    for (pass = 0; ok && (pass < 2); pass++)
+    {
+        out = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, files[0].mode);
+        ok = (out >= 0);
+        if (ok)
+        {
+            ok = (ARUPDATER_Utils_CopyRange((pass == 0) ? in : -1, mapped, offset, out, files[0].size) == 0);
+            close(out);
+        }
+        ok = ok && sameFile(&files[0], folder, 1);
+    }
+
+    if (mapped != MAP_FAILED)
+        munmap((void *)mapped, st.st_size);
+    if (in >= 0)
+        close(in);
+
+    return report("copy a range of the plf", ok, ok ? ARUPDATER_OK : ARUPDATER_ERROR_SYSTEM);
+}
+
+int main(int argc, char *argv[])
+{
+    char folder[] = "/tmp/arupdater_extractXXXXXX";
+    char plfPath[256];
+    int failures = 0;
+    size_t j;
+    int i;
+
+    if (mkdtemp(folder) == NULL)
+        return 1;
+    snprintf(plfPath, sizeof(plfPath), "%s/test.plf", folder);
+
+    /* the file modes are checked as written in the plf */
+    umask(0);
+
+    /* random data for the stored file, compressible data for the other one */
+    srand(1);
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+    {
+        files[i].data = malloc(files[i].size);
+        if (files[i].data == NULL)
+            return 1;
+        for (j = 0; j < files[i].size; j++)
+            files[i].data[j] = files[i].isCompressed ? (uint8_t)((j / 64) + (j % 7)) : (uint8_t)rand();
+    }
+
+    if (createPlf(plfPath) != 0)
+        return 1;
+
+    failures += !testRead(plfPath);
+    failures += !testOpen(plfPath);
+    failures += !testExtract(plfPath, folder);
+    failures += !testExtractMany(plfPath, folder);
+    failures += !testCopyRange(plfPath, folder);
+
+    unlink(plfPath);
+    rmdir(folder);
+    for (i = 0; i < PLF_EXTRACT_TEST_FILE_COUNT; i++)
+        free(files[i].data);
+
+    return (failures == 0) ? 0 : 1;
+}
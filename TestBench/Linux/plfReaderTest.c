@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file plfReaderTest.c
+ * @brief libARUpdater TestBench checks of the plf reader on valid and broken files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <libARSAL/ARSAL.h>
+
+#include <libARUpdater/ARUpdater.h>
+#include "ARUPDATER_Plf.h"
+
+#define PLF_READER_TEST_TAG         "PlfReaderTest"
+#define PLF_READER_TEST_SECTIONS    3
+
+/* ways to break the plf written by createPlf() */
+typedef enum
+{
+    PLF_READER_TEST_VALID = 0,
+    PLF_READER_TEST_BAD_MAGIC,
+    PLF_READER_TEST_BAD_HEADER_SIZE,
+    PLF_READER_TEST_BAD_SECTION_HEADER_SIZE,
+    PLF_READER_TEST_TRUNCATED_HEADER,
+    PLF_READER_TEST_TRUNCATED_SECTION,
+    PLF_READER_TEST_TRAILER,
+} ePLF_READER_TEST_CASE;
+
+static void writeWord(FILE *f, uint32_t word)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        fputc((word >> (8 * i)) & 0xff, f);
+}
+
+static int createPlf(const char *path, ePLF_READER_TEST_CASE testCase)
+{
+    plf_phdr_t header;
+    FILE *f = fopen(path, "wb");
+    uint32_t size;
+    uint32_t i, j;
+
+    if (f == NULL)
+        return -1;
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = (testCase == PLF_READER_TEST_BAD_MAGIC) ? 0x12345678 : PLF_HEADER_MAGIC;
+    header.p_plfversion = 10;
+    header.p_phdrsize = (testCase == PLF_READER_TEST_BAD_HEADER_SIZE) ? sizeof(header) - 4 : sizeof(header);
+    header.p_shdrsize = (testCase == PLF_READER_TEST_BAD_SECTION_HEADER_SIZE) ? ARUPDATER_PLF_SECTION_HEADER_SIZE - 4 : ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_ver = 4;
+    header.p_edit = 2;
+    header.p_ext = 1;
+
+    if (testCase == PLF_READER_TEST_TRUNCATED_HEADER)
+    {
+        fwrite(&header, 1, sizeof(header) / 2, f);
+        fclose(f);
+        return 0;
+    }
+    fwrite(&header, 1, sizeof(header), f);
+
+    /* sections of sizes that need padding */
+    for (i = 0; i < PLF_READER_TEST_SECTIONS; i++)
+    {
+        size = 1000 + i * 333;
+        writeWord(f, 1);
+        writeWord(f, size);
+        writeWord(f, 0);
+        writeWord(f, 0);
+        writeWord(f, 0);
+
+        if ((testCase == PLF_READER_TEST_TRUNCATED_SECTION) && (i == PLF_READER_TEST_SECTIONS - 1))
+            size /= 2;
+        for (j = 0; j < size; j++)
+            fputc((int)(i + j), f);
+        for (; (j % ARUPDATER_PLF_SECTION_ALIGN) != 0; j++)
+            fputc(0, f);
+    }
+
+    if (testCase == PLF_READER_TEST_TRAILER)
+        fwrite("end", 1, 3, f);
+
+    fclose(f);
+    return 0;
+}
+
+static int runCase(const char *path, ePLF_READER_TEST_CASE testCase, const char *name, eARUPDATER_ERROR expected)
+{
+    ARUPDATER_Plf_t plf;
+    ARUPDATER_PlfVersion version;
+    eARUPDATER_ERROR openError = ARUPDATER_ERROR;
+    eARUPDATER_ERROR versionError = ARUPDATER_ERROR;
+    int ok = 0;
+
+    if (createPlf(path, testCase) == 0)
+    {
+        openError = ARUPDATER_Plf_Open(&plf, path, 64 * 1024);
+        ok = (openError == expected);
+        if (openError == ARUPDATER_OK)
+        {
+            ok = ok && (plf.sectionCount == PLF_READER_TEST_SECTIONS) && (plf.sections[1].size == 1333) &&
+                 (plf.sections[1].offset == sizeof(plf_phdr_t) + 2 * ARUPDATER_PLF_SECTION_HEADER_SIZE + 1000);
+            ARUPDATER_Plf_Close(&plf);
+        }
+        ok = ok && !ARUPDATER_Plf_IsOpen(&plf);
+
+        /* the version check of the manager and downloader goes through the same reader */
+        memset(&version, 0, sizeof(version));
+        versionError = ARUPDATER_Utils_ReadPlfVersion(path, &version);
+        ok = ok && (versionError == expected);
+        if (versionError == ARUPDATER_OK)
+            ok = ok && (version.ver == 4) && (version.edit == 2) && (version.ext == 1) && (version.type == ARUPDATER_PLF_TYPE_PROD);
+    }
+
+    fprintf(stderr, "%s: %s (open: %s, version: %s)\n", name, ok ? "PASS" : "FAIL",
+            ARUPDATER_Error_ToString(openError), ARUPDATER_Error_ToString(versionError));
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    char folder[] = "/tmp/arupdater_plfXXXXXX";
+    char path[256];
+    ARUPDATER_Plf_t plf;
+    int failures = 0;
+
+    if (mkdtemp(folder) == NULL)
+        return 1;
+    snprintf(path, sizeof(path), "%s/test.plf", folder);
+
+    failures += !runCase(path, PLF_READER_TEST_VALID, "valid plf", ARUPDATER_OK);
+    failures += !runCase(path, PLF_READER_TEST_TRAILER, "bytes after the last section", ARUPDATER_OK);
+    failures += !runCase(path, PLF_READER_TEST_BAD_MAGIC, "bad magic", ARUPDATER_ERROR_PLF);
+    failures += !runCase(path, PLF_READER_TEST_BAD_HEADER_SIZE, "bad header size", ARUPDATER_ERROR_PLF);
+    failures += !runCase(path, PLF_READER_TEST_BAD_SECTION_HEADER_SIZE, "bad section header size", ARUPDATER_ERROR_PLF);
+    failures += !runCase(path, PLF_READER_TEST_TRUNCATED_HEADER, "truncated header", ARUPDATER_ERROR_PLF);
+    failures += !runCase(path, PLF_READER_TEST_TRUNCATED_SECTION, "truncated section", ARUPDATER_ERROR_PLF);
+
+    unlink(path);
+    if (ARUPDATER_Plf_Open(&plf, path, 64 * 1024) != ARUPDATER_ERROR_PLF_FILE_NOT_FOUND)
+    {
+        fprintf(stderr, "missing file: FAIL\n");
+        failures++;
+    }
+
+    rmdir(folder);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file segmentedUploadTest.c
+ * @brief libARUpdater TestBench segmented ftp upload against a local ftp stand-in
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libARSAL/ARSAL.h>
+
+#include "ARUPDATER_Ftp.h"
+#include "ARUPDATER_FtpSegments.h"
+#include "ftpStandIn.h"
+
+#define SEGMENTED_TEST_TAG          "SegmentedUploadTest"
+#define SEGMENTED_TEST_FILE_SIZE    (5*1024*1024 + 333)
+#define SEGMENTED_TEST_SEGMENTS     4
+
+static char localPath[256];
+static char remoteFolder[256];
+static char remotePath[512];
+
+static int createFile(const char *path, size_t size, unsigned int seed)
+{
+    FILE *f = fopen(path, "wb");
+    size_t i;
+
+    if (f == NULL)
+        return -1;
+
+    srand(seed);
+    for (i = 0; i < size; i++)
+        fputc(rand() & 0xff, f);
+
+    fclose(f);
+    return 0;
+}
+
+static int sameFiles(const char *path1, const char *path2)
+{
+    FILE *f1 = fopen(path1, "rb");
+    FILE *f2 = fopen(path2, "rb");
+    int c1, c2;
+    int same = (f1 != NULL) && (f2 != NULL);
+
+    while (same)
+    {
+        c1 = fgetc(f1);
+        c2 = fgetc(f2);
+        if (c1 != c2)
+            same = 0;
+        else if (c1 == EOF)
+            break;
+    }
+
+    if (f1 != NULL)
+        fclose(f1);
+    if (f2 != NULL)
+        fclose(f2);
+    return same;
+}
+
+static void progressCallback(void *arg, uint64_t done, uint64_t total)
+{
+    uint64_t *last = arg;
+
+    if (done < *last)
+        fprintf(stderr, "progress went backwards: %llu < %llu\n", (unsigned long long)done, (unsigned long long)*last);
+    *last = done;
+}
+
+static int runUpload(int refuseRest, uint64_t offset, const char *name)
+{
+    FtpStandIn_t *server = NULL;
+    ARUPDATER_FtpSegments_t *segments = NULL;
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    uint64_t lastProgress = 0;
+    struct stat st;
+    int ok = 0;
+
+    if (stat(localPath, &st) != 0)
+        return 0;
+
+    server = FtpStandIn_Start(remoteFolder, refuseRest);
+    if (server != NULL)
+    {
+        segments = ARUPDATER_FtpSegments_New("127.0.0.1", FtpStandIn_GetPort(server), NULL, NULL, SEGMENTED_TEST_SEGMENTS, progressCallback, &lastProgress, &error);
+    }
+
+    if (segments != NULL)
+    {
+        error = ARUPDATER_FtpSegments_Upload(segments, "/plf.tmp", localPath, offset);
+        ok = (error == ARUPDATER_OK) && (lastProgress == (uint64_t)st.st_size) && sameFiles(localPath, remotePath);
+    }
+
+    fprintf(stderr, "%s: %s (%s)\n", name, ok ? "PASS" : "FAIL", ARUPDATER_Error_ToString(error));
+
+    ARUPDATER_FtpSegments_Delete(&segments);
+    FtpStandIn_Stop(&server);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    char folder[] = "/tmp/arupdater_segXXXXXX";
+    char command[512];
+    int failures = 0;
+
+    if (mkdtemp(folder) == NULL)
+        return 1;
+
+    snprintf(localPath, sizeof(localPath), "%s/local.plf", folder);
+    snprintf(remoteFolder, sizeof(remoteFolder), "%s/remote", folder);
+    snprintf(remotePath, sizeof(remotePath), "%s/plf.tmp", remoteFolder);
+    snprintf(command, sizeof(command), "mkdir -p %s", remoteFolder);
+    if ((system(command) != 0) || (createFile(localPath, SEGMENTED_TEST_FILE_SIZE, 1) != 0))
+        return 1;
+
+    /* new upload */
+    failures += !runUpload(0, 0, "new segmented upload");
+
+    /* resume: only the first 2 MiB are on the server */
+    if (truncate(remotePath, 2*1024*1024) != 0)
+        return 1;
+    failures += !runUpload(0, 2*1024*1024, "resumed segmented upload");
+
+    /* server without REST: a stale, longer remote file must be replaced */
+    createFile(remotePath, SEGMENTED_TEST_FILE_SIZE + 4096, 2);
+    failures += !runUpload(1, 1024*1024, "fallback to a single stream");
+
+    /* a file too small to be split */
+    createFile(localPath, 1000, 3);
+    unlink(remotePath);
+    failures += !runUpload(0, 0, "small file");
+
+    snprintf(command, sizeof(command), "rm -rf %s", folder);
+    if (system(command) != 0)
+        fprintf(stderr, "can't remove %s\n", folder);
+
+    return (failures == 0) ? 0 : 1;
+}
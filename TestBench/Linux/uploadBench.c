@@ -0,0 +1,362 @@
+/*
+    Copyright (C) 2014 Parrot SA
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions
+    are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the 
+      distribution.
+    * Neither the name of Parrot nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+    FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+    COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+    INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+    BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+    OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED 
+    AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+    OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+    OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+    SUCH DAMAGE.
+*/
+/**
+ * @file uploadBench.c
+ * @brief libARUpdater TestBench upload throughput benchmark against a local ftp stand-in
+ * @details Runs ARUPDATER_Uploader_ThreadRunNormal over a matrix of file sizes, round trip
+ * times and loss rates, and reports the throughput, the setup latency (until the first
+ * progress) and the cpu time of the uploader per MB. The server runs in a child process so
+ * its cpu time is not counted.
+ * usage: tst-arupdater-upload-bench [-d] [-s sizeKiB,...] [-r rttMs,...] [-l lossPercent,...]
+ * -d uses the direct ftp access (ARUPDATER_Uploader_SetFtpServer) instead of ARDataTransfer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <libARSAL/ARSAL.h>
+#include <libARUtils/ARUtils.h>
+#include <libARUpdater/ARUpdater.h>
+
+#include "ARUPDATER_Manager.h"
+#include "ARUPDATER_Uploader.h"
+#include "ARUPDATER_Plf.h"
+#include "ftpStandIn.h"
+
+#define UPLOAD_BENCH_TAG            "UploadBench"
+#define UPLOAD_BENCH_MAX_VALUES     16
+#define UPLOAD_BENCH_PRODUCT        ARDISCOVERY_PRODUCT_ARDRONE
+
+typedef struct
+{
+    double start;
+    double firstProgress;
+} UploadBench_Run_t;
+
+static double nowSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpuSec(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static int parseList(const char *str, double *values)
+{
+    char *copy = strdup(str);
+    char *save = NULL;
+    char *token;
+    int count = 0;
+
+    for (token = strtok_r(copy, ",", &save); (token != NULL) && (count < UPLOAD_BENCH_MAX_VALUES); token = strtok_r(NULL, ",", &save))
+        values[count++] = atof(token);
+
+    free(copy);
+    return count;
+}
+
+/* the single section of a bench plf, its data follows up to the end of the file */
+static void writeSection(FILE *f, size_t size)
+{
+    uint32_t words[ARUPDATER_PLF_SECTION_HEADER_SIZE / 4] = { 1, (uint32_t)size, 0, 0, 0 };
+    size_t i;
+
+    for (i = 0; i < ARUPDATER_PLF_SECTION_HEADER_SIZE; i++)
+        fputc((words[i / 4] >> (8 * (i % 4))) & 0xff, f);
+}
+
+static int createPlf(const char *rootFolder, size_t size)
+{
+    char path[512];
+    plf_phdr_t header;
+    char *buffer;
+    size_t i, len;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(UPLOAD_BENCH_PRODUCT));
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%s%04x/bench.plf", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER, ARDISCOVERY_getProductID(UPLOAD_BENCH_PRODUCT));
+
+    f = fopen(path, "wb");
+    buffer = malloc(64 * 1024);
+    if ((f == NULL) || (buffer == NULL) || (size < sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE))
+    {
+        if (f != NULL)
+            fclose(f);
+        free(buffer);
+        return -1;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.p_magic = PLF_HEADER_MAGIC;
+    header.p_plfversion = PLF_CURRENT_VERSION;
+    header.p_phdrsize = sizeof(header);
+    header.p_shdrsize = ARUPDATER_PLF_SECTION_HEADER_SIZE;
+    header.p_size = size;
+    fwrite(&header, 1, sizeof(header), f);
+    writeSection(f, size - sizeof(header) - ARUPDATER_PLF_SECTION_HEADER_SIZE);
+
+    for (i = 0; i < 64 * 1024; i++)
+        buffer[i] = (char)rand();
+    for (i = sizeof(header) + ARUPDATER_PLF_SECTION_HEADER_SIZE; i < size; i += len)
+    {
+        len = (size - i < 64 * 1024) ? size - i : 64 * 1024;
+        fwrite(buffer, 1, len, f);
+    }
+
+    fclose(f);
+    free(buffer);
+    return 0;
+}
+
+/* start the stand-in in a child process, returns its pid and port */
+static pid_t startServer(const char *remoteFolder, int rttMs, double lossPercent, int *port)
+{
+    int fds[2];
+    pid_t pid;
+
+    if (pipe(fds) < 0)
+        return -1;
+
+    pid = fork();
+    if (pid == 0)
+    {
+        FtpStandIn_t *server = FtpStandIn_Start(remoteFolder, 0);
+        int serverPort = (server != NULL) ? FtpStandIn_GetPort(server) : -1;
+
+        close(fds[0]);
+        if (server != NULL)
+            FtpStandIn_SetLink(server, rttMs, lossPercent);
+        if (write(fds[1], &serverPort, sizeof(serverPort)) != sizeof(serverPort))
+            serverPort = -1;
+        close(fds[1]);
+        /* killed by the parent */
+        while (serverPort >= 0)
+            pause();
+        _exit(1);
+    }
+
+    close(fds[1]);
+    if ((pid < 0) || (read(fds[0], port, sizeof(*port)) != sizeof(*port)) || (*port < 0))
+    {
+        if (pid > 0)
+        {
+            kill(pid, SIGTERM);
+            waitpid(pid, NULL, 0);
+        }
+        pid = -1;
+    }
+    close(fds[0]);
+
+    return pid;
+}
+
+static void progressCallback(void *arg, float percent)
+{
+    UploadBench_Run_t *run = arg;
+
+    if ((percent > 0) && (run->firstProgress == 0))
+        run->firstProgress = nowSec();
+}
+
+static void completionCallback(void *arg, eARUPDATER_ERROR error)
+{
+}
+
+static void cleanRemote(const char *remoteFolder)
+{
+    char cmd[600];
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s/*", remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, UPLOAD_BENCH_TAG, "can't clean %s", remoteFolder);
+}
+
+static eARUPDATER_ERROR runUpload(const char *rootFolder, ARSAL_MD5_Manager_t *md5Manager, int port, int direct, UploadBench_Run_t *run)
+{
+    eARUPDATER_ERROR error = ARUPDATER_OK;
+    eARUTILS_ERROR ftpError = ARUTILS_OK;
+    ARUPDATER_Manager_t *manager = NULL;
+    ARUTILS_Manager_t *ftpManager = NULL;
+
+    manager = ARUPDATER_Manager_New(&error);
+    if (error == ARUPDATER_OK)
+    {
+        ftpManager = ARUTILS_Manager_New(&ftpError);
+        if (ftpError == ARUTILS_OK)
+            ftpError = ARUTILS_Manager_InitWifiFtp(ftpManager, "127.0.0.1", port, "", "");
+        if (ftpError != ARUTILS_OK)
+            error = ARUPDATER_ERROR_UPLOADER_ARUTILS_ERROR;
+    }
+    if (error == ARUPDATER_OK)
+        error = ARUPDATER_Uploader_New(manager, rootFolder, NULL, ftpManager, md5Manager, 0, UPLOAD_BENCH_PRODUCT, progressCallback, run, completionCallback, NULL);
+    if ((error == ARUPDATER_OK) && direct)
+        error = ARUPDATER_Uploader_SetFtpServer(manager, "127.0.0.1", port, "", "");
+
+    /* ARUPDATER_Uploader_ThreadRun opens the plf before it runs a transport */
+    if (error == ARUPDATER_OK)
+        error = ARUPDATER_Uploader_OpenPlf(manager->uploader);
+
+    if (error == ARUPDATER_OK)
+    {
+        run->start = nowSec();
+        run->firstProgress = 0;
+        error = ARUPDATER_Uploader_ThreadRunNormal(manager);
+        ARUPDATER_Plf_Close(&manager->uploader->plf);
+    }
+
+    if (manager != NULL)
+        ARUPDATER_Manager_Delete(&manager);
+    if (ftpManager != NULL)
+    {
+        ARUTILS_Manager_CloseWifiFtp(ftpManager);
+        ARUTILS_Manager_Delete(&ftpManager);
+    }
+
+    return error;
+}
+
+int main(int argc, char *argv[])
+{
+    double sizes[UPLOAD_BENCH_MAX_VALUES] = { 1024, 16384, 65536 };
+    double rtts[UPLOAD_BENCH_MAX_VALUES] = { 0, 20, 100 };
+    double losses[UPLOAD_BENCH_MAX_VALUES] = { 0, 1 };
+    int sizeCount = 3, rttCount = 3, lossCount = 2;
+    char rootFolder[] = "/tmp/arupdater-bench-local-XXXXXX";
+    char remoteFolder[] = "/tmp/arupdater-bench-remote-XXXXXX";
+    eARSAL_ERROR arsalError = ARSAL_OK;
+    ARSAL_MD5_Manager_t *md5Manager = NULL;
+    eARUPDATER_ERROR error;
+    UploadBench_Run_t run;
+    int direct = 0;
+    int failed = 0;
+    int opt, s, r, l, port;
+    double elapsed, cpu, mb;
+    pid_t server;
+    char cmd[600];
+
+    while ((opt = getopt(argc, argv, "ds:r:l:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            direct = 1;
+            break;
+        case 's':
+            sizeCount = parseList(optarg, sizes);
+            break;
+        case 'r':
+            rttCount = parseList(optarg, rtts);
+            break;
+        case 'l':
+            lossCount = parseList(optarg, losses);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-d] [-s sizeKiB,...] [-r rttMs,...] [-l lossPercent,...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if ((mkdtemp(rootFolder) == NULL) || (mkdtemp(remoteFolder) == NULL))
+        return 1;
+
+    md5Manager = ARSAL_MD5_Manager_New(&arsalError);
+    if (arsalError != ARSAL_OK)
+        return 1;
+    ARSAL_MD5_Manager_Init(md5Manager);
+
+    printf("%10s %8s %8s %10s %10s %12s %s\n", "size(KiB)", "rtt(ms)", "loss(%)", "MB/s", "setup(ms)", "cpu(ms/MB)", "result");
+
+    for (s = 0; s < sizeCount; s++)
+    {
+        /* one plf per size, the md5 and manifest are computed again for each run */
+        snprintf(cmd, sizeof(cmd), "rm -rf %s/%s", rootFolder, ARUPDATER_MANAGER_PLF_FOLDER);
+        if ((system(cmd) != 0) || (createPlf(rootFolder, (size_t)(sizes[s] * 1024)) != 0))
+        {
+            failed = 1;
+            break;
+        }
+        mb = sizes[s] / 1024.0;
+
+        for (r = 0; r < rttCount; r++)
+        {
+            for (l = 0; l < lossCount; l++)
+            {
+                cleanRemote(remoteFolder);
+                server = startServer(remoteFolder, (int)rtts[r], losses[l], &port);
+                if (server < 0)
+                {
+                    failed = 1;
+                    continue;
+                }
+
+                cpu = cpuSec();
+                error = runUpload(rootFolder, md5Manager, port, direct, &run);
+                elapsed = nowSec() - run.start;
+                cpu = cpuSec() - cpu;
+
+                kill(server, SIGTERM);
+                waitpid(server, NULL, 0);
+
+                printf("%10.0f %8.0f %8.2f %10.2f %10.1f %12.1f %s\n", sizes[s], rtts[r], losses[l],
+                       (elapsed > 0) ? mb / elapsed : 0,
+                       (run.firstProgress > 0) ? (run.firstProgress - run.start) * 1000 : -1,
+                       (mb > 0) ? cpu * 1000 / mb : 0,
+                       ARUPDATER_Error_ToString(error));
+                fflush(stdout);
+                if (error != ARUPDATER_OK)
+                    failed = 1;
+            }
+        }
+    }
+
+    ARSAL_MD5_Manager_Delete(&md5Manager);
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", rootFolder, remoteFolder);
+    if (system(cmd) != 0)
+        ARSAL_PRINT(ARSAL_PRINT_WARNING, UPLOAD_BENCH_TAG, "can't remove the bench folders");
+
+    return failed;
+}
@@ -19,7 +19,8 @@ LOCAL_LIBRARIES := \
 LOCAL_CONDITIONAL_LIBRARIES := \
 	OPTIONAL:libmux \
 	OPTIONAL:libpomp \
-	OPTIONAL:libplfng
+	OPTIONAL:libplfng \
+	OPTIONAL:zlib
 
 LOCAL_C_INCLUDES := \
 	$(LOCAL_PATH)/Includes \
@@ -29,18 +30,32 @@ LOCAL_CFLAGS := \
 	-DHAVE_CONFIG_H
 
 LOCAL_SRC_FILES := \
+	Sources/ARUPDATER_Arena.c \
+	Sources/ARUPDATER_BleUpload.c \
+	Sources/ARUPDATER_Crc32c.c \
 	Sources/ARUPDATER_Downloader.c \
 	Sources/ARUPDATER_DownloadInformation.c \
+	Sources/ARUPDATER_EventRing.c \
+	Sources/ARUPDATER_FileMap.c \
+	Sources/ARUPDATER_Fleet.c \
+	Sources/ARUPDATER_Ftp.c \
+	Sources/ARUPDATER_FtpSegments.c \
 	Sources/ARUPDATER_Manager.c \
+	Sources/ARUPDATER_Manifest.c \
 	Sources/ARUPDATER_Plf.c \
+	Sources/ARUPDATER_PlfIndex.c \
+	Sources/ARUPDATER_Progress.c \
+	Sources/ARUPDATER_Throughput.c \
 	Sources/ARUPDATER_Uploader.c \
 	Sources/ARUPDATER_Utils.c \
 	gen/Sources/ARUPDATER_Error.c
 
 LOCAL_INSTALL_HEADERS := \
 	Includes/libARUpdater/ARUpdater.h:usr/include/libARUpdater/ \
+	Includes/libARUpdater/ARUPDATER_Allocator.h:usr/include/libARUpdater/ \
 	Includes/libARUpdater/ARUPDATER_Downloader.h:usr/include/libARUpdater/ \
 	Includes/libARUpdater/ARUPDATER_Error.h:usr/include/libARUpdater/ \
+	Includes/libARUpdater/ARUPDATER_Fleet.h:usr/include/libARUpdater/ \
 	Includes/libARUpdater/ARUPDATER_Manager.h:usr/include/libARUpdater/ \
 	Includes/libARUpdater/ARUPDATER_Uploader.h:usr/include/libARUpdater/ \
 	Includes/libARUpdater/ARUPDATER_Utils.h:usr/include/libARUpdater/
@@ -92,7 +92,9 @@ public enum ARUPDATER_ERROR_ENUM {
    /** error on a ARDataTransfer operation in uploader */
     ARUPDATER_ERROR_UPLOADER_ARDATATRANSFER_ERROR (-4998, "error on a ARDataTransfer operation in uploader"),
    /** error on a ARSAL operation in uploader */
-    ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR (-4997, "error on a ARSAL operation in uploader");
+    ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR (-4997, "error on a ARSAL operation in uploader"),
+   /** The device already runs the plf, nothing was uploaded */
+    ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE (-4996, "The device already runs the plf, nothing was uploaded");
 
     private final int value;
     private final String comment;
@@ -119,6 +119,9 @@ const char* ARUPDATER_Error_ToString (eARUPDATER_ERROR error)
     case ARUPDATER_ERROR_UPLOADER_ARSAL_ERROR:
         return "error on a ARSAL operation in uploader";
         break;
+    case ARUPDATER_ERROR_UPLOADER_ALREADY_UP_TO_DATE:
+        return "The device already runs the plf, nothing was uploaded";
+        break;
     default:
         break;
     }